@@ -0,0 +1,103 @@
+#include "corpus.h"
+
+#include "common/thread_pool.h"
+#include "filesystem/du_engine.h"
+#include "filesystem/walker.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <memory>
+
+// ---------------------------------------------------------------------------
+// Tree kernels: the walker behind find/ls -R/grep -r, and du
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Depth 6, fanout 4: ~5,500 directories and ~22,000 files at scale 1.
+struct Tree {
+    corpus::TempDir dir;
+    size_t entries;
+
+    Tree() {
+        int depth = corpus::scale() >= 4 ? 7 : corpus::scale() < 0.5 ? 4 : 6;
+        entries = corpus::make_tree(dir.path(), depth, 4, 4);
+    }
+};
+
+const Tree& tree() {
+    static Tree t;
+    return t;
+}
+
+// find -type f: counts regular files without stat'ing anything.
+class CountVisitor : public WalkVisitor {
+public:
+    bool visit(const WalkEntry& e, void*) override {
+        if (e.type() == EntryType::file)
+            files.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    std::atomic<size_t> files{0};
+};
+
+// find -size +0: every entry is stat'ed.
+class StatVisitor : public WalkVisitor {
+public:
+    bool visit(const WalkEntry& e, void*) override {
+        if (const FileStat* st = e.stat())
+            bytes.fetch_add(st->size, std::memory_order_relaxed);
+        return true;
+    }
+    std::atomic<uint64_t> bytes{0};
+};
+
+}  // namespace
+
+template <typename Visitor>
+static void walk_bench(benchmark::State& state) {
+    const Tree& t = tree();
+    ThreadPool pool(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        Visitor visitor;
+        walk_tree(t.dir.path(), pool, WalkOptions(), visitor);
+        benchmark::DoNotOptimize(&visitor);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * t.entries));
+}
+
+static void BM_WalkTree(benchmark::State& state) {
+    walk_bench<CountVisitor>(state);
+}
+BENCHMARK(BM_WalkTree)->Arg(1)->Arg(4)->Arg(16)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_WalkTreeStat(benchmark::State& state) {
+    walk_bench<StatVisitor>(state);
+}
+BENCHMARK(BM_WalkTreeStat)->Arg(1)->Arg(4)->Arg(16)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_DiskUsage(benchmark::State& state) {
+    const Tree& t = tree();
+    ThreadPool pool(static_cast<size_t>(state.range(0)));
+    DuOptions opts;
+    opts.apparent = false;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(disk_usage(t.dir.path(), pool, opts).total);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * t.entries));
+}
+BENCHMARK(BM_DiskUsage)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// du with its directory cache: the repeated-scan case.
+static void BM_DiskUsageCached(benchmark::State& state) {
+    const Tree& t = tree();
+    corpus::TempDir cache_dir;
+    ThreadPool pool(4);
+    DuOptions opts;
+    opts.cache_path = cache_dir.path() + "/du.cache";
+    disk_usage(t.dir.path(), pool, opts);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(disk_usage(t.dir.path(), pool, opts).total);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * t.entries));
+}
+BENCHMARK(BM_DiskUsageCached)->Unit(benchmark::kMillisecond)->UseRealTime();
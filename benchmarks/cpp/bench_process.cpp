@@ -0,0 +1,81 @@
+#include "process/proc_scan.h"
+
+#include <benchmark/benchmark.h>
+
+#include <csignal>
+#include <cstring>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// /proc scanning behind ps, with extra idle processes to scale the count
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// `count` children that sleep until killed.
+class Sleepers {
+public:
+    explicit Sleepers(size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                for (;;) pause();
+            }
+            if (pid < 0)
+                break;
+            pids_.push_back(pid);
+        }
+    }
+    ~Sleepers() {
+        for (pid_t pid : pids_)
+            kill(pid, SIGKILL);
+        for (pid_t pid : pids_)
+            waitpid(pid, nullptr, 0);
+    }
+    Sleepers(const Sleepers&) = delete;
+    Sleepers& operator=(const Sleepers&) = delete;
+
+private:
+    std::vector<pid_t> pids_;
+};
+
+}  // namespace
+
+static void scan_bench(benchmark::State& state, const ProcScanOptions& opts) {
+    Sleepers extra(static_cast<size_t>(state.range(0)));
+    size_t procs = 0;
+    for (auto _ : state) {
+        auto snapshot = scan_processes(opts);
+        procs = snapshot.size();
+        benchmark::DoNotOptimize(snapshot.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * procs));
+    state.counters["processes"] = static_cast<double>(procs);
+}
+
+static void BM_ScanProcesses(benchmark::State& state) {
+    scan_bench(state, ProcScanOptions());
+}
+BENCHMARK(BM_ScanProcesses)->Arg(0)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+static void BM_ScanProcessesCmdline(benchmark::State& state) {
+    ProcScanOptions opts;
+    opts.cmdline = true;
+    scan_bench(state, opts);
+}
+BENCHMARK(BM_ScanProcessesCmdline)->Arg(0)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+static void BM_ParseProcStat(benchmark::State& state) {
+    static const char line[] =
+        "1234 (my (odd) proc) S 1 1234 1234 0 -1 4194560 1503 0 0 0 12 7 0 0 20 0 4 0 "
+        "98765 231211008 2567 18446744073709551615 1 1 0 0 0 0 0 4096 16387 0 0 0 17 3 "
+        "0 0 0 0 0\n";
+    for (auto _ : state) {
+        ProcStat out;
+        benchmark::DoNotOptimize(parse_proc_stat(line, sizeof(line) - 1, out));
+    }
+}
+BENCHMARK(BM_ParseProcStat);
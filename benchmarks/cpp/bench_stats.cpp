@@ -0,0 +1,33 @@
+#include "common/stats.h"
+
+#include <benchmark/benchmark.h>
+
+// ---------------------------------------------------------------------------
+// Cost of the sf.stats() hooks, off and on
+// ---------------------------------------------------------------------------
+
+static int stats_command() {
+    static const int id = stats_register("bench");
+    return id;
+}
+
+static void BM_StatsScope(benchmark::State& state) {
+    bool was = stats_enable(state.range(0) != 0);
+    int id = stats_command();
+    for (auto _ : state) {
+        StatsScope scope(id);
+        stats_syscalls();
+        stats_bytes(4096);
+    }
+    stats_enable(was);
+}
+BENCHMARK(BM_StatsScope)->Arg(0)->Arg(1);
+
+static void BM_StatsSyscallHook(benchmark::State& state) {
+    bool was = stats_enable(state.range(0) != 0);
+    StatsScope scope(stats_command());
+    for (auto _ : state)
+        stats_syscalls();
+    stats_enable(was);
+}
+BENCHMARK(BM_StatsSyscallHook)->Arg(0)->Arg(1);
@@ -0,0 +1,166 @@
+#include "corpus.h"
+
+#include "common/thread_pool.h"
+#include "filesystem/walker.h"
+#include "text/diff_engine.h"
+#include "text/grep_index.h"
+#include "text/mapped_file.h"
+#include "text/matcher.h"
+#include "text/sort_engine.h"
+#include "text/wc_kernel.h"
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+
+// ---------------------------------------------------------------------------
+// Text kernels: grep, wc, sort, diff
+// ---------------------------------------------------------------------------
+
+static const std::string& log_corpus() {
+    static const std::string data = corpus::log_lines(corpus::scaled(64 << 20));
+    return data;
+}
+
+static void grep_scan(benchmark::State& state, const std::string& pattern, bool icase) {
+    MatchOptions opts;
+    opts.ignore_case = icase;
+    auto matcher = compile_matcher(pattern, opts);
+    const std::string& data = log_corpus();
+    for (auto _ : state) {
+        size_t hits = 0;
+        scan_lines(*matcher, data, false, [&](size_t, std::string_view) {
+            hits++;
+            return true;
+        });
+        benchmark::DoNotOptimize(hits);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+    state.SetLabel(matcher->engine());
+}
+
+static void BM_GrepLiteral(benchmark::State& state) {
+    grep_scan(state, "timeout after", false);
+}
+BENCHMARK(BM_GrepLiteral)->Unit(benchmark::kMillisecond);
+
+static void BM_GrepLiteralIgnoreCase(benchmark::State& state) {
+    grep_scan(state, "TIMEOUT AFTER", true);
+}
+BENCHMARK(BM_GrepLiteralIgnoreCase)->Unit(benchmark::kMillisecond);
+
+static void BM_GrepRegex(benchmark::State& state) {
+    grep_scan(state, "timeout after [0-9]+ms", false);
+}
+BENCHMARK(BM_GrepRegex)->Unit(benchmark::kMillisecond);
+
+static void BM_GrepRegexNoLiteral(benchmark::State& state) {
+    grep_scan(state, "[0-9]{5}\\]: (GET|POST)", false);
+}
+BENCHMARK(BM_GrepRegexNoLiteral)->Unit(benchmark::kMillisecond);
+
+// grep(index=...): candidate blocks from the trigram index, then a scan of
+// just those ranges.
+static void BM_GrepIndexed(benchmark::State& state) {
+    corpus::TempDir dir;
+    std::string path = corpus::write_file(dir.path(), "app.log", log_corpus());
+    std::string index_path = dir.path() + "/app.idx";
+    ThreadPool pool(1);
+    update_grep_index(path, index_path, kGrepIndexBlockSize, pool);
+
+    GrepIndex index(index_path);
+    MappedFile file;
+    file.open(path);
+    FileStat st;
+    stat_at(AT_FDCWD, path.c_str(), true, st);
+    auto matcher = compile_matcher("timeout after [0-9]+ms", MatchOptions());
+    size_t scanned = 0;
+    for (auto _ : state) {
+        std::vector<IndexRange> ranges;
+        index.ranges(st, file.data(), index.candidates(matcher->literal()), ranges);
+        size_t hits = 0;
+        scanned = 0;
+        for (const auto& r : ranges) {
+            scanned += r.end - r.begin;
+            scan_lines(*matcher, file.data().substr(r.begin, r.end - r.begin), false,
+                       [&](size_t, std::string_view) { hits++; return true; });
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * file.size()));
+    state.counters["scanned_fraction"] =
+        static_cast<double>(scanned) / static_cast<double>(file.size());
+}
+BENCHMARK(BM_GrepIndexed)->Unit(benchmark::kMicrosecond);
+
+static void BM_GrepIndexBuild(benchmark::State& state) {
+    corpus::TempDir dir;
+    std::string path = corpus::write_file(dir.path(), "app.log", log_corpus());
+    std::string index_path = dir.path() + "/app.idx";
+    ThreadPool pool(1);
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::remove(index_path.c_str());
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(update_grep_index(path, index_path, kGrepIndexBlockSize, pool));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * log_corpus().size()));
+}
+BENCHMARK(BM_GrepIndexBuild)->Unit(benchmark::kMillisecond);
+
+static void BM_Wc(benchmark::State& state) {
+    const std::string& data = log_corpus();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(wc_count(data));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+    state.SetLabel(wc_kernel_name());
+}
+BENCHMARK(BM_Wc)->Unit(benchmark::kMillisecond);
+
+static void sort_bench(benchmark::State& state, const std::string& data, SortOptions opts) {
+    opts.threads = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        size_t out = 0;
+        sort_lines(data, opts, [&](std::string_view block) { out += block.size(); });
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+
+static void BM_SortLines(benchmark::State& state) {
+    static const std::string data = corpus::log_lines(corpus::scaled(16 << 20), 4);
+    sort_bench(state, data, SortOptions());
+}
+BENCHMARK(BM_SortLines)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_SortNumeric(benchmark::State& state) {
+    static const std::string data = corpus::number_lines(corpus::scaled(1000000));
+    SortOptions opts;
+    opts.numeric = true;
+    sort_bench(state, data, opts);
+}
+BENCHMARK(BM_SortNumeric)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// External-memory path: runs of 4 MiB spilled to $TMPDIR and merged.
+static void BM_SortExternal(benchmark::State& state) {
+    static const std::string data = corpus::log_lines(corpus::scaled(16 << 20), 5);
+    SortOptions opts;
+    opts.buffer_size = 4 << 20;
+    sort_bench(state, data, opts);
+}
+BENCHMARK(BM_SortExternal)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_Diff(benchmark::State& state) {
+    static const std::string a = corpus::log_lines(corpus::scaled(8 << 20), 6);
+    std::string b = corpus::edited(a, static_cast<size_t>(state.range(0)));
+    auto lines1 = split_lines(a);
+    auto lines2 = split_lines(b);
+    for (auto _ : state) {
+        std::vector<uint32_t> ids1, ids2;
+        intern_lines(lines1, true, lines2, true, ids1, ids2);
+        DiffResult result = diff_sequences(ids1, ids2);
+        benchmark::DoNotOptimize(diff_hunks(result, 3));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * (a.size() + b.size())));
+}
+BENCHMARK(BM_Diff)->Arg(1000)->Arg(50)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// Synthetic inputs for the benchmarks
+//
+// Everything is generated from a fixed seed, so runs are comparable across
+// machines and commits. Sizes are scaled by SHELLFAST_BENCH_SCALE (default
+// 1.0) to keep a quick local run short and a CI run meaningful.
+// ---------------------------------------------------------------------------
+
+namespace corpus {
+
+inline double scale() {
+    const char* s = std::getenv("SHELLFAST_BENCH_SCALE");
+    double v = s ? std::atof(s) : 1.0;
+    return v > 0 ? v : 1.0;
+}
+
+inline size_t scaled(size_t n) {
+    size_t v = static_cast<size_t>(static_cast<double>(n) * scale());
+    return v > 0 ? v : 1;
+}
+
+// Syslog-like lines. One line in ~5000 is "ERROR ... timeout after Nms",
+// so literal and regex searches have few matches to report.
+inline std::string log_lines(size_t bytes, uint32_t seed = 1) {
+    static const char* hosts[] = {"web01", "web02", "db01", "cache03", "lb01"};
+    static const char* procs[] = {"nginx", "sshd", "cron", "kernel", "postgres", "app"};
+    static const char* words[] = {"request", "served", "connection", "from", "user",
+                                  "session", "opened", "closed", "GET", "POST",
+                                  "/api/v1/items", "status=200", "bytes=5120", "ok"};
+    std::mt19937 rng(seed);
+    std::string out;
+    out.reserve(bytes + 256);
+    char head[96];
+    while (out.size() < bytes) {
+        uint32_t r = rng();
+        std::snprintf(head, sizeof(head), "Oct %2u %02u:%02u:%02u %s %s[%u]: ",
+                      r % 28 + 1, r % 24, (r >> 8) % 60, (r >> 16) % 60,
+                      hosts[r % 5], procs[(r >> 4) % 6], (r >> 12) % 32768);
+        out += head;
+        if (rng() % 5000 == 0) {
+            out += "ERROR upstream timeout after ";
+            out += std::to_string(rng() % 900 + 100);
+            out += "ms\n";
+            continue;
+        }
+        size_t n = rng() % 10 + 3;
+        for (size_t i = 0; i < n; i++) {
+            out += words[rng() % 14];
+            out += i + 1 < n ? ' ' : '\n';
+        }
+    }
+    return out;
+}
+
+// One random integer per line, for numeric sorts.
+inline std::string number_lines(size_t lines, uint32_t seed = 2) {
+    std::mt19937_64 rng(seed);
+    std::string out;
+    out.reserve(lines * 12);
+    for (size_t i = 0; i < lines; i++) {
+        out += std::to_string(rng() % 1000000000);
+        out += '\n';
+    }
+    return out;
+}
+
+// `base` with about one line in `every` replaced, for diff.
+inline std::string edited(const std::string& base, size_t every, uint32_t seed = 3) {
+    std::mt19937 rng(seed);
+    std::string out;
+    out.reserve(base.size());
+    size_t pos = 0;
+    while (pos < base.size()) {
+        size_t nl = base.find('\n', pos);
+        size_t end = nl == std::string::npos ? base.size() : nl + 1;
+        if (rng() % every == 0)
+            out += "edited line " + std::to_string(rng()) + "\n";
+        else
+            out.append(base, pos, end - pos);
+        pos = end;
+    }
+    return out;
+}
+
+// A directory under $TMPDIR (or /tmp) that is removed with its contents.
+class TempDir {
+public:
+    TempDir() {
+        const char* tmp = std::getenv("TMPDIR");
+        std::string tmpl = std::string(tmp && tmp[0] ? tmp : "/tmp") + "/shellfast-bench.XXXXXX";
+        if (!mkdtemp(&tmpl[0]))
+            throw std::runtime_error("cannot create a temporary directory");
+        path_ = tmpl;
+    }
+    ~TempDir() {
+        nftw(path_.c_str(), [](const char* p, const struct stat*, int, struct FTW*) {
+            return std::remove(p);
+        }, 64, FTW_DEPTH | FTW_PHYS);
+    }
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+inline std::string write_file(const std::string& dir, const std::string& name,
+                              const std::string& content) {
+    std::string path = dir + "/" + name;
+    std::ofstream(path, std::ios::binary).write(content.data(),
+                                                static_cast<std::streamsize>(content.size()));
+    return path;
+}
+
+// A tree `depth` levels deep with `fanout` subdirectories and `files`
+// small files in every directory. Returns the number of entries.
+inline size_t make_tree(const std::string& root, int depth, int fanout, int files) {
+    size_t entries = 0;
+    for (int f = 0; f < files; f++) {
+        write_file(root, "file" + std::to_string(f) + ".txt", std::string(100 + f * 37, 'x'));
+        entries++;
+    }
+    if (depth == 0)
+        return entries;
+    for (int d = 0; d < fanout; d++) {
+        std::string sub = root + "/dir" + std::to_string(d);
+        mkdir(sub.c_str(), 0755);
+        entries += 1 + make_tree(sub, depth - 1, fanout, files);
+    }
+    return entries;
+}
+
+}  // namespace corpus
@@ -0,0 +1,130 @@
+"""Synthetic inputs for the shellfast-vs-coreutils benchmarks.
+
+Every corpus is generated once per session from a fixed seed. Sizes scale
+with SHELLFAST_BENCH_SCALE (default 1.0), like the native suite.
+"""
+
+import os
+import random
+import shutil
+import signal
+import subprocess
+
+import pytest
+
+SCALE = float(os.environ.get("SHELLFAST_BENCH_SCALE", "1") or 1)
+
+HOSTS = ["web01", "web02", "db01", "cache03", "lb01"]
+PROCS = ["nginx", "sshd", "cron", "kernel", "postgres", "app"]
+WORDS = ["request", "served", "connection", "from", "user", "session", "opened",
+         "closed", "GET", "POST", "/api/v1/items", "status=200", "bytes=5120", "ok"]
+
+
+def scaled(n):
+    return max(1, int(n * SCALE))
+
+
+def log_lines(count, seed):
+    rng = random.Random(seed)
+    lines = []
+    for _ in range(count):
+        head = (f"Oct {rng.randint(1, 28):2d} {rng.randrange(24):02d}:{rng.randrange(60):02d}:"
+                f"{rng.randrange(60):02d} {rng.choice(HOSTS)} {rng.choice(PROCS)}"
+                f"[{rng.randrange(32768)}]: ")
+        if rng.randrange(5000) == 0:
+            lines.append(head + f"ERROR upstream timeout after {rng.randrange(100, 1000)}ms")
+        else:
+            lines.append(head + " ".join(rng.choice(WORDS) for _ in range(rng.randint(3, 12))))
+    return lines
+
+
+def write_lines(path, lines):
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+    return str(path)
+
+
+def tool(name):
+    """Path of a coreutils/procps tool, or skip the comparison."""
+    path = shutil.which(name)
+    if path is None:
+        pytest.skip(f"{name} not installed")
+    return path
+
+
+def run(argv):
+    # grep exits 1 without matches and diff 1 with differences.
+    return subprocess.run(argv, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                          check=False).returncode
+
+
+@pytest.fixture(scope="session")
+def corpus_dir(tmp_path_factory):
+    return tmp_path_factory.mktemp("corpus")
+
+
+@pytest.fixture(scope="session")
+def log_file(corpus_dir):
+    """~64 MB of syslog-like lines with rare ERROR lines."""
+    return write_lines(corpus_dir / "app.log", log_lines(scaled(800_000), seed=1))
+
+
+@pytest.fixture(scope="session")
+def log_index(log_file, corpus_dir):
+    import shellfast as sf
+    return sf.index_build(log_file, index=str(corpus_dir / "app.idx"))["index"]
+
+
+@pytest.fixture(scope="session")
+def numbers_file(corpus_dir):
+    rng = random.Random(2)
+    return write_lines(corpus_dir / "numbers.txt",
+                       [str(rng.randrange(10 ** 9)) for _ in range(scaled(1_000_000))])
+
+
+@pytest.fixture(scope="session")
+def diff_pair(corpus_dir):
+    """Two ~8 MB files differing in about one line in a thousand."""
+    base = log_lines(scaled(100_000), seed=6)
+    rng = random.Random(3)
+    edited = [f"edited line {rng.random()}" if rng.randrange(1000) == 0 else line
+              for line in base]
+    return (write_lines(corpus_dir / "a.log", base),
+            write_lines(corpus_dir / "b.log", edited))
+
+
+@pytest.fixture(scope="session")
+def deep_tree(corpus_dir):
+    """Depth 6, fanout 4, four files per directory (~27,000 entries)."""
+    root = corpus_dir / "tree"
+    depth = 7 if SCALE >= 4 else 4 if SCALE < 0.5 else 6
+
+    def fill(path, level):
+        path.mkdir()
+        for i in range(4):
+            (path / f"file{i}.txt").write_text("x" * (100 + i * 37))
+        if level < depth:
+            for d in range(4):
+                fill(path / f"dir{d}", level + 1)
+
+    fill(root, 0)
+    return str(root)
+
+
+@pytest.fixture(scope="session")
+def many_processes():
+    """~1,000 extra sleeping processes, so ps has a large /proc to scan."""
+    sleep = shutil.which("sleep")
+    if sleep is None:
+        pytest.skip("sleep not installed")
+    procs = []
+    try:
+        for _ in range(scaled(1000)):
+            procs.append(subprocess.Popen([sleep, "3600"]))
+    except OSError:
+        pass  # process limit: benchmark with what we got
+    yield len(procs)
+    for p in procs:
+        p.send_signal(signal.SIGKILL)
+    for p in procs:
+        p.wait()
@@ -0,0 +1,36 @@
+"""find and du over a deep synthetic tree: shellfast against the GNU tools."""
+
+import pytest
+import shellfast as sf
+
+from conftest import run, tool
+
+pytest.importorskip("pytest_benchmark")
+
+
+class TestFind:
+    def test_shellfast(self, benchmark, deep_tree):
+        benchmark.group = "find"
+        assert benchmark(sf.find, deep_tree, type="f")
+
+    def test_shellfast_threads(self, benchmark, deep_tree):
+        benchmark.group = "find"
+        benchmark(sf.find, deep_tree, type="f", threads=0)
+
+    def test_gnu(self, benchmark, deep_tree):
+        benchmark.group = "find"
+        benchmark(run, [tool("find"), deep_tree, "-type", "f"])
+
+
+class TestDu:
+    def test_shellfast(self, benchmark, deep_tree):
+        benchmark.group = "du"
+        benchmark(sf.du, deep_tree, apparent=False)
+
+    def test_shellfast_threads(self, benchmark, deep_tree):
+        benchmark.group = "du"
+        benchmark(sf.du, deep_tree, apparent=False, threads=0)
+
+    def test_gnu(self, benchmark, deep_tree):
+        benchmark.group = "du"
+        benchmark(run, [tool("du"), "-s", deep_tree])
@@ -0,0 +1,18 @@
+"""ps with a large /proc: shellfast against procps."""
+
+import pytest
+import shellfast as sf
+
+from conftest import run, tool
+
+pytest.importorskip("pytest_benchmark")
+
+
+class TestPs:
+    def test_shellfast(self, benchmark, many_processes):
+        benchmark.group = "ps"
+        assert len(benchmark(sf.ps)) >= many_processes
+
+    def test_gnu(self, benchmark, many_processes):
+        benchmark.group = "ps"
+        benchmark(run, [tool("ps"), "-eo", "pid,ppid,user,stat,rss,comm"])
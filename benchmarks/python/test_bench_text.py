@@ -0,0 +1,78 @@
+"""grep, wc, sort and diff: shellfast against the GNU tools.
+
+Each command has a benchmark group, so ``--benchmark-group-by=group`` puts
+the two implementations side by side.
+"""
+
+import pytest
+import shellfast as sf
+
+from conftest import run, tool
+
+pytest.importorskip("pytest_benchmark")
+
+GREP_CASES = [
+    ("literal", "timeout after", []),
+    ("regex", "timeout after [0-9]+ms", ["-E"]),
+    ("ignore_case", "TIMEOUT AFTER", ["-i"]),
+]
+
+
+@pytest.mark.parametrize("name,pattern,flags", GREP_CASES, ids=[c[0] for c in GREP_CASES])
+class TestGrep:
+    def test_shellfast(self, benchmark, log_file, name, pattern, flags):
+        benchmark.group = f"grep-{name}"
+        result = benchmark(sf.grep, pattern, log_file, ignore_case="-i" in flags)
+        assert result
+
+    def test_shellfast_threads(self, benchmark, log_file, name, pattern, flags):
+        benchmark.group = f"grep-{name}"
+        benchmark(sf.grep, pattern, log_file, ignore_case="-i" in flags, threads=0)
+
+    def test_shellfast_indexed(self, benchmark, log_file, log_index, name, pattern, flags):
+        benchmark.group = f"grep-{name}"
+        result = benchmark(sf.grep, pattern, log_file, ignore_case="-i" in flags,
+                           index=log_index)
+        assert result == sf.grep(pattern, log_file, ignore_case="-i" in flags)
+
+    def test_gnu(self, benchmark, log_file, name, pattern, flags):
+        benchmark.group = f"grep-{name}"
+        benchmark(run, [tool("grep"), "-n", *flags, pattern, log_file])
+
+
+class TestWc:
+    def test_shellfast(self, benchmark, log_file):
+        benchmark.group = "wc"
+        benchmark(sf.wc, log_file)
+
+    def test_gnu(self, benchmark, log_file):
+        benchmark.group = "wc"
+        benchmark(run, [tool("wc"), log_file])
+
+
+class TestSort:
+    def test_shellfast(self, benchmark, log_file):
+        benchmark.group = "sort"
+        benchmark(sf.sort_file, log_file, threads=0, as_bytes=True)
+
+    def test_gnu(self, benchmark, log_file):
+        benchmark.group = "sort"
+        benchmark(run, [tool("sort"), log_file])
+
+    def test_shellfast_numeric(self, benchmark, numbers_file):
+        benchmark.group = "sort-numeric"
+        benchmark(sf.sort_file, numbers_file, numeric=True, threads=0, as_bytes=True)
+
+    def test_gnu_numeric(self, benchmark, numbers_file):
+        benchmark.group = "sort-numeric"
+        benchmark(run, [tool("sort"), "-n", numbers_file])
+
+
+class TestDiff:
+    def test_shellfast(self, benchmark, diff_pair):
+        benchmark.group = "diff"
+        assert benchmark(sf.diff, *diff_pair)
+
+    def test_gnu(self, benchmark, diff_pair):
+        benchmark.group = "diff"
+        benchmark(run, [tool("diff"), "-u", *diff_pair])
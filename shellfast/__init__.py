@@ -8,10 +8,11 @@ significant performance improvements.
 
 Categories:
     - **File & Directory**: ls, pwd, cd, mkdir, rmdir, rm, touch, cp, mv, ln, find, du, chmod, chown
-    - **Text Processing**: cat, echo, head, tail, grep, sort_file, diff, cmp, comm, wc, cut, paste, join
-    - **System Info**: uname, whoami, uptime, env, getenv, export_env, unsetenv, clear, cal, date, sleep, id, groups, free, whereis
-    - **Process Management**: ps, kill, killall
-    - **Networking**: ping, nslookup, ifconfig
+    - **Text Processing**: cat, echo, head, tail, grep, index_build, sort_file, diff, cmp, comm, wc, cut, paste, join, pipeline
+    - **System Info**: uname, whoami, uptime, env, getenv, export_env, unsetenv, clear, cal, date, sleep, id, groups, free, sysstat, whereis, which, which_many
+    - **Process Management**: ps, ProcessSampler, pgrep, kill, killall
+    - **Networking**: ping, ping_many, nslookup, nslookup_many, ifconfig, InterfaceSampler
+    - **Instrumentation**: stats, stats_enable
 
 Example:
     >>> import shellfast as sf
@@ -48,6 +49,10 @@ from shellfast._core import (
     head,
     tail,
     grep,
+    index_build,
+    grep_iter,
+    cat_iter,
+    tail_iter,
     sort_file,
     diff,
     cmp,
@@ -56,6 +61,7 @@ from shellfast._core import (
     cut,
     paste,
     join,
+    pipeline,
 
     # ── System Info Commands ──────────────────────────────────────────────
     uname,
@@ -72,17 +78,29 @@ from shellfast._core import (
     id,
     groups,
     free,
+    sysstat,
     whereis,
+    which,
+    which_many,
 
     # ── Process Management Commands ───────────────────────────────────────
     ps,
+    ProcessSampler,
+    pgrep,
     kill,
     killall,
 
     # ── Networking Commands ───────────────────────────────────────────────
     ping,
+    ping_many,
     nslookup,
+    nslookup_many,
     ifconfig,
+    InterfaceSampler,
+
+    # ── Instrumentation ───────────────────────────────────────────────────
+    stats,
+    stats_enable,
 )
 
 __all__ = [
@@ -90,14 +108,17 @@ __all__ = [
     "ls", "pwd", "cd", "mkdir", "rmdir", "rm", "touch",
     "cp", "mv", "ln", "find", "du", "chmod", "chown",
     # Text Processing
-    "cat", "echo", "head", "tail", "grep", "sort_file",
-    "diff", "cmp", "comm", "wc", "cut", "paste", "join",
+    "cat", "echo", "head", "tail", "grep", "index_build", "sort_file",
+    "grep_iter", "cat_iter", "tail_iter",
+    "diff", "cmp", "comm", "wc", "cut", "paste", "join", "pipeline",
     # System
     "uname", "whoami", "uptime", "env", "getenv", "export_env",
     "unsetenv", "clear", "cal", "date", "sleep", "id", "groups",
-    "free", "whereis",
+    "free", "sysstat", "whereis", "which", "which_many",
     # Process
-    "ps", "kill", "killall",
+    "ps", "ProcessSampler", "pgrep", "kill", "killall",
     # Network
-    "ping", "nslookup", "ifconfig",
+    "ping", "ping_many", "nslookup", "nslookup_many", "ifconfig", "InterfaceSampler",
+    # Instrumentation
+    "stats", "stats_enable",
 ]
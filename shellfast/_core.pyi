@@ -1,9 +1,32 @@
 """Type stubs for shellfast._core C++ extension module."""
 
-from typing import Any, Dict, List, Optional, Union
+from typing import Any, Callable, Dict, Iterator, List, Literal, Optional, Union, overload
 
 # ── File & Directory Commands ────────────────────────────────────────────────
 
+class StatResult:
+    """One entry of :func:`ls` with ``stat=True``; strings are built on access."""
+    name: str
+    path: str
+    type: str
+    is_directory: bool
+    is_symlink: bool
+    mode: int
+    permissions: str
+    uid: int
+    gid: int
+    owner: str
+    group: str
+    size: int
+    size_human: str
+    nlink: int
+    ino: int
+    mtime: float
+    mtime_ns: int
+    last_modified: str
+    symlink_target: Optional[str]
+    def to_dict(self) -> Dict[str, Any]: ...
+
 def ls(
     path: str = ".",
     all: bool = False,
@@ -13,7 +36,9 @@ def ls(
     reverse: bool = False,
     human_readable: bool = False,
     directory_only: bool = False,
-) -> List[Union[str, Dict[str, Any]]]:
+    threads: int = 1,
+    stat: bool = False,
+) -> List[Union[str, Dict[str, Any], StatResult]]:
     """List directory contents. Equivalent to ``ls``."""
     ...
 
@@ -33,19 +58,52 @@ def rmdir(path: str) -> None:
     """Remove empty directory. Equivalent to ``rmdir``."""
     ...
 
-def rm(path: str, recursive: bool = False, force: bool = False) -> None:
+class RemoveHandle:
+    """Handle returned by :func:`rm` with ``async_=True``."""
+    @property
+    def path(self) -> str: ...
+    def wait(self) -> None: ...
+    def done(self) -> bool: ...
+
+@overload
+def rm(
+    path: str,
+    recursive: bool = False,
+    force: bool = False,
+    threads: int = 1,
+    async_: Literal[False] = False,
+) -> None:
     """Remove files/directories. Equivalent to ``rm``."""
     ...
+@overload
+def rm(
+    path: str,
+    recursive: bool = False,
+    force: bool = False,
+    threads: int = 1,
+    *,
+    async_: Literal[True],
+) -> Optional[RemoveHandle]:
+    """Remove in the background; the handle is None if nothing existed."""
+    ...
 
 def touch(path: str, no_create: bool = False) -> None:
     """Create file or update timestamp. Equivalent to ``touch``."""
     ...
 
-def cp(src: str, dst: str, recursive: bool = False, force: bool = False, preserve: bool = False) -> None:
+def cp(
+    src: str,
+    dst: str,
+    recursive: bool = False,
+    force: bool = False,
+    preserve: bool = False,
+    threads: int = 1,
+    progress: Optional[Callable[[int, int], Any]] = None,
+) -> None:
     """Copy files/directories. Equivalent to ``cp``."""
     ...
 
-def mv(src: str, dst: str, force: bool = False) -> None:
+def mv(src: str, dst: str, force: bool = False, threads: int = 1) -> None:
     """Move/rename files. Equivalent to ``mv``."""
     ...
 
@@ -60,25 +118,55 @@ def find(
     min_size: int = -1,
     max_size: int = -1,
     max_depth: int = -1,
+    threads: int = 1,
+    path_glob: str = "",
+    mtime: str = "",
+    newer: str = "",
+    user: str = "",
+    perm: str = "",
+    prune: List[str] = [],
 ) -> List[str]:
     """Search files in directory hierarchy. Equivalent to ``find``."""
     ...
 
-def du(path: str = ".", human_readable: bool = False, summary_only: bool = True) -> Union[Dict[str, Any], List[Dict[str, Any]]]:
+def du(
+    path: str = ".",
+    human_readable: bool = False,
+    summary_only: bool = True,
+    threads: int = 1,
+    apparent: bool = True,
+    cache: str = "",
+) -> Union[Dict[str, Any], List[Dict[str, Any]]]:
     """Estimate disk usage. Equivalent to ``du``."""
     ...
 
-def chmod(path: str, mode: int, recursive: bool = False) -> None:
+def chmod(path: str, mode: int, recursive: bool = False, threads: int = 1) -> None:
     """Change file permissions. Equivalent to ``chmod``."""
     ...
 
-def chown(path: str, owner: str = "", group: str = "", recursive: bool = False) -> None:
+def chown(
+    path: str, owner: str = "", group: str = "", recursive: bool = False, threads: int = 1
+) -> None:
     """Change file ownership. Equivalent to ``chown``."""
     ...
 
 # ── Text Processing Commands ─────────────────────────────────────────────────
 
-def cat(path: str, number_lines: bool = False, squeeze_blank: bool = False) -> str:
+class TextBuffer:
+    """Result bytes returned with ``as_bytes=True``; supports the buffer protocol."""
+    def __len__(self) -> int: ...
+    def __bytes__(self) -> bytes: ...
+    def decode(self) -> str: ...
+    def lines(self) -> "LineView": ...
+
+class LineView:
+    """Lines of a :class:`TextBuffer` without newlines, decoded per access."""
+    def __len__(self) -> int: ...
+    def __getitem__(self, index: int) -> str: ...
+
+def cat(
+    path: str, number_lines: bool = False, squeeze_blank: bool = False, as_bytes: bool = False
+) -> Union[str, TextBuffer]:
     """Display file contents. Equivalent to ``cat``."""
     ...
 
@@ -86,11 +174,11 @@ def echo(text: str, no_newline: bool = False) -> str:
     """Return a string. Equivalent to ``echo``."""
     ...
 
-def head(path: str, n: int = 10, bytes: int = -1) -> str:
+def head(path: str, n: int = 10, bytes: int = -1, as_bytes: bool = False) -> Union[str, TextBuffer]:
     """Return first N lines. Equivalent to ``head``."""
     ...
 
-def tail(path: str, n: int = 10, bytes: int = -1) -> str:
+def tail(path: str, n: int = 10, bytes: int = -1, as_bytes: bool = False) -> Union[str, TextBuffer]:
     """Return last N lines. Equivalent to ``tail``."""
     ...
 
@@ -104,10 +192,68 @@ def grep(
     invert: bool = False,
     files_only: bool = False,
     whole_word: bool = False,
+    fixed_strings: bool = False,
+    threads: int = 1,
+    index: Union[None, bool, str] = None,
 ) -> Union[List[Dict[str, Any]], Dict[str, int], List[str]]:
     """Search for pattern in files. Equivalent to ``grep``."""
     ...
 
+def index_build(
+    path: str,
+    index: str = "",
+    block_size: int = 262144,
+    threads: int = 1,
+) -> Dict[str, Any]:
+    """Build or update a trigram index for ``grep(index=...)``."""
+    ...
+
+class GrepIterator(Iterator[List[Dict[str, Any]]]):
+    """Iterator returned by :func:`grep_iter`."""
+    def __iter__(self) -> "GrepIterator": ...
+    def __next__(self) -> List[Dict[str, Any]]: ...
+    def close(self) -> None: ...
+
+class LineIterator(Iterator[str]):
+    """Iterator returned by :func:`cat_iter` and :func:`tail_iter`."""
+    def __iter__(self) -> "LineIterator": ...
+    def __next__(self) -> str: ...
+    def close(self) -> None: ...
+
+def grep_iter(
+    pattern: str,
+    path: str,
+    ignore_case: bool = False,
+    recursive: bool = False,
+    line_numbers: bool = True,
+    invert: bool = False,
+    whole_word: bool = False,
+    fixed_strings: bool = False,
+    max_count: int = -1,
+    batch_size: int = 1024,
+) -> GrepIterator:
+    """Search for pattern in files, yielding batches of matches."""
+    ...
+
+def cat_iter(
+    path: str,
+    number_lines: bool = False,
+    squeeze_blank: bool = False,
+    batch_size: int = 1024,
+) -> LineIterator:
+    """Read a file in batches of lines."""
+    ...
+
+def tail_iter(
+    path: str,
+    n: int = 10,
+    batch_size: int = 1024,
+    follow: bool = False,
+    timeout: float = -1.0,
+) -> LineIterator:
+    """Read the last N lines of a file in batches."""
+    ...
+
 def sort_file(
     path: str,
     reverse: bool = False,
@@ -116,7 +262,12 @@ def sort_file(
     key: int = 0,
     separator: str = "",
     ignore_case: bool = False,
-) -> str:
+    buffer_size: int = 0,
+    output: str = "",
+    temp_dir: str = "",
+    threads: int = 1,
+    as_bytes: bool = False,
+) -> Union[str, TextBuffer]:
     """Sort lines of a file. Equivalent to ``sort``."""
     ...
 
@@ -124,36 +275,95 @@ def diff(file1: str, file2: str, unified: bool = True, context_lines: int = 3) -
     """Compare two files line by line. Equivalent to ``diff``."""
     ...
 
-def cmp(file1: str, file2: str, silent: bool = False) -> Dict[str, Any]:
+def cmp(file1: str, file2: str, silent: bool = False, max_diffs: int = 0) -> Dict[str, Any]:
     """Compare two files byte by byte. Equivalent to ``cmp``."""
     ...
 
-def comm(file1: str, file2: str) -> Dict[str, List[str]]:
+def comm(file1: str, file2: str, assume_sorted: bool = False) -> Dict[str, List[str]]:
     """Compare two sorted files. Equivalent to ``comm``."""
     ...
 
+@overload
 def wc(
     path: str,
     lines_only: bool = False,
     words_only: bool = False,
     chars_only: bool = False,
     bytes_only: bool = False,
+    threads: int = 1,
 ) -> Dict[str, Any]:
     """Count lines/words/chars/bytes. Equivalent to ``wc``."""
     ...
+@overload
+def wc(
+    paths: List[str],
+    lines_only: bool = False,
+    words_only: bool = False,
+    chars_only: bool = False,
+    bytes_only: bool = False,
+    threads: int = 1,
+) -> List[Dict[str, Any]]:
+    """Count several files in parallel. Equivalent to ``wc file...``."""
+    ...
 
-def cut(path: str, delimiter: str = "\t", fields: str = "1") -> str:
+def cut(
+    path: str, delimiter: str = "\t", fields: str = "1", as_bytes: bool = False
+) -> Union[str, TextBuffer]:
     """Extract fields from each line. Equivalent to ``cut``."""
     ...
 
-def paste(files: List[str], delimiter: str = "\t") -> str:
+def paste(
+    files: List[str], delimiter: str = "\t", as_bytes: bool = False
+) -> Union[str, TextBuffer]:
     """Merge lines of files. Equivalent to ``paste``."""
     ...
 
-def join(file1: str, file2: str, field1: int = 1, field2: int = 1, separator: str = "") -> str:
+def join(
+    file1: str,
+    file2: str,
+    field1: int = 1,
+    field2: int = 1,
+    separator: str = "",
+    assume_sorted: bool = False,
+    output: str = "",
+    as_bytes: bool = False,
+) -> Union[str, TextBuffer]:
     """Join two files on a common field. Equivalent to ``join``."""
     ...
 
+class Pipeline:
+    """Native text stages built by :func:`pipeline`; each method appends a stage."""
+    def grep(
+        self,
+        pattern: str,
+        ignore_case: bool = False,
+        invert: bool = False,
+        whole_word: bool = False,
+        fixed_strings: bool = False,
+    ) -> "Pipeline": ...
+    def cut(self, fields: str = "1", delimiter: str = "\t") -> "Pipeline": ...
+    def sort(
+        self,
+        reverse: bool = False,
+        numeric: bool = False,
+        unique: bool = False,
+        key: int = 0,
+        separator: str = "",
+        ignore_case: bool = False,
+        buffer_size: int = 0,
+        temp_dir: str = "",
+        threads: int = 1,
+    ) -> "Pipeline": ...
+    def head(self, n: int = 10) -> "Pipeline": ...
+    def tail(self, n: int = 10) -> "Pipeline": ...
+    def comm(self, path: str, keep: str = "only_in_first") -> "Pipeline": ...
+    def run(self, path: str, output: str = "", threaded: bool = False) -> str: ...
+    def __len__(self) -> int: ...
+
+def pipeline() -> Pipeline:
+    """Start a native grep | cut | sort | ... pipeline over one file."""
+    ...
+
 # ── System Commands ──────────────────────────────────────────────────────────
 
 def uname(all: bool = False) -> Dict[str, str]:
@@ -212,23 +422,135 @@ def free(human_readable: bool = False) -> Dict[str, Any]:
     """Display memory usage. Equivalent to ``free``."""
     ...
 
+class SysStat:
+    """One :func:`sysstat` snapshot; memory sizes are in kB."""
+    uptime: float
+    load_1: float
+    load_5: float
+    load_15: float
+    threads_total: int
+    mem_total: int
+    mem_free: int
+    mem_available: int
+    mem_used: int
+    buffers: int
+    cached: int
+    shmem: int
+    sreclaimable: int
+    dirty: int
+    writeback: int
+    swap_total: int
+    swap_free: int
+    ctxt: int
+    forks: int
+    procs_running: int
+    procs_blocked: int
+    pgfault: int
+    pgmajfault: int
+    pswpin: int
+    pswpout: int
+    oom_kill: int
+    psi_cpu: Optional[Dict[str, Any]]
+    psi_memory: Optional[Dict[str, Any]]
+    psi_io: Optional[Dict[str, Any]]
+    interval: Optional[float]
+    cpu_busy_percent: Optional[float]
+    cpu_user_percent: Optional[float]
+    cpu_system_percent: Optional[float]
+    cpu_iowait_percent: Optional[float]
+    cpu_steal_percent: Optional[float]
+    cpu_idle_percent: Optional[float]
+    ctxt_per_sec: Optional[float]
+    forks_per_sec: Optional[float]
+    pgfault_per_sec: Optional[float]
+    pgmajfault_per_sec: Optional[float]
+    def to_dict(self) -> Dict[str, Any]: ...
+
+def sysstat(delta: bool = False) -> SysStat:
+    """Memory, CPU, load and pressure in one snapshot, like ``free`` + ``uptime`` + ``vmstat``."""
+    ...
+
 def whereis(command: str) -> Dict[str, Any]:
     """Locate binary, source, and man pages. Equivalent to ``whereis``."""
     ...
 
+def which(command: str) -> Optional[str]:
+    """Locate a command in PATH. Equivalent to ``which``."""
+    ...
+
+def which_many(commands: List[str]) -> Dict[str, Optional[str]]:
+    """Locate many commands in PATH through the cached PATH index."""
+    ...
+
 # ── Process Commands ─────────────────────────────────────────────────────────
 
-def ps(all: bool = True, sort_by: str = "pid") -> List[Dict[str, Any]]:
+@overload
+def ps(
+    all: bool = True,
+    sort_by: str = "pid",
+    fields: Optional[List[str]] = None,
+    table: Literal[False] = False,
+) -> List[Dict[str, Any]]:
     """List running processes. Equivalent to ``ps``."""
     ...
+@overload
+def ps(
+    all: bool = True,
+    sort_by: str = "pid",
+    fields: Optional[List[str]] = None,
+    *,
+    table: Literal[True],
+) -> Dict[str, List[Any]]:
+    """List running processes as columns."""
+    ...
+
+class ProcessSampler:
+    """Per-process CPU%, I/O rates and RSS deltas between snapshots, like ``top``."""
+    def __init__(self, interval: float = 0.0, io: bool = True, cmdline: bool = False) -> None: ...
+    def sample(self) -> List[Dict[str, Any]]: ...
+    def top(self, n: int = 10, by: str = "cpu") -> List[Dict[str, Any]]: ...
+    def start(self, interval: float) -> None: ...
+    def stop(self) -> None: ...
+    @property
+    def running(self) -> bool: ...
+    @property
+    def interval(self) -> float: ...
+    def __enter__(self) -> "ProcessSampler": ...
+    def __exit__(self, *args: Any) -> None: ...
 
 def kill(pid: int, signal: int = 15) -> None:
     """Send signal to a process. Equivalent to ``kill``."""
     ...
 
-def killall(name: str, signal: int = 15) -> Dict[str, Any]:
+@overload
+def pgrep(pattern: str, match: str = "regex") -> List[int]:
+    """Find processes by name. Equivalent to ``pgrep``."""
+    ...
+@overload
+def pgrep(patterns: List[str], match: str = "regex") -> Dict[str, List[int]]:
+    """Find processes for several patterns in one /proc pass."""
+    ...
+
+@overload
+def killall(
+    name: str,
+    signal: int = 15,
+    match: str = "exact",
+    wait: bool = False,
+    timeout: float = 5.0,
+) -> Dict[str, Any]:
     """Kill all processes by name. Equivalent to ``killall``."""
     ...
+@overload
+def killall(
+    names: List[str],
+    signal: int = 15,
+    match: str = "exact",
+    wait: bool = False,
+    timeout: float = 5.0,
+) -> Dict[str, Any]:
+    """Kill all processes matching any of several names in one /proc pass."""
+    ...
 
 # ── Network Commands ─────────────────────────────────────────────────────────
 
@@ -236,10 +558,48 @@ def ping(host: str, count: int = 4, timeout: float = 2.0) -> Dict[str, Any]:
     """Send ICMP echo requests. Equivalent to ``ping``."""
     ...
 
-def nslookup(hostname: str, ipv6: bool = False) -> Dict[str, Any]:
+def ping_many(
+    hosts: List[str],
+    count: int = 4,
+    interval: float = 1.0,
+    timeout: float = 2.0,
+) -> List[Dict[str, Any]]:
+    """Ping many hosts concurrently from one epoll loop."""
+    ...
+
+def nslookup(hostname: str, ipv6: bool = False, reverse: bool = True) -> Dict[str, Any]:
     """DNS hostname resolution. Equivalent to ``nslookup``."""
     ...
 
+def nslookup_many(
+    names: List[str],
+    ipv6: bool = False,
+    reverse: bool = False,
+    concurrency: int = 64,
+    timeout: float = 5.0,
+    cache: bool = True,
+    cache_ttl: float = 60.0,
+) -> List[Dict[str, Any]]:
+    """Resolve many hostnames concurrently, with a shared cache."""
+    ...
+
 def ifconfig(interface_name: str = "") -> List[Dict[str, Any]]:
     """Display network interface info. Equivalent to ``ifconfig``."""
     ...
+
+class InterfaceSampler:
+    """Per-interface RX/TX byte, packet and drop rates between netlink dumps."""
+    def __init__(self, interfaces: Optional[List[str]] = None) -> None: ...
+    def sample(self) -> List[Dict[str, Any]]: ...
+    @property
+    def interval(self) -> float: ...
+
+# ── Instrumentation ──────────────────────────────────────────────────────────
+
+def stats(reset: bool = False) -> Dict[str, Dict[str, Any]]:
+    """Per-command calls, bytes, syscalls and latency histogram."""
+    ...
+
+def stats_enable(enabled: bool = True) -> bool:
+    """Turn stats collection on or off; returns the previous setting."""
+    ...
@@ -0,0 +1,128 @@
+#include "id_names.h"
+
+#include <cerrno>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <grp.h>
+#include <pwd.h>
+
+static constexpr size_t kIdCacheSize = 4096;
+
+namespace {
+
+class IdNameCache {
+public:
+    explicit IdNameCache(std::string (*resolve)(uint32_t)) : resolve_(resolve) {}
+
+    std::string get(uint32_t id) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(id);
+            if (it != index_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                return it->second->second;
+            }
+        }
+        // Resolved unlocked: a slow directory service must not serialize
+        // lookups of other ids. Two threads may both resolve a new id.
+        std::string name = resolve_(id);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index_.find(id) == index_.end()) {
+            lru_.emplace_front(id, name);
+            index_[id] = lru_.begin();
+            if (lru_.size() > kIdCacheSize) {
+                index_.erase(lru_.back().first);
+                lru_.pop_back();
+            }
+        }
+        return name;
+    }
+
+private:
+    std::string (*resolve_)(uint32_t);
+    std::mutex mutex_;
+    std::list<std::pair<uint32_t, std::string>> lru_;     // most recent first
+    std::unordered_map<uint32_t, std::list<std::pair<uint32_t, std::string>>::iterator> index_;
+};
+
+std::string lookup_user(uint32_t uid) {
+    std::vector<char> buf(1024);
+    for (;;) {
+        struct passwd pw;
+        struct passwd* result = nullptr;
+        int err = getpwuid_r(uid, &pw, buf.data(), buf.size(), &result);
+        if (err == ERANGE && buf.size() < (1u << 20)) {
+            buf.resize(buf.size() * 4);
+            continue;
+        }
+        if (err == 0 && result)
+            return result->pw_name;
+        return std::to_string(uid);
+    }
+}
+
+std::string lookup_group(uint32_t gid) {
+    std::vector<char> buf(1024);
+    for (;;) {
+        struct group gr;
+        struct group* result = nullptr;
+        int err = getgrgid_r(gid, &gr, buf.data(), buf.size(), &result);
+        if (err == ERANGE && buf.size() < (1u << 20)) {
+            buf.resize(buf.size() * 4);
+            continue;
+        }
+        if (err == 0 && result)
+            return result->gr_name;
+        return std::to_string(gid);
+    }
+}
+
+}  // namespace
+
+std::string user_name(uint32_t uid) {
+    static IdNameCache cache(lookup_user);
+    return cache.get(uid);
+}
+
+std::string group_name(uint32_t gid) {
+    static IdNameCache cache(lookup_group);
+    return cache.get(gid);
+}
+
+bool user_id(const std::string& name, uint32_t& uid) {
+    std::vector<char> buf(1024);
+    for (;;) {
+        struct passwd pw;
+        struct passwd* result = nullptr;
+        int err = getpwnam_r(name.c_str(), &pw, buf.data(), buf.size(), &result);
+        if (err == ERANGE && buf.size() < (1u << 20)) {
+            buf.resize(buf.size() * 4);
+            continue;
+        }
+        if (err != 0 || !result)
+            return false;
+        uid = result->pw_uid;
+        return true;
+    }
+}
+
+bool group_id(const std::string& name, uint32_t& gid) {
+    std::vector<char> buf(1024);
+    for (;;) {
+        struct group gr;
+        struct group* result = nullptr;
+        int err = getgrnam_r(name.c_str(), &gr, buf.data(), buf.size(), &result);
+        if (err == ERANGE && buf.size() < (1u << 20)) {
+            buf.resize(buf.size() * 4);
+            continue;
+        }
+        if (err != 0 || !result)
+            return false;
+        gid = result->gr_gid;
+        return true;
+    }
+}
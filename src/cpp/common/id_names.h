@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// ---------------------------------------------------------------------------
+// uid / gid -> name, cached
+//
+// getpwuid_r / getgrgid_r can go through NSS to sssd, LDAP or NIS, at a
+// network round trip per call; a listing of a large tree owned by a few
+// users would repeat the same handful of lookups for every entry. Results
+// are kept in a process-wide LRU (per kind, a few thousand ids), shared by
+// every command and thread. An id without a name is cached too, as its
+// number, which is what ls prints for it.
+// ---------------------------------------------------------------------------
+
+std::string user_name(uint32_t uid);
+std::string group_name(uint32_t gid);
+
+// Name -> uid / gid with getpwnam_r / getgrnam_r, uncached and safe to call
+// without the GIL. False if there is no such user or group.
+bool user_id(const std::string& name, uint32_t& uid);
+bool group_id(const std::string& name, uint32_t& gid);
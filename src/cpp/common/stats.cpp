@@ -0,0 +1,193 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+std::atomic<bool> g_stats_enabled{false};
+
+// Enough for every binding with room to spare; commands registered beyond
+// it are not counted.
+static constexpr size_t kMaxCommands = 128;
+
+namespace {
+
+// One command's counters in one thread's block. Only the owning thread
+// stores to them, so a relaxed load + store is a safe increment.
+struct Counters {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> syscalls{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> latency[kStatsLatencyBuckets] = {};
+};
+
+inline void bump(std::atomic<uint64_t>& c, uint64_t n) {
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+struct ThreadBlock {
+    Counters commands[kMaxCommands];
+};
+
+// Plain totals, as summed by a snapshot.
+struct Totals {
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+    uint64_t syscalls = 0;
+    uint64_t total_ns = 0;
+    uint64_t latency[kStatsLatencyBuckets] = {};
+
+    void add(const Counters& c) {
+        calls += c.calls.load(std::memory_order_relaxed);
+        bytes += c.bytes.load(std::memory_order_relaxed);
+        syscalls += c.syscalls.load(std::memory_order_relaxed);
+        total_ns += c.total_ns.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < kStatsLatencyBuckets; i++)
+            latency[i] += c.latency[i].load(std::memory_order_relaxed);
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::string> names;
+    std::vector<ThreadBlock*> live;
+    std::vector<Totals> retired = std::vector<Totals>(kMaxCommands);
+    std::vector<Totals> baseline = std::vector<Totals>(kMaxCommands);
+};
+
+// Never destroyed: threads may exit (and retire their blocks) during
+// static destruction.
+Registry& registry() {
+    static Registry* r = new Registry();
+    return *r;
+}
+
+// Folds the block into the retired totals when its thread exits.
+struct BlockHolder {
+    ThreadBlock* block = nullptr;
+
+    ~BlockHolder() {
+        if (!block) return;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (size_t i = 0; i < kMaxCommands; i++)
+            r.retired[i].add(block->commands[i]);
+        r.live.erase(std::find(r.live.begin(), r.live.end(), block));
+        delete block;
+    }
+};
+
+thread_local BlockHolder tls_block;
+thread_local int tls_command = -1;
+
+Counters* local_counters(int command) {
+    if (command < 0 || static_cast<size_t>(command) >= kMaxCommands)
+        return nullptr;
+    if (!tls_block.block) {
+        auto block = std::make_unique<ThreadBlock>();
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.live.push_back(block.get());
+        tls_block.block = block.release();
+    }
+    return &tls_block.block->commands[command];
+}
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+size_t latency_bucket(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    size_t bucket = us == 0 ? 0 : static_cast<size_t>(64 - __builtin_clzll(us));
+    return std::min(bucket, kStatsLatencyBuckets - 1);
+}
+
+}  // namespace
+
+bool stats_enable(bool on) {
+    return g_stats_enabled.exchange(on);
+}
+
+int stats_register(const char* name) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto it = std::find(r.names.begin(), r.names.end(), name);
+    if (it != r.names.end())
+        return static_cast<int>(it - r.names.begin());
+    r.names.emplace_back(name);
+    return static_cast<int>(r.names.size() - 1);
+}
+
+int stats_current_command() {
+    return tls_command;
+}
+
+void stats_set_command(int command) {
+    tls_command = command;
+}
+
+void stats_add_bytes(uint64_t n) {
+    if (Counters* c = local_counters(tls_command))
+        bump(c->bytes, n);
+}
+
+void stats_add_syscalls(uint64_t n) {
+    if (Counters* c = local_counters(tls_command))
+        bump(c->syscalls, n);
+}
+
+std::vector<CommandStats> stats_snapshot(bool reset) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    size_t count = std::min(r.names.size(), kMaxCommands);
+    std::vector<CommandStats> out;
+    for (size_t i = 0; i < count; i++) {
+        Totals t = r.retired[i];
+        for (ThreadBlock* block : r.live)
+            t.add(block->commands[i]);
+        Totals base = r.baseline[i];
+        if (reset)
+            r.baseline[i] = t;
+        if (t.calls == base.calls && t.bytes == base.bytes && t.syscalls == base.syscalls)
+            continue;
+        CommandStats s;
+        s.name = r.names[i];
+        s.calls = t.calls - base.calls;
+        s.bytes = t.bytes - base.bytes;
+        s.syscalls = t.syscalls - base.syscalls;
+        s.total_ns = t.total_ns - base.total_ns;
+        for (size_t b = 0; b < kStatsLatencyBuckets; b++)
+            s.latency[b] = t.latency[b] - base.latency[b];
+        out.push_back(std::move(s));
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// StatsScope
+// ---------------------------------------------------------------------------
+
+StatsScope::StatsScope(int command) : command_(command), previous_(tls_command) {
+    if (!stats_enabled())
+        return;
+    tls_command = command;
+    start_ns_ = now_ns();
+}
+
+StatsScope::~StatsScope() {
+    if (start_ns_ < 0)
+        return;
+    tls_command = previous_;
+    Counters* c = local_counters(command_);
+    if (!c)
+        return;
+    uint64_t elapsed = static_cast<uint64_t>(std::max<int64_t>(now_ns() - start_ns_, 0));
+    bump(c->calls, 1);
+    bump(c->total_ns, elapsed);
+    bump(c->latency[latency_bucket(elapsed)], 1);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Command statistics behind sf.stats()
+//
+// Every command binding is wrapped in counted(), which records one call and
+// its wall-clock latency in a log2 histogram. Kernels report the bytes they
+// read and the system calls they make through stats_bytes() and
+// stats_syscalls(); both are charged to the command the calling thread is
+// running, and ThreadPool workers run under the command of the thread that
+// created the pool.
+//
+// Counters live in per-thread blocks that only their own thread writes
+// (relaxed atomic loads and stores, no locked instructions), so a hook costs
+// a flag test and a few stores. A snapshot sums the live blocks and what
+// exited threads left behind; a reset only moves the baseline snapshots are
+// taken against. Collection is off until stats_enable(true): every hook is
+// then a single relaxed load.
+// ---------------------------------------------------------------------------
+
+// Bucket i counts calls that took less than 2^i microseconds (and at least
+// 2^(i-1)); the last bucket also takes everything slower.
+constexpr size_t kStatsLatencyBuckets = 32;
+
+struct CommandStats {
+    std::string name;
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+    uint64_t syscalls = 0;
+    uint64_t total_ns = 0;
+    uint64_t latency[kStatsLatencyBuckets] = {};
+};
+
+extern std::atomic<bool> g_stats_enabled;
+
+inline bool stats_enabled() { return g_stats_enabled.load(std::memory_order_relaxed); }
+
+// Turns collection on or off; returns the previous setting.
+bool stats_enable(bool on);
+
+// Id of the command called `name`, registering it on first use. Bindings
+// that share a name (overloads) share an id.
+int stats_register(const char* name);
+
+// The command the calling thread is running (-1 for none), and a way to
+// set it for threads that work on a command's behalf.
+int stats_current_command();
+void stats_set_command(int command);
+
+void stats_add_bytes(uint64_t n);
+void stats_add_syscalls(uint64_t n);
+
+inline void stats_bytes(uint64_t n) {
+    if (stats_enabled()) stats_add_bytes(n);
+}
+
+inline void stats_syscalls(uint64_t n = 1) {
+    if (stats_enabled()) stats_add_syscalls(n);
+}
+
+// Totals since the last reset, for every command called at least once.
+// With reset, the next snapshot starts from zero.
+std::vector<CommandStats> stats_snapshot(bool reset = false);
+
+// Records one call of `command` on this thread: the command is current for
+// the scope's lifetime, and its latency is added when the scope ends.
+class StatsScope {
+public:
+    explicit StatsScope(int command);
+    ~StatsScope();
+
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+
+private:
+    int command_;
+    int previous_;
+    int64_t start_ns_ = -1;     // -1 when collection was off at the start
+};
+
+// Wraps a command implementation for m.def() so each call is counted under
+// `name`. The wrapper has the same signature, so py::arg lists still apply.
+template <typename R, typename... Args>
+auto counted(const char* name, R (*fn)(Args...)) {
+    int id = stats_register(name);
+    return [id, fn](Args... args) -> R {
+        StatsScope scope(id);
+        return fn(std::forward<Args>(args)...);
+    };
+}
@@ -0,0 +1,143 @@
+#include "thread_pool.h"
+#include "stats.h"
+
+#include <utility>
+
+static thread_local const ThreadPool* tls_pool = nullptr;
+static thread_local int tls_index = -1;
+
+// ---------------------------------------------------------------------------
+// ThreadPool
+// ---------------------------------------------------------------------------
+
+ThreadPool::ThreadPool(size_t threads) : command_(stats_current_command()) {
+    if (threads <= 1)
+        return;
+    for (size_t i = 0; i < threads; i++)
+        queues_.push_back(std::make_unique<Queue>());
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; i++)
+        workers_.emplace_back([this, i] { worker_loop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : workers_)
+        t.join();
+}
+
+size_t ThreadPool::resolve_threads(int requested) {
+    if (requested > 0)
+        return static_cast<size_t>(requested);
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+int ThreadPool::current_worker() const {
+    return tls_pool == this ? tls_index : -1;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    if (workers_.empty()) {
+        pending_.fetch_add(1);
+        run_task(task);
+        pending_.fetch_sub(1);
+        return;
+    }
+
+    size_t target = tls_pool == this
+        ? static_cast<size_t>(tls_index)
+        : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+    pending_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_++;
+    }
+    wake_.notify_one();
+}
+
+void ThreadPool::wait() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_.load() == 0; });
+    }
+    std::exception_ptr err;
+    {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        err = std::exchange(error_, nullptr);
+    }
+    if (err)
+        std::rethrow_exception(err);
+}
+
+bool ThreadPool::try_pop(size_t index, std::function<void()>& task) {
+    bool found = false;
+    {
+        // Own deque first, newest task first
+        Queue& own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    for (size_t k = 1; !found && k < queues_.size(); k++) {
+        // Steal the oldest task of another worker
+        Queue& victim = *queues_[(index + k) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (found) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_--;
+    }
+    return found;
+}
+
+void ThreadPool::run_task(std::function<void()>& task) {
+    try {
+        task();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_)
+            error_ = std::current_exception();
+    }
+}
+
+void ThreadPool::worker_loop(size_t index) {
+    tls_pool = this;
+    tls_index = static_cast<int>(index);
+    stats_set_command(command_);
+
+    for (;;) {
+        std::function<void()> task;
+        if (try_pop(index, task)) {
+            run_task(task);
+            task = nullptr;
+            if (pending_.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0)
+            return;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// ThreadPool — small work-stealing pool for the native command kernels
+//
+// Every worker owns a deque. Tasks submitted from a worker go to the back of
+// its own deque and are popped LIFO, so nested work (e.g. the chunks of a
+// file a worker just opened) stays cache-warm; idle workers steal from the
+// front of other deques. Tasks submitted from outside the pool are spread
+// round-robin.
+//
+// A pool of 0 or 1 threads starts no workers and runs each task inline in
+// submit(), so single-threaded callers pay nothing for going through it.
+//
+// Workers count their syscalls and bytes (common/stats.h) under the command
+// that was running on the thread that created the pool.
+//
+// The pool never touches Python; callers run it inside a
+// py::gil_scoped_release block. The first exception thrown by a task is
+// captured and rethrown from wait().
+// ---------------------------------------------------------------------------
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished, then rethrows the
+    // first exception a task raised, if any.
+    void wait();
+
+    // Number of worker threads (0 when tasks run inline).
+    size_t size() const { return workers_.size(); }
+
+    // Index of the calling worker in [0, size()), or -1 when called from a
+    // thread that does not belong to this pool.
+    int current_worker() const;
+
+    // Maps a user-facing `threads=` argument to a thread count: values <= 0
+    // mean one thread per hardware core.
+    static size_t resolve_threads(int requested);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void worker_loop(size_t index);
+    bool try_pop(size_t index, std::function<void()>& task);
+    void run_task(std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_queue_{0};
+    std::atomic<size_t> pending_{0};
+    int command_;                    // stats command of the creating thread
+
+    std::mutex mutex_;               // guards queued_, stop_ and the condvars
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    size_t queued_ = 0;
+    bool stop_ = false;
+
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+};
@@ -0,0 +1,546 @@
+#include "copy_engine.h"
+#include "walker.h"
+#include "common/stats.h"
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Bytes per copy_file_range / sendfile call, so progress and cancellation
+// stay responsive on multi-GB files.
+static constexpr size_t kCopyChunk = 8 << 20;
+static constexpr size_t kCopyBuffer = 1 << 20;
+static constexpr auto kProgressInterval = std::chrono::milliseconds(100);
+
+namespace {
+
+enum class CopyMethod : uint8_t { reflink, copy_file_range, sendfile, read_write };
+
+std::runtime_error copy_error(const std::string& what, const std::string& path, int err) {
+    return std::runtime_error(what + " '" + path + "': " + std::strerror(err));
+}
+
+// errno values with which a kernel copy mechanism declines a pair of files
+// (as opposed to an I/O error), so the next mechanism should be tried.
+bool declined(int err) {
+    return err == ENOSYS || err == EXDEV || err == EINVAL || err == EOPNOTSUPP ||
+           err == ENOTSUP || err == EBADF || err == ETXTBSY;
+}
+
+// Access and modification times of `st`, as utimensat() takes them.
+void file_times(const FileStat& st, struct timespec ts[2]) {
+    ts[0].tv_sec = static_cast<time_t>(st.atime_sec);
+    ts[0].tv_nsec = static_cast<long>(st.atime_nsec);
+    ts[1].tv_sec = static_cast<time_t>(st.mtime_sec);
+    ts[1].tv_nsec = static_cast<long>(st.mtime_nsec);
+}
+
+struct FdGuard {
+    int fd;
+    ~FdGuard() {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Shared state of one copy
+// ---------------------------------------------------------------------------
+
+class CopyState {
+public:
+    explicit CopyState(const CopyOptions& opts) : opts(opts) {}
+
+    const CopyOptions& opts;
+    std::atomic<bool> stop{false};          // an error or a cancel
+    std::atomic<bool> cancelled{false};
+
+    std::atomic<uint64_t> files{0};
+    std::atomic<uint64_t> dirs{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> by_method[4] = {};
+
+    void add_bytes(uint64_t n) {
+        bytes.fetch_add(n, std::memory_order_relaxed);
+        report(false);
+    }
+
+    void file_done(CopyMethod method) {
+        files.fetch_add(1, std::memory_order_relaxed);
+        by_method[static_cast<int>(method)].fetch_add(1, std::memory_order_relaxed);
+        report(false);
+    }
+
+    // Calls the progress callback if it is due (or `final`). Other threads
+    // skip rather than wait while one is reporting.
+    void report(bool final) {
+        if (!opts.progress)
+            return;
+        std::unique_lock<std::mutex> lock(report_mutex_, std::defer_lock);
+        if (final) {
+            lock.lock();
+        } else if (!lock.try_lock()) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (!final && now - last_report_ < kProgressInterval)
+            return;
+        last_report_ = now;
+        if (!opts.progress(files.load(), bytes.load())) {
+            cancelled = true;
+            stop = true;
+        }
+    }
+
+    // Set after the first error or a cancel; remaining work returns early
+    // instead of starting new copies.
+    bool stopping() const { return stop.load(std::memory_order_relaxed); }
+
+    CopyStats stats() const {
+        CopyStats s;
+        s.files = files;
+        s.dirs = dirs;
+        s.bytes = bytes;
+        s.reflinked = by_method[0];
+        s.copy_file_range = by_method[1];
+        s.sendfile = by_method[2];
+        s.read_write = by_method[3];
+        return s;
+    }
+
+private:
+    std::mutex report_mutex_;
+    std::chrono::steady_clock::time_point last_report_{};
+};
+
+// ---------------------------------------------------------------------------
+// File data
+// ---------------------------------------------------------------------------
+
+// Copies [off, off + len) of `in` to the same offsets of `out`, starting
+// with `method` and stepping down whenever a mechanism declines. Returns
+// false if the copy was stopped.
+bool copy_range(int in, int out, uint64_t off, uint64_t len, CopyMethod& method,
+                CopyState& state, const std::string& src, const std::string& dst) {
+    static thread_local std::unique_ptr<char[]> buffer;
+    uint64_t end = off + len;
+
+    while (off < end) {
+        if (state.stopping())
+            return false;
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(end - off, kCopyChunk));
+        ssize_t n;
+
+        if (method == CopyMethod::copy_file_range) {
+            loff_t in_off = static_cast<loff_t>(off), out_off = static_cast<loff_t>(off);
+            n = copy_file_range(in, &in_off, out, &out_off, chunk, 0);
+            stats_syscalls();
+            if (n < 0 && declined(errno)) {
+                method = CopyMethod::sendfile;
+                continue;
+            }
+        } else if (method == CopyMethod::sendfile) {
+            off_t in_off = static_cast<off_t>(off);
+            if (lseek(out, static_cast<off_t>(off), SEEK_SET) < 0)
+                throw copy_error("cannot seek in", dst, errno);
+            n = sendfile(out, in, &in_off, chunk);
+            stats_syscalls(2);      // with the lseek
+            if (n < 0 && declined(errno)) {
+                method = CopyMethod::read_write;
+                posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+                continue;
+            }
+        } else {
+            if (!buffer)
+                buffer.reset(new char[kCopyBuffer]);
+            chunk = std::min(chunk, kCopyBuffer);
+            n = pread(in, buffer.get(), chunk, static_cast<off_t>(off));
+            stats_syscalls();
+            if (n > 0) {
+                ssize_t written = 0;
+                while (written < n) {
+                    ssize_t w = pwrite(out, buffer.get() + written, static_cast<size_t>(n - written),
+                                       static_cast<off_t>(off) + written);
+                    stats_syscalls();
+                    if (w < 0 && errno == EINTR) continue;
+                    if (w < 0) throw copy_error("error writing", dst, errno);
+                    written += w;
+                }
+                // Large copies should not push everything else out of the
+                // page cache.
+                posix_fadvise(in, static_cast<off_t>(off), n, POSIX_FADV_DONTNEED);
+            } else if (n < 0 && errno != EINTR) {
+                throw copy_error("error reading", src, errno);
+            }
+        }
+
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw copy_error("error copying", src, errno);
+        }
+        if (n == 0) {
+            // Kernel copies can report 0 for files they cannot handle; only
+            // a plain read of 0 means the source really ended (it shrank).
+            if (method == CopyMethod::read_write)
+                break;
+            method = method == CopyMethod::copy_file_range ? CopyMethod::sendfile
+                                                            : CopyMethod::read_write;
+            continue;
+        }
+        off += static_cast<uint64_t>(n);
+        state.add_bytes(static_cast<uint64_t>(n));
+        stats_bytes(static_cast<uint64_t>(n));
+    }
+    return true;
+}
+
+// Copies the contents of `in` (whose stat is `st`) into the empty `out`.
+// Returns the first mechanism that moved data.
+CopyMethod copy_data(int in, int out, const struct stat& st, CopyState& state,
+                     const std::string& src, const std::string& dst) {
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+    if (size > 0 && ioctl(out, FICLONE, in) == 0) {
+        state.add_bytes(size);
+        return CopyMethod::reflink;
+    }
+
+    CopyMethod method = CopyMethod::copy_file_range;
+    if (size == 0) {
+        // Possibly a pseudo-file that reports no size (procfs); read to EOF.
+        method = CopyMethod::read_write;
+        copy_range(in, out, 0, UINT64_MAX / 2, method, state, src, dst);
+        return method;
+    }
+
+    CopyMethod first = method;
+    bool first_set = false;
+    auto copy_extent = [&](uint64_t off, uint64_t len) {
+        bool ok = copy_range(in, out, off, len, method, state, src, dst);
+        if (!first_set) {
+            first = method;
+            first_set = true;
+        }
+        return ok;
+    };
+
+    bool sparse = static_cast<uint64_t>(st.st_blocks) * 512 < size;
+    if (!sparse) {
+        copy_extent(0, size);
+        return first;
+    }
+
+    // Copy only the data extents; the holes between them are left unwritten
+    // and the final size is set with ftruncate.
+    uint64_t pos = 0;
+    while (pos < size) {
+        off_t data = lseek(in, static_cast<off_t>(pos), SEEK_DATA);
+        if (data < 0) {
+            if (errno == ENXIO)
+                break;      // only a hole remains
+            // SEEK_DATA unsupported: copy everything from here.
+            copy_extent(pos, size - pos);
+            pos = size;
+            break;
+        }
+        off_t hole = lseek(in, data, SEEK_HOLE);
+        if (hole < 0)
+            hole = static_cast<off_t>(size);
+        uint64_t from = static_cast<uint64_t>(data);
+        uint64_t to = std::min<uint64_t>(static_cast<uint64_t>(hole), size);
+        state.add_bytes(from - pos);    // the skipped hole
+        if (!copy_extent(from, to - from))
+            return first;
+        pos = to;
+    }
+    if (pos < size)
+        state.add_bytes(size - pos);
+    if (ftruncate(out, static_cast<off_t>(size)) != 0)
+        throw copy_error("cannot extend", dst, errno);
+    return first;
+}
+
+// Copies one regular file (following a symlink at `src`) to `dst`.
+void copy_file(const std::string& src, const std::string& dst, CopyState& state) {
+    if (state.stopping())
+        return;
+    int in = ::open(src.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0)
+        throw copy_error("cannot open", src, errno);
+    FdGuard in_guard{in};
+    struct stat st;
+    if (fstat(in, &st) != 0)
+        throw copy_error("cannot stat", src, errno);
+
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (state.opts.overwrite ? O_TRUNC : O_EXCL);
+    int out = ::open(dst.c_str(), flags, 0600);
+    if (out < 0)
+        throw copy_error("cannot create regular file", dst, errno);
+    FdGuard out_guard{out};
+
+    CopyMethod method = copy_data(in, out, st, state, src, dst);
+    if (fchmod(out, st.st_mode & 07777) != 0)
+        throw copy_error("cannot set permissions of", dst, errno);
+    if (state.opts.preserve_times) {
+        struct timespec ts[2] = {st.st_atim, st.st_mtim};
+        if (futimens(out, ts) != 0)
+            throw copy_error("cannot set times of", dst, errno);
+    }
+    out_guard.fd = -1;
+    if (::close(out) != 0)      // NFS reports write errors here
+        throw copy_error("error writing", dst, errno);
+    if (!state.stopping())
+        state.file_done(method);
+}
+
+// Creates a symlink to `target` at `dst`; `st` is the source link's own
+// metadata, for preserve_times.
+void copy_symlink(const std::string& target, const std::string& dst, CopyState& state,
+                  const FileStat* st) {
+    if (symlink(target.c_str(), dst.c_str()) != 0 &&
+        !(errno == EEXIST && state.opts.overwrite && unlink(dst.c_str()) == 0 &&
+          symlink(target.c_str(), dst.c_str()) == 0))
+        throw copy_error("cannot create symbolic link", dst, errno);
+    if (state.opts.preserve_times && st) {
+        // Not every filesystem keeps symlink times; like cp -p, ignore that.
+        struct timespec ts[2];
+        file_times(*st, ts);
+        utimensat(AT_FDCWD, dst.c_str(), ts, AT_SYMLINK_NOFOLLOW);
+    }
+}
+
+std::string read_link_at(int dir_fd, const std::string& name, const std::string& path) {
+    char buf[PATH_MAX];
+    ssize_t len = readlinkat(dir_fd, name.c_str(), buf, sizeof(buf));
+    if (len < 0)
+        throw copy_error("cannot read symbolic link", path, errno);
+    return std::string(buf, static_cast<size_t>(len));
+}
+
+// ---------------------------------------------------------------------------
+// Trees
+// ---------------------------------------------------------------------------
+
+class CopyVisitor : public WalkVisitor {
+public:
+    CopyVisitor(ThreadPool& pool, CopyState& state) : pool_(pool), state_(state) {}
+
+    void* root_state(const std::string& dst) { return &dst_dirs_.emplace_back(dst); }
+
+    bool visit(const WalkEntry& e, void* dir) override {
+        if (state_.stopping())
+            return false;
+        const std::string& dst_dir = *static_cast<std::string*>(dir);
+        std::string dst = join_path(dst_dir, e.name());
+
+        switch (e.type()) {
+            case EntryType::dir: {
+                const FileStat* st = e.stat();
+                if (!st)
+                    throw copy_error("cannot stat", e.path(), ENOENT);
+                make_dir(dst, *st);
+                return true;
+            }
+            case EntryType::symlink:
+                if (!state_.opts.copy_symlinks && e.target_type() == EntryType::file) {
+                    submit_file(e.path(), std::move(dst));
+                } else {
+                    std::string name(e.name());
+                    copy_symlink(read_link_at(e.dir_fd(), name, e.path()), dst, state_,
+                                 e.stat());
+                }
+                return false;
+            case EntryType::file:
+                submit_file(e.path(), std::move(dst));
+                return false;
+            default: {
+                const FileStat* st = e.stat();
+                if (!st)
+                    throw copy_error("cannot stat", e.path(), ENOENT);
+                auto dev = static_cast<dev_t>(st->rdev);
+                if (mknod(dst.c_str(), st->mode, dev) != 0 &&
+                    !(errno == EEXIST && state_.opts.overwrite && unlink(dst.c_str()) == 0 &&
+                      mknod(dst.c_str(), st->mode, dev) == 0))
+                    throw copy_error("cannot create special file", dst, errno);
+                if (state_.opts.preserve_times) {
+                    struct timespec ts[2];
+                    file_times(*st, ts);
+                    if (utimensat(AT_FDCWD, dst.c_str(), ts, 0) != 0)
+                        throw copy_error("cannot set times of", dst, errno);
+                }
+                return false;
+            }
+        }
+    }
+
+    void* enter(const WalkEntry& e, void* parent) override {
+        std::string dst = join_path(*static_cast<std::string*>(parent), e.name());
+        std::lock_guard<std::mutex> lock(mutex_);
+        return &dst_dirs_.emplace_back(std::move(dst));
+    }
+
+    // Copying silently past an unreadable directory would lose data.
+    void error(const std::string& path, int err) override {
+        throw copy_error("cannot read directory", path, err);
+    }
+
+    // Creates `dst` (a no-op for an existing directory). Its mode (and
+    // times) are set after the copy, so a read-only source directory can
+    // still be filled.
+    void make_dir(const std::string& dst, const FileStat& st) {
+        if (mkdir(dst.c_str(), 0700) != 0) {
+            struct stat st;
+            if (errno == EEXIST && stat(dst.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+                return;
+            throw copy_error("cannot create directory", dst, errno);
+        }
+        state_.dirs.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex_);
+        dir_modes_.emplace_back(dst, st);
+    }
+
+    // Deepest first, so no directory loses search permission before its
+    // children are done.
+    void apply_dir_modes() {
+        for (auto it = dir_modes_.rbegin(); it != dir_modes_.rend(); ++it) {
+            const std::string& path = it->first;
+            if (chmod(path.c_str(), it->second.mode & 07777) != 0)
+                throw copy_error("cannot set permissions of", path, errno);
+            if (state_.opts.preserve_times) {
+                struct timespec ts[2];
+                file_times(it->second, ts);
+                if (utimensat(AT_FDCWD, path.c_str(), ts, 0) != 0)
+                    throw copy_error("cannot set times of", path, errno);
+            }
+        }
+    }
+
+private:
+    void submit_file(std::string src, std::string dst) {
+        CopyState* state = &state_;
+        pool_.submit([state, src = std::move(src), dst = std::move(dst)] {
+            try {
+                copy_file(src, dst, *state);
+            } catch (...) {
+                state->stop = true;
+                throw;
+            }
+        });
+    }
+
+    ThreadPool& pool_;
+    CopyState& state_;
+    std::mutex mutex_;
+    std::deque<std::string> dst_dirs_;      // deque: states stay put as it grows
+    std::vector<std::pair<std::string, FileStat>> dir_modes_;
+};
+
+// Absolute, symlink-free form of a path that may not exist yet.
+std::string resolve_path(const std::string& path) {
+    if (char* real = realpath(path.c_str(), nullptr)) {
+        std::string out(real);
+        std::free(real);
+        return out;
+    }
+    std::string p = path;
+    while (p.size() > 1 && p.back() == '/')
+        p.pop_back();
+    size_t slash = p.rfind('/');
+    std::string parent = slash == std::string::npos ? "." : (slash == 0 ? "/" : p.substr(0, slash));
+    std::string name = slash == std::string::npos ? p : p.substr(slash + 1);
+    if (char* real = realpath(parent.c_str(), nullptr)) {
+        std::string out = join_path(real, name);
+        std::free(real);
+        return out;
+    }
+    return p;
+}
+
+std::string base_name(const std::string& path) {
+    std::string p = path;
+    while (p.size() > 1 && p.back() == '/')
+        p.pop_back();
+    size_t slash = p.rfind('/');
+    return slash == std::string::npos ? p : p.substr(slash + 1);
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// copy_path
+// ---------------------------------------------------------------------------
+
+CopyStats copy_path(const std::string& src, const std::string& dst, bool recursive,
+                    ThreadPool& pool, const CopyOptions& opts) {
+    CopyState state(opts);
+
+    FileStat lst, st;
+    int err = stat_at(AT_FDCWD, src.c_str(), false, lst);
+    if (err != 0)
+        throw copy_error("cannot stat", src, err);
+    bool is_link = lst.type() == EntryType::symlink;
+    bool dangling = is_link && stat_at(AT_FDCWD, src.c_str(), true, st) != 0;
+    if (!is_link)
+        st = lst;
+
+    FileStat dst_st;
+    bool dst_exists = stat_at(AT_FDCWD, dst.c_str(), true, dst_st) == 0;
+    bool dst_is_dir = dst_exists && dst_st.type() == EntryType::dir;
+
+    if (is_link && (opts.copy_symlinks || dangling)) {
+        std::string target = dst_is_dir ? join_path(dst, base_name(src)) : dst;
+        std::string name = src;
+        copy_symlink(read_link_at(AT_FDCWD, name, src), target, state, &lst);
+        return state.stats();
+    }
+
+    if (st.type() != EntryType::dir) {
+        std::string target = dst_is_dir ? join_path(dst, base_name(src)) : dst;
+        FileStat target_st;
+        if (stat_at(AT_FDCWD, target.c_str(), true, target_st) == 0 &&
+            target_st.dev == st.dev && target_st.ino == st.ino)
+            throw std::runtime_error("'" + src + "' and '" + target + "' are the same file");
+        if (st.type() != EntryType::file)
+            throw std::runtime_error("cannot copy special file '" + src + "'");
+        copy_file(src, target, state);
+        state.report(true);
+        if (state.cancelled)
+            throw CopyCancelled();
+        return state.stats();
+    }
+
+    if (!recursive)
+        throw std::runtime_error("-r not specified; omitting directory '" + src + "'");
+    if (dst_exists && !dst_is_dir)
+        throw std::runtime_error("cannot overwrite non-directory '" + dst +
+                                 "' with directory '" + src + "'");
+    std::string real_src = resolve_path(src);
+    std::string real_dst = resolve_path(dst);
+    if (real_dst == real_src || real_dst.compare(0, real_src.size() + 1, real_src + "/") == 0)
+        throw std::runtime_error("cannot copy a directory, '" + src + "', into itself, '" +
+                                 dst + "'");
+
+    CopyVisitor visitor(pool, state);
+    visitor.make_dir(dst, st);
+    walk_tree(src, pool, WalkOptions(), visitor, visitor.root_state(dst));
+    visitor.apply_dir_modes();
+    state.report(true);
+    if (state.cancelled)
+        throw CopyCancelled();
+    return state.stats();
+}
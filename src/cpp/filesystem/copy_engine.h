@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+class ThreadPool;
+
+// ---------------------------------------------------------------------------
+// Copy engine behind cp
+//
+// File data is copied with the cheapest mechanism the filesystems allow,
+// falling back per file (and mid-file, from the offset reached) when one is
+// refused:
+//
+//   reflink           ioctl(FICLONE): shares extents on btrfs, XFS, bcachefs
+//                     and similar; no data is copied at all.
+//   copy_file_range   in-kernel copy; server-side on NFS 4.2 and SMB.
+//   sendfile          in-kernel copy where copy_file_range is unsupported
+//                     (older kernels, some cross-filesystem pairs).
+//   read/write        1 MiB buffers with POSIX_FADV_SEQUENTIAL, dropping
+//                     the source pages behind the copy.
+//
+// Sparse files (fewer allocated blocks than their size) are copied extent
+// by extent with SEEK_DATA / SEEK_HOLE, so holes stay holes.
+//
+// Directory trees are read by the parallel walker, and each regular file is
+// its own task on the pool, so many small files are copied concurrently.
+// Permission bits are copied; directories get theirs after their contents.
+// Inside a tree, symlinks to directories are recreated as symlinks (like
+// cp -R), and special files are recreated with mknod.
+// ---------------------------------------------------------------------------
+
+struct CopyOptions {
+    bool overwrite = false;         // replace existing files
+    bool copy_symlinks = false;     // recreate symlinks to files too
+    bool preserve_times = false;    // copy access and modification times
+
+    // Called with running totals (files completed, bytes copied) at most
+    // every 100 ms and once at the end, from whichever thread made progress,
+    // never from two at once. Return false to cancel.
+    std::function<bool(uint64_t files, uint64_t bytes)> progress;
+};
+
+struct CopyStats {
+    uint64_t files = 0;
+    uint64_t dirs = 0;
+    uint64_t bytes = 0;
+    // Files by the first mechanism that copied their data.
+    uint64_t reflinked = 0;
+    uint64_t copy_file_range = 0;
+    uint64_t sendfile = 0;
+    uint64_t read_write = 0;
+};
+
+// Thrown when the progress callback asks to stop.
+class CopyCancelled : public std::runtime_error {
+public:
+    CopyCancelled() : std::runtime_error("cancelled") {}
+};
+
+// Copies `src` to `dst` like cp: a file (or a symlink to one) goes to `dst`,
+// or into `dst` when that is a directory; a directory needs `recursive` and
+// is copied onto `dst`, which is created if missing. Throws
+// std::runtime_error on the first failure (files copied by then stay).
+CopyStats copy_path(const std::string& src, const std::string& dst, bool recursive,
+                    ThreadPool& pool, const CopyOptions& opts);
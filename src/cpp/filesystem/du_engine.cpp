@@ -0,0 +1,388 @@
+#include "du_engine.h"
+#include "walker.h"
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kCacheMagic[] = "shellfast-du 1\n";
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// InodeSet — (dev, inode) pairs already counted
+// ---------------------------------------------------------------------------
+
+// Only multiply-linked inodes are inserted, so the set stays small; it is
+// split into independently locked open-addressing tables so walk threads
+// rarely wait on each other.
+class InodeSet {
+public:
+    // True the first time (dev, ino) is inserted.
+    bool insert(uint64_t dev, uint64_t ino) {
+        uint64_t h = hash(dev, ino);
+        Shard& s = shards_[h % kShards];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if ((s.used + 1) * 2 > s.slots.size())
+            grow(s);
+        size_t mask = s.slots.size() - 1;
+        for (size_t i = (h / kShards) & mask;; i = (i + 1) & mask) {
+            Key& k = s.slots[i];
+            if (!k.used) {
+                k = Key{dev, ino, true};
+                s.used++;
+                return true;
+            }
+            if (k.dev == dev && k.ino == ino)
+                return false;
+        }
+    }
+
+private:
+    static constexpr size_t kShards = 64;
+
+    struct Key {
+        uint64_t dev = 0;
+        uint64_t ino = 0;
+        bool used = false;
+    };
+    struct Shard {
+        std::mutex mutex;
+        std::vector<Key> slots;
+        size_t used = 0;
+    };
+
+    static uint64_t hash(uint64_t dev, uint64_t ino) {
+        uint64_t h = ino * 0x9E3779B97F4A7C15ULL ^ (dev + 0x632BE59BD9B4E019ULL);
+        h ^= h >> 29;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        return h ^ (h >> 32);
+    }
+
+    static void grow(Shard& s) {
+        std::vector<Key> old = std::move(s.slots);
+        s.slots.assign(std::max<size_t>(16, old.size() * 2), Key());
+        size_t mask = s.slots.size() - 1;
+        for (const Key& k : old) {
+            if (!k.used) continue;
+            size_t i = (hash(k.dev, k.ino) / kShards) & mask;
+            while (s.slots[i].used) i = (i + 1) & mask;
+            s.slots[i] = k;
+        }
+    }
+
+    Shard shards_[kShards];
+};
+
+// ---------------------------------------------------------------------------
+// Cache file
+// ---------------------------------------------------------------------------
+
+// What is remembered about one directory.
+struct CachedDir {
+    int64_t mtime_sec = 0;
+    uint32_t mtime_nsec = 0;
+    uint64_t ino = 0;
+    uint64_t dev = 0;
+    uint64_t bytes = 0;                 // entries, excluding subdirectories
+    std::vector<std::string> subdirs;
+};
+
+using DuCache = std::unordered_map<std::string, CachedDir>;
+
+// Bounds-checked reader over the loaded cache file.
+class CacheReader {
+public:
+    explicit CacheReader(const std::string& data) : data_(data) {}
+
+    template <typename T>
+    bool get(T& out) {
+        if (data_.size() - pos_ < sizeof(T)) return false;
+        std::memcpy(&out, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool get(std::string& out) {
+        uint32_t len;
+        if (!get(len) || data_.size() - pos_ < len) return false;
+        out.assign(data_, pos_, len);
+        pos_ += len;
+        return true;
+    }
+
+    bool expect(std::string_view literal) {
+        if (data_.compare(pos_, literal.size(), literal) != 0) return false;
+        pos_ += literal.size();
+        return true;
+    }
+
+private:
+    const std::string& data_;
+    size_t pos_ = 0;
+};
+
+// Loads the cache for (root, apparent); any mismatch or damage gives an
+// empty cache, so the scan simply starts from scratch.
+DuCache load_cache(const std::string& path, const std::string& root, bool apparent) {
+    DuCache cache;
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return cache;
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    CacheReader r(data);
+    uint8_t mode;
+    std::string cached_root;
+    uint64_t count;
+    if (!r.expect(kCacheMagic) || !r.get(mode) || mode != (apparent ? 1 : 0) ||
+        !r.get(cached_root) || cached_root != root || !r.get(count))
+        return cache;
+
+    for (uint64_t i = 0; i < count; i++) {
+        std::string dir_path;
+        CachedDir dir;
+        uint32_t nsub;
+        if (!r.get(dir_path) || !r.get(dir.mtime_sec) || !r.get(dir.mtime_nsec) ||
+            !r.get(dir.ino) || !r.get(dir.dev) || !r.get(dir.bytes) || !r.get(nsub))
+            return DuCache();
+        dir.subdirs.resize(nsub);
+        for (auto& name : dir.subdirs) {
+            if (!r.get(name))
+                return DuCache();
+        }
+        cache.emplace(std::move(dir_path), std::move(dir));
+    }
+    return cache;
+}
+
+template <typename T>
+void put(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void put(std::string& out, std::string_view s) {
+    put(out, static_cast<uint32_t>(s.size()));
+    out.append(s.data(), s.size());
+}
+
+// ---------------------------------------------------------------------------
+// The walk
+// ---------------------------------------------------------------------------
+
+struct DirSlot {
+    std::string path;
+    size_t index = 0;
+    size_t parent = 0;
+    uint64_t self_bytes = 0;        // the directory inode (blocks mode)
+    uint64_t entries = 0;           // its entries, excluding subdirectories
+    uint64_t total = 0;             // after rollup
+
+    // Cache bookkeeping
+    bool has_key = false;
+    bool from_cache = false;
+    int64_t mtime_sec = 0;
+    uint32_t mtime_nsec = 0;
+    uint64_t ino = 0;
+    uint64_t dev = 0;
+    std::vector<std::string> subdirs;
+};
+
+class DuWalk : public WalkVisitor {
+public:
+    DuWalk(const std::string& root, const DuOptions& opts, const DuCache& cache)
+        : root_(root), apparent_(opts.apparent), caching_(!opts.cache_path.empty()),
+          cache_(cache) {}
+
+    DirSlot& add_root(std::string path, const FileStat& st) {
+        slots_.emplace_back();
+        DirSlot& slot = slots_.back();
+        slot.path = std::move(path);
+        if (!apparent_)
+            slot.self_bytes = st.blocks * 512;
+        return slot;
+    }
+
+    bool visit(const WalkEntry& e, void* state) override {
+        DirSlot* dir = static_cast<DirSlot*>(state);
+        if (e.is_dir()) {
+            if (caching_)
+                dir->subdirs.emplace_back(e.name());
+            return true;
+        }
+        const FileStat* st;
+        if (apparent_) {
+            if (e.target_type() != EntryType::file)
+                return true;
+            st = e.target_stat();
+        } else {
+            st = e.stat();
+        }
+        if (!st)
+            return true;
+        if (st->nlink > 1 && !inodes_.insert(st->dev, st->ino))
+            return true;
+        dir->entries += apparent_ ? st->size : st->blocks * 512;
+        return true;
+    }
+
+    void* enter(const WalkEntry& e, void* parent) override {
+        uint64_t self = 0;
+        if (!apparent_) {
+            if (const FileStat* st = e.stat())
+                self = st->blocks * 512;
+        }
+        std::string path = e.path();
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_.emplace_back();
+        DirSlot& slot = slots_.back();
+        slot.path = std::move(path);
+        slot.index = slots_.size() - 1;
+        slot.parent = static_cast<DirSlot*>(parent)->index;
+        slot.self_bytes = self;
+        return &slot;
+    }
+
+    void error(const std::string& path, int err) override {
+        if (path == root_)
+            throw std::runtime_error("cannot read directory '" + path + "': " +
+                                     std::strerror(err));
+    }
+
+    bool cached_listing(const std::string&, int dir_fd, void* state,
+                        std::vector<std::string>& names) override {
+        if (!caching_)
+            return false;
+        DirSlot* dir = static_cast<DirSlot*>(state);
+        struct stat st;
+        if (fstat(dir_fd, &st) != 0)
+            return false;
+        dir->has_key = true;
+        dir->mtime_sec = st.st_mtim.tv_sec;
+        dir->mtime_nsec = static_cast<uint32_t>(st.st_mtim.tv_nsec);
+        dir->ino = static_cast<uint64_t>(st.st_ino);
+        dir->dev = static_cast<uint64_t>(st.st_dev);
+
+        auto it = cache_.find(dir->path);
+        if (it == cache_.end())
+            return false;
+        const CachedDir& c = it->second;
+        if (c.mtime_sec != dir->mtime_sec || c.mtime_nsec != dir->mtime_nsec ||
+            c.ino != dir->ino || c.dev != dir->dev)
+            return false;
+        dir->entries = c.bytes;
+        dir->from_cache = true;
+        names = c.subdirs;
+        return true;
+    }
+
+    std::deque<DirSlot>& slots() { return slots_; }
+
+private:
+    const std::string& root_;
+    bool apparent_;
+    bool caching_;
+    const DuCache& cache_;
+    InodeSet inodes_;
+    std::mutex mutex_;
+    std::deque<DirSlot> slots_;     // deque: slots stay put as it grows
+};
+
+void save_cache(const std::string& path, const std::string& root, bool apparent,
+                const std::deque<DirSlot>& slots) {
+    std::string out(kCacheMagic);
+    put(out, static_cast<uint8_t>(apparent ? 1 : 0));
+    put(out, std::string_view(root));
+    uint64_t count = 0;
+    for (const auto& s : slots) count += s.has_key;
+    put(out, count);
+    for (const auto& s : slots) {
+        if (!s.has_key) continue;
+        put(out, std::string_view(s.path));
+        put(out, s.mtime_sec);
+        put(out, s.mtime_nsec);
+        put(out, s.ino);
+        put(out, s.dev);
+        put(out, s.entries);
+        put(out, static_cast<uint32_t>(s.subdirs.size()));
+        for (const auto& name : s.subdirs)
+            put(out, std::string_view(name));
+    }
+
+    // Write beside the target and rename, so a reader never sees half a file.
+    std::string tmp = path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        f.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (!f.flush()) {
+            int err = errno;
+            std::remove(tmp.c_str());
+            throw std::runtime_error("cannot write cache '" + path + "': " + std::strerror(err));
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        int err = errno;
+        std::remove(tmp.c_str());
+        throw std::runtime_error("cannot write cache '" + path + "': " + std::strerror(err));
+    }
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// disk_usage
+// ---------------------------------------------------------------------------
+
+DuResult disk_usage(const std::string& root, ThreadPool& pool, const DuOptions& opts) {
+    FileStat root_st;
+    int err = stat_at(AT_FDCWD, root.c_str(), true, root_st);
+    if (err != 0)
+        throw std::runtime_error("cannot access '" + root + "': " + std::strerror(err));
+
+    std::string root_path = root;
+    while (root_path.size() > 1 && root_path.back() == '/')
+        root_path.pop_back();
+
+    DuCache cache;
+    if (!opts.cache_path.empty())
+        cache = load_cache(opts.cache_path, root_path, opts.apparent);
+
+    DuWalk walk(root, opts, cache);
+    DirSlot& top = walk.add_root(root_path, root_st);
+    walk_tree(root, pool, WalkOptions(), walk, &top);
+
+    // Children always come after their parent, so one reverse pass rolls
+    // every subtree up.
+    std::deque<DirSlot>& slots = walk.slots();
+    for (auto& s : slots)
+        s.total = s.self_bytes + s.entries;
+    for (size_t i = slots.size(); i-- > 1;)
+        slots[slots[i].parent].total += slots[i].total;
+
+    DuResult result;
+    result.total = slots[0].total;
+    result.dirs.reserve(slots.size());
+    for (const auto& s : slots) {
+        result.dirs.push_back(DuDirUsage{s.path, s.total});
+        result.cached_dirs += s.from_cache;
+    }
+    std::sort(result.dirs.begin(), result.dirs.end(),
+              [](const DuDirUsage& a, const DuDirUsage& b) { return a.path < b.path; });
+
+    if (!opts.cache_path.empty())
+        save_cache(opts.cache_path, root_path, opts.apparent, slots);
+    return result;
+}
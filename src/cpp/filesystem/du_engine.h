@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// ---------------------------------------------------------------------------
+// Disk usage engine behind du
+//
+// Walks the tree once on the parallel walker and gives every directory a
+// slot in a flat array that records its parent's index. Children always
+// get higher indices than their parent, so a single reverse pass rolls each
+// subtree total up into its parent.
+//
+// Two ways to count:
+//
+//   apparent   st_size of regular files (symlinks to files count their
+//              target), the old du behaviour.
+//   blocks     st_blocks * 512 of every entry: files, symlinks and the
+//              directories themselves, without following links. Sparse
+//              files count what they actually occupy, like GNU du.
+//
+// Either way an inode with several hard links is counted once: entries with
+// st_nlink > 1 go through a sharded (dev, inode) hash set.
+//
+// With a cache file, each directory's own total (its entries, excluding
+// subdirectories) is stored with the directory's mtime and inode. On the
+// next scan a directory whose mtime is unchanged is not read at all. Its
+// stored total is used, and only its recorded subdirectories are visited.
+// Adding, removing or renaming an entry changes the directory's mtime, but
+// rewriting a file in place does not. A cached scan therefore picks up a
+// grown file once something in its directory changes. Hard links shared
+// between a cached directory and a rescanned one may be counted twice. Use
+// no cache when exact figures matter.
+// ---------------------------------------------------------------------------
+
+struct DuOptions {
+    bool apparent = true;
+    std::string cache_path;     // empty = no cache
+};
+
+struct DuDirUsage {
+    std::string path;
+    uint64_t bytes = 0;         // the whole subtree
+};
+
+struct DuResult {
+    uint64_t total = 0;
+    std::vector<DuDirUsage> dirs;   // every directory, sorted by path
+    size_t cached_dirs = 0;         // directories answered from the cache
+};
+
+// Disk usage of the directory `root` (a symlink root is followed). Throws
+// std::runtime_error if the root cannot be read or the cache cannot be
+// written; an unreadable or stale cache file is ignored.
+DuResult disk_usage(const std::string& root, ThreadPool& pool, const DuOptions& opts);
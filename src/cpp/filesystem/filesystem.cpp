@@ -1,7 +1,16 @@
 #include "filesystem.h"
+#include "walker.h"
+#include "find_filter.h"
+#include "du_engine.h"
+#include "copy_engine.h"
+#include "remove_engine.h"
+#include "common/id_names.h"
+#include "common/stats.h"
+#include "common/thread_pool.h"
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <atomic>
 #include <filesystem>
 #include <string>
 #include <vector>
@@ -11,9 +20,11 @@
 #include <chrono>
 #include <ctime>
 #include <cstring>
+#include <cerrno>
 
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <pwd.h>
 #include <grp.h>
@@ -55,133 +66,274 @@ static std::string permissions_string(fs::perms p) {
     return s;
 }
 
-static std::string format_time(fs::file_time_type ftime) {
-    auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-        ftime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
-    std::time_t tt = std::chrono::system_clock::to_time_t(sctp);
+static std::string file_type_char(EntryType type) {
+    switch (type) {
+        case EntryType::symlink:   return "l";
+        case EntryType::dir:       return "d";
+        case EntryType::block:     return "b";
+        case EntryType::character: return "c";
+        case EntryType::fifo:      return "p";
+        case EntryType::socket:    return "s";
+        default:                   return "-";
+    }
+}
+
+static std::string format_epoch(int64_t seconds) {
+    std::time_t tt = static_cast<std::time_t>(seconds);
+    struct tm tm_buf;
     char buf[64];
-    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", std::localtime(&tt));
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", localtime_r(&tt, &tm_buf));
     return std::string(buf);
 }
 
-static std::string get_owner(const fs::path& p) {
-    struct stat st;
-    if (stat(p.c_str(), &st) == 0) {
-        struct passwd* pw = getpwuid(st.st_uid);
-        return pw ? pw->pw_name : std::to_string(st.st_uid);
-    }
-    return "?";
+static void check_threads(const char* cmd, int threads) {
+    if (threads < 0)
+        throw py::value_error(std::string(cmd) + ": threads must be >= 0");
 }
 
-static std::string get_group(const fs::path& p) {
-    struct stat st;
-    if (stat(p.c_str(), &st) == 0) {
-        struct group* gr = getgrgid(st.st_gid);
-        return gr ? gr->gr_name : std::to_string(st.st_gid);
+// Base for the command visitors: a walk root that cannot be listed is an
+// error for the command, unreadable directories below it are skipped.
+class CommandVisitor : public WalkVisitor {
+public:
+    CommandVisitor(const char* cmd, const std::string& root) : cmd_(cmd), root_(root) {}
+
+    void error(const std::string& path, int err) override {
+        if (path == root_)
+            throw py::value_error(std::string(cmd_) + ": cannot read directory '" +
+                                  path + "': " + std::strerror(err));
     }
-    return "?";
-}
 
-static std::string file_type_char(const fs::directory_entry& e) {
-    if (e.is_symlink()) return "l";
-    if (e.is_directory()) return "d";
-    if (e.is_block_file()) return "b";
-    if (e.is_character_file()) return "c";
-    if (e.is_fifo()) return "p";
-    if (e.is_socket()) return "s";
-    return "-";
-}
+protected:
+    const char* cmd_;
+    const std::string& root_;
+};
 
 // ---------------------------------------------------------------------------
 // ls — List directory contents
 // ---------------------------------------------------------------------------
 
-static py::list ls_impl(const std::string& path,
-                         bool all,
-                         bool long_format,
-                         bool recursive,
-                         const std::string& sort_by,
-                         bool reverse,
-                         bool human_readable,
-                         bool directory_only) {
-    fs::path dir_path(path);
-    if (!fs::exists(dir_path))
-        throw py::value_error("ls: cannot access '" + path + "': No such file or directory");
-
-    std::vector<fs::directory_entry> entries;
-
-    auto collect = [&](auto& iterator) {
-        for (const auto& entry : iterator) {
-            std::string name = entry.path().filename().string();
-            if (!all && !name.empty() && name[0] == '.')
-                continue;
-            if (directory_only && !entry.is_directory())
-                continue;
-            entries.push_back(entry);
+struct LsInfo {
+    std::string name;
+    std::string path;
+    std::string type;
+    bool is_directory;
+    bool is_symlink;
+    std::string permissions;
+    std::string owner;
+    std::string group;
+    std::string last_modified;
+    uintmax_t size;
+    bool has_target;
+    std::string symlink_target;
+};
+
+// What the walk records per entry; names and times are formatted afterwards
+// on one thread, or on demand when the entry is returned as a StatResult.
+struct LsEntry {
+    std::string name;
+    std::string path;
+    EntryType type = EntryType::unknown;
+    bool is_directory = false;      // after following symlinks
+    uint32_t mode = 0;              // of the symlink target, like ls -L
+    uint32_t uid = 0;
+    uint32_t gid = 0;
+    uint32_t nlink = 0;
+    uint64_t ino = 0;
+    int64_t mtime_sec = 0;
+    uint32_t mtime_nsec = 0;
+    uintmax_t size = 0;             // regular files only
+    bool has_target = false;
+    std::string symlink_target;
+
+    // The target of a symlink, read on first use when the walk did not.
+    const std::string& target() {
+        if (type == EntryType::symlink && !has_target) {
+            char buf[PATH_MAX];
+            ssize_t len = readlink(path.c_str(), buf, sizeof(buf));
+            if (len > 0)
+                symlink_target.assign(buf, static_cast<size_t>(len));
+            has_target = true;
         }
-    };
-
-    if (recursive) {
-        auto it = fs::recursive_directory_iterator(
-            dir_path, fs::directory_options::skip_permission_denied);
-        collect(it);
-    } else {
-        auto it = fs::directory_iterator(
-            dir_path, fs::directory_options::skip_permission_denied);
-        collect(it);
+        return symlink_target;
     }
+};
+
+class LsVisitor : public CommandVisitor {
+public:
+    LsVisitor(const std::string& root, bool all, bool directory_only, bool need_stat,
+              bool long_format, bool read_links)
+        : CommandVisitor("ls", root), all_(all), directory_only_(directory_only),
+          need_stat_(need_stat), long_format_(long_format), read_links_(read_links) {}
+
+    bool visit(const WalkEntry& e, void* dir) override {
+        std::string_view name = e.name();
+        if (!all_ && name[0] == '.')
+            return false;
+        bool is_directory = e.target_type() == EntryType::dir;
+        if (directory_only_ && !is_directory)
+            return true;
+
+        LsEntry info;
+        info.name = std::string(name);
+        info.type = e.type();
+        info.is_directory = is_directory;
+        if (long_format_)
+            info.path = e.path();
+        if (need_stat_) {
+            const FileStat* st = e.target_stat();
+            if (!st) st = e.stat();
+            if (st) {
+                info.mode = st->mode;
+                info.uid = st->uid;
+                info.gid = st->gid;
+                info.nlink = st->nlink;
+                info.ino = st->ino;
+                info.mtime_sec = st->mtime_sec;
+                info.mtime_nsec = st->mtime_nsec;
+                if (st->type() == EntryType::file)
+                    info.size = st->size;
+            }
+        }
+        if (read_links_ && e.is_symlink()) {
+            char target[PATH_MAX];
+            std::string n(name);
+            ssize_t len = readlinkat(e.dir_fd(), n.c_str(), target, sizeof(target));
+            info.has_target = true;
+            if (len > 0)
+                info.symlink_target.assign(target, static_cast<size_t>(len));
+        }
+        order_.node(dir).push_back(std::move(info));
+        return true;
+    }
+
+    void* enter(const WalkEntry&, void* parent) override { return order_.child(parent); }
+
+    WalkOrder<LsEntry> order_;
+
+private:
+    bool all_;
+    bool directory_only_;
+    bool need_stat_;
+    bool long_format_;
+    bool read_links_;
+};
+
+// Walks and sorts. With `stat_results` the metadata is recorded but
+// symlinks are only read if their target is asked for.
+static std::vector<LsEntry> ls_entries(const std::string& path,
+                                       bool all,
+                                       bool long_format,
+                                       bool recursive,
+                                       const std::string& sort_by,
+                                       bool reverse,
+                                       bool directory_only,
+                                       int threads,
+                                       bool stat_results) {
+    FileStat root_st;
+    if (stat_at(AT_FDCWD, path.c_str(), true, root_st) != 0)
+        throw py::value_error("ls: cannot access '" + path + "': No such file or directory");
+
+    bool need_stat = long_format || stat_results || sort_by == "size" || sort_by == "time";
+    LsVisitor visitor(path, all, directory_only, need_stat, long_format || stat_results,
+                      long_format && !stat_results);
+    ThreadPool pool(recursive ? ThreadPool::resolve_threads(threads) : 1);
+    WalkOptions opts;
+    opts.max_depth = recursive ? -1 : 1;
+    walk_tree(path, pool, opts, visitor, visitor.order_.root());
+    std::vector<LsEntry> entries = visitor.order_.take();
 
-    // Sort
+    // Sort (stable, so ties keep walk order)
     if (sort_by == "name") {
-        std::sort(entries.begin(), entries.end(),
-                  [](const auto& a, const auto& b) {
-                      return a.path().filename() < b.path().filename();
-                  });
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const LsEntry& a, const LsEntry& b) { return a.name < b.name; });
     } else if (sort_by == "size") {
-        std::sort(entries.begin(), entries.end(),
-                  [](const auto& a, const auto& b) {
-                      uintmax_t sa = a.is_regular_file() ? a.file_size() : 0;
-                      uintmax_t sb = b.is_regular_file() ? b.file_size() : 0;
-                      return sa < sb;
-                  });
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const LsEntry& a, const LsEntry& b) { return a.size < b.size; });
     } else if (sort_by == "time") {
-        std::sort(entries.begin(), entries.end(),
-                  [](const auto& a, const auto& b) {
-                      return a.last_write_time() < b.last_write_time();
-                  });
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const LsEntry& a, const LsEntry& b) {
+                             return a.mtime_sec != b.mtime_sec ? a.mtime_sec < b.mtime_sec
+                                                               : a.mtime_nsec < b.mtime_nsec;
+                         });
     }
 
     if (reverse)
         std::reverse(entries.begin(), entries.end());
+    return entries;
+}
+
+static std::vector<LsInfo> ls_collect(std::vector<LsEntry> entries, bool long_format) {
+    std::vector<LsInfo> infos;
+    infos.reserve(entries.size());
+    for (auto& entry : entries) {
+        LsInfo info;
+        info.name = std::move(entry.name);
+        if (long_format) {
+            info.path          = std::move(entry.path);
+            info.type          = file_type_char(entry.type);
+            info.is_directory  = entry.is_directory;
+            info.is_symlink    = entry.type == EntryType::symlink;
+            info.permissions   = permissions_string(static_cast<fs::perms>(entry.mode & 0777));
+            info.owner         = user_name(entry.uid);
+            info.group         = group_name(entry.gid);
+            info.last_modified = format_epoch(entry.mtime_sec);
+            info.size          = entry.size;
+            info.has_target    = entry.has_target;
+            info.symlink_target = std::move(entry.symlink_target);
+        }
+        infos.push_back(std::move(info));
+    }
+    return infos;
+}
+
+static py::list ls_impl(const std::string& path,
+                         bool all,
+                         bool long_format,
+                         bool recursive,
+                         const std::string& sort_by,
+                         bool reverse,
+                         bool human_readable,
+                         bool directory_only,
+                         int threads,
+                         bool stat) {
+    check_threads("ls", threads);
+    std::vector<LsEntry> entries;
+    std::vector<LsInfo> infos;
+    {
+        py::gil_scoped_release release;
+        entries = ls_entries(path, all, long_format, recursive, sort_by,
+                             reverse, directory_only, threads, stat);
+        if (!stat)
+            infos = ls_collect(std::move(entries), long_format);
+    }
 
     py::list result;
+    if (stat) {
+        for (auto& entry : entries)
+            result.append(py::cast(std::move(entry)));
+        return result;
+    }
 
-    for (const auto& entry : entries) {
+    for (const auto& info : infos) {
         if (long_format) {
-            py::dict info;
-            info["name"]          = entry.path().filename().string();
-            info["path"]          = entry.path().string();
-            info["type"]          = file_type_char(entry);
-            info["is_directory"]  = entry.is_directory();
-            info["is_symlink"]    = entry.is_symlink();
-            info["permissions"]   = permissions_string(entry.status().permissions());
-            info["owner"]         = get_owner(entry.path());
-            info["group"]         = get_group(entry.path());
-            info["last_modified"] = format_time(entry.last_write_time());
-
-            uintmax_t sz = entry.is_regular_file() ? entry.file_size() : 0;
-            info["size"]  = sz;
-            info["size_human"] = human_readable_size(sz);
-
-            if (entry.is_symlink()) {
-                std::error_code ec;
-                auto target = fs::read_symlink(entry.path(), ec);
-                info["symlink_target"] = ec ? "" : target.string();
-            }
-
-            result.append(info);
+            py::dict d;
+            d["name"]          = info.name;
+            d["path"]          = info.path;
+            d["type"]          = info.type;
+            d["is_directory"]  = info.is_directory;
+            d["is_symlink"]    = info.is_symlink;
+            d["permissions"]   = info.permissions;
+            d["owner"]         = info.owner;
+            d["group"]         = info.group;
+            d["last_modified"] = info.last_modified;
+            d["size"]          = info.size;
+            d["size_human"]    = human_readable_size(info.size);
+            if (info.has_target)
+                d["symlink_target"] = info.symlink_target;
+
+            result.append(d);
         } else {
-            result.append(entry.path().filename().string());
+            result.append(info.name);
         }
     }
 
@@ -242,21 +394,46 @@ static void rmdir_impl(const std::string& path) {
 // rm — Remove files and directories
 // ---------------------------------------------------------------------------
 
-static void rm_impl(const std::string& path, bool recursive, bool force) {
-    fs::path target(path);
-    if (!fs::exists(target)) {
+static py::object rm_impl(const std::string& path, bool recursive, bool force,
+                          int threads, bool async_) {
+    check_threads("rm", threads);
+    FileStat st;
+    int err = stat_at(AT_FDCWD, path.c_str(), false, st);
+    if (err == ENOENT) {
         if (!force)
             throw py::value_error("rm: cannot remove '" + path + "': No such file or directory");
-        return;
+        return py::none();
     }
-    if (fs::is_directory(target) && !recursive) {
-        throw py::value_error("rm: cannot remove '" + path + "': Is a directory (use recursive=True)");
+    if (err != 0)
+        throw py::value_error("rm: cannot remove '" + path + "': " + std::strerror(err));
+    if (st.type() == EntryType::dir) {
+        if (!recursive)
+            throw py::value_error("rm: cannot remove '" + path + "': Is a directory (use recursive=True)");
+        FileStat root;
+        if (stat_at(AT_FDCWD, "/", false, root) == 0 && root.dev == st.dev && root.ino == st.ino)
+            throw py::value_error("rm: it is dangerous to operate recursively on '/'");
     }
-    if (recursive) {
-        fs::remove_all(target);
-    } else {
-        fs::remove(target);
+
+    size_t workers = ThreadPool::resolve_threads(threads);
+    if (async_) {
+        std::unique_ptr<BackgroundRemove> handle;
+        {
+            py::gil_scoped_release release;
+            handle = std::make_unique<BackgroundRemove>(path, workers);
+        }
+        return py::cast(std::move(handle));
     }
+
+    {
+        py::gil_scoped_release release;
+        ThreadPool pool(st.type() == EntryType::dir ? workers : 1);
+        try {
+            remove_path(path, pool);
+        } catch (const std::runtime_error& e) {
+            throw py::value_error(std::string("rm: ") + e.what());
+        }
+    }
+    return py::none();
 }
 
 // ---------------------------------------------------------------------------
@@ -280,37 +457,148 @@ static void touch_impl(const std::string& path, bool no_create) {
 // cp — Copy files and directories
 // ---------------------------------------------------------------------------
 
-static void cp_impl(const std::string& src, const std::string& dst,
-                     bool recursive, bool force, bool preserve) {
-    fs::path source(src);
-    fs::path destination(dst);
-
-    if (!fs::exists(source))
-        throw py::value_error("cp: cannot stat '" + src + "': No such file or directory");
+// Forwards copy progress to a Python callable. Called from copy workers,
+// so the GIL is taken just for the call; an exception it raises cancels the
+// copy and is re-raised once the workers are done.
+struct CopyProgressCallback {
+    py::object fn;
+    std::unique_ptr<py::error_already_set> error;
+
+    bool operator()(uint64_t files, uint64_t bytes) {
+        py::gil_scoped_acquire gil;
+        try {
+            fn(bytes, files);
+            return true;
+        } catch (py::error_already_set& e) {
+            error = std::make_unique<py::error_already_set>(std::move(e));
+            return false;
+        }
+    }
+};
 
-    auto options = fs::copy_options::none;
-    if (recursive)   options |= fs::copy_options::recursive;
-    if (force)       options |= fs::copy_options::overwrite_existing;
-    if (preserve)    options |= fs::copy_options::copy_symlinks;
+static void cp_impl(const std::string& src, const std::string& dst,
+                     bool recursive, bool force, bool preserve, int threads,
+                     py::object progress) {
+    check_threads("cp", threads);
+    CopyProgressCallback callback{progress, nullptr};
+    CopyOptions opts;
+    opts.overwrite = force;
+    opts.copy_symlinks = preserve;
+    if (!progress.is_none())
+        opts.progress = [&callback](uint64_t files, uint64_t bytes) {
+            return callback(files, bytes);
+        };
+
+    {
+        py::gil_scoped_release release;
+
+        FileStat st;
+        if (stat_at(AT_FDCWD, src.c_str(), false, st) != 0)
+            throw py::value_error("cp: cannot stat '" + src + "': No such file or directory");
+
+        ThreadPool pool(recursive ? ThreadPool::resolve_threads(threads) : 1);
+        try {
+            copy_path(src, dst, recursive, pool, opts);
+        } catch (const CopyCancelled&) {
+            // The callback raised; re-raised below with the GIL held.
+        } catch (const std::runtime_error& e) {
+            throw py::value_error(std::string("cp: ") + e.what());
+        }
+    }
 
-    fs::copy(source, destination, options);
+    if (callback.error)
+        throw std::move(*callback.error);
 }
 
 // ---------------------------------------------------------------------------
 // mv — Move/rename files
 // ---------------------------------------------------------------------------
 
-static void mv_impl(const std::string& src, const std::string& dst, bool force) {
-    fs::path source(src);
-    fs::path destination(dst);
+// A name beside `dst`, on its filesystem, for a copy to land on before it
+// is renamed over `dst`.
+static std::string mv_temp_path(std::string dst) {
+    static std::atomic<unsigned> counter{0};
+    while (dst.size() > 1 && dst.back() == '/')
+        dst.pop_back();
+    size_t slash = dst.rfind('/');
+    std::string dir = slash == std::string::npos ? "" : dst.substr(0, slash + 1);
+    std::string base = slash == std::string::npos ? dst : dst.substr(slash + 1);
+    for (;;) {
+        std::string tmp = dir + "." + base + ".mv" + std::to_string(getpid()) + "." +
+                          std::to_string(counter++);
+        FileStat st;
+        if (stat_at(AT_FDCWD, tmp.c_str(), false, st) != 0)
+            return tmp;
+    }
+}
 
-    if (!fs::exists(source))
+// Across filesystems rename() fails with EXDEV; the tree is then copied
+// (symlinks as symlinks, with modes and times) to a temporary name beside
+// `dst`, renamed over it, and the source removed. A failed copy is removed
+// again and leaves both the source and an existing `dst` untouched.
+static void mv_impl(const std::string& src, const std::string& dst, bool force,
+                     int threads) {
+    check_threads("mv", threads);
+    FileStat src_st, dst_st;
+    if (stat_at(AT_FDCWD, src.c_str(), false, src_st) != 0)
         throw py::value_error("mv: cannot stat '" + src + "': No such file or directory");
-
-    if (fs::exists(destination) && !force)
+    bool dst_exists = stat_at(AT_FDCWD, dst.c_str(), false, dst_st) == 0;
+    if (dst_exists && !force)
         throw py::value_error("mv: cannot move '" + src + "' to '" + dst + "': Destination exists (use force=True)");
 
-    fs::rename(source, destination);
+    auto fail = [&](int err) {
+        return py::value_error("mv: cannot move '" + src + "' to '" + dst + "': " +
+                               std::strerror(err));
+    };
+    if (rename(src.c_str(), dst.c_str()) == 0)
+        return;
+    if (errno != EXDEV)
+        throw fail(errno);
+
+    bool src_dir = src_st.type() == EntryType::dir;
+    bool dst_dir = dst_exists && dst_st.type() == EntryType::dir;
+    if (dst_exists) {
+        // What rename() would have replaced: a non-directory with a
+        // non-directory, or an empty directory with a directory.
+        if (dst_dir != src_dir)
+            throw fail(dst_dir ? EISDIR : ENOTDIR);
+        std::error_code ec;
+        if (dst_dir && !fs::is_empty(dst, ec))
+            throw fail(ec ? ec.value() : ENOTEMPTY);
+    }
+
+    ThreadPool pool(src_dir ? ThreadPool::resolve_threads(threads) : 1);
+    CopyOptions opts;
+    opts.copy_symlinks = true;
+    opts.preserve_times = true;
+    std::string tmp = mv_temp_path(dst);
+    auto discard_copy = [&] {
+        FileStat tmp_st;
+        if (stat_at(AT_FDCWD, tmp.c_str(), false, tmp_st) != 0)
+            return;
+        try {
+            remove_path(tmp, pool);
+        } catch (const std::runtime_error&) {
+            // Best effort; the error that got us here is the one to report.
+        }
+    };
+    try {
+        copy_path(src, tmp, true, pool, opts);
+    } catch (const std::runtime_error& e) {
+        discard_copy();
+        throw py::value_error(std::string("mv: ") + e.what());
+    }
+    // rename() replaces a file, but a directory only once it is out of the way.
+    if ((dst_dir && rmdir(dst.c_str()) != 0) || rename(tmp.c_str(), dst.c_str()) != 0) {
+        int err = errno;
+        discard_copy();
+        throw fail(err);
+    }
+    try {
+        remove_path(src, pool);
+    } catch (const std::runtime_error& e) {
+        throw py::value_error(std::string("mv: ") + e.what());
+    }
 }
 
 // ---------------------------------------------------------------------------
@@ -335,65 +623,77 @@ static void ln_impl(const std::string& target, const std::string& link_name,
 // find — Search for files
 // ---------------------------------------------------------------------------
 
-static py::list find_impl(const std::string& path,
-                            const std::string& name,
-                            const std::string& type,
-                            long long min_size,
-                            long long max_size,
-                            int max_depth) {
-    fs::path root(path);
-    if (!fs::exists(root))
-        throw py::value_error("find: '" + path + "': No such file or directory");
-
-    py::list results;
-
-    auto matches_name = [&](const fs::directory_entry& entry) -> bool {
-        if (name.empty()) return true;
-        std::string fname = entry.path().filename().string();
-        // Simple glob: support '*' prefix/suffix
-        if (name.front() == '*' && name.back() == '*') {
-            std::string pattern = name.substr(1, name.size() - 2);
-            return fname.find(pattern) != std::string::npos;
-        } else if (name.front() == '*') {
-            std::string suffix = name.substr(1);
-            return fname.size() >= suffix.size() &&
-                   fname.compare(fname.size() - suffix.size(), suffix.size(), suffix) == 0;
-        } else if (name.back() == '*') {
-            std::string prefix = name.substr(0, name.size() - 1);
-            return fname.compare(0, prefix.size(), prefix) == 0;
+class FindVisitor : public CommandVisitor {
+public:
+    FindVisitor(const std::string& root, const FindFilter& filter)
+        : CommandVisitor("find", root), filter_(filter),
+          rel_offset_(root.empty() || root.back() == '/' ? root.size() : root.size() + 1) {}
+
+    bool visit(const WalkEntry& e, void* dir) override {
+        if (filter_.pruned(e))
+            return false;
+        if (filter_.needs_path()) {
+            std::string path = e.path();
+            if (filter_.matches(e, std::string_view(path).substr(rel_offset_)))
+                order_.node(dir).push_back(std::move(path));
+        } else if (filter_.matches(e, std::string_view())) {
+            order_.node(dir).push_back(e.path());
         }
-        return fname == name;
-    };
-
-    auto matches_type = [&](const fs::directory_entry& entry) -> bool {
-        if (type.empty()) return true;
-        if (type == "f") return entry.is_regular_file();
-        if (type == "d") return entry.is_directory();
-        if (type == "l") return entry.is_symlink();
         return true;
-    };
+    }
 
-    auto matches_size = [&](const fs::directory_entry& entry) -> bool {
-        if (!entry.is_regular_file()) return (min_size < 0 && max_size < 0);
-        auto sz = static_cast<long long>(entry.file_size());
-        if (min_size >= 0 && sz < min_size) return false;
-        if (max_size >= 0 && sz > max_size) return false;
-        return true;
-    };
+    void* enter(const WalkEntry&, void* parent) override { return order_.child(parent); }
+
+    WalkOrder<std::string> order_;
+
+private:
+    const FindFilter& filter_;
+    size_t rel_offset_;
+};
+
+static std::vector<std::string> find_impl(const std::string& path,
+                                          const std::string& name,
+                                          const std::string& type,
+                                          long long min_size,
+                                          long long max_size,
+                                          int max_depth,
+                                          int threads,
+                                          const std::string& path_glob,
+                                          const std::string& mtime,
+                                          const std::string& newer,
+                                          const std::string& user,
+                                          const std::string& perm,
+                                          const std::vector<std::string>& prune) {
+    check_threads("find", threads);
+    FileStat root_st;
+    if (stat_at(AT_FDCWD, path.c_str(), true, root_st) != 0)
+        throw py::value_error("find: '" + path + "': No such file or directory");
 
-    for (auto it = fs::recursive_directory_iterator(
-             root, fs::directory_options::skip_permission_denied);
-         it != fs::recursive_directory_iterator(); ++it) {
-        if (max_depth >= 0 && it.depth() > max_depth) {
-            it.disable_recursion_pending();
-            continue;
-        }
-        if (matches_name(*it) && matches_type(*it) && matches_size(*it)) {
-            results.append(it->path().string());
-        }
+    FindQuery query;
+    query.name = name;
+    query.path_glob = path_glob;
+    query.type = type;
+    query.min_size = min_size;
+    query.max_size = max_size;
+    query.mtime = mtime;
+    query.newer = newer;
+    query.user = user;
+    query.perm = perm;
+    query.prune = prune;
+
+    std::unique_ptr<FindFilter> filter;
+    try {
+        filter = std::make_unique<FindFilter>(query);
+    } catch (const std::invalid_argument& e) {
+        throw py::value_error(std::string("find: ") + e.what());
     }
 
-    return results;
+    FindVisitor visitor(path, *filter);
+    ThreadPool pool(ThreadPool::resolve_threads(threads));
+    WalkOptions opts;
+    opts.max_depth = max_depth >= 0 ? max_depth + 1 : -1;
+    walk_tree(path, pool, opts, visitor, visitor.order_.root());
+    return visitor.order_.take();
 }
 
 // ---------------------------------------------------------------------------
@@ -401,47 +701,50 @@ static py::list find_impl(const std::string& path,
 // ---------------------------------------------------------------------------
 
 static py::object du_impl(const std::string& path, bool human_readable,
-                            bool summary_only) {
-    fs::path root(path);
-    if (!fs::exists(root))
-        throw py::value_error("du: cannot access '" + path + "': No such file or directory");
-
-    if (summary_only || fs::is_regular_file(root)) {
-        uintmax_t total = 0;
-        if (fs::is_regular_file(root)) {
-            total = fs::file_size(root);
+                            bool summary_only, int threads, bool apparent,
+                            const std::string& cache) {
+    check_threads("du", threads);
+    bool summary = false;
+    DuResult usage;
+
+    {
+        py::gil_scoped_release release;
+
+        FileStat root_st;
+        if (stat_at(AT_FDCWD, path.c_str(), true, root_st) != 0)
+            throw py::value_error("du: cannot access '" + path + "': No such file or directory");
+
+        bool root_is_dir = root_st.type() == EntryType::dir;
+        summary = summary_only || !root_is_dir;
+        if (!root_is_dir) {
+            usage.total = apparent ? root_st.size : root_st.blocks * 512;
         } else {
-            for (auto& entry : fs::recursive_directory_iterator(
-                     root, fs::directory_options::skip_permission_denied)) {
-                if (entry.is_regular_file())
-                    total += entry.file_size();
+            DuOptions opts;
+            opts.apparent = apparent;
+            opts.cache_path = cache;
+            ThreadPool pool(ThreadPool::resolve_threads(threads));
+            try {
+                usage = disk_usage(path, pool, opts);
+            } catch (const std::runtime_error& e) {
+                throw py::value_error(std::string("du: ") + e.what());
             }
         }
+    }
+
+    if (summary) {
         py::dict res;
-        res["path"] = root.string();
-        res["bytes"] = total;
-        res["human"] = human_readable_size(total);
+        res["path"] = fs::path(path).string();
+        res["bytes"] = usage.total;
+        res["human"] = human_readable_size(usage.total);
         return res;
     }
 
-    // Per-directory breakdown
     py::list results;
-    std::map<std::string, uintmax_t> dir_sizes;
-
-    for (auto& entry : fs::recursive_directory_iterator(
-             root, fs::directory_options::skip_permission_denied)) {
-        if (entry.is_regular_file()) {
-            auto sz = entry.file_size();
-            auto dir = entry.path().parent_path().string();
-            dir_sizes[dir] += sz;
-        }
-    }
-
-    for (auto& [dir, sz] : dir_sizes) {
+    for (const auto& dir : usage.dirs) {
         py::dict d;
-        d["path"]  = dir;
-        d["bytes"] = sz;
-        d["human"] = human_readable_size(sz);
+        d["path"]  = dir.path;
+        d["bytes"] = dir.bytes;
+        d["human"] = human_readable_size(dir.bytes);
         results.append(d);
     }
 
@@ -452,23 +755,51 @@ static py::object du_impl(const std::string& path, bool human_readable,
 // chmod — Change file permissions
 // ---------------------------------------------------------------------------
 
-static void chmod_impl(const std::string& path, int mode, bool recursive) {
-    fs::path target(path);
-    if (!fs::exists(target))
-        throw py::value_error("chmod: cannot access '" + path + "': No such file or directory");
+// Applies an *at() operation to every entry below the root, from the
+// directory descriptor the walk already holds.
+template <typename Apply>
+class ApplyVisitor : public CommandVisitor {
+public:
+    ApplyVisitor(const char* cmd, const std::string& root, Apply apply)
+        : CommandVisitor(cmd, root), apply_(apply) {}
+
+    bool visit(const WalkEntry& e, void*) override {
+        apply_(e);
+        return true;
+    }
 
-    auto perms = static_cast<fs::perms>(mode);
+private:
+    Apply apply_;
+};
 
-    auto apply = [&](const fs::path& p) {
-        fs::permissions(p, perms, fs::perm_options::replace);
-    };
+template <typename Apply>
+static void apply_tree(const char* cmd, const std::string& root, int threads, Apply apply) {
+    ApplyVisitor<Apply> visitor(cmd, root, apply);
+    ThreadPool pool(ThreadPool::resolve_threads(threads));
+    walk_tree(root, pool, WalkOptions(), visitor);
+}
 
-    apply(target);
-    if (recursive && fs::is_directory(target)) {
-        for (auto& entry : fs::recursive_directory_iterator(
-                 target, fs::directory_options::skip_permission_denied)) {
-            apply(entry.path());
-        }
+static void chmod_impl(const std::string& path, int mode, bool recursive, int threads) {
+    check_threads("chmod", threads);
+    FileStat root_st;
+    if (stat_at(AT_FDCWD, path.c_str(), true, root_st) != 0)
+        throw py::value_error("chmod: cannot access '" + path + "': No such file or directory");
+
+    auto perms = static_cast<mode_t>(mode) & 07777;
+
+    if (::chmod(path.c_str(), perms) != 0)
+        throw py::value_error("chmod: changing permissions of '" + path +
+                              "': " + std::strerror(errno));
+    if (recursive && root_st.type() == EntryType::dir) {
+        apply_tree("chmod", path, threads, [perms](const WalkEntry& e) {
+            std::string name(e.name());
+            // ENOENT: removed during the walk, or a dangling symlink.
+            if (fchmodat(e.dir_fd(), name.c_str(), perms, 0) != 0 && errno != ENOENT) {
+                int err = errno;
+                throw py::value_error("chmod: changing permissions of '" + e.path() +
+                                      "': " + std::strerror(err));
+            }
+        });
     }
 }
 
@@ -477,39 +808,33 @@ static void chmod_impl(const std::string& path, int mode, bool recursive) {
 // ---------------------------------------------------------------------------
 
 static void chown_impl(const std::string& path, const std::string& owner,
-                        const std::string& group, bool recursive) {
-    fs::path target(path);
-    if (!fs::exists(target))
+                        const std::string& group, bool recursive, int threads) {
+    check_threads("chown", threads);
+    FileStat root_st;
+    if (stat_at(AT_FDCWD, path.c_str(), true, root_st) != 0)
         throw py::value_error("chown: cannot access '" + path + "': No such file or directory");
 
     uid_t uid = static_cast<uid_t>(-1);
     gid_t gid = static_cast<gid_t>(-1);
 
-    if (!owner.empty()) {
-        struct passwd* pw = getpwnam(owner.c_str());
-        if (!pw)
-            throw py::value_error("chown: invalid user: '" + owner + "'");
-        uid = pw->pw_uid;
-    }
-    if (!group.empty()) {
-        struct group* gr = getgrnam(group.c_str());
-        if (!gr)
-            throw py::value_error("chown: invalid group: '" + group + "'");
-        gid = gr->gr_gid;
-    }
-
-    auto apply = [&](const fs::path& p) {
-        if (::chown(p.c_str(), uid, gid) != 0)
-            throw py::value_error("chown: changing ownership of '" + p.string() +
-                                  "': " + std::strerror(errno));
-    };
-
-    apply(target);
-    if (recursive && fs::is_directory(target)) {
-        for (auto& entry : fs::recursive_directory_iterator(
-                 target, fs::directory_options::skip_permission_denied)) {
-            apply(entry.path());
-        }
+    // Runs without the GIL: the reentrant lookups, not getpwnam/getgrnam.
+    if (!owner.empty() && !user_id(owner, uid))
+        throw py::value_error("chown: invalid user: '" + owner + "'");
+    if (!group.empty() && !group_id(group, gid))
+        throw py::value_error("chown: invalid group: '" + group + "'");
+
+    if (::chown(path.c_str(), uid, gid) != 0)
+        throw py::value_error("chown: changing ownership of '" + path +
+                              "': " + std::strerror(errno));
+    if (recursive && root_st.type() == EntryType::dir) {
+        apply_tree("chown", path, threads, [uid, gid](const WalkEntry& e) {
+            std::string name(e.name());
+            if (fchownat(e.dir_fd(), name.c_str(), uid, gid, 0) != 0 && errno != ENOENT) {
+                int err = errno;
+                throw py::value_error("chown: changing ownership of '" + e.path() +
+                                      "': " + std::strerror(err));
+            }
+        });
     }
 }
 
@@ -520,7 +845,7 @@ static void chown_impl(const std::string& path, const std::string& owner,
 void init_filesystem(py::module_ &m) {
 
     // -- ls -----------------------------------------------------------------
-    m.def("ls", &ls_impl,
+    m.def("ls", counted("ls", &ls_impl),
         R"doc(
         List directory contents.
 
@@ -545,9 +870,17 @@ void init_filesystem(py::module_ &m) {
                                    Equivalent to ``ls -h``.
             directory_only (bool): If True, only list directories.
                                    Equivalent to ``ls -d``.
+            threads (int): Number of worker threads for a recursive listing.
+                           0 uses every core. The result does not depend on
+                           the thread count.
+            stat (bool): If True, return StatResult objects instead of names
+                         or dicts. They hold the raw metadata; owner, group,
+                         permissions, times and symlink targets are only
+                         formatted or read when the attribute is accessed.
 
         Returns:
-            list: A list of filenames (str) or dicts (if long_format=True).
+            list: A list of filenames (str), dicts (if long_format=True) or
+            StatResult objects (if stat=True).
 
         Raises:
             ValueError: If path does not exist.
@@ -559,10 +892,76 @@ void init_filesystem(py::module_ &m) {
         py::arg("sort_by") = "name",
         py::arg("reverse") = false,
         py::arg("human_readable") = false,
-        py::arg("directory_only") = false);
+        py::arg("directory_only") = false,
+        py::arg("threads") = 1,
+        py::arg("stat") = false);
+
+    py::class_<LsEntry>(m, "StatResult",
+        "One entry of ls(stat=True). String attributes are built on access.")
+        .def_readonly("name", &LsEntry::name)
+        .def_readonly("path", &LsEntry::path)
+        .def_property_readonly("type",
+             [](const LsEntry& e) { return file_type_char(e.type); },
+             "Type character as in ls -l: '-', 'd', 'l', 'b', 'c', 'p' or 's'.")
+        .def_readonly("is_directory", &LsEntry::is_directory)
+        .def_property_readonly("is_symlink",
+             [](const LsEntry& e) { return e.type == EntryType::symlink; })
+        .def_readonly("mode", &LsEntry::mode, "st_mode (of a symlink's target).")
+        .def_property_readonly("permissions",
+             [](const LsEntry& e) {
+                 return permissions_string(static_cast<fs::perms>(e.mode & 0777));
+             })
+        .def_readonly("uid", &LsEntry::uid)
+        .def_readonly("gid", &LsEntry::gid)
+        .def_property_readonly("owner", [](const LsEntry& e) { return user_name(e.uid); })
+        .def_property_readonly("group", [](const LsEntry& e) { return group_name(e.gid); })
+        .def_readonly("size", &LsEntry::size, "Size in bytes (regular files only).")
+        .def_property_readonly("size_human",
+             [](const LsEntry& e) { return human_readable_size(e.size); })
+        .def_readonly("nlink", &LsEntry::nlink)
+        .def_readonly("ino", &LsEntry::ino)
+        .def_property_readonly("mtime",
+             [](const LsEntry& e) { return e.mtime_sec + e.mtime_nsec / 1e9; },
+             "Modification time in seconds since the epoch.")
+        .def_property_readonly("mtime_ns",
+             [](const LsEntry& e) {
+                 return e.mtime_sec * 1000000000LL + static_cast<int64_t>(e.mtime_nsec);
+             })
+        .def_property_readonly("last_modified",
+             [](const LsEntry& e) { return format_epoch(e.mtime_sec); })
+        .def_property_readonly("symlink_target",
+             [](LsEntry& e) -> py::object {
+                 if (e.type != EntryType::symlink)
+                     return py::none();
+                 return py::str(e.target());
+             },
+             "Target of a symlink (read on first access), else None.")
+        .def("to_dict",
+             [](LsEntry& e) {
+                 py::dict d;
+                 d["name"]          = e.name;
+                 d["path"]          = e.path;
+                 d["type"]          = file_type_char(e.type);
+                 d["is_directory"]  = e.is_directory;
+                 d["is_symlink"]    = e.type == EntryType::symlink;
+                 d["permissions"]   = permissions_string(static_cast<fs::perms>(e.mode & 0777));
+                 d["owner"]         = user_name(e.uid);
+                 d["group"]         = group_name(e.gid);
+                 d["last_modified"] = format_epoch(e.mtime_sec);
+                 d["size"]          = e.size;
+                 d["size_human"]    = human_readable_size(e.size);
+                 if (e.type == EntryType::symlink)
+                     d["symlink_target"] = e.target();
+                 return d;
+             },
+             "The dict ls(long_format=True) returns for this entry.")
+        .def("__repr__", [](const LsEntry& e) {
+            return "StatResult(name=" + py::repr(py::str(e.name)).cast<std::string>() +
+                   ", type='" + file_type_char(e.type) + "', size=" + std::to_string(e.size) + ")";
+        });
 
     // -- pwd ----------------------------------------------------------------
-    m.def("pwd", &pwd_impl,
+    m.def("pwd", counted("pwd", &pwd_impl),
         R"doc(
         Print working directory.
 
@@ -574,7 +973,7 @@ void init_filesystem(py::module_ &m) {
         )doc");
 
     // -- cd -----------------------------------------------------------------
-    m.def("cd", &cd_impl,
+    m.def("cd", counted("cd", &cd_impl),
         R"doc(
         Change the current working directory.
 
@@ -587,10 +986,11 @@ void init_filesystem(py::module_ &m) {
         Raises:
             ValueError: If path does not exist or is not a directory.
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("path"));
 
     // -- mkdir --------------------------------------------------------------
-    m.def("mkdir", &mkdir_impl,
+    m.def("mkdir", counted("mkdir", &mkdir_impl),
         R"doc(
         Create a directory.
 
@@ -605,11 +1005,12 @@ void init_filesystem(py::module_ &m) {
         Raises:
             ValueError: If directory cannot be created.
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("path"),
         py::arg("parents") = false);
 
     // -- rmdir --------------------------------------------------------------
-    m.def("rmdir", &rmdir_impl,
+    m.def("rmdir", counted("rmdir", &rmdir_impl),
         R"doc(
         Remove an empty directory.
 
@@ -622,10 +1023,11 @@ void init_filesystem(py::module_ &m) {
         Raises:
             ValueError: If path doesn't exist, is not a directory, or is not empty.
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("path"));
 
     // -- rm -----------------------------------------------------------------
-    m.def("rm", &rm_impl,
+    m.def("rm", counted("rm", &rm_impl),
         R"doc(
         Remove files or directories.
 
@@ -638,17 +1040,49 @@ void init_filesystem(py::module_ &m) {
                               recursively. Equivalent to ``rm -r``.
             force (bool): If True, ignore nonexistent files and never prompt.
                           Equivalent to ``rm -f``.
+            threads (int): Number of worker threads for a recursive removal;
+                           directories are read and emptied in parallel.
+                           0 uses every core.
+            async_ (bool): If True, rename the target to a hidden sibling
+                           (``.<name>.rm-<pid>-<n>``) and delete it on a
+                           background thread. The path is free when rm
+                           returns.
+
+        Returns:
+            RemoveHandle: With ``async_=True``, a handle to wait on;
+            otherwise None.
 
         Raises:
-            ValueError: If path doesn't exist (unless force=True) or trying to
-                        remove a directory without recursive=True.
+            ValueError: If path doesn't exist (unless force=True), trying to
+                        remove a directory without recursive=True, or an
+                        entry cannot be removed. Everything removable is
+                        removed first; the first failure is reported.
         )doc",
         py::arg("path"),
         py::arg("recursive") = false,
-        py::arg("force") = false);
+        py::arg("force") = false,
+        py::arg("threads") = 1,
+        py::arg("async_") = false);
+
+    py::class_<BackgroundRemove>(m, "RemoveHandle",
+        "Handle returned by rm(async_=True) for a removal running in the background.")
+        .def("wait",
+             [](BackgroundRemove& self) {
+                 try {
+                     py::gil_scoped_release release;
+                     self.wait();
+                 } catch (const std::runtime_error& e) {
+                     throw py::value_error(std::string("rm: ") + e.what());
+                 }
+             },
+             "Block until the removal has finished. Raises ValueError if it failed.")
+        .def("done", &BackgroundRemove::done,
+             "Return True once the removal has finished.")
+        .def_property_readonly("path", &BackgroundRemove::path,
+             "Where the target is being removed from (its hidden name).");
 
     // -- touch --------------------------------------------------------------
-    m.def("touch", &touch_impl,
+    m.def("touch", counted("touch", &touch_impl),
         R"doc(
         Create an empty file or update its timestamp.
 
@@ -663,59 +1097,88 @@ void init_filesystem(py::module_ &m) {
         Raises:
             ValueError: If the file cannot be created.
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("path"),
         py::arg("no_create") = false);
 
     // -- cp -----------------------------------------------------------------
-    m.def("cp", &cp_impl,
+    m.def("cp", counted("cp", &cp_impl),
         R"doc(
         Copy files or directories.
 
         Equivalent to the ``cp`` shell command. Copies a source file or
-        directory to a destination.
+        directory to a destination. A file copied onto an existing directory
+        lands inside it; a directory is copied onto ``dst``, which is created
+        if missing.
+
+        File data is copied by the kernel where possible: a reflink (shared
+        extents) first, then ``copy_file_range``, then ``sendfile``, then
+        plain reads and writes. Sparse files keep their holes, and permission
+        bits are copied.
 
         Args:
             src (str): Source path.
             dst (str): Destination path.
             recursive (bool): If True, copy directories recursively.
-                              Equivalent to ``cp -r``.
+                              Equivalent to ``cp -r``. Inside the tree,
+                              symlinks to directories are copied as symlinks.
             force (bool): If True, overwrite existing files.
                           Equivalent to ``cp -f``.
             preserve (bool): If True, preserve symlinks instead of following them.
                              Equivalent to ``cp -P``.
+            threads (int): Number of worker threads for a recursive copy;
+                           files are copied concurrently. 0 uses every core.
+            progress (callable): Called as ``progress(bytes_copied,
+                                 files_copied)`` with running totals, at
+                                 most every 100 ms and once at the end.
+                                 An exception it raises stops the copy and
+                                 is propagated.
 
         Raises:
-            ValueError: If source does not exist.
+            ValueError: If source does not exist, is a directory without
+                        recursive=True, or a file cannot be copied.
         )doc",
         py::arg("src"),
         py::arg("dst"),
         py::arg("recursive") = false,
         py::arg("force") = false,
-        py::arg("preserve") = false);
+        py::arg("preserve") = false,
+        py::arg("threads") = 1,
+        py::arg("progress") = py::none());
 
     // -- mv -----------------------------------------------------------------
-    m.def("mv", &mv_impl,
+    m.def("mv", counted("mv", &mv_impl),
         R"doc(
         Move or rename files and directories.
 
         Equivalent to the ``mv`` shell command. Moves a file or directory from
         source to destination. Can also be used to rename.
 
+        Across filesystems, where a rename is impossible, the source is copied
+        with the same engine as ``cp`` (keeping symlinks, permissions and
+        times) and then removed, like ``mv`` does.
+
         Args:
             src (str): Source path.
             dst (str): Destination path.
             force (bool): If True, overwrite existing destination without prompting.
                           Equivalent to ``mv -f``.
+            threads (int): Number of worker threads for a cross-filesystem
+                           move of a directory. 0 uses every core.
 
         Raises:
-            ValueError: If source does not exist or destination exists without force.
+            ValueError: If source does not exist, destination exists without
+                        force, or the move fails. A failed cross-filesystem
+                        copy leaves the source untouched.
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("src"),
         py::arg("dst"),
-        py::arg("force") = false);
+        py::arg("force") = false,
+        py::arg("threads") = 1);
 
     // -- ln -----------------------------------------------------------------
-    m.def("ln", &ln_impl,
+    m.def("ln", counted("ln", &ln_impl),
         R"doc(
         Create hard or symbolic links.
 
@@ -731,25 +1194,30 @@ void init_filesystem(py::module_ &m) {
         Raises:
             ValueError: If target does not exist (for hard links).
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("target"),
         py::arg("link_name"),
         py::arg("symbolic") = false);
 
     // -- find ---------------------------------------------------------------
-    m.def("find", &find_impl,
+    m.def("find", counted("find", &find_impl),
         R"doc(
         Search for files in a directory hierarchy.
 
         Equivalent to the ``find`` shell command. Recursively searches for files
-        matching the given criteria.
+        matching all of the given criteria. Cheap criteria (name, type) are
+        checked first, so files are only stat'ed when a size, time, owner or
+        permission criterion has to look at them.
 
         Args:
             path (str): Root directory to search from.
-            name (str): Filename pattern to match. Supports simple globs:
-                        ``"*.txt"`` (suffix), ``"test*"`` (prefix),
-                        ``"*log*"`` (contains). Empty string matches all.
+            name (str): Glob matched against the file name, with fnmatch
+                        syntax: ``*``, ``?``, ``[a-z]``, ``[!x]``,
+                        ``[[:digit:]]``. Empty string matches all.
+                        Equivalent to ``find -name``.
             type (str): File type filter: "f" (regular file), "d" (directory),
-                        "l" (symlink). Empty string matches all.
+                        "l" (symlink), "b", "c", "p", "s"; several may be
+                        given separated by commas. Empty string matches all.
                         Equivalent to ``find -type``.
             min_size (int): Minimum file size in bytes. -1 to ignore.
                             Equivalent to ``find -size +N``.
@@ -757,27 +1225,59 @@ void init_filesystem(py::module_ &m) {
                             Equivalent to ``find -size -N``.
             max_depth (int): Maximum directory depth to search. -1 for unlimited.
                              Equivalent to ``find -maxdepth``.
+            threads (int): Number of worker threads; directories are read in
+                           parallel. 0 uses every core. Paths are returned in
+                           the same order whatever the thread count.
+            path_glob (str): Glob matched against the path relative to
+                             ``path``, where ``*`` stops at ``/`` and ``**``
+                             spans directories (``"src/**/*.h"``).
+                             Similar to ``find -path``.
+            mtime (str): Age of the last modification in days: ``"N"``
+                         exactly, ``"+N"`` more than, ``"-N"`` less than.
+                         Equivalent to ``find -mtime``.
+            newer (str): Only files modified after this file.
+                         Equivalent to ``find -newer``.
+            user (str): Only files owned by this user name or uid.
+                        Equivalent to ``find -user``.
+            perm (str): Octal mode: ``"644"`` exactly, ``"-644"`` all of
+                        these bits, ``"/022"`` any of them.
+                        Equivalent to ``find -perm``.
+            prune (list[str]): Globs on directory names that are neither
+                               returned nor descended into, e.g.
+                               ``[".git", "node_modules"]``.
+                               Equivalent to ``find -name X -prune``.
 
         Returns:
             list[str]: List of matching file paths.
 
         Raises:
-            ValueError: If path does not exist.
+            ValueError: If path does not exist, a criterion is malformed, the
+                        user is unknown, or ``newer`` cannot be stat'ed.
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("path") = ".",
         py::arg("name") = "",
         py::arg("type") = "",
         py::arg("min_size") = -1,
         py::arg("max_size") = -1,
-        py::arg("max_depth") = -1);
+        py::arg("max_depth") = -1,
+        py::arg("threads") = 1,
+        py::arg("path_glob") = "",
+        py::arg("mtime") = "",
+        py::arg("newer") = "",
+        py::arg("user") = "",
+        py::arg("perm") = "",
+        py::arg("prune") = std::vector<std::string>());
 
     // -- du -----------------------------------------------------------------
-    m.def("du", &du_impl,
+    m.def("du", counted("du", &du_impl),
         R"doc(
         Estimate file and directory space usage.
 
         Equivalent to the ``du`` shell command. Calculates disk usage for a
-        given path.
+        given path. Each directory's figure includes everything below it,
+        and a file with several hard links is counted once (with several
+        threads, which directory it is attributed to can vary).
 
         Args:
             path (str): File or directory path.
@@ -785,20 +1285,39 @@ void init_filesystem(py::module_ &m) {
                                    Equivalent to ``du -h``.
             summary_only (bool): If True, return only the total for the path.
                                  Equivalent to ``du -s``.
+            threads (int): Number of worker threads; directories are read in
+                           parallel. 0 uses every core.
+            apparent (bool): If True (the default), sum the sizes of regular
+                             files. If False, sum the blocks allocated to
+                             every file, symlink and directory, so sparse
+                             files count what they occupy on disk. False is
+                             what plain ``du`` does; True is
+                             ``du --apparent-size``.
+            cache (str): Path of a cache file that makes repeated scans
+                         incremental. A directory whose mtime has not changed
+                         since the last scan is not read again, and its
+                         stored total is reused. Files rewritten in place do
+                         not change their directory's mtime, so leave this
+                         empty when exact figures are needed.
 
         Returns:
             dict or list[dict]: A dict with keys "path", "bytes", "human" if
-            summary_only=True, or a list of such dicts per subdirectory.
+            summary_only=True, or a list of such dicts, one per directory
+            (sorted by path), each with the total of its subtree.
 
         Raises:
-            ValueError: If path does not exist.
+            ValueError: If path does not exist, cannot be read, or the cache
+                        cannot be written.
         )doc",
         py::arg("path") = ".",
         py::arg("human_readable") = false,
-        py::arg("summary_only") = true);
+        py::arg("summary_only") = true,
+        py::arg("threads") = 1,
+        py::arg("apparent") = true,
+        py::arg("cache") = "");
 
     // -- chmod --------------------------------------------------------------
-    m.def("chmod", &chmod_impl,
+    m.def("chmod", counted("chmod", &chmod_impl),
         R"doc(
         Change file mode (permissions).
 
@@ -810,16 +1329,20 @@ void init_filesystem(py::module_ &m) {
             mode (int): Octal permission mode, e.g. 0o755, 0o644.
             recursive (bool): If True, apply permissions recursively to all
                               files and subdirectories. Equivalent to ``chmod -R``.
+            threads (int): Number of worker threads for a recursive change.
+                           0 uses every core.
 
         Raises:
             ValueError: If path does not exist.
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("path"),
         py::arg("mode"),
-        py::arg("recursive") = false);
+        py::arg("recursive") = false,
+        py::arg("threads") = 1);
 
     // -- chown --------------------------------------------------------------
-    m.def("chown", &chown_impl,
+    m.def("chown", counted("chown", &chown_impl),
         R"doc(
         Change file owner and group.
 
@@ -832,13 +1355,17 @@ void init_filesystem(py::module_ &m) {
             group (str): New group name. Empty string to leave unchanged.
             recursive (bool): If True, apply changes recursively.
                               Equivalent to ``chown -R``.
+            threads (int): Number of worker threads for a recursive change.
+                           0 uses every core.
 
         Raises:
             ValueError: If path doesn't exist, user/group is invalid, or
                         insufficient privileges.
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("path"),
         py::arg("owner") = "",
         py::arg("group") = "",
-        py::arg("recursive") = false);
+        py::arg("recursive") = false,
+        py::arg("threads") = 1);
 }
@@ -0,0 +1,258 @@
+#include "find_filter.h"
+#include "common/id_names.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#include <fcntl.h>
+
+namespace {
+
+// Test costs, cheapest first.
+enum Cost { kCostName, kCostType, kCostPath, kCostStat };
+
+// Metadata of what the entry refers to; the link itself when dangling.
+const FileStat* meta(const WalkEntry& e) {
+    const FileStat* st = e.target_stat();
+    return st ? st : e.stat();
+}
+
+class NameTest : public FindTest {
+public:
+    explicit NameTest(const std::string& glob) : glob_(glob) {}
+    bool test(const WalkEntry& e, std::string_view) const override {
+        return glob_.match(e.name());
+    }
+
+private:
+    GlobPattern glob_;
+};
+
+class PathTest : public FindTest {
+public:
+    explicit PathTest(const std::string& glob) : glob_(glob, true) {}
+    bool test(const WalkEntry&, std::string_view rel_path) const override {
+        return glob_.match(rel_path);
+    }
+
+private:
+    GlobPattern glob_;
+};
+
+class TypeTest : public FindTest {
+public:
+    explicit TypeTest(const std::string& spec) {
+        for (char c : spec) {
+            switch (c) {
+                case 'f': types_.push_back(EntryType::file); break;
+                case 'd': types_.push_back(EntryType::dir); break;
+                case 'l': symlink_ = true; break;
+                case 'b': types_.push_back(EntryType::block); break;
+                case 'c': types_.push_back(EntryType::character); break;
+                case 'p': types_.push_back(EntryType::fifo); break;
+                case 's': types_.push_back(EntryType::socket); break;
+                case ',': break;
+                default:
+                    throw std::invalid_argument("unknown type '" + std::string(1, c) + "'");
+            }
+        }
+    }
+
+    bool test(const WalkEntry& e, std::string_view) const override {
+        if (symlink_ && e.is_symlink())
+            return true;
+        if (types_.empty())
+            return false;
+        EntryType t = e.target_type();
+        return std::find(types_.begin(), types_.end(), t) != types_.end();
+    }
+
+private:
+    std::vector<EntryType> types_;  // after following symlinks
+    bool symlink_ = false;
+};
+
+class SizeTest : public FindTest {
+public:
+    SizeTest(long long min_size, long long max_size) : min_(min_size), max_(max_size) {}
+    bool test(const WalkEntry& e, std::string_view) const override {
+        if (e.target_type() != EntryType::file)
+            return false;
+        const FileStat* st = e.target_stat();
+        if (!st) return false;
+        auto sz = static_cast<long long>(st->size);
+        if (min_ >= 0 && sz < min_) return false;
+        if (max_ >= 0 && sz > max_) return false;
+        return true;
+    }
+
+private:
+    long long min_;
+    long long max_;
+};
+
+// find -mtime: age in whole days (rounded down) compared with N.
+class MtimeTest : public FindTest {
+public:
+    MtimeTest(char cmp, long long days, int64_t now) : cmp_(cmp), days_(days), now_(now) {}
+    bool test(const WalkEntry& e, std::string_view) const override {
+        const FileStat* st = meta(e);
+        if (!st) return false;
+        int64_t age = now_ - st->mtime_sec;
+        int64_t days = age >= 0 ? age / 86400 : -((-age + 86399) / 86400);
+        if (cmp_ == '+') return days > days_;
+        if (cmp_ == '-') return days < days_;
+        return days == days_;
+    }
+
+private:
+    char cmp_;
+    long long days_;
+    int64_t now_;
+};
+
+class NewerTest : public FindTest {
+public:
+    NewerTest(int64_t sec, uint32_t nsec) : sec_(sec), nsec_(nsec) {}
+    bool test(const WalkEntry& e, std::string_view) const override {
+        const FileStat* st = meta(e);
+        if (!st) return false;
+        return st->mtime_sec > sec_ || (st->mtime_sec == sec_ && st->mtime_nsec > nsec_);
+    }
+
+private:
+    int64_t sec_;
+    uint32_t nsec_;
+};
+
+class UserTest : public FindTest {
+public:
+    explicit UserTest(uint32_t uid) : uid_(uid) {}
+    bool test(const WalkEntry& e, std::string_view) const override {
+        const FileStat* st = meta(e);
+        return st && st->uid == uid_;
+    }
+
+private:
+    uint32_t uid_;
+};
+
+// find -perm: "MODE" exact, "-MODE" all bits set, "/MODE" any bit set.
+class PermTest : public FindTest {
+public:
+    PermTest(char cmp, uint32_t bits) : cmp_(cmp), bits_(bits) {}
+    bool test(const WalkEntry& e, std::string_view) const override {
+        const FileStat* st = meta(e);
+        if (!st) return false;
+        uint32_t mode = st->mode & 07777;
+        if (cmp_ == '-') return (mode & bits_) == bits_;
+        if (cmp_ == '/') return bits_ == 0 || (mode & bits_) != 0;
+        return mode == bits_;
+    }
+
+private:
+    char cmp_;
+    uint32_t bits_;
+};
+
+long long parse_count(std::string_view digits, const char* what, const std::string& spec) {
+    if (digits.empty())
+        throw std::invalid_argument(std::string("invalid ") + what + " '" + spec + "'");
+    long long value = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '9' || value > (1LL << 40))
+            throw std::invalid_argument(std::string("invalid ") + what + " '" + spec + "'");
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+uint32_t lookup_user(const std::string& user) {
+    if (std::all_of(user.begin(), user.end(), [](char c) { return c >= '0' && c <= '9'; }))
+        return static_cast<uint32_t>(parse_count(user, "user", user));
+    uint32_t uid;
+    if (!user_id(user, uid))
+        throw std::invalid_argument("unknown user '" + user + "'");
+    return uid;
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// FindFilter
+// ---------------------------------------------------------------------------
+
+FindFilter::FindFilter(const FindQuery& q) {
+    std::vector<std::pair<int, std::unique_ptr<FindTest>>> tests;
+
+    if (!q.name.empty())
+        tests.emplace_back(kCostName, std::make_unique<NameTest>(q.name));
+    if (!q.type.empty())
+        tests.emplace_back(kCostType, std::make_unique<TypeTest>(q.type));
+    if (!q.path_glob.empty()) {
+        tests.emplace_back(kCostPath, std::make_unique<PathTest>(q.path_glob));
+        needs_path_ = true;
+    }
+    if (q.min_size >= 0 || q.max_size >= 0)
+        tests.emplace_back(kCostStat, std::make_unique<SizeTest>(q.min_size, q.max_size));
+    if (!q.mtime.empty()) {
+        char cmp = q.mtime[0] == '+' || q.mtime[0] == '-' ? q.mtime[0] : '=';
+        long long days = parse_count(std::string_view(q.mtime).substr(cmp == '=' ? 0 : 1),
+                                     "mtime", q.mtime);
+        tests.emplace_back(kCostStat, std::make_unique<MtimeTest>(
+                                          cmp, days, static_cast<int64_t>(std::time(nullptr))));
+    }
+    if (!q.newer.empty()) {
+        FileStat ref;
+        int err = stat_at(AT_FDCWD, q.newer.c_str(), true, ref);
+        if (err != 0)
+            throw std::invalid_argument("cannot stat '" + q.newer + "': " + std::strerror(err));
+        tests.emplace_back(kCostStat, std::make_unique<NewerTest>(ref.mtime_sec, ref.mtime_nsec));
+    }
+    if (!q.user.empty())
+        tests.emplace_back(kCostStat, std::make_unique<UserTest>(lookup_user(q.user)));
+    if (!q.perm.empty()) {
+        char cmp = q.perm[0] == '-' || q.perm[0] == '/' ? q.perm[0] : '=';
+        std::string_view digits = std::string_view(q.perm).substr(cmp == '=' ? 0 : 1);
+        uint32_t bits = 0;
+        if (digits.empty() || digits.size() > 4)
+            throw std::invalid_argument("invalid mode '" + q.perm + "'");
+        for (char c : digits) {
+            if (c < '0' || c > '7')
+                throw std::invalid_argument("invalid mode '" + q.perm + "'");
+            bits = bits * 8 + static_cast<uint32_t>(c - '0');
+        }
+        tests.emplace_back(kCostStat, std::make_unique<PermTest>(cmp, bits));
+    }
+
+    std::stable_sort(tests.begin(), tests.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (auto& t : tests)
+        tests_.push_back(std::move(t.second));
+
+    for (const auto& p : q.prune)
+        prune_.emplace_back(p);
+}
+
+FindFilter::~FindFilter() = default;
+
+bool FindFilter::pruned(const WalkEntry& e) const {
+    if (prune_.empty() || !e.is_dir())
+        return false;
+    for (const auto& p : prune_) {
+        if (p.match(e.name()))
+            return true;
+    }
+    return false;
+}
+
+bool FindFilter::matches(const WalkEntry& e, std::string_view rel_path) const {
+    for (const auto& t : tests_) {
+        if (!t->test(e, rel_path))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "glob.h"
+#include "walker.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// FindFilter — the compiled predicates of find
+//
+// Every criterion of a FindQuery becomes one test, and the tests run
+// cheapest first: name globs (no syscalls), then type (d_type, a stat only
+// for symlinks), then path globs (needs the joined path), and only then the
+// tests that read metadata (size, mtime, newer, user, perm). An entry
+// rejected early is therefore never stat'ed, and metadata is fetched at
+// most once per entry (WalkEntry caches it).
+//
+// Metadata tests look through symlinks, like the size test always has; a
+// dangling link is judged by the link itself.
+//
+// Tests are const and stateless, so one filter serves every walk thread.
+// ---------------------------------------------------------------------------
+
+struct FindQuery {
+    std::string name;               // glob on the entry name
+    std::string path_glob;          // glob on the path relative to the root
+    std::string type;               // f d l b c p s; empty = any
+    long long min_size = -1;        // bytes, regular files only; -1 = off
+    long long max_size = -1;
+    std::string mtime;              // days, find -mtime style: "N", "+N", "-N"
+    std::string newer;              // modified after this file
+    std::string user;               // user name or numeric uid
+    std::string perm;               // find -perm style: "644", "-644", "/644"
+    std::vector<std::string> prune; // globs on directory names not to enter
+};
+
+class FindTest {
+public:
+    virtual ~FindTest() = default;
+    virtual bool test(const WalkEntry& e, std::string_view rel_path) const = 0;
+};
+
+class FindFilter {
+public:
+    // Throws std::invalid_argument for a malformed criterion, an unknown
+    // user, or a `newer` reference that cannot be stat'ed.
+    explicit FindFilter(const FindQuery& q);
+    ~FindFilter();
+
+    // True if matches() needs the entry's path relative to the root.
+    bool needs_path() const { return needs_path_; }
+
+    // True for a directory that must not be reported or descended into.
+    bool pruned(const WalkEntry& e) const;
+
+    // `rel_path` is only looked at when needs_path() is true.
+    bool matches(const WalkEntry& e, std::string_view rel_path) const;
+
+private:
+    std::vector<std::unique_ptr<FindTest>> tests_;
+    std::vector<GlobPattern> prune_;
+    bool needs_path_ = false;
+};
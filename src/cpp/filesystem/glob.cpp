@@ -0,0 +1,258 @@
+#include "glob.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Compilation
+// ---------------------------------------------------------------------------
+
+// Adds the members of a POSIX class name ("alpha", "digit", ...) to `set`.
+// Returns false for an unknown name.
+static bool add_posix_class(std::string_view name, std::array<uint64_t, 4>& set) {
+    int (*pred)(int) = nullptr;
+    if (name == "alpha") pred = isalpha;
+    else if (name == "digit") pred = isdigit;
+    else if (name == "alnum") pred = isalnum;
+    else if (name == "upper") pred = isupper;
+    else if (name == "lower") pred = islower;
+    else if (name == "space") pred = isspace;
+    else if (name == "blank") pred = isblank;
+    else if (name == "punct") pred = ispunct;
+    else if (name == "xdigit") pred = isxdigit;
+    else if (name == "cntrl") pred = iscntrl;
+    else if (name == "print") pred = isprint;
+    else if (name == "graph") pred = isgraph;
+    else return false;
+    for (int c = 0; c < 128; c++) {
+        if (pred(c))
+            set[c >> 6] |= uint64_t(1) << (c & 63);
+    }
+    return true;
+}
+
+static void add_range(std::array<uint64_t, 4>& set, unsigned char lo, unsigned char hi) {
+    for (unsigned c = lo; c <= hi; c++)
+        set[c >> 6] |= uint64_t(1) << (c & 63);
+}
+
+GlobPattern::GlobPattern(std::string_view pattern, bool path_mode)
+    : source_(pattern), path_mode_(path_mode) {
+    size_t n = pattern.size();
+    size_t i = 0;
+    while (i < n) {
+        char c = pattern[i];
+        if (c == '\\' && i + 1 < n) {
+            tokens_.push_back({Op::literal, pattern[i + 1], 0});
+            i += 2;
+        } else if (c == '*') {
+            size_t j = i;
+            while (j < n && pattern[j] == '*') j++;
+            if (path_mode && j - i >= 2) {
+                if (j < n && pattern[j] == '/') {
+                    tokens_.push_back({Op::globstar_dir, 0, 0});
+                    j++;
+                } else {
+                    tokens_.push_back({Op::globstar, 0, 0});
+                }
+            } else {
+                tokens_.push_back({Op::star, 0, 0});
+            }
+            i = j;
+        } else if (c == '?') {
+            tokens_.push_back({Op::any, 0, 0});
+            i++;
+        } else if (c == '[') {
+            // Parse the class; if it never closes, '[' is a literal.
+            CharSet set{};
+            size_t j = i + 1;
+            bool negate = j < n && (pattern[j] == '!' || pattern[j] == '^');
+            if (negate) j++;
+            bool first = true;
+            bool closed = false;
+            while (j < n) {
+                if (pattern[j] == ']' && !first) {
+                    closed = true;
+                    break;
+                }
+                first = false;
+                if (pattern[j] == '[' && j + 1 < n && pattern[j + 1] == ':') {
+                    size_t end = pattern.find(":]", j + 2);
+                    if (end != std::string_view::npos &&
+                        add_posix_class(pattern.substr(j + 2, end - j - 2), set)) {
+                        j = end + 2;
+                        continue;
+                    }
+                }
+                if (pattern[j] == '\\' && j + 1 < n) j++;
+                unsigned char lo = static_cast<unsigned char>(pattern[j]);
+                unsigned char hi = lo;
+                j++;
+                if (j + 1 < n && pattern[j] == '-' && pattern[j + 1] != ']') {
+                    j++;
+                    if (pattern[j] == '\\' && j + 1 < n) j++;
+                    hi = static_cast<unsigned char>(pattern[j]);
+                    j++;
+                }
+                if (lo <= hi)
+                    add_range(set, lo, hi);
+            }
+            if (!closed) {
+                tokens_.push_back({Op::literal, '[', 0});
+                i++;
+                continue;
+            }
+            if (negate) {
+                for (auto& word : set) word = ~word;
+            }
+            if (path_mode)
+                set['/' >> 6] &= ~(uint64_t(1) << ('/' & 63));
+            tokens_.push_back({Op::cls, 0, static_cast<uint16_t>(classes_.size())});
+            classes_.push_back(set);
+            i = j + 1;
+        } else {
+            tokens_.push_back({Op::literal, c, 0});
+            i++;
+        }
+    }
+
+    // Direct shapes: literals with at most a leading and a trailing '*'.
+    // A path-mode '*' stops at '/', so only exact matches qualify there.
+    size_t lo = 0, hi = tokens_.size();
+    bool lead = lo < hi && tokens_[lo].op == Op::star;
+    if (lead) lo++;
+    bool trail = lo < hi && tokens_[hi - 1].op == Op::star;
+    if (trail) hi--;
+    bool literal_core = true;
+    for (size_t k = lo; k < hi; k++) {
+        if (tokens_[k].op != Op::literal) {
+            literal_core = false;
+            break;
+        }
+        literal_.push_back(tokens_[k].ch);
+    }
+    if (!literal_core || (path_mode && (lead || trail))) {
+        literal_.clear();
+        shape_ = Shape::general;
+    } else if (lead && trail) {
+        shape_ = Shape::contains;
+    } else if (lead) {
+        shape_ = Shape::suffix;
+    } else if (trail) {
+        shape_ = Shape::prefix;
+    } else {
+        shape_ = Shape::exact;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Matching
+// ---------------------------------------------------------------------------
+
+bool GlobPattern::match(std::string_view text) const {
+    switch (shape_) {
+        case Shape::exact:
+            return text == literal_;
+        case Shape::prefix:
+            return text.size() >= literal_.size() &&
+                   text.compare(0, literal_.size(), literal_) == 0;
+        case Shape::suffix:
+            return text.size() >= literal_.size() &&
+                   text.compare(text.size() - literal_.size(), literal_.size(), literal_) == 0;
+        case Shape::contains:
+            return text.find(literal_) != std::string_view::npos;
+        case Shape::general:
+            break;
+    }
+    return match_general(text);
+}
+
+// Runs the tokens over `text` one at a time, tracking the set of text
+// positions each prefix of the pattern can end at. O(tokens * length) with
+// no backtracking, so no pattern can go exponential.
+bool GlobPattern::match_general(std::string_view text) const {
+    size_t n = text.size();
+    char stack_buf[2 * 256];
+    std::vector<char> heap_buf;
+    char* cur = stack_buf;
+    if (n + 1 > 256) {
+        heap_buf.resize(2 * (n + 1));
+        cur = heap_buf.data();
+    }
+    char* next = cur + (n + 1);
+    std::memset(cur, 0, n + 1);
+    cur[0] = 1;
+
+    for (const Token& t : tokens_) {
+        std::memset(next, 0, n + 1);
+        bool any_live = false;
+        switch (t.op) {
+            case Op::literal:
+                for (size_t p = 0; p < n; p++) {
+                    if (cur[p] && text[p] == t.ch) {
+                        next[p + 1] = 1;
+                        any_live = true;
+                    }
+                }
+                break;
+            case Op::any:
+                for (size_t p = 0; p < n; p++) {
+                    if (cur[p] && !(path_mode_ && text[p] == '/')) {
+                        next[p + 1] = 1;
+                        any_live = true;
+                    }
+                }
+                break;
+            case Op::cls: {
+                const CharSet& set = classes_[t.cls];
+                for (size_t p = 0; p < n; p++) {
+                    if (cur[p] && in_set(set, static_cast<unsigned char>(text[p]))) {
+                        next[p + 1] = 1;
+                        any_live = true;
+                    }
+                }
+                break;
+            }
+            case Op::star: {
+                char run = 0;
+                for (size_t q = 0; q <= n; q++) {
+                    if (path_mode_ && q > 0 && text[q - 1] == '/')
+                        run = 0;
+                    run |= cur[q];
+                    next[q] = run;
+                    any_live |= run != 0;
+                }
+                break;
+            }
+            case Op::globstar: {
+                char run = 0;
+                for (size_t q = 0; q <= n; q++) {
+                    run |= cur[q];
+                    next[q] = run;
+                    any_live |= run != 0;
+                }
+                break;
+            }
+            case Op::globstar_dir: {
+                // Nothing, or anything that ends in '/'.
+                char seen = 0;
+                for (size_t q = 0; q <= n; q++) {
+                    if (q > 0)
+                        seen |= cur[q - 1];
+                    next[q] = cur[q] || (q > 0 && text[q - 1] == '/' && seen);
+                    any_live |= next[q] != 0;
+                }
+                break;
+            }
+        }
+        if (!any_live)
+            return false;
+        std::swap(cur, next);
+    }
+    return cur[n] != 0;
+}
+
+bool glob_match(std::string_view pattern, std::string_view text, bool path_mode) {
+    return GlobPattern(pattern, path_mode).match(text);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// GlobPattern — compiled fnmatch-style wildcard pattern
+//
+//   *        any run of characters (in path mode: not crossing '/')
+//   ?        any one character (in path mode: not '/')
+//   [...]    a class: ranges (a-z), negation ([!x] or [^x]), POSIX classes
+//            ([[:digit:]]); a ']' right after the '[' is literal
+//   \c       the character c itself
+//   **       path mode only: any run of characters including '/'; "**/"
+//            also matches nothing, so "src/**/*.h" matches "src/a.h"
+//
+// A leading '.' is not special, like find -name. A '[' without its ']' is
+// a literal. Patterns without metacharacters, and the common "*x", "x*" and
+// "*x*" shapes, skip the general matcher and compare directly.
+//
+// Matching keeps no state, so one pattern can be shared between threads.
+// ---------------------------------------------------------------------------
+
+class GlobPattern {
+public:
+    GlobPattern() = default;
+    explicit GlobPattern(std::string_view pattern, bool path_mode = false);
+
+    bool match(std::string_view text) const;
+
+    bool empty() const { return source_.empty(); }
+    const std::string& source() const { return source_; }
+
+private:
+    enum class Op : uint8_t { literal, any, cls, star, globstar, globstar_dir };
+    enum class Shape : uint8_t { general, exact, prefix, suffix, contains };
+
+    struct Token {
+        Op op;
+        char ch;            // literal
+        uint16_t cls;       // index into classes_
+    };
+
+    using CharSet = std::array<uint64_t, 4>;
+
+    static bool in_set(const CharSet& set, unsigned char c) {
+        return (set[c >> 6] >> (c & 63)) & 1;
+    }
+
+    bool match_general(std::string_view text) const;
+
+    std::string source_;
+    bool path_mode_ = false;
+    Shape shape_ = Shape::general;
+    std::string literal_;   // for the direct shapes
+    std::vector<Token> tokens_;
+    std::vector<CharSet> classes_;
+};
+
+// One-shot convenience: GlobPattern(pattern).match(text).
+bool glob_match(std::string_view pattern, std::string_view text, bool path_mode = false);
@@ -0,0 +1,213 @@
+#include "remove_engine.h"
+#include "walker.h"
+#include "common/stats.h"
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Passes over a tree before giving up on directories that stay non-empty.
+static constexpr int kRemovePasses = 3;
+// Directories of one level per removal task.
+static constexpr size_t kRmdirBatch = 256;
+
+namespace {
+
+// Collects the directories of a tree and unlinks everything else as it is
+// listed. Failures are recorded, not thrown, so the rest still goes.
+class RemoveVisitor : public WalkVisitor {
+public:
+    bool visit(const WalkEntry& e, void*) override {
+        if (e.is_dir())
+            return true;
+        std::string name(e.name());
+        stats_syscalls();
+        if (unlinkat(e.dir_fd(), name.c_str(), 0) == 0) {
+            files.fetch_add(1, std::memory_order_relaxed);
+        } else if (errno == EISDIR) {
+            // d_type was stale: a directory replaced the entry meanwhile;
+            // the next pass picks it up.
+        } else if (errno != ENOENT) {
+            fail(e.path(), errno);
+        }
+        return false;
+    }
+
+    void* enter(const WalkEntry& e, void*) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dirs_.emplace_back(e.depth(), e.path());
+        return nullptr;
+    }
+
+    void error(const std::string& path, int err) override {
+        if (err != ENOENT)
+            fail(path, err);
+    }
+
+    void fail(const std::string& path, int err) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error_.empty())
+            error_ = "cannot remove '" + path + "': " + std::strerror(err);
+    }
+
+    // Removes the collected directories, deepest level first, each level
+    // in parallel. One left non-empty keeps the root from going, which
+    // remove_path notices.
+    void remove_dirs(ThreadPool& pool) {
+        std::stable_sort(dirs_.begin(), dirs_.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+        size_t begin = 0;
+        while (begin < dirs_.size()) {
+            size_t end = begin;
+            while (end < dirs_.size() && dirs_[end].first == dirs_[begin].first)
+                ++end;
+            for (size_t i = begin; i < end; i += kRmdirBatch) {
+                size_t last = std::min(end, i + kRmdirBatch);
+                pool.submit([this, i, last] {
+                    for (size_t j = i; j < last; ++j) {
+                        const std::string& path = dirs_[j].second;
+                        stats_syscalls();
+                        if (unlinkat(AT_FDCWD, path.c_str(), AT_REMOVEDIR) == 0)
+                            dirs.fetch_add(1, std::memory_order_relaxed);
+                        else if (errno != ENOTEMPTY && errno != EEXIST && errno != ENOENT)
+                            fail(path, errno);
+                    }
+                });
+            }
+            pool.wait();
+            begin = end;
+        }
+        dirs_.clear();
+    }
+
+    const std::string& first_error() const { return error_; }
+
+    std::atomic<uint64_t> files{0};
+    std::atomic<uint64_t> dirs{0};
+
+private:
+    std::mutex mutex_;
+    std::vector<std::pair<int, std::string>> dirs_;    // (depth, path)
+    std::string error_;
+};
+
+std::runtime_error remove_error(const std::string& path, int err) {
+    return std::runtime_error("cannot remove '" + path + "': " + std::strerror(err));
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// remove_path
+// ---------------------------------------------------------------------------
+
+RemoveStats remove_path(const std::string& path, ThreadPool& pool) {
+    RemoveStats stats;
+    FileStat st;
+    int err = stat_at(AT_FDCWD, path.c_str(), false, st);
+    if (err != 0)
+        throw remove_error(path, err);
+    if (st.type() != EntryType::dir) {
+        if (unlink(path.c_str()) != 0)
+            throw remove_error(path, errno);
+        stats.files = 1;
+        return stats;
+    }
+
+    RemoveVisitor visitor;
+    for (int pass = 1;; ++pass) {
+        walk_tree(path, pool, WalkOptions(), visitor, nullptr);
+        visitor.remove_dirs(pool);
+        if (!visitor.first_error().empty())
+            break;
+        if (unlinkat(AT_FDCWD, path.c_str(), AT_REMOVEDIR) == 0) {
+            visitor.dirs.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        int rmdir_err = errno;
+        if ((rmdir_err != ENOTEMPTY && rmdir_err != EEXIST) || pass == kRemovePasses) {
+            visitor.fail(path, rmdir_err);
+            break;
+        }
+        // Entries were missed while their directory changed: walk again.
+    }
+    if (!visitor.first_error().empty())
+        throw std::runtime_error(visitor.first_error());
+    stats.files = visitor.files.load();
+    stats.dirs = visitor.dirs.load();
+    return stats;
+}
+
+// ---------------------------------------------------------------------------
+// BackgroundRemove
+// ---------------------------------------------------------------------------
+
+struct BackgroundRemove::Shared {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    RemoveStats stats;
+    std::exception_ptr error;
+};
+
+// Splits "dir/name" into the directory (with its slash) and the name.
+static std::pair<std::string, std::string> split_path(std::string path) {
+    while (path.size() > 1 && path.back() == '/')
+        path.pop_back();
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos)
+        return {"", path};
+    return {path.substr(0, slash + 1), path.substr(slash + 1)};
+}
+
+BackgroundRemove::BackgroundRemove(const std::string& path, size_t threads)
+    : shared_(std::make_shared<Shared>()), path_(path) {
+    static std::atomic<unsigned> counter{0};
+    auto [dir, name] = split_path(path);
+    std::string hidden = dir + "." + name + ".rm-" + std::to_string(getpid()) + "-" +
+                         std::to_string(counter.fetch_add(1));
+    if (rename(path.c_str(), hidden.c_str()) == 0)
+        path_ = std::move(hidden);
+
+    std::thread([shared = shared_, target = path_, threads] {
+        RemoveStats stats;
+        std::exception_ptr error;
+        try {
+            ThreadPool pool(threads);
+            stats = remove_path(target, pool);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->stats = stats;
+        shared->error = error;
+        shared->done = true;
+        shared->cv.notify_all();
+    }).detach();
+}
+
+bool BackgroundRemove::done() const {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    return shared_->done;
+}
+
+RemoveStats BackgroundRemove::wait() {
+    std::unique_lock<std::mutex> lock(shared_->mutex);
+    shared_->cv.wait(lock, [this] { return shared_->done; });
+    if (shared_->error)
+        std::rethrow_exception(shared_->error);
+    return shared_->stats;
+}
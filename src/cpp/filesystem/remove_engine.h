@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class ThreadPool;
+
+// ---------------------------------------------------------------------------
+// Remove engine behind rm (and mv across filesystems)
+//
+// A tree is deleted on the parallel walker: every non-directory is removed
+// with unlinkat() relative to its parent's open descriptor as soon as it is
+// listed, using only the d_type from getdents64, so nothing is stat'ed and
+// no path is resolved per file. Directories are then removed deepest level
+// first, each level in parallel. Some filesystems (NFS, older tmpfs) may
+// skip entries of a directory that changes while it is being read; a
+// directory left non-empty that way is walked again.
+//
+// Errors do not stop the removal: everything that can be removed is, and
+// the first failure is thrown at the end, like rm -rf reporting and moving
+// on.
+// ---------------------------------------------------------------------------
+
+struct RemoveStats {
+    uint64_t files = 0;         // everything but directories
+    uint64_t dirs = 0;
+};
+
+// Removes `path`: a directory with everything below it, anything else
+// (including a symlink to a directory) with unlink. Throws
+// std::runtime_error naming the first entry that could not be removed.
+RemoveStats remove_path(const std::string& path, ThreadPool& pool);
+
+// ---------------------------------------------------------------------------
+// BackgroundRemove — rename, then delete on a background thread
+//
+// The target is first renamed to a hidden sibling (".<name>.rm-<pid>-<n>"
+// in the same directory, so always on the same filesystem). The original
+// name is free as soon as the constructor returns, and the slow delete
+// runs on its own thread and pool. If the rename is refused (a mount point,
+// a sticky directory) the target is deleted in place instead.
+//
+// Destroying the handle does not stop or wait for the removal. A process
+// that exits first leaves the rest of the hidden directory behind.
+// ---------------------------------------------------------------------------
+
+class BackgroundRemove {
+public:
+    // Starts removing `path` with `threads` workers (already resolved).
+    BackgroundRemove(const std::string& path, size_t threads);
+
+    // Where the target is being removed from: the hidden name, or the
+    // original path when it could not be renamed.
+    const std::string& path() const { return path_; }
+
+    bool done() const;
+
+    // Blocks until the removal has finished; rethrows its error.
+    RemoveStats wait();
+
+private:
+    struct Shared;
+    std::shared_ptr<Shared> shared_;
+    std::string path_;
+};
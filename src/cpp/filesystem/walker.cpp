@@ -0,0 +1,394 @@
+#include "walker.h"
+#include "common/stats.h"
+#include "common/thread_pool.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+// getdents64 buffer per open directory; large enough that a directory of a
+// few thousand entries is read in one or two syscalls.
+static constexpr size_t kDirBufferSize = 32 * 1024;
+
+// Subdirectories are opened with openat while their parent is still open
+// and the descriptor is kept until the task runs, up to this many at once.
+// Past that, queued directories are reopened by path instead.
+static constexpr int kMaxHeldDirFds = 256;
+
+// ---------------------------------------------------------------------------
+// Metadata
+// ---------------------------------------------------------------------------
+
+EntryType entry_type_from_mode(uint32_t mode) {
+    switch (mode & S_IFMT) {
+        case S_IFREG:  return EntryType::file;
+        case S_IFDIR:  return EntryType::dir;
+        case S_IFLNK:  return EntryType::symlink;
+        case S_IFBLK:  return EntryType::block;
+        case S_IFCHR:  return EntryType::character;
+        case S_IFIFO:  return EntryType::fifo;
+        case S_IFSOCK: return EntryType::socket;
+        default:       return EntryType::unknown;
+    }
+}
+
+static EntryType entry_type_from_dtype(unsigned char d_type) {
+    switch (d_type) {
+        case DT_REG:  return EntryType::file;
+        case DT_DIR:  return EntryType::dir;
+        case DT_LNK:  return EntryType::symlink;
+        case DT_BLK:  return EntryType::block;
+        case DT_CHR:  return EntryType::character;
+        case DT_FIFO: return EntryType::fifo;
+        case DT_SOCK: return EntryType::socket;
+        default:      return EntryType::unknown;
+    }
+}
+
+int stat_at(int dir_fd, const char* name, bool follow, FileStat& out) {
+    int flags = AT_NO_AUTOMOUNT | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+    stats_syscalls();
+#ifdef STATX_BASIC_STATS
+    struct statx sx;
+    if (statx(dir_fd, name, flags, STATX_BASIC_STATS | STATX_BTIME, &sx) == 0) {
+        out.mode = sx.stx_mode;
+        out.nlink = sx.stx_nlink;
+        out.uid = sx.stx_uid;
+        out.gid = sx.stx_gid;
+        out.ino = sx.stx_ino;
+        out.dev = makedev(sx.stx_dev_major, sx.stx_dev_minor);
+        out.rdev = makedev(sx.stx_rdev_major, sx.stx_rdev_minor);
+        out.size = sx.stx_size;
+        out.blocks = sx.stx_blocks;
+        out.blksize = sx.stx_blksize;
+        out.atime_sec = sx.stx_atime.tv_sec;
+        out.atime_nsec = sx.stx_atime.tv_nsec;
+        out.mtime_sec = sx.stx_mtime.tv_sec;
+        out.mtime_nsec = sx.stx_mtime.tv_nsec;
+        out.ctime_sec = sx.stx_ctime.tv_sec;
+        out.ctime_nsec = sx.stx_ctime.tv_nsec;
+        out.has_btime = (sx.stx_mask & STATX_BTIME) != 0;
+        if (out.has_btime) {
+            out.btime_sec = sx.stx_btime.tv_sec;
+            out.btime_nsec = sx.stx_btime.tv_nsec;
+        }
+        return 0;
+    }
+    if (errno != ENOSYS)
+        return errno;
+#endif
+    struct stat st;
+    if (fstatat(dir_fd, name, &st, flags) != 0)
+        return errno;
+    out.mode = st.st_mode;
+    out.nlink = static_cast<uint32_t>(st.st_nlink);
+    out.uid = st.st_uid;
+    out.gid = st.st_gid;
+    out.ino = st.st_ino;
+    out.dev = st.st_dev;
+    out.rdev = st.st_rdev;
+    out.size = static_cast<uint64_t>(st.st_size);
+    out.blocks = static_cast<uint64_t>(st.st_blocks);
+    out.blksize = static_cast<uint32_t>(st.st_blksize);
+    out.atime_sec = st.st_atim.tv_sec;
+    out.atime_nsec = static_cast<uint32_t>(st.st_atim.tv_nsec);
+    out.mtime_sec = st.st_mtim.tv_sec;
+    out.mtime_nsec = static_cast<uint32_t>(st.st_mtim.tv_nsec);
+    out.ctime_sec = st.st_ctim.tv_sec;
+    out.ctime_nsec = static_cast<uint32_t>(st.st_ctim.tv_nsec);
+    out.has_btime = false;
+    return 0;
+}
+
+std::string join_path(std::string_view dir, std::string_view name) {
+    std::string p;
+    p.reserve(dir.size() + 1 + name.size());
+    p.append(dir.data(), dir.size());
+    if (!p.empty() && p.back() != '/')
+        p.push_back('/');
+    p.append(name.data(), name.size());
+    return p;
+}
+
+// ---------------------------------------------------------------------------
+// WalkEntry
+// ---------------------------------------------------------------------------
+
+const FileStat* WalkEntry::stat() const {
+    if (stat_state_ == 0) {
+        std::string name(name_);
+        stat_state_ = stat_at(dir_fd_, name.c_str(), false, stat_) == 0 ? 1 : -1;
+    }
+    return stat_state_ > 0 ? &stat_ : nullptr;
+}
+
+const FileStat* WalkEntry::target_stat() const {
+    if (type_ != EntryType::symlink)
+        return stat();
+    if (target_state_ == 0) {
+        std::string name(name_);
+        target_state_ = stat_at(dir_fd_, name.c_str(), true, target_) == 0 ? 1 : -1;
+    }
+    return target_state_ > 0 ? &target_ : nullptr;
+}
+
+EntryType WalkEntry::target_type() const {
+    if (type_ != EntryType::symlink)
+        return type_;
+    const FileStat* st = target_stat();
+    return st ? st->type() : EntryType::unknown;
+}
+
+// ---------------------------------------------------------------------------
+// Reading a directory
+// ---------------------------------------------------------------------------
+
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Iterates the entries of an open directory with getdents64, skipping "."
+// and "..".
+class DirReader {
+public:
+    explicit DirReader(int fd) : fd_(fd), buffer_(new char[kDirBufferSize]) {}
+
+    // Returns false at the end or on error (see error()).
+    bool next(const LinuxDirent64*& ent) {
+        for (;;) {
+            if (pos_ >= len_) {
+                long n = syscall(SYS_getdents64, fd_, buffer_.get(), kDirBufferSize);
+                stats_syscalls();
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    if (n < 0) error_ = errno;
+                    return false;
+                }
+                len_ = static_cast<size_t>(n);
+                pos_ = 0;
+                stats_bytes(len_);
+            }
+            ent = reinterpret_cast<const LinuxDirent64*>(buffer_.get() + pos_);
+            pos_ += ent->d_reclen;
+            const char* name = ent->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                continue;
+            return true;
+        }
+    }
+
+    int error() const { return error_; }
+
+private:
+    int fd_;
+    std::unique_ptr<char[]> buffer_;
+    size_t pos_ = 0;
+    size_t len_ = 0;
+    int error_ = 0;
+};
+
+// Opens a directory for reading. Only the walk root may be a symlink.
+static int open_dir_at(int dir_fd, const char* name, bool follow = false) {
+    int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | (follow ? 0 : O_NOFOLLOW);
+    int fd;
+    do {
+        fd = openat(dir_fd, name, flags);
+        stats_syscalls();
+    } while (fd < 0 && errno == EINTR);
+    if (fd >= 0)
+        stats_syscalls();           // the close that goes with it
+    return fd;
+}
+
+// ---------------------------------------------------------------------------
+// walk_tree
+// ---------------------------------------------------------------------------
+
+class DirWalk {
+public:
+    DirWalk(ThreadPool& pool, const WalkOptions& opts, WalkVisitor& visitor)
+        : pool_(pool), opts_(opts), visitor_(visitor) {}
+
+    // Fills in the type with statx when the filesystem leaves d_type unknown.
+    static void resolve_type(WalkEntry& entry) {
+        if (entry.type_ != EntryType::unknown)
+            return;
+        if (const FileStat* st = entry.stat())
+            entry.type_ = st->type();
+    }
+
+    // Lists one directory. `fd` is an already opened descriptor (owned by
+    // this call) or -1 to open `path`.
+    void list(std::string path, int fd, bool held, int depth, void* state) {
+        if (held)
+            held_fds_.fetch_sub(1, std::memory_order_relaxed);
+        if (fd < 0) {
+            fd = open_dir_at(AT_FDCWD, path.c_str(), depth == 0);
+            if (fd < 0) {
+                visitor_.error(path, errno);
+                return;
+            }
+        }
+        FdGuard guard{fd};
+        if (stop_.load(std::memory_order_relaxed))
+            return;
+
+        try {
+            std::vector<std::string> names;
+            if (visitor_.cached_listing(path, fd, state, names)) {
+                for (const auto& name : names) {
+                    if (stop_.load(std::memory_order_relaxed))
+                        return;
+                    WalkEntry entry(fd, path, name, EntryType::unknown, depth + 1, 0);
+                    resolve_type(entry);
+                    visit_entry(fd, entry, state);
+                }
+                return;
+            }
+
+            DirReader reader(fd);
+            const LinuxDirent64* ent;
+            while (reader.next(ent)) {
+                if (stop_.load(std::memory_order_relaxed))
+                    return;
+                WalkEntry entry(fd, path, ent->d_name, entry_type_from_dtype(ent->d_type),
+                                depth + 1, ent->d_ino);
+                resolve_type(entry);
+                visit_entry(fd, entry, state);
+            }
+            if (reader.error() != 0)
+                visitor_.error(path, reader.error());
+        } catch (...) {
+            stop_.store(true, std::memory_order_relaxed);
+            throw;
+        }
+    }
+
+private:
+    struct FdGuard {
+        int fd;
+        ~FdGuard() { ::close(fd); }
+    };
+
+    void visit_entry(int dir_fd, const WalkEntry& entry, void* state) {
+        bool descend = visitor_.visit(entry, state);
+        if (!descend || !entry.is_dir())
+            return;
+        if (opts_.max_depth >= 0 && entry.depth() >= opts_.max_depth)
+            return;
+        descend_into(dir_fd, entry, visitor_.enter(entry, state));
+    }
+
+    void descend_into(int parent_fd, const WalkEntry& entry, void* state) {
+        std::string child = entry.path();
+        int child_fd = -1;
+        bool held = false;
+        if (held_fds_.fetch_add(1, std::memory_order_relaxed) < kMaxHeldDirFds) {
+            std::string name(entry.name());
+            child_fd = open_dir_at(parent_fd, name.c_str());
+            if (child_fd < 0) {
+                held_fds_.fetch_sub(1, std::memory_order_relaxed);
+                visitor_.error(child, errno);
+                return;
+            }
+            held = true;
+        } else {
+            held_fds_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        int depth = entry.depth();
+        pool_.submit([this, child = std::move(child), child_fd, held, depth, state]() mutable {
+            list(std::move(child), child_fd, held, depth, state);
+        });
+    }
+
+    ThreadPool& pool_;
+    const WalkOptions& opts_;
+    WalkVisitor& visitor_;
+    std::atomic<int> held_fds_{0};
+    std::atomic<bool> stop_{false};
+};
+
+void walk_tree(const std::string& root, ThreadPool& pool, const WalkOptions& opts,
+               WalkVisitor& visitor, void* root_state) {
+    DirWalk walk(pool, opts, visitor);
+    if (opts.max_depth != 0) {
+        try {
+            walk.list(root, -1, false, 0, root_state);
+        } catch (...) {
+            // Queued directories still reference `walk`; let them finish.
+            try { pool.wait(); } catch (...) {}
+            throw;
+        }
+    }
+    pool.wait();
+}
+
+// ---------------------------------------------------------------------------
+// WalkStream
+// ---------------------------------------------------------------------------
+
+struct WalkStream::Frame {
+    std::string path;
+    int fd;
+    int depth;
+    DirReader reader;
+
+    Frame(std::string p, int f, int d) : path(std::move(p)), fd(f), depth(d), reader(f) {}
+    ~Frame() { ::close(fd); }
+};
+
+WalkStream::WalkStream(const std::string& root, const WalkOptions& opts) : opts_(opts) {
+    if (opts_.max_depth == 0)
+        return;
+    int fd = open_dir_at(AT_FDCWD, root.c_str(), true);
+    if (fd >= 0)
+        stack_.push_back(std::make_unique<Frame>(root, fd, 0));
+}
+
+WalkStream::~WalkStream() = default;
+
+bool WalkStream::next() {
+    if (descend_ && entry_) {
+        descend_ = false;
+        std::string name(entry_->name());
+        int fd = open_dir_at(stack_.back()->fd, name.c_str());
+        if (fd >= 0)
+            stack_.push_back(std::make_unique<Frame>(entry_->path(), fd, entry_->depth()));
+    }
+    descend_ = false;
+    entry_.reset();
+
+    while (!stack_.empty()) {
+        Frame& top = *stack_.back();
+        const LinuxDirent64* ent;
+        if (!top.reader.next(ent)) {
+            stack_.pop_back();
+            continue;
+        }
+        entry_ = std::make_unique<WalkEntry>(top.fd, top.path, ent->d_name,
+                                             entry_type_from_dtype(ent->d_type),
+                                             top.depth + 1, ent->d_ino);
+        DirWalk::resolve_type(*entry_);
+        descend_ = entry_->is_dir() &&
+                   (opts_.max_depth < 0 || entry_->depth() < opts_.max_depth);
+        return true;
+    }
+    return false;
+}
+
+void WalkStream::close() {
+    entry_.reset();
+    stack_.clear();
+    descend_ = false;
+}
@@ -0,0 +1,267 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class ThreadPool;
+
+// ---------------------------------------------------------------------------
+// Directory walker — the tree traversal behind find, du, ls, chmod, chown
+// and grep's recursive mode
+//
+// Directories are read with getdents64 through file descriptors, and
+// subdirectories are opened with openat relative to their parent, so the
+// kernel never re-resolves a full path. Entry types come from d_type. Most
+// entries therefore cost no stat at all, and statx runs only when a caller
+// asks for metadata (or the filesystem does not report d_type). Each
+// directory is one task on a work-stealing ThreadPool, so wide trees and
+// high-latency filesystems (NFS) are listed in parallel.
+//
+// Symlinks are reported but never followed when descending, and
+// directories that cannot be opened or read are skipped, like
+// fs::directory_options::skip_permission_denied.
+// ---------------------------------------------------------------------------
+
+enum class EntryType : uint8_t {
+    unknown, file, dir, symlink, block, character, fifo, socket
+};
+
+// Type of a stat mode (S_IFMT bits).
+EntryType entry_type_from_mode(uint32_t mode);
+
+// The metadata of one file, as filled in by statx (or fstatat where statx
+// is unavailable).
+struct FileStat {
+    uint32_t mode = 0;
+    uint32_t nlink = 0;
+    uint32_t uid = 0;
+    uint32_t gid = 0;
+    uint64_t ino = 0;
+    uint64_t dev = 0;
+    uint64_t rdev = 0;
+    uint64_t size = 0;
+    uint64_t blocks = 0;        // 512-byte units
+    uint32_t blksize = 0;
+    int64_t atime_sec = 0;
+    int64_t mtime_sec = 0;
+    int64_t ctime_sec = 0;
+    int64_t btime_sec = 0;      // only valid when has_btime
+    uint32_t atime_nsec = 0;
+    uint32_t mtime_nsec = 0;
+    uint32_t ctime_nsec = 0;
+    uint32_t btime_nsec = 0;
+    bool has_btime = false;
+
+    EntryType type() const { return entry_type_from_mode(mode); }
+};
+
+// statx(dir_fd, name) without triggering automounts. `follow` follows a
+// final symlink. Use AT_FDCWD as dir_fd for a plain path. Returns 0 or an
+// errno value.
+int stat_at(int dir_fd, const char* name, bool follow, FileStat& out);
+
+// "dir/name", without doubling a trailing slash of `dir`.
+std::string join_path(std::string_view dir, std::string_view name);
+
+// ---------------------------------------------------------------------------
+// WalkEntry — one directory entry, valid for the duration of a visit
+// ---------------------------------------------------------------------------
+
+class WalkEntry {
+public:
+    WalkEntry(int dir_fd, const std::string& dir_path, std::string_view name,
+              EntryType type, int depth, uint64_t ino)
+        : dir_fd_(dir_fd), dir_path_(dir_path), name_(name), type_(type),
+          depth_(depth), ino_(ino) {}
+
+    // Open descriptor of the containing directory, for *at() calls.
+    int dir_fd() const { return dir_fd_; }
+    const std::string& dir_path() const { return dir_path_; }
+    std::string_view name() const { return name_; }
+    std::string path() const { return join_path(dir_path_, name_); }
+
+    // Type of the entry itself (a symlink is EntryType::symlink).
+    EntryType type() const { return type_; }
+    bool is_dir() const { return type_ == EntryType::dir; }
+    bool is_symlink() const { return type_ == EntryType::symlink; }
+
+    // 1 for the children of the walk root, 2 for theirs, ...
+    int depth() const { return depth_; }
+    uint64_t ino() const { return ino_; }
+
+    // lstat-style metadata, fetched with one statx on first use. nullptr if
+    // the entry disappeared in the meantime.
+    const FileStat* stat() const;
+
+    // Metadata of what the entry refers to: the same as stat() except that
+    // symlinks are followed. nullptr for a dangling link.
+    const FileStat* target_stat() const;
+
+    // Type after following symlinks (unknown for a dangling link).
+    EntryType target_type() const;
+
+private:
+    friend class DirWalk;
+
+    int dir_fd_;
+    const std::string& dir_path_;
+    std::string_view name_;
+    EntryType type_;
+    int depth_;
+    uint64_t ino_;
+
+    mutable FileStat stat_;
+    mutable FileStat target_;
+    mutable int8_t stat_state_ = 0;     // 0 = not fetched, 1 = ok, -1 = failed
+    mutable int8_t target_state_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// walk_tree — parallel traversal
+// ---------------------------------------------------------------------------
+
+struct WalkOptions {
+    // Deepest level to visit (1 = only the root's children); -1 = no limit.
+    int max_depth = -1;
+};
+
+// Receives the entries of a walk. visit() and enter() are called from pool
+// workers concurrently, but all calls for the entries of one directory come
+// from the same task, in readdir order.
+class WalkVisitor {
+public:
+    virtual ~WalkVisitor() = default;
+
+    // Called for every entry below the root. `dir_state` is what enter()
+    // returned for the containing directory (the walk's root_state for the
+    // root). Return false to not descend into a directory entry.
+    virtual bool visit(const WalkEntry& entry, void* dir_state) = 0;
+
+    // Called for a directory entry that is about to be descended into,
+    // right after its visit(); returns the state handed to the visits of
+    // its children.
+    virtual void* enter(const WalkEntry& /*dir*/, void* /*parent_state*/) { return nullptr; }
+
+    // A directory that could not be opened or read. Skipped by default.
+    virtual void error(const std::string& /*path*/, int /*err*/) {}
+
+    // Called with each directory's open descriptor before it is read.
+    // Returning true replaces the listing: only the entries named in
+    // `names` are visited (their types are stat'ed), so a visitor that
+    // remembers an unchanged directory (du's cache) can skip reading it.
+    virtual bool cached_listing(const std::string& /*path*/, int /*dir_fd*/,
+                                void* /*dir_state*/, std::vector<std::string>& /*names*/) {
+        return false;
+    }
+};
+
+// Walks the tree below `root` (the root itself is not visited) on `pool`
+// and waits for the pool to drain, rethrowing the first exception a visitor
+// or any other task on the pool raised.
+void walk_tree(const std::string& root, ThreadPool& pool, const WalkOptions& opts,
+               WalkVisitor& visitor, void* root_state = nullptr);
+
+// ---------------------------------------------------------------------------
+// WalkOrder — deterministic output from a parallel walk
+//
+// Keeps per-directory output buckets linked into a tree, so once the walk is
+// done the items come out exactly as a serial pre-order walk would have
+// produced them, whatever the thread count. Use node() and child() from a
+// WalkVisitor's visit() and enter():
+//
+//     bool visit(const WalkEntry& e, void* dir) override {
+//         order.node(dir).push_back(e.path());
+//         return true;
+//     }
+//     void* enter(const WalkEntry&, void* parent) override {
+//         return order.child(parent);
+//     }
+// ---------------------------------------------------------------------------
+
+template <typename T>
+class WalkOrder {
+public:
+    struct Node {
+        std::deque<T> items;    // deque: references stay valid as it grows
+        // Children, each placed after the first `pos` items of this node.
+        std::vector<std::pair<size_t, std::unique_ptr<Node>>> children;
+    };
+
+    void* root() { return &root_; }
+
+    std::deque<T>& node(void* state) { return static_cast<Node*>(state)->items; }
+
+    // New child bucket of `parent`, ordered after its current items.
+    void* child(void* parent) {
+        Node* p = static_cast<Node*>(parent);
+        p->children.emplace_back(p->items.size(), std::make_unique<Node>());
+        return p->children.back().second.get();
+    }
+
+    // Moves every item out in pre-order. Call after the walk.
+    std::vector<T> take() {
+        std::vector<T> out;
+        struct Frame { Node* node; size_t item; size_t child; };
+        std::vector<Frame> stack{{&root_, 0, 0}};
+        while (!stack.empty()) {
+            Frame& f = stack.back();
+            Node* n = f.node;
+            if (f.child < n->children.size() && n->children[f.child].first <= f.item) {
+                Node* c = n->children[f.child++].second.get();
+                stack.push_back({c, 0, 0});
+                continue;
+            }
+            if (f.item < n->items.size()) {
+                out.push_back(std::move(n->items[f.item++]));
+                continue;
+            }
+            stack.pop_back();
+        }
+        root_ = Node();
+        return out;
+    }
+
+private:
+    Node root_;
+};
+
+// ---------------------------------------------------------------------------
+// WalkStream — lazy, serial pre-order walk
+//
+// For callers that consume entries one at a time and may stop early (the
+// streaming iterators). Holds one open descriptor per level of the current
+// path.
+// ---------------------------------------------------------------------------
+
+class WalkStream {
+public:
+    // Returns false from next() straight away if `root` cannot be opened.
+    explicit WalkStream(const std::string& root, const WalkOptions& opts = WalkOptions());
+    ~WalkStream();
+
+    WalkStream(const WalkStream&) = delete;
+    WalkStream& operator=(const WalkStream&) = delete;
+
+    // Advances to the next entry; false at the end. The entry stays valid
+    // until the following call. Directories are descended into after they
+    // have been returned, unless skip_children() is called first.
+    bool next();
+    const WalkEntry& entry() const { return *entry_; }
+    void skip_children() { descend_ = false; }
+
+    // Drops all remaining entries and closes every descriptor.
+    void close();
+
+private:
+    struct Frame;
+
+    std::vector<std::unique_ptr<Frame>> stack_;
+    std::unique_ptr<WalkEntry> entry_;
+    WalkOptions opts_;
+    bool descend_ = false;
+};
@@ -1,5 +1,9 @@
+#include "common/stats.h"
 #include <pybind11/pybind11.h>
 
+#include <cstdlib>
+#include <cstring>
+
 namespace py = pybind11;
 
 // Forward declarations for each submodule initializer
@@ -9,6 +13,30 @@ void init_system(py::module_ &m);
 void init_process(py::module_ &m);
 void init_network(py::module_ &m);
 
+// ---------------------------------------------------------------------------
+// stats — per-command counters
+// ---------------------------------------------------------------------------
+
+static py::dict stats_impl(bool reset) {
+    py::dict res;
+    for (const auto& s : stats_snapshot(reset)) {
+        py::dict latency;
+        for (size_t i = 0; i < kStatsLatencyBuckets; i++) {
+            if (s.latency[i] > 0)
+                latency[py::int_(uint64_t(1) << i)] = s.latency[i];
+        }
+        py::dict d;
+        d["calls"] = s.calls;
+        d["bytes"] = s.bytes;
+        d["syscalls"] = s.syscalls;
+        d["total_seconds"] = static_cast<double>(s.total_ns) / 1e9;
+        d["mean_us"] = s.calls ? static_cast<double>(s.total_ns) / 1e3 / s.calls : 0.0;
+        d["latency_us"] = latency;
+        res[py::str(s.name)] = d;
+    }
+    return res;
+}
+
 PYBIND11_MODULE(_core, m) {
     m.doc() = R"doc(
         ShellFast Core C++ Module
@@ -31,4 +59,44 @@ PYBIND11_MODULE(_core, m) {
     init_system(m);
     init_process(m);
     init_network(m);
+
+    // Set SHELLFAST_STATS=1 to collect from the first call on.
+    const char* env = std::getenv("SHELLFAST_STATS");
+    if (env && env[0] && std::strcmp(env, "0") != 0)
+        stats_enable(true);
+
+    m.def("stats", &stats_impl,
+        R"doc(
+        Per-command call statistics.
+
+        Collected only while enabled (``stats_enable(True)``, or the
+        ``SHELLFAST_STATS=1`` environment variable at import). Counters are
+        kept per thread and summed here, so collection costs a few plain
+        stores per call and per system call.
+
+        Args:
+            reset (bool): Start the next snapshot from zero.
+
+        Returns:
+            dict: Command name -> dict with ``calls``, ``bytes`` (read from
+            files, directories and /proc by the native kernels),
+            ``syscalls`` (made by those kernels), ``total_seconds``,
+            ``mean_us`` and ``latency_us``, a histogram mapping an upper
+            bound in microseconds (a power of two) to the number of calls
+            that took less than it. Only commands called since the last
+            reset are listed.
+        )doc",
+        py::arg("reset") = false);
+
+    m.def("stats_enable", &stats_enable,
+        R"doc(
+        Turn collection for ``stats()`` on or off.
+
+        Args:
+            enabled (bool): New setting.
+
+        Returns:
+            bool: The previous setting.
+        )doc",
+        py::arg("enabled") = true);
 }
@@ -0,0 +1,58 @@
+#include "iface_sampler.h"
+
+#include <time.h>
+
+static double monotonic_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec) + ts.tv_nsec / 1e9;
+}
+
+static double rate(uint64_t now, uint64_t before, double dt) {
+    return now >= before ? static_cast<double>(now - before) / dt : 0;
+}
+
+InterfaceSampler::InterfaceSampler(std::vector<std::string> names)
+    : names_(names.begin(), names.end()) {}
+
+std::vector<LinkSample> InterfaceSampler::sample() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<LinkInfo> links = dump_links("", false);
+    double now = monotonic_seconds();
+    double dt = previous_time_ < 0 ? 0 : now - previous_time_;
+
+    std::unordered_map<std::string, LinkInfo> next;
+    std::vector<LinkSample> samples;
+    for (auto& link : links) {
+        if (!names_.empty() && !names_.count(link.name))
+            continue;
+        LinkSample s;
+        auto prev = previous_.find(link.name);
+        if (prev != previous_.end() && prev->second.index == link.index && dt > 0) {
+            const LinkStats& a = link.stats;
+            const LinkStats& b = prev->second.stats;
+            s.is_new = false;
+            s.rx_bytes_rate = rate(a.rx_bytes, b.rx_bytes, dt);
+            s.tx_bytes_rate = rate(a.tx_bytes, b.tx_bytes, dt);
+            s.rx_packets_rate = rate(a.rx_packets, b.rx_packets, dt);
+            s.tx_packets_rate = rate(a.tx_packets, b.tx_packets, dt);
+            s.rx_dropped_rate = rate(a.rx_dropped, b.rx_dropped, dt);
+            s.tx_dropped_rate = rate(a.tx_dropped, b.tx_dropped, dt);
+            s.rx_errors_rate = rate(a.rx_errors, b.rx_errors, dt);
+            s.tx_errors_rate = rate(a.tx_errors, b.tx_errors, dt);
+        }
+        next.emplace(link.name, link);
+        s.link = std::move(link);
+        samples.push_back(std::move(s));
+    }
+
+    previous_ = std::move(next);
+    previous_time_ = now;
+    last_interval_ = dt;
+    return samples;
+}
+
+double InterfaceSampler::last_interval() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_interval_;
+}
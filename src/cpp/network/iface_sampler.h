@@ -0,0 +1,48 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "netlink.h"
+
+// ---------------------------------------------------------------------------
+// InterfaceSampler — interface rates from consecutive netlink dumps
+//
+// Each sample is one RTM_GETLINK dump (no address dump). The sampler keeps
+// every interface's counters from the previous sample and reports the
+// change since then, per second. An interface is matched to its previous
+// sample by name and ifindex, so a veth deleted and recreated under the
+// same name counts as new. A new interface has no rates. A counter that
+// went backwards (driver reset) reads as 0.
+// ---------------------------------------------------------------------------
+
+struct LinkSample {
+    LinkInfo link;
+    bool is_new = true;     // no previous sample; rates are 0
+    double rx_bytes_rate = 0, tx_bytes_rate = 0;
+    double rx_packets_rate = 0, tx_packets_rate = 0;
+    double rx_dropped_rate = 0, tx_dropped_rate = 0;
+    double rx_errors_rate = 0, tx_errors_rate = 0;
+};
+
+class InterfaceSampler {
+public:
+    // Samples only `names` if not empty.
+    explicit InterfaceSampler(std::vector<std::string> names);
+
+    // Takes a dump now and returns the rates since the previous one, in
+    // ifindex order. Throws std::runtime_error if netlink fails.
+    std::vector<LinkSample> sample();
+
+    // Seconds the latest sample covers (0 before the second one).
+    double last_interval() const;
+
+private:
+    std::unordered_set<std::string> names_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, LinkInfo> previous_;
+    double previous_time_ = -1;     // monotonic seconds
+    double last_interval_ = 0;
+};
@@ -0,0 +1,213 @@
+#include "netlink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <arpa/inet.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+class NetlinkSocket {
+public:
+    NetlinkSocket() {
+        fd_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+        if (fd_ < 0)
+            throw std::runtime_error(std::string("netlink: ") + std::strerror(errno));
+    }
+    ~NetlinkSocket() { close(fd_); }
+
+    NetlinkSocket(const NetlinkSocket&) = delete;
+    NetlinkSocket& operator=(const NetlinkSocket&) = delete;
+
+    // Sends a dump request of `type` and calls `on_message` for every
+    // message of the reply.
+    template <typename Fn>
+    void dump(uint16_t type, Fn&& on_message) {
+        struct {
+            struct nlmsghdr header;
+            struct rtgenmsg body;
+        } req = {};
+        req.header.nlmsg_len = NLMSG_LENGTH(sizeof(req.body));
+        req.header.nlmsg_type = type;
+        req.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+        req.header.nlmsg_seq = ++seq_;
+        req.body.rtgen_family = AF_UNSPEC;
+        if (send(fd_, &req, req.header.nlmsg_len, 0) < 0)
+            throw std::runtime_error(std::string("netlink: ") + std::strerror(errno));
+
+        for (;;) {
+            ssize_t n = recv(fd_, buf_, sizeof(buf_), 0);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error(std::string("netlink: ") + std::strerror(errno));
+            }
+            auto len = static_cast<unsigned>(n);
+            for (auto* h = reinterpret_cast<struct nlmsghdr*>(buf_); NLMSG_OK(h, len);
+                 h = NLMSG_NEXT(h, len)) {
+                if (h->nlmsg_seq != seq_)
+                    continue;
+                if (h->nlmsg_type == NLMSG_DONE)
+                    return;
+                if (h->nlmsg_type == NLMSG_ERROR) {
+                    auto* err = static_cast<struct nlmsgerr*>(NLMSG_DATA(h));
+                    throw std::runtime_error(std::string("netlink: ") +
+                                             std::strerror(-err->error));
+                }
+                on_message(h);
+            }
+        }
+    }
+
+private:
+    int fd_ = -1;
+    uint32_t seq_ = 0;
+    alignas(struct nlmsghdr) char buf_[64 * 1024];     // a dump part is at most 32 KiB
+};
+
+std::string format_mac(const unsigned char* data, size_t len) {
+    std::string out;
+    char part[4];
+    for (size_t i = 0; i < len; ++i) {
+        snprintf(part, sizeof(part), i ? ":%02x" : "%02x", data[i]);
+        out += part;
+    }
+    return out;
+}
+
+std::string format_ip(int family, const void* data) {
+    char ip[INET6_ADDRSTRLEN] = "";
+    inet_ntop(family, data, ip, sizeof(ip));
+    return ip;
+}
+
+void parse_link(const struct nlmsghdr* h, LinkInfo& link) {
+    auto* ifi = static_cast<const struct ifinfomsg*>(NLMSG_DATA(h));
+    link.index = ifi->ifi_index;
+    link.flags = ifi->ifi_flags;
+
+    bool have_stats64 = false;
+    int len = static_cast<int>(IFLA_PAYLOAD(h));
+    for (auto* rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        const void* data = RTA_DATA(rta);
+        size_t size = RTA_PAYLOAD(rta);
+        switch (rta->rta_type) {
+            case IFLA_IFNAME: {
+                auto* name = static_cast<const char*>(data);
+                link.name.assign(name, strnlen(name, size));
+                break;
+            }
+            case IFLA_MTU:
+                if (size >= sizeof(uint32_t))
+                    link.mtu = static_cast<int>(*static_cast<const uint32_t*>(data));
+                break;
+            case IFLA_ADDRESS:
+                link.mac = format_mac(static_cast<const unsigned char*>(data), size);
+                break;
+            case IFLA_STATS64: {
+                struct rtnl_link_stats64 s = {};
+                std::memcpy(&s, data, std::min(size, sizeof(s)));
+                link.stats = {s.rx_packets, s.tx_packets, s.rx_bytes, s.tx_bytes,
+                              s.rx_errors, s.tx_errors, s.rx_dropped, s.tx_dropped,
+                              s.multicast, s.collisions};
+                link.has_stats = have_stats64 = true;
+                break;
+            }
+            case IFLA_STATS:
+                if (!have_stats64) {
+                    struct rtnl_link_stats s = {};
+                    std::memcpy(&s, data, std::min(size, sizeof(s)));
+                    link.stats = {s.rx_packets, s.tx_packets, s.rx_bytes, s.tx_bytes,
+                                  s.rx_errors, s.tx_errors, s.rx_dropped, s.tx_dropped,
+                                  s.multicast, s.collisions};
+                    link.has_stats = true;
+                }
+                break;
+            case IFLA_LINKINFO: {
+                int nested = static_cast<int>(size);
+                for (auto* info = static_cast<const struct rtattr*>(data); RTA_OK(info, nested);
+                     info = RTA_NEXT(info, nested)) {
+                    if (info->rta_type == IFLA_INFO_KIND) {
+                        auto* kind = static_cast<const char*>(RTA_DATA(info));
+                        link.kind.assign(kind, strnlen(kind, RTA_PAYLOAD(info)));
+                    }
+                }
+                break;
+            }
+        }
+    }
+}
+
+// Returns the interface index of the address, or 0 if it is not IPv4/IPv6.
+int parse_address(const struct nlmsghdr* h, LinkAddress& addr) {
+    auto* ifa = static_cast<const struct ifaddrmsg*>(NLMSG_DATA(h));
+    if (ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6)
+        return 0;
+    addr.family = ifa->ifa_family;
+    addr.prefixlen = ifa->ifa_prefixlen;
+    addr.scope = ifa->ifa_scope;
+
+    // IFA_LOCAL is the local address; IFA_ADDRESS is the peer on
+    // point-to-point links and the same as IFA_LOCAL otherwise.
+    std::string local;
+    int len = static_cast<int>(IFA_PAYLOAD(h));
+    for (auto* rta = IFA_RTA(ifa); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        switch (rta->rta_type) {
+            case IFA_ADDRESS:   addr.address = format_ip(addr.family, RTA_DATA(rta)); break;
+            case IFA_LOCAL:     local = format_ip(addr.family, RTA_DATA(rta)); break;
+            case IFA_BROADCAST: addr.broadcast = format_ip(addr.family, RTA_DATA(rta)); break;
+        }
+    }
+    if (!local.empty())
+        addr.address = local;
+    return static_cast<int>(ifa->ifa_index);
+}
+
+}  // namespace
+
+std::vector<LinkInfo> dump_links(const std::string& name, bool addresses) {
+    NetlinkSocket nl;
+    std::vector<LinkInfo> links;
+    nl.dump(RTM_GETLINK, [&](const struct nlmsghdr* h) {
+        if (h->nlmsg_type != RTM_NEWLINK)
+            return;
+        LinkInfo link;
+        parse_link(h, link);
+        if (name.empty() || link.name == name)
+            links.push_back(std::move(link));
+    });
+    std::sort(links.begin(), links.end(),
+              [](const LinkInfo& a, const LinkInfo& b) { return a.index < b.index; });
+
+    if (addresses && !links.empty()) {
+        std::unordered_map<int, size_t> by_index;
+        for (size_t i = 0; i < links.size(); ++i)
+            by_index[links[i].index] = i;
+        nl.dump(RTM_GETADDR, [&](const struct nlmsghdr* h) {
+            if (h->nlmsg_type != RTM_NEWADDR)
+                return;
+            LinkAddress addr;
+            auto it = by_index.find(parse_address(h, addr));
+            if (it != by_index.end())
+                links[it->second].addresses.push_back(std::move(addr));
+        });
+    }
+    return links;
+}
+
+std::string ipv4_netmask(int prefixlen) {
+    uint32_t mask = prefixlen <= 0 ? 0 : prefixlen >= 32 ? 0xFFFFFFFFu
+                                                         : ~((1u << (32 - prefixlen)) - 1);
+    struct in_addr in;
+    in.s_addr = htonl(mask);
+    return format_ip(AF_INET, &in);
+}
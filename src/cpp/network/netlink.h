@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// rtnetlink interface dump behind ifconfig and InterfaceSampler
+//
+// One NETLINK_ROUTE socket, one RTM_GETLINK dump (name, flags, MTU, MAC,
+// kind and the 64-bit counters of every link) and, when addresses are
+// wanted, one RTM_GETADDR dump. Every address of every interface is kept.
+// Nothing is read from /sys, so the cost does not grow with a file per
+// interface, which matters on hosts with hundreds of veths.
+// ---------------------------------------------------------------------------
+
+struct LinkStats {
+    uint64_t rx_packets = 0, tx_packets = 0;
+    uint64_t rx_bytes = 0, tx_bytes = 0;
+    uint64_t rx_errors = 0, tx_errors = 0;
+    uint64_t rx_dropped = 0, tx_dropped = 0;
+    uint64_t multicast = 0, collisions = 0;
+};
+
+struct LinkAddress {
+    int family = 0;             // AF_INET or AF_INET6
+    std::string address;
+    int prefixlen = 0;
+    std::string broadcast;      // IPv4 only; empty if none
+    int scope = 0;              // RT_SCOPE_*
+};
+
+struct LinkInfo {
+    int index = 0;
+    std::string name;
+    unsigned flags = 0;         // IFF_*
+    int mtu = 0;
+    std::string mac;            // empty if the link has no hardware address
+    std::string kind;           // "veth", "bridge", ...; empty for physical links
+    bool has_stats = false;
+    LinkStats stats;
+    std::vector<LinkAddress> addresses;
+};
+
+// Every link (or only `name`, if not empty), in ifindex order, with their
+// addresses if `addresses` is set. Throws std::runtime_error if netlink
+// fails.
+std::vector<LinkInfo> dump_links(const std::string& name, bool addresses);
+
+// "255.255.255.0" for 24.
+std::string ipv4_netmask(int prefixlen);
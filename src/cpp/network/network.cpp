@@ -1,141 +1,109 @@
 #include "network.h"
+#include "ping_engine.h"
+#include "resolver.h"
+#include "netlink.h"
+#include "iface_sampler.h"
+#include "common/stats.h"
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
 #include <string>
 #include <vector>
-#include <sstream>
-#include <fstream>
 #include <cstring>
-#include <cstdio>
 #include <algorithm>
-#include <map>
+#include <memory>
+#include <optional>
 
 #include <sys/socket.h>
-#include <sys/ioctl.h>
 #include <netdb.h>
-#include <arpa/inet.h>
 #include <netinet/in.h>
-#include <netinet/ip_icmp.h>
 #include <net/if.h>
-#include <ifaddrs.h>
-#include <unistd.h>
-#include <chrono>
-#include <cerrno>
 
 namespace py = pybind11;
 
 // ---------------------------------------------------------------------------
-// ping — Send ICMP echo requests (requires raw socket or setcap)
+// ping — Send ICMP echo requests (unprivileged ICMP sockets)
 // ---------------------------------------------------------------------------
 
-static py::dict ping_impl(const std::string& host, int count, double timeout) {
-    // Resolve hostname
-    struct addrinfo hints = {}, *res = nullptr;
-    hints.ai_family = AF_INET;
-    hints.ai_socktype = SOCK_DGRAM;
-
-    int err = getaddrinfo(host.c_str(), nullptr, &hints, &res);
-    if (err != 0)
-        throw py::value_error("ping: unknown host " + host + ": " + gai_strerror(err));
-
-    char ip_str[INET_ADDRSTRLEN];
-    struct sockaddr_in* addr = (struct sockaddr_in*)res->ai_addr;
-    inet_ntop(AF_INET, &addr->sin_addr, ip_str, sizeof(ip_str));
-    freeaddrinfo(res);
-
-    // Try to create raw socket for proper ICMP ping
-    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP);
-    bool can_ping = (sock >= 0);
-
+static py::dict ping_dict(const PingResult& r) {
     py::dict result;
-    result["host"] = host;
-    result["ip"]   = std::string(ip_str);
+    result["host"] = r.host;
+    result["ip"]   = r.ip;
 
-    if (!can_ping) {
+    if (!r.error.empty()) {
+        result["reachable"] = false;
+        result["error"] = r.error;
+        result["packets_sent"]     = 0;
+        result["packets_received"] = 0;
+        return result;
+    }
+    if (!r.can_ping) {
         // Fallback: just resolve and report
         result["reachable"] = true;  // resolved but can't ICMP
-        result["note"] = "ICMP raw sockets require root or CAP_NET_RAW. Host resolved successfully.";
+        result["note"] = "ICMP sockets are not permitted for this group (see "
+                         "net.ipv4.ping_group_range). Host resolved successfully.";
         result["packets_sent"]     = 0;
         result["packets_received"] = 0;
         return result;
     }
 
-    // Set timeout
-    struct timeval tv;
-    tv.tv_sec = static_cast<int>(timeout);
-    tv.tv_usec = static_cast<int>((timeout - tv.tv_sec) * 1000000);
-    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-
-    struct sockaddr_in dest = {};
-    dest.sin_family = AF_INET;
-    inet_pton(AF_INET, ip_str, &dest.sin_addr);
-
-    int sent = 0, received = 0;
-    double total_rtt = 0, min_rtt = 1e9, max_rtt = 0;
-
-    for (int i = 0; i < count; i++) {
-        // ICMP echo request via DGRAM ICMP socket
-        struct icmphdr icmp_hdr = {};
-        icmp_hdr.type = ICMP_ECHO;
-        icmp_hdr.code = 0;
-        icmp_hdr.un.echo.id = getpid() & 0xFFFF;
-        icmp_hdr.un.echo.sequence = i + 1;
-
-        // Checksum
-        uint32_t sum = 0;
-        uint16_t* ptr = (uint16_t*)&icmp_hdr;
-        for (size_t j = 0; j < sizeof(icmp_hdr) / 2; j++)
-            sum += ptr[j];
-        sum = (sum >> 16) + (sum & 0xFFFF);
-        sum += (sum >> 16);
-        icmp_hdr.checksum = ~sum;
-
-        auto t_start = std::chrono::high_resolution_clock::now();
-
-        ssize_t n = sendto(sock, &icmp_hdr, sizeof(icmp_hdr), 0,
-                           (struct sockaddr*)&dest, sizeof(dest));
-        if (n <= 0) { sent++; continue; }
-        sent++;
-
-        char recv_buf[1024];
-        struct sockaddr_in from = {};
-        socklen_t fromlen = sizeof(from);
-        n = recvfrom(sock, recv_buf, sizeof(recv_buf), 0,
-                     (struct sockaddr*)&from, &fromlen);
-
-        auto t_end = std::chrono::high_resolution_clock::now();
-        double rtt = std::chrono::duration<double, std::milli>(t_end - t_start).count();
-
-        if (n > 0) {
-            received++;
-            total_rtt += rtt;
-            min_rtt = std::min(min_rtt, rtt);
-            max_rtt = std::max(max_rtt, rtt);
-        }
-    }
-
-    close(sock);
-
+    int sent = r.sent, received = r.received;
     result["packets_sent"]     = sent;
     result["packets_received"] = received;
     result["packet_loss"]      = sent > 0 ? (1.0 - static_cast<double>(received) / sent) * 100.0 : 100.0;
     result["reachable"]        = received > 0;
+    result["duplicates"]       = r.duplicates;
 
     if (received > 0) {
-        result["rtt_min_ms"] = min_rtt;
-        result["rtt_avg_ms"] = total_rtt / received;
-        result["rtt_max_ms"] = max_rtt;
+        result["rtt_min_ms"]  = r.min_ms;
+        result["rtt_avg_ms"]  = r.avg_ms;
+        result["rtt_max_ms"]  = r.max_ms;
+        result["rtt_mdev_ms"] = r.mdev_ms;
+        result["jitter_ms"]   = r.jitter_ms;
     }
 
     return result;
 }
 
+static std::vector<PingResult> ping_run(const std::vector<std::string>& hosts,
+                                        const PingOptions& opts) {
+    py::gil_scoped_release release;
+    try {
+        return ping_hosts(hosts, opts);
+    } catch (const std::exception& e) {
+        throw py::value_error(std::string("ping: ") + e.what());
+    }
+}
+
+static py::dict ping_impl(const std::string& host, int count, double timeout) {
+    PingOptions opts;
+    opts.count = count;
+    opts.interval = 0;      // each probe is timed on its own; no need to pace
+    opts.timeout = timeout;
+    std::vector<PingResult> results = ping_run({host}, opts);
+    if (!results[0].error.empty())
+        throw py::value_error("ping: " + results[0].error);
+    return ping_dict(results[0]);
+}
+
+static py::list ping_many_impl(const std::vector<std::string>& hosts, int count,
+                               double interval, double timeout) {
+    PingOptions opts;
+    opts.count = count;
+    opts.interval = interval;
+    opts.timeout = timeout;
+    std::vector<PingResult> results = ping_run(hosts, opts);
+    py::list out;
+    for (const auto& r : results)
+        out.append(ping_dict(r));
+    return out;
+}
+
 // ---------------------------------------------------------------------------
 // nslookup — DNS resolution
 // ---------------------------------------------------------------------------
 
-static py::dict nslookup_impl(const std::string& hostname, bool ipv6) {
+static DnsAnswer nslookup_collect(const std::string& hostname, bool ipv6, bool reverse) {
     struct addrinfo hints = {}, *res = nullptr;
     hints.ai_family = ipv6 ? AF_INET6 : AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
@@ -145,118 +113,204 @@ static py::dict nslookup_impl(const std::string& hostname, bool ipv6) {
         throw py::value_error("nslookup: can't resolve '" + hostname + "': " +
                               gai_strerror(err));
 
+    DnsAnswer lookup;
+    collect_addresses(res, lookup);
+    freeaddrinfo(res);
+
+    // Reverse lookup of the first address
+    if (reverse && !lookup.addresses.empty())
+        reverse_lookup(lookup.addresses[0].first, lookup.addresses[0].second, lookup);
+    return lookup;
+}
+
+static py::dict lookup_dict(const std::string& hostname, const DnsAnswer& lookup) {
     py::dict result;
     result["hostname"] = hostname;
 
     py::list addresses;
-    for (struct addrinfo* rp = res; rp != nullptr; rp = rp->ai_next) {
-        char ip_str[INET6_ADDRSTRLEN];
-        if (rp->ai_family == AF_INET) {
-            struct sockaddr_in* addr4 = (struct sockaddr_in*)rp->ai_addr;
-            inet_ntop(AF_INET, &addr4->sin_addr, ip_str, sizeof(ip_str));
-        } else if (rp->ai_family == AF_INET6) {
-            struct sockaddr_in6* addr6 = (struct sockaddr_in6*)rp->ai_addr;
-            inet_ntop(AF_INET6, &addr6->sin6_addr, ip_str, sizeof(ip_str));
-        } else {
-            continue;
-        }
-
+    for (const auto& [address, family] : lookup.addresses) {
         py::dict addr;
-        addr["address"] = std::string(ip_str);
-        addr["family"]  = rp->ai_family == AF_INET ? "IPv4" : "IPv6";
+        addr["address"] = address;
+        addr["family"]  = family == AF_INET ? "IPv4" : "IPv6";
         addresses.append(addr);
     }
-
     result["addresses"] = addresses;
 
-    // Reverse lookup for each address
-    if (res) {
-        char host_buf[NI_MAXHOST];
-        if (getnameinfo(res->ai_addr, res->ai_addrlen,
-                        host_buf, sizeof(host_buf),
-                        nullptr, 0, NI_NAMEREQD) == 0) {
-            result["canonical_name"] = std::string(host_buf);
+    if (lookup.has_canonical)
+        result["canonical_name"] = lookup.canonical_name;
+
+    return result;
+}
+
+static py::dict nslookup_impl(const std::string& hostname, bool ipv6, bool reverse) {
+    DnsAnswer lookup;
+    {
+        py::gil_scoped_release release;
+        lookup = nslookup_collect(hostname, ipv6, reverse);
+    }
+    return lookup_dict(hostname, lookup);
+}
+
+static py::list nslookup_many_impl(const std::vector<std::string>& names, bool ipv6,
+                                   bool reverse, int concurrency, double timeout,
+                                   bool cache, double cache_ttl) {
+    if (concurrency < 1)
+        throw py::value_error("nslookup: concurrency must be at least 1");
+    ResolveOptions opts;
+    opts.ipv6 = ipv6;
+    opts.reverse = reverse;
+    opts.concurrency = static_cast<size_t>(concurrency);
+    opts.timeout = timeout;
+    opts.cache = cache;
+    opts.cache_ttl = cache_ttl;
+
+    std::vector<DnsAnswer> answers;
+    {
+        py::gil_scoped_release release;
+        try {
+            answers = resolve_names(names, opts);
+        } catch (const std::exception& e) {
+            throw py::value_error(std::string("nslookup: ") + e.what());
         }
     }
 
-    freeaddrinfo(res);
-    return result;
+    py::list out;
+    for (size_t i = 0; i < names.size(); ++i) {
+        py::dict result = lookup_dict(names[i], answers[i]);
+        if (!answers[i].error.empty())
+            result["error"] = answers[i].error;
+        result["cached"] = answers[i].cached;
+        out.append(result);
+    }
+    return out;
 }
 
 // ---------------------------------------------------------------------------
 // ifconfig — Network interface information
 // ---------------------------------------------------------------------------
 
+static py::dict stats_dict(const LinkStats& st) {
+    py::dict stats;
+    stats["rx_bytes"]   = st.rx_bytes;
+    stats["tx_bytes"]   = st.tx_bytes;
+    stats["rx_packets"] = st.rx_packets;
+    stats["tx_packets"] = st.tx_packets;
+    stats["rx_errors"]  = st.rx_errors;
+    stats["tx_errors"]  = st.tx_errors;
+    stats["rx_dropped"] = st.rx_dropped;
+    stats["tx_dropped"] = st.tx_dropped;
+    stats["multicast"]  = st.multicast;
+    stats["collisions"] = st.collisions;
+    return stats;
+}
+
 static py::list ifconfig_impl(const std::string& interface_name) {
-    struct ifaddrs* ifaddr;
-    if (getifaddrs(&ifaddr) == -1)
-        throw py::value_error("ifconfig: cannot get interfaces: " +
-                              std::string(std::strerror(errno)));
-
-    // Collect all interface info
-    std::map<std::string, py::dict> interfaces;
-
-    for (struct ifaddrs* ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
-        if (!ifa->ifa_addr) continue;
-
-        std::string name = ifa->ifa_name;
-        if (!interface_name.empty() && name != interface_name) continue;
-
-        if (interfaces.find(name) == interfaces.end()) {
-            py::dict iface;
-            iface["name"] = name;
-            iface["flags"] = static_cast<int>(ifa->ifa_flags);
-            iface["is_up"] = (ifa->ifa_flags & IFF_UP) != 0;
-            iface["is_loopback"] = (ifa->ifa_flags & IFF_LOOPBACK) != 0;
-            iface["is_running"] = (ifa->ifa_flags & IFF_RUNNING) != 0;
-            interfaces[name] = iface;
+    std::vector<LinkInfo> links;
+    {
+        py::gil_scoped_release release;
+        try {
+            links = dump_links(interface_name, true);
+        } catch (const std::runtime_error& e) {
+            throw py::value_error("ifconfig: cannot get interfaces: " + std::string(e.what()));
         }
+        std::sort(links.begin(), links.end(),
+                  [](const LinkInfo& a, const LinkInfo& b) { return a.name < b.name; });
+    }
 
-        char ip_str[INET6_ADDRSTRLEN];
-
-        if (ifa->ifa_addr->sa_family == AF_INET) {
-            struct sockaddr_in* addr = (struct sockaddr_in*)ifa->ifa_addr;
-            inet_ntop(AF_INET, &addr->sin_addr, ip_str, sizeof(ip_str));
-            interfaces[name]["ipv4_address"] = std::string(ip_str);
-
-            if (ifa->ifa_netmask) {
-                struct sockaddr_in* mask = (struct sockaddr_in*)ifa->ifa_netmask;
-                inet_ntop(AF_INET, &mask->sin_addr, ip_str, sizeof(ip_str));
-                interfaces[name]["ipv4_netmask"] = std::string(ip_str);
-            }
-            if (ifa->ifa_broadaddr && !(ifa->ifa_flags & IFF_LOOPBACK)) {
-                struct sockaddr_in* bcast = (struct sockaddr_in*)ifa->ifa_broadaddr;
-                inet_ntop(AF_INET, &bcast->sin_addr, ip_str, sizeof(ip_str));
-                interfaces[name]["ipv4_broadcast"] = std::string(ip_str);
+    py::list result;
+    for (const auto& info : links) {
+        py::dict iface;
+        iface["name"] = info.name;
+        iface["index"] = info.index;
+        iface["flags"] = info.flags;
+        iface["is_up"] = (info.flags & IFF_UP) != 0;
+        iface["is_loopback"] = (info.flags & IFF_LOOPBACK) != 0;
+        iface["is_running"] = (info.flags & IFF_RUNNING) != 0;
+        if (!info.kind.empty()) iface["kind"] = info.kind;
+
+        // The first address of each family, as before; all of them in
+        // "addresses".
+        const LinkAddress* v4 = nullptr;
+        const LinkAddress* v6 = nullptr;
+        py::list addresses;
+        for (const auto& a : info.addresses) {
+            py::dict addr;
+            addr["address"]   = a.address;
+            addr["family"]    = a.family == AF_INET ? "IPv4" : "IPv6";
+            addr["prefixlen"] = a.prefixlen;
+            if (a.family == AF_INET) {
+                addr["netmask"] = ipv4_netmask(a.prefixlen);
+                if (!a.broadcast.empty()) addr["broadcast"] = a.broadcast;
+                if (!v4) v4 = &a;
+            } else if (!v6) {
+                v6 = &a;
             }
-        } else if (ifa->ifa_addr->sa_family == AF_INET6) {
-            struct sockaddr_in6* addr6 = (struct sockaddr_in6*)ifa->ifa_addr;
-            inet_ntop(AF_INET6, &addr6->sin6_addr, ip_str, sizeof(ip_str));
-            interfaces[name]["ipv6_address"] = std::string(ip_str);
-        } else if (ifa->ifa_addr->sa_family == AF_PACKET) {
-            // MAC address — read from /sys
-            std::ifstream mac_ifs("/sys/class/net/" + name + "/address");
-            std::string mac;
-            if (mac_ifs.is_open() && std::getline(mac_ifs, mac))
-                interfaces[name]["mac_address"] = mac;
-
-            // MTU
-            std::ifstream mtu_ifs("/sys/class/net/" + name + "/mtu");
-            int mtu;
-            if (mtu_ifs.is_open() && (mtu_ifs >> mtu))
-                interfaces[name]["mtu"] = mtu;
+            addresses.append(addr);
         }
+        if (v4) {
+            iface["ipv4_address"] = v4->address;
+            iface["ipv4_netmask"] = ipv4_netmask(v4->prefixlen);
+            if (!v4->broadcast.empty() && !(info.flags & IFF_LOOPBACK))
+                iface["ipv4_broadcast"] = v4->broadcast;
+        }
+        if (v6) iface["ipv6_address"] = v6->address;
+        iface["addresses"] = addresses;
+
+        if (!info.mac.empty()) iface["mac_address"] = info.mac;
+        if (info.mtu > 0)      iface["mtu"]         = info.mtu;
+        if (info.has_stats)    iface["stats"]       = stats_dict(info.stats);
+        result.append(iface);
     }
 
-    freeifaddrs(ifaddr);
+    return result;
+}
 
-    py::list result;
-    for (auto& [name, iface] : interfaces)
-        result.append(iface);
+// ---------------------------------------------------------------------------
+// InterfaceSampler — RX/TX rates from consecutive netlink dumps
+// ---------------------------------------------------------------------------
 
+static py::object rate_if_known(const LinkSample& s, double rate) {
+    return s.is_new ? py::object(py::none()) : py::object(py::float_(rate));
+}
+
+static py::list link_sample_list(const std::vector<LinkSample>& samples) {
+    py::list result(samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        const LinkSample& s = samples[i];
+        const LinkStats& st = s.link.stats;
+        py::dict link;
+        link["name"]                  = s.link.name;
+        link["index"]                 = s.link.index;
+        link["is_up"]                 = (s.link.flags & IFF_UP) != 0;
+        link["rx_bytes"]              = st.rx_bytes;
+        link["tx_bytes"]              = st.tx_bytes;
+        link["rx_packets"]            = st.rx_packets;
+        link["tx_packets"]            = st.tx_packets;
+        link["rx_dropped"]            = st.rx_dropped;
+        link["tx_dropped"]            = st.tx_dropped;
+        link["rx_bytes_per_sec"]      = rate_if_known(s, s.rx_bytes_rate);
+        link["tx_bytes_per_sec"]      = rate_if_known(s, s.tx_bytes_rate);
+        link["rx_packets_per_sec"]    = rate_if_known(s, s.rx_packets_rate);
+        link["tx_packets_per_sec"]    = rate_if_known(s, s.tx_packets_rate);
+        link["rx_dropped_per_sec"]    = rate_if_known(s, s.rx_dropped_rate);
+        link["tx_dropped_per_sec"]    = rate_if_known(s, s.tx_dropped_rate);
+        link["rx_errors_per_sec"]     = rate_if_known(s, s.rx_errors_rate);
+        link["tx_errors_per_sec"]     = rate_if_known(s, s.tx_errors_rate);
+        link["new"]                   = s.is_new;
+        result[i] = link;
+    }
     return result;
 }
 
+static std::vector<LinkSample> iface_sample(InterfaceSampler& sampler) {
+    py::gil_scoped_release release;
+    try {
+        return sampler.sample();
+    } catch (const std::runtime_error& e) {
+        throw py::value_error(std::string("InterfaceSampler: ") + e.what());
+    }
+}
+
 // ===========================================================================
 // pybind11 registration
 // ===========================================================================
@@ -264,14 +318,15 @@ static py::list ifconfig_impl(const std::string& interface_name) {
 void init_network(py::module_ &m) {
 
     // -- ping ---------------------------------------------------------------
-    m.def("ping", &ping_impl,
+    m.def("ping", counted("ping", &ping_impl),
         R"doc(
         Send ICMP echo requests to a host.
 
         Equivalent to the ``ping`` shell command. Resolves the hostname and
-        sends ICMP echo requests. Requires raw socket capability
-        (root or CAP_NET_RAW). Falls back to DNS resolution only if
-        raw sockets are unavailable.
+        sends all echo requests at once over an unprivileged ICMP socket
+        (the caller's group must be in net.ipv4.ping_group_range); each
+        reply is matched to its request by sequence number. Falls back to
+        DNS resolution only if ICMP sockets are unavailable.
 
         Args:
             host (str): Hostname or IP address to ping.
@@ -282,8 +337,9 @@ void init_network(py::module_ &m) {
 
         Returns:
             dict: Keys "host", "ip", "reachable", "packets_sent",
-                  "packets_received", "packet_loss", "rtt_min_ms",
-                  "rtt_avg_ms", "rtt_max_ms".
+                  "packets_received", "packet_loss", "duplicates",
+                  "rtt_min_ms", "rtt_avg_ms", "rtt_max_ms", "rtt_mdev_ms",
+                  "jitter_ms".
 
         Raises:
             ValueError: If host cannot be resolved.
@@ -292,8 +348,45 @@ void init_network(py::module_ &m) {
         py::arg("count") = 4,
         py::arg("timeout") = 2.0);
 
+    // -- ping_many ----------------------------------------------------------
+    m.def("ping_many", counted("ping_many", &ping_many_impl),
+        R"doc(
+        Ping many hosts concurrently.
+
+        All hosts share one ICMP socket per address family (IPv4 and IPv6),
+        driven by a single epoll loop with the GIL released. Round k of
+        probes starts ``k * interval`` seconds in, and the probes of a round
+        are spread evenly across the interval, so 500 hosts take about
+        ``count * interval + timeout`` seconds rather than minutes. Replies
+        are matched to their probe by sequence number and payload, and
+        timed with kernel receive timestamps (SO_TIMESTAMPNS).
+
+        Args:
+            hosts (list[str]): Hostnames or IP addresses to ping.
+            count (int): Echo requests per host. Default is 4.
+                         Equivalent to ``ping -c``.
+            interval (float): Seconds between the requests to one host.
+                              Default is 1.0. Equivalent to ``ping -i``.
+            timeout (float): Seconds to wait for each reply. Default is 2.0.
+                             Equivalent to ``ping -W``.
+
+        Returns:
+            list[dict]: One dict per host, in input order, with the keys of
+                        ``ping`` plus "duplicates", "rtt_mdev_ms" and
+                        "jitter_ms" (mean difference between consecutive
+                        RTTs). A host that does not resolve has
+                        "reachable" False and an "error" message.
+
+        Raises:
+            ValueError: If count, interval or timeout is out of range.
+        )doc",
+        py::arg("hosts"),
+        py::arg("count") = 4,
+        py::arg("interval") = 1.0,
+        py::arg("timeout") = 2.0);
+
     // -- nslookup -----------------------------------------------------------
-    m.def("nslookup", &nslookup_impl,
+    m.def("nslookup", counted("nslookup", &nslookup_impl),
         R"doc(
         Query DNS to resolve a hostname.
 
@@ -304,6 +397,9 @@ void init_network(py::module_ &m) {
             hostname (str): The hostname to resolve.
             ipv6 (bool): If True, prefer IPv6 addresses.
                          Equivalent to ``nslookup -type=AAAA``.
+            reverse (bool): Also look up "canonical_name" from the first
+                            address. Default is True; pass False to skip
+                            the reverse query.
 
         Returns:
             dict: Keys "hostname", "addresses" (list of dicts with "address"
@@ -313,28 +409,125 @@ void init_network(py::module_ &m) {
             ValueError: If the hostname cannot be resolved.
         )doc",
         py::arg("hostname"),
-        py::arg("ipv6") = false);
+        py::arg("ipv6") = false,
+        py::arg("reverse") = true);
+
+    // -- nslookup_many ------------------------------------------------------
+    m.def("nslookup_many", counted("nslookup_many", &nslookup_many_impl),
+        R"doc(
+        Resolve many hostnames concurrently.
+
+        Lookups run through getaddrinfo_a (so /etc/hosts and nsswitch.conf
+        apply as for ``nslookup``), up to ``concurrency`` at a time, with
+        the GIL released. A slow name costs at most ``timeout`` seconds and
+        does not hold up the others. A name given more than once is looked
+        up once.
+
+        Answers are kept in a process-wide cache shared by all calls. The
+        system resolver does not report record TTLs, so entries expire
+        after ``cache_ttl`` seconds. Names that do not exist are cached as
+        well; temporary failures and timeouts are not.
+
+        Args:
+            names (list[str]): Hostnames to resolve.
+            ipv6 (bool): If True, only IPv6 addresses.
+            reverse (bool): Also look up "canonical_name" from the first
+                            address. Default is False.
+            concurrency (int): Maximum lookups in flight. Default is 64.
+            timeout (float): Seconds to wait for each lookup. Default is 5.
+            cache (bool): Use and fill the cache. Default is True.
+            cache_ttl (float): Seconds a cached answer stays valid.
+                               Default is 60.
+
+        Returns:
+            list[dict]: One dict per name, in input order, with the keys of
+                        ``nslookup`` plus "cached" (bool). A name that fails
+                        has empty "addresses" and an "error" message instead
+                        of raising.
+
+        Raises:
+            ValueError: If concurrency, timeout or cache_ttl is out of range.
+        )doc",
+        py::arg("names"),
+        py::arg("ipv6") = false,
+        py::arg("reverse") = false,
+        py::arg("concurrency") = 64,
+        py::arg("timeout") = 5.0,
+        py::arg("cache") = true,
+        py::arg("cache_ttl") = 60.0);
 
     // -- ifconfig -----------------------------------------------------------
-    m.def("ifconfig", &ifconfig_impl,
+    m.def("ifconfig", counted("ifconfig", &ifconfig_impl),
         R"doc(
         Display network interface information.
 
         Equivalent to the ``ifconfig`` shell command. Returns information
         about all network interfaces or a specific one, including
-        IP addresses, netmask, MAC address, MTU, and status flags.
+        IP addresses, netmask, MAC address, MTU, counters and status flags.
+        Everything comes from one rtnetlink link dump and one address dump.
 
         Args:
             interface_name (str): Specific interface to query (e.g. "eth0").
                                   Empty string for all interfaces.
 
         Returns:
-            list[dict]: Each dict contains "name", "ipv4_address",
-                        "ipv4_netmask", "ipv6_address", "mac_address",
-                        "mtu", "is_up", "is_loopback", "is_running".
+            list[dict]: Each dict contains "name", "index", "ipv4_address",
+                        "ipv4_netmask", "ipv4_broadcast", "ipv6_address"
+                        (the first address of each family), "addresses"
+                        (every address, as dicts with "address", "family",
+                        "prefixlen" and for IPv4 "netmask" and
+                        "broadcast"), "mac_address", "mtu", "kind" (e.g.
+                        "veth"; absent for physical links), "stats"
+                        (rx/tx bytes, packets, errors and drops, multicast,
+                        collisions), "flags", "is_up", "is_loopback" and
+                        "is_running".
 
         Raises:
             ValueError: If interface info cannot be retrieved.
         )doc",
         py::arg("interface_name") = "");
+
+    // -- InterfaceSampler ---------------------------------------------------
+    py::class_<InterfaceSampler>(m, "InterfaceSampler",
+        R"doc(
+        Per-interface RX/TX rates between consecutive netlink dumps.
+
+        Each sample() is a single RTM_GETLINK dump, cheap enough to poll
+        hundreds of veth interfaces. Rates are per second over the time
+        since the previous sample; an interface seen for the first time
+        (``new`` is True, including a name recreated with a new ifindex)
+        has None rates. Creating the sampler takes the first sample.
+
+        Args:
+            interfaces (list[str], optional): Only sample these interfaces.
+                                              Default is every interface.
+
+        Raises:
+            ValueError: If netlink is not available.
+        )doc")
+        .def(py::init([](std::optional<std::vector<std::string>> interfaces) {
+                 auto self = std::make_unique<InterfaceSampler>(
+                     interfaces ? std::move(*interfaces) : std::vector<std::string>());
+                 iface_sample(*self);
+                 return self;
+             }),
+             py::arg("interfaces") = py::none())
+        .def("sample",
+             [](InterfaceSampler& self) { return link_sample_list(iface_sample(self)); },
+             R"doc(
+             Dump the counters now and return the rates since the previous sample.
+
+             Returns:
+                 list[dict]: One dict per interface, in ifindex order, with
+                             "name", "index", "is_up", the counters
+                             "rx_bytes", "tx_bytes", "rx_packets",
+                             "tx_packets", "rx_dropped", "tx_dropped", the
+                             rates "rx_bytes_per_sec", "tx_bytes_per_sec",
+                             "rx_packets_per_sec", "tx_packets_per_sec",
+                             "rx_dropped_per_sec", "tx_dropped_per_sec",
+                             "rx_errors_per_sec", "tx_errors_per_sec" and
+                             "new".
+             )doc")
+        .def_property_readonly("interval", &InterfaceSampler::last_interval,
+             "Seconds covered by the latest sample (0 before the second one).");
 }
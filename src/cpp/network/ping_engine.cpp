@@ -0,0 +1,338 @@
+#include "ping_engine.h"
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/icmp6.h>
+#include <netinet/in.h>
+#include <netinet/ip_icmp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+int64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Echo header plus our payload; the kernel fills in the id and checksum of
+// datagram ICMP sockets.
+struct EchoPacket {
+    uint8_t type;
+    uint8_t code;
+    uint16_t checksum;
+    uint16_t id;
+    uint16_t sequence;
+    uint64_t token;             // identifies this run
+    uint32_t host;
+    uint32_t probe;
+};
+
+enum class ProbeState : uint8_t { waiting, answered, lost };
+
+struct Probe {
+    int64_t sent_ns = 0;        // CLOCK_REALTIME, comparable with SO_TIMESTAMPNS
+    int64_t deadline_ns = 0;    // CLOCK_MONOTONIC
+    uint16_t sequence = 0;
+    ProbeState state = ProbeState::waiting;
+};
+
+struct Target {
+    struct sockaddr_storage addr = {};
+    socklen_t addr_len = 0;
+    int family = 0;
+    std::vector<Probe> probes;
+};
+
+// Prefers an IPv4 address, like ping without -6.
+std::string resolve(const std::string& host, Target& target) {
+    struct addrinfo hints = {}, *res = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    int err = getaddrinfo(host.c_str(), nullptr, &hints, &res);
+    if (err != 0)
+        throw std::runtime_error("unknown host " + host + ": " + gai_strerror(err));
+
+    const struct addrinfo* pick = res;
+    for (const struct addrinfo* ai = res; ai; ai = ai->ai_next) {
+        if (ai->ai_family == AF_INET) {
+            pick = ai;
+            break;
+        }
+    }
+    std::memcpy(&target.addr, pick->ai_addr, pick->ai_addrlen);
+    target.addr_len = pick->ai_addrlen;
+    target.family = pick->ai_family;
+
+    char ip[INET6_ADDRSTRLEN] = "";
+    const void* src = target.family == AF_INET
+        ? static_cast<const void*>(&reinterpret_cast<sockaddr_in*>(&target.addr)->sin_addr)
+        : static_cast<const void*>(&reinterpret_cast<sockaddr_in6*>(&target.addr)->sin6_addr);
+    inet_ntop(target.family, src, ip, sizeof(ip));
+    freeaddrinfo(res);
+    return ip;
+}
+
+int open_icmp_socket(int family) {
+    int proto = family == AF_INET ? static_cast<int>(IPPROTO_ICMP)
+                                  : static_cast<int>(IPPROTO_ICMPV6);
+    int fd = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, proto);
+    if (fd < 0)
+        return -1;
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+    int rcvbuf = 1 << 20;       // a round of replies from many hosts at once
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    return fd;
+}
+
+void summarize(PingResult& r) {
+    if (r.rtts.empty())
+        return;
+    double sum = 0, sum_sq = 0, diff = 0;
+    r.min_ms = r.max_ms = r.rtts[0];
+    for (size_t i = 0; i < r.rtts.size(); ++i) {
+        double v = r.rtts[i];
+        sum += v;
+        sum_sq += v * v;
+        r.min_ms = std::min(r.min_ms, v);
+        r.max_ms = std::max(r.max_ms, v);
+        if (i > 0)
+            diff += std::fabs(v - r.rtts[i - 1]);
+    }
+    double n = static_cast<double>(r.rtts.size());
+    r.avg_ms = sum / n;
+    r.mdev_ms = std::sqrt(std::max(sum_sq / n - r.avg_ms * r.avg_ms, 0.0));
+    r.jitter_ms = r.rtts.size() > 1 ? diff / (n - 1) : 0;
+}
+
+class PingRun {
+public:
+    PingRun(std::vector<PingResult>& results, std::vector<Target>& targets, const PingOptions& opts)
+        : results_(results), targets_(targets), opts_(opts) {
+        token_ = std::random_device()() | (static_cast<uint64_t>(clock_ns(CLOCK_REALTIME)) << 32);
+    }
+
+    ~PingRun() {
+        for (int fd : {fd4_, fd6_, ep_})
+            if (fd >= 0)
+                close(fd);
+    }
+
+    void run();
+
+private:
+    void send_probe(size_t host, int probe);
+    void drain(int fd);
+    void expire(int64_t now);
+
+    std::vector<PingResult>& results_;
+    std::vector<Target>& targets_;
+    const PingOptions& opts_;
+    uint64_t token_ = 0;
+    uint16_t next_sequence_ = 1;
+    int fd4_ = -1, fd6_ = -1, ep_ = -1;
+    std::deque<std::pair<size_t, int>> in_flight_;     // send order = deadline order
+};
+
+void PingRun::send_probe(size_t host, int probe) {
+    Target& t = targets_[host];
+    Probe& p = t.probes[probe];
+    EchoPacket pkt = {};
+    pkt.type = t.family == AF_INET ? ICMP_ECHO : ICMP6_ECHO_REQUEST;
+    pkt.sequence = htons(next_sequence_);
+    pkt.token = token_;
+    pkt.host = static_cast<uint32_t>(host);
+    pkt.probe = static_cast<uint32_t>(probe);
+    p.sequence = next_sequence_++;
+
+    int fd = t.family == AF_INET ? fd4_ : fd6_;
+    p.sent_ns = clock_ns(CLOCK_REALTIME);
+    p.deadline_ns = clock_ns(CLOCK_MONOTONIC) + static_cast<int64_t>(opts_.timeout * 1e9);
+    results_[host].sent++;
+    // A failed send (e.g. no route) is simply a lost probe.
+    sendto(fd, &pkt, sizeof(pkt), 0, reinterpret_cast<const sockaddr*>(&t.addr), t.addr_len);
+    in_flight_.emplace_back(host, probe);
+}
+
+void PingRun::drain(int fd) {
+    EchoPacket pkt;
+    char control[256];
+    for (;;) {
+        struct iovec iov = {&pkt, sizeof(pkt)};
+        struct msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ssize_t n = recvmsg(fd, &msg, MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return;     // EAGAIN, or an ICMP error queued for the socket
+        }
+        if (static_cast<size_t>(n) < sizeof(pkt) || pkt.token != token_ ||
+            pkt.host >= targets_.size())
+            continue;
+        if (pkt.type != (fd == fd4_ ? ICMP_ECHOREPLY : ICMP6_ECHO_REPLY))
+            continue;
+        Target& t = targets_[pkt.host];
+        if (pkt.probe >= t.probes.size())
+            continue;
+        Probe& p = t.probes[pkt.probe];
+        if (p.sequence != ntohs(pkt.sequence) || p.sent_ns == 0)
+            continue;
+
+        PingResult& r = results_[pkt.host];
+        if (p.state == ProbeState::answered) {
+            r.duplicates++;
+            continue;
+        }
+        if (p.state == ProbeState::lost)
+            continue;   // arrived after its timeout
+
+        int64_t received_ns = 0;
+        for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+                struct timespec ts;
+                std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                received_ns = static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+            }
+        }
+        if (received_ns == 0)
+            received_ns = clock_ns(CLOCK_REALTIME);
+        p.state = ProbeState::answered;
+        r.received++;
+        r.rtts.push_back(std::max<int64_t>(received_ns - p.sent_ns, 0) / 1e6);
+    }
+}
+
+void PingRun::expire(int64_t now) {
+    while (!in_flight_.empty()) {
+        auto [host, probe] = in_flight_.front();
+        Probe& p = targets_[host].probes[probe];
+        if (p.state == ProbeState::waiting) {
+            if (p.deadline_ns > now)
+                return;
+            p.state = ProbeState::lost;
+        }
+        in_flight_.pop_front();
+    }
+}
+
+void PingRun::run() {
+    // The send schedule: every pingable host in round-robin order, rounds
+    // `interval` apart, each round spread across the interval.
+    std::vector<size_t> order;
+    for (size_t i = 0; i < targets_.size(); ++i) {
+        if (!results_[i].error.empty())
+            continue;
+        int& fd = targets_[i].family == AF_INET ? fd4_ : fd6_;
+        if (fd < 0)
+            fd = open_icmp_socket(targets_[i].family);
+        if (fd < 0)
+            continue;
+        results_[i].can_ping = true;
+        targets_[i].probes.resize(static_cast<size_t>(opts_.count));
+        order.push_back(i);
+    }
+    if (order.empty())
+        return;
+
+    ep_ = epoll_create1(EPOLL_CLOEXEC);
+    if (ep_ < 0)
+        throw std::runtime_error(std::string("epoll: ") + std::strerror(errno));
+    for (int fd : {fd4_, fd6_}) {
+        if (fd < 0)
+            continue;
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(ep_, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    const int64_t interval_ns = static_cast<int64_t>(opts_.interval * 1e9);
+    const int64_t spacing_ns = interval_ns / static_cast<int64_t>(order.size());
+    const size_t total = order.size() * static_cast<size_t>(opts_.count);
+    const int64_t start = clock_ns(CLOCK_MONOTONIC);
+    size_t next = 0;    // index into the schedule: round * hosts + slot
+    struct epoll_event events[2];
+
+    while (next < total || !in_flight_.empty()) {
+        int64_t now = clock_ns(CLOCK_MONOTONIC);
+        while (next < total) {
+            size_t round = next / order.size(), slot = next % order.size();
+            int64_t due = start + static_cast<int64_t>(round) * interval_ns +
+                          static_cast<int64_t>(slot) * spacing_ns;
+            if (due > now)
+                break;
+            send_probe(order[slot], static_cast<int>(round));
+            ++next;
+        }
+        expire(now);
+
+        int64_t wake = INT64_MAX;
+        if (next < total) {
+            size_t round = next / order.size(), slot = next % order.size();
+            wake = start + static_cast<int64_t>(round) * interval_ns +
+                   static_cast<int64_t>(slot) * spacing_ns;
+        }
+        if (!in_flight_.empty()) {
+            const Probe& p = targets_[in_flight_.front().first].probes[in_flight_.front().second];
+            wake = std::min(wake, p.deadline_ns);
+        }
+        if (wake == INT64_MAX)
+            break;
+        // Round up so the loop does not spin on a sub-millisecond remainder.
+        int ms = static_cast<int>(std::max<int64_t>((wake - now + 999999) / 1000000, 0));
+        int n = epoll_wait(ep_, events, 2, ms);
+        for (int i = 0; i < n; ++i)
+            drain(events[i].data.fd);
+    }
+}
+
+}  // namespace
+
+std::vector<PingResult> ping_hosts(const std::vector<std::string>& hosts, const PingOptions& opts) {
+    if (opts.count < 1)
+        throw std::invalid_argument("count must be at least 1");
+    if (opts.interval < 0)
+        throw std::invalid_argument("interval must be non-negative");
+    if (opts.timeout <= 0)
+        throw std::invalid_argument("timeout must be positive");
+
+    std::vector<PingResult> results(hosts.size());
+    std::vector<Target> targets(hosts.size());
+
+    // getaddrinfo blocks, so resolve the hosts concurrently.
+    ThreadPool pool(std::min<size_t>(hosts.size(), 16));
+    for (size_t i = 0; i < hosts.size(); ++i) {
+        results[i].host = hosts[i];
+        pool.submit([&, i] {
+            try {
+                results[i].ip = resolve(hosts[i], targets[i]);
+            } catch (const std::runtime_error& e) {
+                results[i].error = e.what();
+            }
+        });
+    }
+    pool.wait();
+
+    PingRun(results, targets, opts).run();
+    for (auto& r : results)
+        summarize(r);
+    return results;
+}
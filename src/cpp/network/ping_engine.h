@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Multi-host ICMP echo engine behind ping and ping_many
+//
+// All hosts share one unprivileged ICMP datagram socket per address family
+// (IPPROTO_ICMP / IPPROTO_ICMPV6, allowed by net.ipv4.ping_group_range).
+// Probes go out on a paced schedule: round k starts at k * interval, and
+// the sends of a round are spread evenly across the interval. A single
+// epoll loop sends due probes, drains replies and expires probes whose
+// timeout has passed. The kernel routes replies to the socket by echo id;
+// each reply is then matched to its probe by sequence number and by a
+// payload carrying the run token and probe index, so stray or late replies
+// are never counted. Receive times come from SO_TIMESTAMPNS, so the RTT
+// does not include the time spent in the loop.
+// ---------------------------------------------------------------------------
+
+struct PingOptions {
+    int count = 4;              // probes per host
+    double interval = 1.0;      // seconds between probes to one host
+    double timeout = 2.0;       // seconds to wait for each reply
+};
+
+struct PingResult {
+    std::string host;
+    std::string ip;
+    std::string error;          // resolution failure; nothing was sent
+    bool can_ping = false;      // an ICMP socket exists for the family
+    int sent = 0;
+    int received = 0;
+    int duplicates = 0;
+    std::vector<double> rtts;   // ms, in probe order, received probes only
+
+    // Over `rtts`; 0 when nothing was received. mdev is the standard
+    // deviation (as ping reports it), jitter the mean difference between
+    // consecutive RTTs.
+    double min_ms = 0, avg_ms = 0, max_ms = 0, mdev_ms = 0, jitter_ms = 0;
+};
+
+// Resolves and pings every host; results are in input order. Hosts that
+// do not resolve get `error` set. Throws std::invalid_argument for bad
+// options.
+std::vector<PingResult> ping_hosts(const std::vector<std::string>& hosts, const PingOptions& opts);
@@ -0,0 +1,304 @@
+#include "resolver.h"
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+static constexpr size_t kDnsCacheSize = 65536;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// A getaddrinfo_a request; everything it points to lives alongside it.
+struct Request {
+    std::string name;
+    struct addrinfo hints = {};
+    struct gaicb cb = {};
+    Clock::time_point deadline;
+    size_t slot = 0;            // index into the unique names
+};
+
+class DnsCache {
+public:
+    bool get(const std::string& key, DnsAnswer& out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end())
+            return false;
+        if (Clock::now() >= it->second->expires) {
+            lru_.erase(it->second);
+            index_.erase(it);
+            return false;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second);
+        out = it->second->answer;
+        out.cached = true;
+        return true;
+    }
+
+    void put(const std::string& key, const DnsAnswer& answer, double ttl) {
+        auto expires = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                          std::chrono::duration<double>(ttl));
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            lru_.erase(it->second);
+            index_.erase(it);
+        }
+        lru_.push_front({key, answer, expires});
+        index_[key] = lru_.begin();
+        if (lru_.size() > kDnsCacheSize) {
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+        }
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        DnsAnswer answer;
+        Clock::time_point expires;
+    };
+    std::mutex mutex_;
+    std::list<Entry> lru_;      // most recent first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+DnsCache& dns_cache() {
+    static DnsCache cache;
+    return cache;
+}
+
+// Requests that timed out while the resolver was working on them. They
+// must stay allocated until they complete, so each call frees the ones
+// that have finished since.
+std::mutex g_parked_mutex;
+std::vector<std::unique_ptr<Request>> g_parked;
+
+void reap_parked() {
+    std::lock_guard<std::mutex> lock(g_parked_mutex);
+    g_parked.erase(std::remove_if(g_parked.begin(), g_parked.end(),
+                                  [](const std::unique_ptr<Request>& r) {
+                                      if (gai_error(&r->cb) == EAI_INPROGRESS)
+                                          return false;
+                                      if (r->cb.ar_result)
+                                          freeaddrinfo(r->cb.ar_result);
+                                      return true;
+                                  }),
+                   g_parked.end());
+}
+
+void park(std::unique_ptr<Request> r) {
+    std::lock_guard<std::mutex> lock(g_parked_mutex);
+    g_parked.push_back(std::move(r));
+}
+
+std::string cache_key(const std::string& name, bool ipv6) {
+    std::string key = name;
+    key.push_back('\0');
+    key.push_back(ipv6 ? '6' : '*');
+    return key;
+}
+
+std::string gai_message(const std::string& name, int err) {
+    return "can't resolve '" + name + "': " + gai_strerror(err);
+}
+
+// Resolves names[todo[...]] with up to `opts.concurrency` requests in
+// flight. Sets `definite[slot]` for answers worth caching.
+void resolve_async(const std::vector<std::string>& names, const std::vector<size_t>& todo,
+                   const ResolveOptions& opts, std::vector<DnsAnswer>& answers,
+                   std::vector<bool>& definite) {
+    const auto timeout = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(opts.timeout));
+    std::vector<std::unique_ptr<Request>> inflight;
+    std::vector<struct gaicb*> list;
+    size_t next = 0;
+
+    while (next < todo.size() || !inflight.empty()) {
+        while (next < todo.size() && inflight.size() < opts.concurrency) {
+            auto r = std::make_unique<Request>();
+            r->slot = todo[next++];
+            r->name = names[r->slot];
+            r->hints.ai_family = opts.ipv6 ? AF_INET6 : AF_UNSPEC;
+            r->hints.ai_socktype = SOCK_STREAM;
+            r->cb.ar_name = r->name.c_str();
+            r->cb.ar_request = &r->hints;
+            r->deadline = Clock::now() + timeout;
+            struct gaicb* cbp = &r->cb;
+            int err = getaddrinfo_a(GAI_NOWAIT, &cbp, 1, nullptr);
+            if (err != 0) {
+                answers[r->slot].error = gai_message(r->name, err);
+                continue;
+            }
+            inflight.push_back(std::move(r));
+        }
+
+        if (inflight.empty())
+            continue;
+
+        // Sleep until one completes or the earliest deadline passes.
+        Clock::time_point wake = Clock::time_point::max();
+        list.clear();
+        for (const auto& r : inflight) {
+            list.push_back(&r->cb);
+            wake = std::min(wake, r->deadline);
+        }
+        auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(wake - Clock::now());
+        if (left.count() > 0) {
+            struct timespec ts;
+            ts.tv_sec = static_cast<time_t>(left.count() / 1000000000);
+            ts.tv_nsec = static_cast<long>(left.count() % 1000000000);
+            gai_suspend(list.data(), static_cast<int>(list.size()), &ts);
+        }
+
+        auto now = Clock::now();
+        for (size_t i = 0; i < inflight.size();) {
+            Request& r = *inflight[i];
+            DnsAnswer& answer = answers[r.slot];
+            int err = gai_error(&r.cb);
+            if (err == EAI_INPROGRESS && now >= r.deadline) {
+                // Read the state once: the lookup may finish between the
+                // cancel and any later check, and then its result is ours.
+                gai_cancel(&r.cb);
+                err = gai_error(&r.cb);
+                if (err == EAI_INPROGRESS) {
+                    answer.error = "can't resolve '" + r.name + "': timed out";
+                    park(std::move(inflight[i]));
+                    inflight.erase(inflight.begin() + static_cast<std::ptrdiff_t>(i));
+                    continue;
+                }
+            }
+            if (err == EAI_INPROGRESS) {
+                ++i;
+                continue;
+            }
+            if (err == 0) {
+                collect_addresses(r.cb.ar_result, answer);
+                freeaddrinfo(r.cb.ar_result);
+            } else if (err == EAI_CANCELED) {
+                answer.error = "can't resolve '" + r.name + "': timed out";
+            } else {
+                answer.error = gai_message(r.name, err);
+            }
+            definite[r.slot] = err == 0 || err == EAI_NONAME;
+            inflight.erase(inflight.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+}
+
+}  // namespace
+
+void collect_addresses(const struct addrinfo* res, DnsAnswer& answer) {
+    for (const struct addrinfo* rp = res; rp != nullptr; rp = rp->ai_next) {
+        char ip_str[INET6_ADDRSTRLEN];
+        if (rp->ai_family == AF_INET) {
+            const auto* addr4 = reinterpret_cast<const struct sockaddr_in*>(rp->ai_addr);
+            inet_ntop(AF_INET, &addr4->sin_addr, ip_str, sizeof(ip_str));
+        } else if (rp->ai_family == AF_INET6) {
+            const auto* addr6 = reinterpret_cast<const struct sockaddr_in6*>(rp->ai_addr);
+            inet_ntop(AF_INET6, &addr6->sin6_addr, ip_str, sizeof(ip_str));
+        } else {
+            continue;
+        }
+        answer.addresses.emplace_back(ip_str, rp->ai_family);
+    }
+}
+
+void reverse_lookup(const std::string& address, int family, DnsAnswer& answer) {
+    struct sockaddr_storage ss = {};
+    socklen_t len;
+    if (family == AF_INET) {
+        auto* sa = reinterpret_cast<struct sockaddr_in*>(&ss);
+        sa->sin_family = AF_INET;
+        inet_pton(AF_INET, address.c_str(), &sa->sin_addr);
+        len = sizeof(*sa);
+    } else {
+        auto* sa = reinterpret_cast<struct sockaddr_in6*>(&ss);
+        sa->sin6_family = AF_INET6;
+        inet_pton(AF_INET6, address.c_str(), &sa->sin6_addr);
+        len = sizeof(*sa);
+    }
+    char host_buf[NI_MAXHOST];
+    if (getnameinfo(reinterpret_cast<struct sockaddr*>(&ss), len, host_buf, sizeof(host_buf),
+                    nullptr, 0, NI_NAMEREQD) == 0) {
+        answer.has_canonical = true;
+        answer.canonical_name = host_buf;
+    }
+}
+
+std::vector<DnsAnswer> resolve_names(const std::vector<std::string>& names,
+                                     const ResolveOptions& opts) {
+    if (opts.concurrency < 1)
+        throw std::invalid_argument("concurrency must be at least 1");
+    if (opts.timeout <= 0)
+        throw std::invalid_argument("timeout must be positive");
+    if (opts.cache_ttl < 0)
+        throw std::invalid_argument("cache_ttl must be non-negative");
+    reap_parked();
+
+    // Each distinct name once; `slot_of[i]` is the unique slot of names[i].
+    std::vector<std::string> unique;
+    std::vector<size_t> slot_of(names.size());
+    {
+        std::unordered_map<std::string, size_t> seen;
+        for (size_t i = 0; i < names.size(); ++i) {
+            auto [it, added] = seen.emplace(names[i], unique.size());
+            if (added)
+                unique.push_back(names[i]);
+            slot_of[i] = it->second;
+        }
+    }
+
+    std::vector<DnsAnswer> answers(unique.size());
+    std::vector<size_t> todo;
+    for (size_t i = 0; i < unique.size(); ++i)
+        if (!opts.cache || !dns_cache().get(cache_key(unique[i], opts.ipv6), answers[i]))
+            todo.push_back(i);
+    std::vector<bool> definite(unique.size(), false);
+    resolve_async(unique, todo, opts, answers, definite);
+
+    // getnameinfo has no asynchronous form; run the reverse lookups on a
+    // pool instead.
+    if (opts.reverse) {
+        ThreadPool pool(std::min<size_t>(opts.concurrency, 32));
+        for (auto& answer : answers) {
+            if (!answer.error.empty() || answer.addresses.empty() || answer.has_canonical)
+                continue;
+            pool.submit([&answer] {
+                reverse_lookup(answer.addresses[0].first, answer.addresses[0].second, answer);
+            });
+        }
+        pool.wait();
+    }
+
+    if (opts.cache && opts.cache_ttl > 0) {
+        for (size_t i : todo)
+            if (definite[i])
+                dns_cache().put(cache_key(unique[i], opts.ipv6), answers[i], opts.cache_ttl);
+    }
+
+    std::vector<DnsAnswer> result;
+    result.reserve(names.size());
+    for (size_t slot : slot_of) {
+        result.push_back(answers[slot]);
+        if (!opts.reverse) {
+            // A cached answer may carry a name from an earlier reverse call.
+            result.back().has_canonical = false;
+            result.back().canonical_name.clear();
+        }
+    }
+    return result;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct addrinfo;
+
+// ---------------------------------------------------------------------------
+// Concurrent, cached name resolution behind nslookup_many
+//
+// Lookups go through glibc's getaddrinfo_a, so they follow nsswitch.conf
+// and /etc/hosts exactly like getaddrinfo, with up to `concurrency` of
+// them in flight at once. Each is abandoned after `timeout` seconds
+// without holding up the others. A request the resolver is still working
+// on cannot be freed, so it is parked and reaped on a later call; until
+// the system resolver gives up on it, it keeps one of glibc's resolver
+// threads busy.
+//
+// Answers are kept in a process-wide LRU shared by every call. getaddrinfo
+// does not report record TTLs, so entries live for `cache_ttl` seconds.
+// Definite failures (no such name) are cached as well. Temporary failures
+// and timeouts are not.
+// ---------------------------------------------------------------------------
+
+struct DnsAnswer {
+    std::vector<std::pair<std::string, int>> addresses;    // (address, family)
+    bool has_canonical = false;
+    std::string canonical_name;     // reverse lookup of the first address
+    std::string error;              // empty on success
+    bool cached = false;
+};
+
+struct ResolveOptions {
+    bool ipv6 = false;              // AAAA only
+    bool reverse = false;           // fill canonical_name
+    size_t concurrency = 64;
+    double timeout = 5.0;           // seconds per lookup
+    bool cache = true;
+    double cache_ttl = 60.0;        // seconds
+};
+
+// Answers for `names`, in input order; a name given twice is looked up
+// once. Failures are reported in DnsAnswer::error. Throws
+// std::invalid_argument for bad options.
+std::vector<DnsAnswer> resolve_names(const std::vector<std::string>& names,
+                                     const ResolveOptions& opts);
+
+// Appends the IPv4/IPv6 addresses of `res` to `answer`.
+void collect_addresses(const struct addrinfo* res, DnsAnswer& answer);
+
+// Sets canonical_name from a reverse lookup of `address` (as printed by
+// collect_addresses); leaves has_canonical false if there is none.
+void reverse_lookup(const std::string& address, int family, DnsAnswer& answer);
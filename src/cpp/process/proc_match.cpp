@@ -0,0 +1,209 @@
+#include "proc_match.h"
+#include "proc_scan.h"
+#include "text/matcher.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Same numbers on every architecture; older libc headers lack them.
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_pidfd_send_signal
+#define SYS_pidfd_send_signal 424
+#endif
+
+namespace {
+
+int pidfd_open(int pid) {
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+}
+
+int pidfd_send_signal(int pidfd, int sig) {
+    return static_cast<int>(syscall(SYS_pidfd_send_signal, pidfd, sig, nullptr, 0));
+}
+
+// True if `proc.pid` is still the process the scan saw and has not exited
+// (a zombie keeps its stat entry until reaped).
+bool still_running(const ProcMatch& proc, std::string& buf) {
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/stat", proc.pid);
+    ProcStat st;
+    return read_proc_file(AT_FDCWD, path, buf) &&
+           parse_proc_stat(buf.data(), buf.size(), st) &&
+           st.starttime == proc.starttime && st.state != 'Z';
+}
+
+struct Signalled {
+    ProcMatch proc;
+    int pidfd;      // -1 on the kill() fallback
+};
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// Matching
+// ---------------------------------------------------------------------------
+
+std::vector<std::vector<ProcMatch>> match_processes(const std::vector<std::string>& patterns,
+                                                    ProcMatchMode mode) {
+    std::vector<std::unique_ptr<Matcher>> matchers;
+    std::unordered_map<std::string, std::vector<size_t>> by_name;
+    if (mode == ProcMatchMode::exact) {
+        for (size_t i = 0; i < patterns.size(); ++i)
+            by_name[patterns[i]].push_back(i);
+    } else {
+        for (const auto& p : patterns)
+            matchers.push_back(compile_matcher(p, MatchOptions()));
+    }
+
+    ProcScanOptions opts;
+    opts.cmdline = mode == ProcMatchMode::cmdline;
+    std::vector<ProcStat> procs = scan_processes(opts);
+
+    int self = getpid();
+    std::vector<std::vector<ProcMatch>> result(patterns.size());
+    for (const auto& p : procs) {
+        if (p.pid == self)
+            continue;
+        ProcMatch m{p.pid, p.starttime};
+        if (mode == ProcMatchMode::exact) {
+            auto it = by_name.find(p.comm);
+            if (it != by_name.end())
+                for (size_t i : it->second)
+                    result[i].push_back(m);
+            continue;
+        }
+        const std::string& subject = mode == ProcMatchMode::cmdline ? p.cmdline : p.comm;
+        for (size_t i = 0; i < matchers.size(); ++i)
+            if (matchers[i]->matches(subject))
+                result[i].push_back(m);
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Signalling
+// ---------------------------------------------------------------------------
+
+SignalReport signal_processes(const std::vector<ProcMatch>& procs, int sig, double wait_seconds) {
+    SignalReport report;
+    std::vector<Signalled> live;
+    std::string buf;
+    bool waiting = wait_seconds >= 0;
+
+    for (const auto& proc : procs) {
+        int fd = pidfd_open(proc.pid);
+        if (fd < 0 && errno == ESRCH)
+            continue;   // already gone
+        // Otherwise fd < 0 means ENOSYS (old kernel) or EMFILE (very many
+        // processes): fall back to kill().
+        if (!still_running(proc, buf)) {
+            if (fd >= 0)
+                close(fd);
+            continue;   // exited, or pid reused since the scan
+        }
+        bool ok = fd >= 0 ? pidfd_send_signal(fd, sig) == 0 : ::kill(proc.pid, sig) == 0;
+        if (!ok) {
+            int err = errno;
+            if (fd >= 0)
+                close(fd);
+            if (err == ESRCH)
+                continue;
+            report.failed.push_back(proc.pid);
+            if (!report.first_error)
+                report.first_error = err;
+            continue;
+        }
+        report.signalled.push_back(proc.pid);
+        if (waiting) {
+            live.push_back({proc, fd});
+        } else if (fd >= 0) {
+            close(fd);
+        }
+    }
+    if (!waiting)
+        return report;
+
+    // A pidfd becomes readable when its process exits. Processes signalled
+    // without a pidfd are polled with the start-time check instead.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<
+        std::chrono::steady_clock::duration>(std::chrono::duration<double>(wait_seconds));
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    size_t polled = 0;
+    for (size_t i = 0; i < live.size(); ++i) {
+        if (live[i].pidfd < 0)
+            continue;
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        if (ep >= 0 && epoll_ctl(ep, EPOLL_CTL_ADD, live[i].pidfd, &ev) == 0) {
+            ++polled;
+        } else {
+            close(live[i].pidfd);
+            live[i].pidfd = -1;
+        }
+    }
+
+    std::vector<bool> exited(live.size(), false);
+    size_t pending = live.size();
+    std::vector<struct epoll_event> events(64);
+    while (pending > 0) {
+        bool fallback = polled < pending;
+        auto now = std::chrono::steady_clock::now();
+        long ms = static_cast<long>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count());
+        if (ms < 0)
+            ms = 0;
+        if (fallback && ms > 10)
+            ms = 10;
+
+        if (polled > 0) {
+            int n = epoll_wait(ep, events.data(), static_cast<int>(events.size()),
+                               static_cast<int>(ms));
+            for (int k = 0; k < n; ++k) {
+                size_t i = events[k].data.u64;
+                if (exited[i])
+                    continue;
+                exited[i] = true;
+                epoll_ctl(ep, EPOLL_CTL_DEL, live[i].pidfd, nullptr);
+                --polled;
+                --pending;
+            }
+        } else if (ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        }
+
+        if (fallback) {
+            for (size_t i = 0; i < live.size(); ++i) {
+                if (exited[i] || live[i].pidfd >= 0)
+                    continue;
+                if (!still_running(live[i].proc, buf)) {
+                    exited[i] = true;
+                    --pending;
+                }
+            }
+        }
+        if (std::chrono::steady_clock::now() >= deadline)
+            break;
+    }
+
+    for (size_t i = 0; i < live.size(); ++i) {
+        (exited[i] ? report.exited : report.remaining).push_back(live[i].proc.pid);
+        if (live[i].pidfd >= 0)
+            close(live[i].pidfd);
+    }
+    if (ep >= 0)
+        close(ep);
+    return report;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Process matching and signalling behind pgrep and killall
+//
+// match_processes() answers many patterns with one /proc pass. Exact names
+// go through a name -> patterns hash index, so each process costs a single
+// lookup however many names are asked for. Regexes use grep's matcher
+// against the process name, or against the full command line in cmdline
+// mode (like pgrep -f).
+//
+// signal_processes() sends signals through pidfds (pidfd_open +
+// pidfd_send_signal). After a pidfd is opened, the process's start time is
+// checked against the scan, so a pid recycled in between is never
+// signalled. Waiting for exit polls the pidfds with epoll. Kernels without
+// pidfds (before 5.3) fall back to kill() after the same start-time check,
+// which narrows the race to the few microseconds between the check and
+// the kill.
+// ---------------------------------------------------------------------------
+
+enum class ProcMatchMode { exact, regex, cmdline };
+
+struct ProcMatch {
+    int pid = 0;
+    uint64_t starttime = 0;     // identifies the process along with pid
+};
+
+// For each pattern, the processes it matches, in /proc order. The calling
+// process is never matched. Throws std::runtime_error if /proc cannot be
+// read and std::regex_error for an invalid pattern.
+std::vector<std::vector<ProcMatch>> match_processes(const std::vector<std::string>& patterns,
+                                                    ProcMatchMode mode);
+
+struct SignalReport {
+    std::vector<int> signalled;
+    std::vector<int> failed;        // e.g. EPERM
+    int first_error = 0;            // errno of the first failure
+    std::vector<int> exited;        // only when waiting
+    std::vector<int> remaining;     // signalled but still running at the timeout
+};
+
+// Sends `sig` to every process in `procs` that still exists. With
+// `wait_seconds` >= 0, then waits up to that long for them to exit.
+// Processes that are already gone are skipped silently.
+SignalReport signal_processes(const std::vector<ProcMatch>& procs, int sig, double wait_seconds);
@@ -0,0 +1,187 @@
+#include "proc_sampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include <time.h>
+
+static double monotonic_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec) + ts.tv_nsec / 1e9;
+}
+
+static double sample_value(const ProcSample& s, SampleKey key) {
+    switch (key) {
+        case SampleKey::cpu:       return s.cpu_percent;
+        case SampleKey::mem:       return s.mem_kb;
+        case SampleKey::mem_delta: return s.mem_delta_kb;
+        case SampleKey::read:      return s.read_rate;
+        case SampleKey::write:     return s.write_rate;
+        case SampleKey::io:
+            return std::max(s.read_rate, 0.0) + std::max(s.write_rate, 0.0);
+    }
+    return 0;
+}
+
+SampleKey parse_sample_key(const std::string& key) {
+    if (key == "cpu") return SampleKey::cpu;
+    if (key == "mem") return SampleKey::mem;
+    if (key == "mem_delta") return SampleKey::mem_delta;
+    if (key == "io") return SampleKey::io;
+    if (key == "read") return SampleKey::read;
+    if (key == "write") return SampleKey::write;
+    throw std::invalid_argument("unknown key '" + key + "'");
+}
+
+// ---------------------------------------------------------------------------
+// ProcessSampler
+// ---------------------------------------------------------------------------
+
+ProcessSampler::ProcessSampler(bool io, bool cmdline) {
+    opts_.io = io;
+    opts_.cmdline = cmdline;
+}
+
+ProcessSampler::~ProcessSampler() { stop(); }
+
+std::vector<ProcSample> ProcessSampler::take_sample(double& interval) {
+    std::vector<ProcStat> procs = scan_processes(opts_);
+    double now = monotonic_seconds();
+    double dt = previous_time_ < 0 ? 0 : now - previous_time_;
+    double ticks = static_cast<double>(clock_ticks());
+    double page_kb = page_size() / 1024.0;
+    double uptime = system_uptime();
+
+    std::unordered_map<int, Previous> next;
+    next.reserve(procs.size());
+    std::vector<ProcSample> samples;
+    samples.reserve(procs.size());
+    for (auto& p : procs) {
+        ProcSample s;
+        uint64_t cpu_ticks = p.utime + p.stime;
+        s.mem_kb = static_cast<double>(p.rss) * page_kb;
+
+        auto prev = previous_.find(p.pid);
+        if (prev != previous_.end() && prev->second.starttime == p.starttime && dt > 0) {
+            const Previous& b = prev->second;
+            uint64_t used = cpu_ticks >= b.cpu_ticks ? cpu_ticks - b.cpu_ticks : 0;
+            s.cpu_percent = static_cast<double>(used) / ticks / dt * 100.0;
+            s.mem_delta_kb = static_cast<double>(p.rss - b.rss) * page_kb;
+            if (p.read_bytes >= 0 && b.read_bytes >= 0)
+                s.read_rate = static_cast<double>(std::max<int64_t>(p.read_bytes - b.read_bytes, 0)) / dt;
+            if (p.write_bytes >= 0 && b.write_bytes >= 0)
+                s.write_rate = static_cast<double>(std::max<int64_t>(p.write_bytes - b.write_bytes, 0)) / dt;
+        } else {
+            s.is_new = true;
+            double age = uptime - static_cast<double>(p.starttime) / ticks;
+            if (age > 0) {
+                s.cpu_percent = static_cast<double>(cpu_ticks) / ticks / age * 100.0;
+                if (p.read_bytes >= 0)
+                    s.read_rate = static_cast<double>(p.read_bytes) / age;
+                if (p.write_bytes >= 0)
+                    s.write_rate = static_cast<double>(p.write_bytes) / age;
+            }
+        }
+
+        next.emplace(p.pid, Previous{p.starttime, cpu_ticks, p.rss, p.read_bytes, p.write_bytes});
+        s.proc = std::move(p);
+        samples.push_back(std::move(s));
+    }
+
+    previous_ = std::move(next);
+    previous_time_ = now;
+    interval = dt;
+    return samples;
+}
+
+std::vector<ProcSample> ProcessSampler::sample() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_)
+        latest_ = take_sample(last_interval_);
+    return latest_;
+}
+
+std::vector<ProcSample> ProcessSampler::top(size_t n, SampleKey key) {
+    std::vector<ProcSample> samples = sample();
+    n = std::min(n, samples.size());
+    std::partial_sort(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(n),
+                      samples.end(), [key](const ProcSample& a, const ProcSample& b) {
+                          double va = sample_value(a, key), vb = sample_value(b, key);
+                          return va != vb ? va > vb : a.proc.pid < b.proc.pid;
+                      });
+    samples.resize(n);
+    return samples;
+}
+
+void ProcessSampler::start(double interval) {
+    std::lock_guard<std::mutex> control(control_);
+    stop_thread();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        latest_ = take_sample(last_interval_);
+        stopping_ = false;
+        running_ = true;
+    }
+    thread_ = std::thread(&ProcessSampler::run, this, interval);
+}
+
+void ProcessSampler::stop() {
+    std::lock_guard<std::mutex> control(control_);
+    stop_thread();
+}
+
+void ProcessSampler::stop_thread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+    // Only now: until the thread has exited it may still be scanning, and
+    // sample() must not take a sample of its own alongside it.
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+}
+
+bool ProcessSampler::running() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+double ProcessSampler::last_interval() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_interval_;
+}
+
+// Samples on a fixed schedule (not a fixed sleep), so the rate stays at
+// 1/interval however long a scan takes. The scan runs unlocked, so
+// sample() and friends only ever wait for the swap into latest_.
+void ProcessSampler::run(double interval) {
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(interval));
+    auto next = std::chrono::steady_clock::now() + period;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!wake_.wait_until(lock, next, [this] { return stopping_; })) {
+        lock.unlock();
+        std::vector<ProcSample> samples;
+        double dt = 0;
+        bool ok = true;
+        try {
+            samples = take_sample(dt);
+        } catch (const std::exception&) {
+            ok = false;     // /proc briefly unreadable: keep the previous result.
+        }
+        lock.lock();
+        if (ok) {
+            latest_ = std::move(samples);
+            last_interval_ = dt;
+        }
+        next += period;
+        auto now = std::chrono::steady_clock::now();
+        if (next < now)
+            next = now + period;    // fell behind; don't burst to catch up
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "proc_scan.h"
+
+// ---------------------------------------------------------------------------
+// ProcessSampler — interval rates from consecutive /proc snapshots
+//
+// ps reports CPU time divided by process age, which says nothing about
+// what is hot right now. The sampler keeps, per pid, the CPU ticks, storage
+// I/O counters and RSS of the previous snapshot and reports the change
+// since then: CPU% over the interval (100 = one core), read/write bytes
+// per second and the RSS delta. A pid is matched to its previous sample
+// only if its start time is unchanged, so a recycled pid counts as a new
+// process. A process seen for the first time reports its lifetime average.
+//
+// Optionally a background thread samples at a fixed interval; queries then
+// read the latest result without touching /proc.
+// ---------------------------------------------------------------------------
+
+struct ProcSample {
+    ProcStat proc;
+    double cpu_percent = 0;
+    double mem_kb = 0;
+    double mem_delta_kb = 0;
+    double read_rate = -1;      // bytes/s; -1 when /proc/N/io is unreadable
+    double write_rate = -1;
+    bool is_new = false;        // no previous sample of this process
+};
+
+enum class SampleKey { cpu, mem, mem_delta, io, read, write };
+
+// Parses "cpu", "mem", "mem_delta", "io", "read" or "write"; throws
+// std::invalid_argument otherwise.
+SampleKey parse_sample_key(const std::string& key);
+
+class ProcessSampler {
+public:
+    ProcessSampler(bool io, bool cmdline);
+    ~ProcessSampler();
+
+    ProcessSampler(const ProcessSampler&) = delete;
+    ProcessSampler& operator=(const ProcessSampler&) = delete;
+
+    // Takes a snapshot now and returns the rates since the previous one.
+    // While the background thread runs, returns its latest result instead.
+    std::vector<ProcSample> sample();
+
+    // The `n` processes with the highest `key`, from sample().
+    std::vector<ProcSample> top(size_t n, SampleKey key);
+
+    // Samples every `interval` seconds on a background thread (restarting
+    // it if running). The first sample is taken before returning.
+    void start(double interval);
+    void stop();
+    bool running() const;
+
+    // Seconds the latest sample covers (0 before the second one).
+    double last_interval() const;
+
+private:
+    struct Previous {
+        uint64_t starttime;
+        uint64_t cpu_ticks;
+        int64_t rss;
+        int64_t read_bytes;
+        int64_t write_bytes;
+    };
+
+    // Scans /proc and returns the samples and the seconds they cover.
+    // previous_ belongs to the sampling thread while running_, and to
+    // callers holding mutex_ otherwise.
+    std::vector<ProcSample> take_sample(double& interval);
+    void run(double interval);
+    void stop_thread();                         // requires control_
+
+    ProcScanOptions opts_;
+    mutable std::mutex mutex_;
+    std::unordered_map<int, Previous> previous_;
+    double previous_time_ = -1;                 // monotonic seconds
+    double last_interval_ = 0;                  // guarded by mutex_
+    std::vector<ProcSample> latest_;            // guarded by mutex_
+
+    std::mutex control_;                        // serializes start/stop
+    std::thread thread_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    bool running_ = false;                      // guarded by mutex_
+};
@@ -0,0 +1,238 @@
+#include "proc_scan.h"
+#include "common/stats.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static constexpr size_t kProcDirBuffer = 64 << 10;
+
+namespace {
+
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+struct FdGuard {
+    int fd;
+    ~FdGuard() {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+// A pid directory name: all digits.
+bool is_pid(const char* name, int& pid) {
+    if (*name == '\0')
+        return false;
+    long value = 0;
+    for (const char* p = name; *p; ++p) {
+        if (*p < '0' || *p > '9')
+            return false;
+        value = value * 10 + (*p - '0');
+        if (value > 0x7fffffff)
+            return false;
+    }
+    pid = static_cast<int>(value);
+    return true;
+}
+
+// Next space-separated integer field.
+bool next_field(const char*& p, const char* end, int64_t& value) {
+    while (p < end && *p == ' ')
+        ++p;
+    bool negative = p < end && *p == '-';
+    if (negative)
+        ++p;
+    if (p >= end || *p < '0' || *p > '9')
+        return false;
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+        v = v * 10 + static_cast<uint64_t>(*p++ - '0');
+    value = negative ? -static_cast<int64_t>(v) : static_cast<int64_t>(v);
+    return true;
+}
+
+// The read_bytes / write_bytes lines of /proc/N/io.
+void parse_proc_io(const std::string& buf, ProcStat& out) {
+    const char* p = buf.data();
+    const char* end = p + buf.size();
+    while (p < end) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!eol) eol = end;
+        size_t len = static_cast<size_t>(eol - p);
+        int64_t* field = nullptr;
+        const char* value = nullptr;
+        if (len > 11 && memcmp(p, "read_bytes:", 11) == 0) {
+            field = &out.read_bytes;
+            value = p + 11;
+        } else if (len > 12 && memcmp(p, "write_bytes:", 12) == 0) {
+            field = &out.write_bytes;
+            value = p + 12;
+        }
+        if (field)
+            next_field(value, eol, *field);
+        p = eol + 1;
+    }
+}
+
+}  // namespace
+
+bool read_proc_file(int dir_fd, const char* name, std::string& buf) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    stats_syscalls();
+    if (fd < 0)
+        return false;
+    FdGuard guard{fd};
+    stats_syscalls();               // its close
+    buf.clear();
+    size_t len = 0;
+    for (;;) {
+        if (buf.size() - len < 1024)
+            buf.resize(len + 4096);
+        ssize_t n = ::read(fd, &buf[len], buf.size() - len);
+        stats_syscalls();
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0) {
+            buf.clear();
+            return false;
+        }
+        if (n == 0)
+            break;
+        len += static_cast<size_t>(n);
+    }
+    buf.resize(len);
+    stats_bytes(len);
+    return true;
+}
+
+bool parse_proc_stat(const char* data, size_t len, ProcStat& out) {
+    const char* end = data + len;
+    // "pid (comm) state ppid ..."; comm may itself contain ") ".
+    const char* open = static_cast<const char*>(memchr(data, '(', len));
+    const char* close = nullptr;
+    for (const char* p = end; p > data; --p) {
+        if (p[-1] == ')') {
+            close = p - 1;
+            break;
+        }
+    }
+    if (!open || !close || close < open || close + 2 >= end)
+        return false;
+    out.comm.assign(open + 1, static_cast<size_t>(close - open - 1));
+    out.state = close[2];
+
+    // Fields 4 (ppid) to 24 (rss) of proc(5).
+    int64_t f[25] = {};
+    const char* p = close + 3;
+    for (int i = 4; i <= 24; ++i) {
+        if (!next_field(p, end, f[i]))
+            return false;
+    }
+    out.ppid = static_cast<int>(f[4]);
+    out.utime = static_cast<uint64_t>(f[14]);
+    out.stime = static_cast<uint64_t>(f[15]);
+    out.priority = f[18];
+    out.nice = f[19];
+    out.threads = f[20];
+    out.starttime = static_cast<uint64_t>(f[22]);
+    out.vsize = static_cast<uint64_t>(f[23]);
+    out.rss = f[24];
+    return true;
+}
+
+std::vector<ProcStat> scan_processes(const ProcScanOptions& opts) {
+    int proc_fd = ::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (proc_fd < 0)
+        throw std::runtime_error("/proc filesystem not available");
+    FdGuard proc_guard{proc_fd};
+
+    std::vector<ProcStat> procs;
+    std::unique_ptr<char[]> dents(new char[kProcDirBuffer]);
+    std::string buf;
+    buf.reserve(4096);
+    char path[64];
+
+    for (;;) {
+        long n = syscall(SYS_getdents64, proc_fd, dents.get(), kProcDirBuffer);
+        stats_syscalls();
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        stats_bytes(static_cast<uint64_t>(n));
+        for (long pos = 0; pos < n;) {
+            auto* ent = reinterpret_cast<const LinuxDirent64*>(dents.get() + pos);
+            pos += ent->d_reclen;
+            int pid;
+            if ((ent->d_type != DT_DIR && ent->d_type != DT_UNKNOWN) || !is_pid(ent->d_name, pid))
+                continue;
+
+            struct stat st;
+            stats_syscalls();
+            if (fstatat(proc_fd, ent->d_name, &st, 0) != 0)
+                continue;       // exited
+            if (opts.uid >= 0 && st.st_uid != static_cast<uid_t>(opts.uid))
+                continue;
+
+            snprintf(path, sizeof(path), "%s/stat", ent->d_name);
+            ProcStat proc;
+            if (!read_proc_file(proc_fd, path, buf) ||
+                !parse_proc_stat(buf.data(), buf.size(), proc))
+                continue;
+            proc.pid = pid;
+            proc.uid = st.st_uid;
+
+            if (opts.cmdline) {
+                snprintf(path, sizeof(path), "%s/cmdline", ent->d_name);
+                if (read_proc_file(proc_fd, path, buf)) {
+                    while (!buf.empty() && buf.back() == '\0')
+                        buf.pop_back();
+                    for (char& c : buf) {
+                        if (c == '\0') c = ' ';
+                    }
+                    proc.cmdline = buf;
+                }
+                if (proc.cmdline.empty())
+                    proc.cmdline = "[" + proc.comm + "]";
+            }
+            if (opts.io) {
+                snprintf(path, sizeof(path), "%s/io", ent->d_name);
+                if (read_proc_file(proc_fd, path, buf))
+                    parse_proc_io(buf, proc);
+            }
+            procs.push_back(std::move(proc));
+        }
+    }
+    return procs;
+}
+
+double system_uptime() {
+    std::string buf;
+    if (!read_proc_file(AT_FDCWD, "/proc/uptime", buf))
+        return 0;
+    return std::strtod(buf.c_str(), nullptr);
+}
+
+long clock_ticks() {
+    static const long ticks = sysconf(_SC_CLK_TCK);
+    return ticks;
+}
+
+long page_size() {
+    static const long size = sysconf(_SC_PAGESIZE);
+    return size;
+}
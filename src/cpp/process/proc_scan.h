@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// /proc snapshot engine behind ps and ProcessSampler
+//
+// One pass over /proc: the pid directories are listed with getdents64, the
+// owner comes from fstatat() on the directory (the process's effective
+// uid), and only /proc/N/stat is read, with openat() and one read() into a
+// reused buffer, and parsed by hand. /proc/N/cmdline and /proc/N/io are
+// read only when asked for. Processes that exit during the scan are
+// skipped.
+// ---------------------------------------------------------------------------
+
+struct ProcScanOptions {
+    bool cmdline = false;       // read /proc/N/cmdline
+    bool io = false;            // read /proc/N/io
+    int64_t uid = -1;           // only processes owned by this uid; -1 = all
+};
+
+struct ProcStat {
+    int pid = 0;
+    int ppid = 0;
+    char state = '?';
+    std::string comm;           // the (comm) field of stat
+    std::string cmdline;        // arguments joined by spaces; "[comm]" if none
+    uint32_t uid = 0;
+    int64_t priority = 0;
+    int64_t nice = 0;
+    int64_t threads = 0;
+    uint64_t utime = 0;         // clock ticks
+    uint64_t stime = 0;
+    uint64_t starttime = 0;     // clock ticks after boot
+    uint64_t vsize = 0;         // bytes
+    int64_t rss = 0;            // pages
+    // Bytes fetched from / sent to storage (read_bytes / write_bytes of
+    // /proc/N/io); -1 when not read or not readable (another user's
+    // process without CAP_SYS_PTRACE).
+    int64_t read_bytes = -1;
+    int64_t write_bytes = -1;
+};
+
+// Snapshot of every (matching) process, in /proc order. Throws
+// std::runtime_error if /proc cannot be read.
+std::vector<ProcStat> scan_processes(const ProcScanOptions& opts);
+
+// Parses the contents of /proc/N/stat. Returns false if it is malformed.
+bool parse_proc_stat(const char* data, size_t len, ProcStat& out);
+
+// Reads a small /proc file (relative to `dir_fd`) into `buf`. Returns
+// false if it cannot be opened or read.
+bool read_proc_file(int dir_fd, const char* name, std::string& buf);
+
+double system_uptime();         // seconds, from /proc/uptime
+long clock_ticks();             // sysconf(_SC_CLK_TCK)
+long page_size();
@@ -1,176 +1,204 @@
 #include "process.h"
+#include "proc_scan.h"
+#include "proc_sampler.h"
+#include "proc_match.h"
+#include "common/stats.h"
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
 #include <string>
 #include <vector>
-#include <fstream>
-#include <sstream>
-#include <filesystem>
 #include <cstring>
 #include <algorithm>
+#include <memory>
+#include <optional>
+#include <regex>
 
 #include <signal.h>
 #include <unistd.h>
-#include <dirent.h>
 #include <sys/types.h>
 
 namespace py = pybind11;
-namespace fs = std::filesystem;
 
 // ---------------------------------------------------------------------------
-// Helper: Read a /proc/[pid]/... file
+// ps — List running processes
 // ---------------------------------------------------------------------------
 
-static std::string read_proc_file(const std::string& path) {
-    std::ifstream ifs(path);
-    if (!ifs.is_open()) return "";
-    std::ostringstream oss;
-    oss << ifs.rdbuf();
-    return oss.str();
+// The columns ps returns, in dict order.
+enum PsField {
+    kPsPid, kPsPpid, kPsCommand, kPsCmdline, kPsState, kPsCpu, kPsMem,
+    kPsThreads, kPsUid, kPsPriority, kPsNice, kPsFieldCount
+};
+
+static const char* const kPsFieldNames[kPsFieldCount] = {
+    "pid", "ppid", "command", "cmdline", "state", "cpu_percent", "mem_kb",
+    "threads", "uid", "priority", "nice",
+};
+
+struct PsRow {
+    ProcStat proc;
+    double cpu_percent;     // lifetime average
+    double mem_kb;
+};
+
+static std::vector<int> ps_fields(const std::optional<std::vector<std::string>>& fields) {
+    std::vector<int> out;
+    if (!fields) {
+        for (int i = 0; i < kPsFieldCount; i++) out.push_back(i);
+        return out;
+    }
+    for (const auto& name : *fields) {
+        int i = 0;
+        while (i < kPsFieldCount && name != kPsFieldNames[i]) i++;
+        if (i == kPsFieldCount)
+            throw py::value_error("ps: unknown field '" + name + "'");
+        out.push_back(i);
+    }
+    return out;
 }
 
-// ---------------------------------------------------------------------------
-// ps — List running processes
-// ---------------------------------------------------------------------------
+static std::vector<PsRow> ps_collect(bool all, const std::string& sort_by, bool cmdline) {
+    ProcScanOptions opts;
+    opts.cmdline = cmdline;
+    if (!all) opts.uid = getuid();
+    std::vector<ProcStat> procs;
+    try {
+        procs = scan_processes(opts);
+    } catch (const std::runtime_error& e) {
+        throw py::value_error(std::string("ps: ") + e.what());
+    }
 
-static py::list ps_impl(bool all, const std::string& sort_by) {
-    py::list result;
-    fs::path proc_dir("/proc");
+    double sys_uptime = system_uptime();
+    double ticks = static_cast<double>(clock_ticks());
+    double page_kb = page_size() / 1024.0;
 
-    if (!fs::exists(proc_dir))
-        throw py::value_error("ps: /proc filesystem not available");
+    std::vector<PsRow> rows;
+    rows.reserve(procs.size());
+    for (auto& p : procs) {
+        double total_time = static_cast<double>(p.utime + p.stime) / ticks;
+        double proc_uptime = sys_uptime - static_cast<double>(p.starttime) / ticks;
+        double cpu_percent = proc_uptime > 0 ? (total_time / proc_uptime) * 100.0 : 0.0;
+        double mem_kb = static_cast<double>(p.rss) * page_kb;
+        rows.push_back({std::move(p), cpu_percent, mem_kb});
+    }
 
-    uid_t current_uid = getuid();
-    long page_size = sysconf(_SC_PAGESIZE);
-    long clk_tck = sysconf(_SC_CLK_TCK);
+    if (sort_by == "cpu") {
+        std::stable_sort(rows.begin(), rows.end(), [](const PsRow& a, const PsRow& b) {
+            return a.cpu_percent > b.cpu_percent;
+        });
+    } else if (sort_by == "mem") {
+        std::stable_sort(rows.begin(), rows.end(), [](const PsRow& a, const PsRow& b) {
+            return a.mem_kb > b.mem_kb;
+        });
+    } else if (!sort_by.empty()) {
+        std::sort(rows.begin(), rows.end(), [](const PsRow& a, const PsRow& b) {
+            return a.proc.pid < b.proc.pid;
+        });
+    }
+    return rows;
+}
 
-    // Read system uptime for CPU% calculation
-    double sys_uptime = 0;
-    {
-        std::ifstream ifs("/proc/uptime");
-        if (ifs.is_open()) ifs >> sys_uptime;
+static py::object ps_value(const PsRow& r, int field) {
+    switch (field) {
+        case kPsPid:      return py::int_(r.proc.pid);
+        case kPsPpid:     return py::int_(r.proc.ppid);
+        case kPsCommand:  return py::str(r.proc.comm);
+        case kPsCmdline:  return py::str(r.proc.cmdline);
+        case kPsState:    return py::str(std::string(1, r.proc.state));
+        case kPsCpu:      return py::float_(r.cpu_percent);
+        case kPsMem:      return py::float_(r.mem_kb);
+        case kPsThreads:  return py::int_(r.proc.threads);
+        case kPsUid:      return py::str(std::to_string(r.proc.uid));
+        case kPsPriority: return py::int_(r.proc.priority);
+        default:          return py::int_(r.proc.nice);
     }
+}
 
-    for (auto& entry : fs::directory_iterator(proc_dir)) {
-        if (!entry.is_directory()) continue;
-        std::string dirname = entry.path().filename().string();
-
-        // Only numeric directories (PIDs)
-        if (!std::all_of(dirname.begin(), dirname.end(), ::isdigit))
-            continue;
-
-        int pid = std::stoi(dirname);
-        std::string proc_path = "/proc/" + dirname;
-
-        // Read stat file
-        std::string stat_content = read_proc_file(proc_path + "/stat");
-        if (stat_content.empty()) continue;
-
-        // Parse /proc/[pid]/stat
-        // Format: pid (comm) state ppid pgrp ...
-        auto comm_start = stat_content.find('(');
-        auto comm_end = stat_content.rfind(')');
-        if (comm_start == std::string::npos || comm_end == std::string::npos)
-            continue;
-
-        std::string command = stat_content.substr(comm_start + 1, comm_end - comm_start - 1);
-        std::string after_comm = stat_content.substr(comm_end + 2);
-
-        std::istringstream iss(after_comm);
-        std::string state;
-        int ppid;
-        iss >> state >> ppid;
-
-        // Skip fields to get to utime and stime (fields 14 and 15 after comm)
-        std::string skip;
-        for (int i = 0; i < 9; i++) iss >> skip; // pgrp, session, tty, tpgid, flags, minflt, cminflt, majflt, cmajflt
-        unsigned long utime, stime;
-        iss >> utime >> stime;
-
-        // Skip to starttime (field 22)
-        unsigned long cutime, cstime;
-        iss >> cutime >> cstime;
-        long priority, nice;
-        iss >> priority >> nice;
-        long num_threads;
-        iss >> num_threads;
-        iss >> skip; // itrealvalue
-        unsigned long long starttime;
-        iss >> starttime;
-
-        // vsize and rss
-        unsigned long vsize;
-        long rss;
-        iss >> vsize >> rss;
-
-        // CPU percentage
-        double total_time = static_cast<double>(utime + stime) / clk_tck;
-        double proc_uptime = sys_uptime - (static_cast<double>(starttime) / clk_tck);
-        double cpu_percent = proc_uptime > 0 ? (total_time / proc_uptime) * 100.0 : 0.0;
+static py::object ps_impl(bool all, const std::string& sort_by,
+                          const std::optional<std::vector<std::string>>& fields,
+                          bool table) {
+    std::vector<int> columns = ps_fields(fields);
+    bool cmdline = std::find(columns.begin(), columns.end(), kPsCmdline) != columns.end();
+    std::vector<PsRow> rows;
+    {
+        py::gil_scoped_release release;
+        rows = ps_collect(all, sort_by, cmdline);
+    }
 
-        // Memory
-        double mem_kb = rss * (page_size / 1024.0);
-
-        // UID check for non-all mode
-        std::string uid_str = "";
-        {
-            std::ifstream status_ifs(proc_path + "/status");
-            std::string line;
-            uid_t proc_uid = 0;
-            while (std::getline(status_ifs, line)) {
-                if (line.find("Uid:") == 0) {
-                    std::istringstream uid_iss(line.substr(4));
-                    uid_iss >> proc_uid;
-                    break;
-                }
-            }
-            if (!all && proc_uid != current_uid) continue;
-            uid_str = std::to_string(proc_uid);
+    std::vector<py::str> keys;
+    for (int c : columns)
+        keys.emplace_back(kPsFieldNames[c]);
+
+    if (table) {
+        py::dict result;
+        for (size_t i = 0; i < columns.size(); i++) {
+            py::list column(rows.size());
+            for (size_t j = 0; j < rows.size(); j++)
+                column[j] = ps_value(rows[j], columns[i]);
+            result[keys[i]] = column;
         }
+        return result;
+    }
 
-        // Read cmdline for full command
-        std::string cmdline = read_proc_file(proc_path + "/cmdline");
-        std::replace(cmdline.begin(), cmdline.end(), '\0', ' ');
-        if (cmdline.empty()) cmdline = "[" + command + "]";
-
+    py::list result(rows.size());
+    for (size_t j = 0; j < rows.size(); j++) {
         py::dict proc;
-        proc["pid"]         = pid;
-        proc["ppid"]        = ppid;
-        proc["command"]     = command;
-        proc["cmdline"]     = cmdline;
-        proc["state"]       = state;
-        proc["cpu_percent"] = cpu_percent;
-        proc["mem_kb"]      = mem_kb;
-        proc["threads"]     = num_threads;
-        proc["uid"]         = uid_str;
-        proc["priority"]    = priority;
-        proc["nice"]        = nice;
-
-        result.append(proc);
+        for (size_t i = 0; i < columns.size(); i++)
+            proc[keys[i]] = ps_value(rows[j], columns[i]);
+        result[j] = proc;
     }
+    return result;
+}
 
-    // Sort
-    if (!sort_by.empty()) {
-        auto items = result.cast<std::vector<py::dict>>();
-        std::sort(items.begin(), items.end(),
-                  [&](const py::dict& a, const py::dict& b) {
-                      if (sort_by == "cpu")
-                          return a["cpu_percent"].cast<double>() > b["cpu_percent"].cast<double>();
-                      if (sort_by == "mem")
-                          return a["mem_kb"].cast<double>() > b["mem_kb"].cast<double>();
-                      if (sort_by == "pid")
-                          return a["pid"].cast<int>() < b["pid"].cast<int>();
-                      return a["pid"].cast<int>() < b["pid"].cast<int>();
-                  });
-        result = py::list();
-        for (auto& item : items)
-            result.append(item);
-    }
+// ---------------------------------------------------------------------------
+// ProcessSampler — interval CPU%, I/O rates and RSS deltas
+// ---------------------------------------------------------------------------
+
+static py::object rate_or_none(double rate) {
+    return rate < 0 ? py::object(py::none()) : py::object(py::float_(rate));
+}
 
+static py::list sample_list(const std::vector<ProcSample>& samples, bool cmdline) {
+    py::list result(samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        const ProcSample& s = samples[i];
+        py::dict proc;
+        proc["pid"]                 = s.proc.pid;
+        proc["ppid"]                = s.proc.ppid;
+        proc["command"]             = s.proc.comm;
+        if (cmdline)
+            proc["cmdline"]         = s.proc.cmdline;
+        proc["state"]               = std::string(1, s.proc.state);
+        proc["uid"]                 = std::to_string(s.proc.uid);
+        proc["threads"]             = s.proc.threads;
+        proc["cpu_percent"]         = s.cpu_percent;
+        proc["mem_kb"]              = s.mem_kb;
+        proc["mem_delta_kb"]        = s.mem_delta_kb;
+        proc["read_bytes_per_sec"]  = rate_or_none(s.read_rate);
+        proc["write_bytes_per_sec"] = rate_or_none(s.write_rate);
+        proc["new"]                 = s.is_new;
+        result[i] = proc;
+    }
     return result;
 }
 
+// Python-side owner of a sampler; remembers whether cmdline is collected.
+struct PySampler {
+    std::unique_ptr<ProcessSampler> sampler;
+    bool cmdline;
+};
+
+// Runs `fn` on the sampler without the GIL; scan errors become ValueError.
+template <typename Fn>
+static auto sampler_call(const char* what, Fn&& fn) {
+    py::gil_scoped_release release;
+    try {
+        return fn();
+    } catch (const std::exception& e) {
+        throw py::value_error(std::string("ProcessSampler.") + what + ": " + e.what());
+    }
+}
+
 // ---------------------------------------------------------------------------
 // kill — Send signal to a process
 // ---------------------------------------------------------------------------
@@ -183,42 +211,125 @@ static void kill_impl(int pid, int sig) {
 }
 
 // ---------------------------------------------------------------------------
-// killall — Kill processes by name
+// pgrep / killall — Find and signal processes by name
 // ---------------------------------------------------------------------------
 
-static py::dict killall_impl(const std::string& name, int sig) {
-    int killed = 0;
-    int failed = 0;
-
-    fs::path proc_dir("/proc");
-    for (auto& entry : fs::directory_iterator(proc_dir)) {
-        if (!entry.is_directory()) continue;
-        std::string dirname = entry.path().filename().string();
-        if (!std::all_of(dirname.begin(), dirname.end(), ::isdigit))
-            continue;
-
-        std::string comm = read_proc_file("/proc/" + dirname + "/comm");
-        // Remove trailing newline
-        while (!comm.empty() && (comm.back() == '\n' || comm.back() == '\r'))
-            comm.pop_back();
-
-        if (comm == name) {
-            int pid = std::stoi(dirname);
-            if (::kill(pid, sig) == 0)
-                killed++;
-            else
-                failed++;
-        }
+static ProcMatchMode parse_match_mode(const char* cmd, const std::string& match) {
+    if (match == "exact") return ProcMatchMode::exact;
+    if (match == "regex") return ProcMatchMode::regex;
+    if (match == "cmdline") return ProcMatchMode::cmdline;
+    throw py::value_error(std::string(cmd) + ": unknown match mode '" + match +
+                          "' (expected exact, regex or cmdline)");
+}
+
+// One /proc pass for all patterns; requires the GIL to be released.
+static std::vector<std::vector<ProcMatch>> find_processes(const char* cmd,
+                                                          const std::vector<std::string>& patterns,
+                                                          ProcMatchMode mode) {
+    try {
+        return match_processes(patterns, mode);
+    } catch (const std::regex_error& e) {
+        throw py::value_error(std::string(cmd) + ": invalid pattern: " + e.what());
+    } catch (const std::runtime_error& e) {
+        throw py::value_error(std::string(cmd) + ": " + e.what());
     }
+}
+
+static py::list pid_list(const std::vector<ProcMatch>& procs) {
+    py::list out;
+    for (const auto& p : procs)
+        out.append(p.pid);
+    return out;
+}
 
-    if (killed == 0 && failed == 0)
-        throw py::value_error("killall: no process found with name '" + name + "'");
+static py::list pgrep_impl(const std::string& pattern, const std::string& match) {
+    ProcMatchMode mode = parse_match_mode("pgrep", match);
+    std::vector<std::vector<ProcMatch>> found;
+    {
+        py::gil_scoped_release release;
+        found = find_processes("pgrep", {pattern}, mode);
+    }
+    return pid_list(found[0]);
+}
 
+static py::dict pgrep_many_impl(const std::vector<std::string>& patterns,
+                                const std::string& match) {
+    ProcMatchMode mode = parse_match_mode("pgrep", match);
+    std::vector<std::vector<ProcMatch>> found;
+    {
+        py::gil_scoped_release release;
+        found = find_processes("pgrep", patterns, mode);
+    }
     py::dict result;
-    result["killed"] = killed;
-    result["failed"] = failed;
-    result["name"]   = name;
+    for (size_t i = 0; i < patterns.size(); ++i)
+        result[py::str(patterns[i])] = pid_list(found[i]);
+    return result;
+}
+
+// Matches `names` and signals the union of the matches, each process once.
+// Fills "killed", "failed", "signal" and "pids" (plus "exited" and
+// "remaining" when waiting) into `result`, and returns the per-name matches.
+static std::vector<std::vector<ProcMatch>> killall_run(const std::vector<std::string>& names,
+                                                       int sig, const std::string& match,
+                                                       bool wait, double timeout,
+                                                       py::dict& result) {
+    ProcMatchMode mode = parse_match_mode("killall", match);
+    if (timeout < 0)
+        throw py::value_error("killall: timeout must be non-negative");
+
+    std::vector<std::vector<ProcMatch>> found;
+    SignalReport report;
+    {
+        py::gil_scoped_release release;
+        found = find_processes("killall", names, mode);
+
+        std::vector<ProcMatch> targets;
+        for (const auto& matches : found)
+            targets.insert(targets.end(), matches.begin(), matches.end());
+        std::sort(targets.begin(), targets.end(),
+                  [](const ProcMatch& a, const ProcMatch& b) { return a.pid < b.pid; });
+        targets.erase(std::unique(targets.begin(), targets.end(),
+                                  [](const ProcMatch& a, const ProcMatch& b) {
+                                      return a.pid == b.pid;
+                                  }),
+                      targets.end());
+        report = signal_processes(targets, sig, wait ? timeout : -1);
+    }
+
+    if (report.signalled.empty() && report.failed.empty()) {
+        std::string what = names.size() == 1 ? "name '" + names[0] + "'"
+                                             : "any of the " + std::to_string(names.size()) +
+                                                   " names";
+        throw py::value_error("killall: no process found with " + what);
+    }
+
+    result["killed"] = report.signalled.size();
+    result["failed"] = report.failed.size();
     result["signal"] = sig;
+    result["pids"]   = report.signalled;
+    if (wait) {
+        result["exited"]    = report.exited;
+        result["remaining"] = report.remaining;
+    }
+    return found;
+}
+
+static py::dict killall_impl(const std::string& name, int sig, const std::string& match,
+                             bool wait, double timeout) {
+    py::dict result;
+    killall_run({name}, sig, match, wait, timeout, result);
+    result["name"] = name;
+    return result;
+}
+
+static py::dict killall_many_impl(const std::vector<std::string>& names, int sig,
+                                  const std::string& match, bool wait, double timeout) {
+    py::dict result;
+    std::vector<std::vector<ProcMatch>> found = killall_run(names, sig, match, wait, timeout, result);
+    py::dict by_name;
+    for (size_t i = 0; i < names.size(); ++i)
+        by_name[py::str(names[i])] = pid_list(found[i]);
+    result["names"] = by_name;
     return result;
 }
 
@@ -229,31 +340,147 @@ static py::dict killall_impl(const std::string& name, int sig) {
 void init_process(py::module_ &m) {
 
     // -- ps -----------------------------------------------------------------
-    m.def("ps", &ps_impl,
+    m.def("ps", counted("ps", &ps_impl),
         R"doc(
         List running processes.
 
         Equivalent to the ``ps`` shell command. Reads the /proc filesystem
         to list currently running processes with CPU, memory, and state info.
+        Only /proc/PID/stat is read per process, plus /proc/PID/cmdline
+        when the "cmdline" field is requested.
 
         Args:
             all (bool): If True, show processes from all users.
                         Equivalent to ``ps aux`` vs ``ps``.
             sort_by (str): Sort results by "cpu", "mem", or "pid".
+            fields (list[str]): The keys to return, in this order. Defaults
+                                to all of them.
+            table (bool): If True, return one dict mapping each field to a
+                          list of values (one per process, in sort order)
+                          instead of a dict per process.
 
         Returns:
             list[dict]: Each dict contains "pid", "ppid", "command", "cmdline",
                         "state", "cpu_percent", "mem_kb", "threads", "uid",
-                        "priority", "nice".
+                        "priority", "nice" (or the requested fields).
+            dict[str, list]: With table=True.
 
         Raises:
-            ValueError: If /proc filesystem is not available.
+            ValueError: If /proc filesystem is not available or a field is
+                        unknown.
         )doc",
         py::arg("all") = true,
-        py::arg("sort_by") = "pid");
+        py::arg("sort_by") = "pid",
+        py::arg("fields") = py::none(),
+        py::arg("table") = false);
+
+    // -- ProcessSampler -----------------------------------------------------
+    py::class_<PySampler>(m, "ProcessSampler",
+        R"doc(
+        Per-process rates between consecutive /proc snapshots, like ``top``.
+
+        Keeps each process's CPU ticks, storage I/O counters and RSS from the
+        previous snapshot and reports the change since then: ``cpu_percent``
+        over the interval (100 = one core), ``read_bytes_per_sec`` /
+        ``write_bytes_per_sec`` from /proc/PID/io (None where it is not
+        readable) and ``mem_delta_kb``. A recycled PID is recognised by its
+        start time. A process seen for the first time (``new`` is True)
+        reports its lifetime average, so the very first sample is like ps.
+
+        Args:
+            interval (float): If positive, sample every ``interval`` seconds
+                              on a background thread; sample() and top() then
+                              return the latest result without reading /proc.
+            io (bool): If True, read /proc/PID/io for I/O rates.
+            cmdline (bool): If True, include "cmdline" in the results.
+
+        Raises:
+            ValueError: If interval is negative or /proc is not available.
+        )doc")
+        .def(py::init([](double interval, bool io, bool cmdline) {
+                 if (interval < 0)
+                     throw py::value_error("ProcessSampler: interval must be >= 0");
+                 auto self = std::make_unique<PySampler>(
+                     PySampler{std::make_unique<ProcessSampler>(io, cmdline), cmdline});
+                 ProcessSampler* sampler = self->sampler.get();
+                 sampler_call("start", [&] {
+                     if (interval > 0)
+                         sampler->start(interval);
+                     else
+                         sampler->sample();
+                 });
+                 return self;
+             }),
+             py::arg("interval") = 0.0,
+             py::arg("io") = true,
+             py::arg("cmdline") = false)
+        .def("sample",
+             [](PySampler& self) {
+                 auto samples = sampler_call("sample", [&] { return self.sampler->sample(); });
+                 return sample_list(samples, self.cmdline);
+             },
+             R"doc(
+             Rates of every process since the previous sample.
+
+             Without a background thread, takes a snapshot now (the first one
+             is taken by the constructor). Returns a list of dicts with "pid",
+             "ppid", "command", "state", "uid", "threads", "cpu_percent",
+             "mem_kb", "mem_delta_kb", "read_bytes_per_sec",
+             "write_bytes_per_sec" and "new" (plus "cmdline"), in PID order.
+             )doc")
+        .def("top",
+             [](PySampler& self, int n, const std::string& by) {
+                 if (n < 0)
+                     throw py::value_error("ProcessSampler.top: n must be >= 0");
+                 SampleKey key;
+                 try {
+                     key = parse_sample_key(by);
+                 } catch (const std::invalid_argument& e) {
+                     throw py::value_error(std::string("ProcessSampler.top: ") + e.what());
+                 }
+                 auto samples = sampler_call("top", [&] {
+                     return self.sampler->top(static_cast<size_t>(n), key);
+                 });
+                 return sample_list(samples, self.cmdline);
+             },
+             R"doc(
+             The ``n`` processes with the highest value of ``by``.
+
+             ``by`` is "cpu", "mem", "mem_delta", "io" (read + write), "read"
+             or "write". Samples like sample() does.
+             )doc",
+             py::arg("n") = 10,
+             py::arg("by") = "cpu")
+        .def("start",
+             [](PySampler& self, double interval) {
+                 if (interval <= 0)
+                     throw py::value_error("ProcessSampler.start: interval must be > 0");
+                 sampler_call("start", [&] { self.sampler->start(interval); });
+             },
+             "Sample every ``interval`` seconds on a background thread.",
+             py::arg("interval"))
+        .def("stop",
+             [](PySampler& self) {
+                 py::gil_scoped_release release;
+                 self.sampler->stop();
+             },
+             "Stop the background thread (if any).")
+        .def_property_readonly("running",
+             [](const PySampler& self) { return self.sampler->running(); },
+             "True while the background thread samples.")
+        .def_property_readonly("interval",
+             [](const PySampler& self) { return self.sampler->last_interval(); },
+             "Seconds covered by the latest sample (0 before the second).")
+        .def("__enter__", [](PySampler& self) -> PySampler& { return self; },
+             py::return_value_policy::reference_internal)
+        .def("__exit__",
+             [](PySampler& self, py::args) {
+                 py::gil_scoped_release release;
+                 self.sampler->stop();
+             });
 
     // -- kill ---------------------------------------------------------------
-    m.def("kill", &kill_impl,
+    m.def("kill", counted("kill", &kill_impl),
         R"doc(
         Send a signal to a process.
 
@@ -271,28 +498,118 @@ void init_process(py::module_ &m) {
             ValueError: If the signal cannot be sent (e.g., no such process,
                         permission denied).
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("pid"),
         py::arg("signal") = 15);
 
+    // -- pgrep --------------------------------------------------------------
+    m.def("pgrep", counted("pgrep", &pgrep_impl),
+        R"doc(
+        Find processes by name.
+
+        Equivalent to the ``pgrep`` shell command. The calling process is
+        never included.
+
+        Args:
+            pattern (str): Pattern to look for.
+            match (str): How ``pattern`` is matched:
+                         "regex" (default) searches the process name
+                         (/proc/PID/comm) with a regular expression;
+                         "exact" requires the name to equal ``pattern``;
+                         "cmdline" searches the full command line,
+                         like ``pgrep -f``.
+
+        Returns:
+            list[int]: PIDs of the matching processes, in ascending order.
+
+        Raises:
+            ValueError: If ``match`` is unknown or the pattern is invalid.
+        )doc",
+        py::arg("pattern"),
+        py::arg("match") = "regex");
+
+    m.def("pgrep", counted("pgrep", &pgrep_many_impl),
+        R"doc(
+        Find processes for several patterns with a single pass over /proc.
+
+        Exact names are looked up in a hash index, so asking for dozens of
+        names costs about the same as asking for one.
+
+        Args:
+            patterns (list[str]): Patterns to look for.
+            match (str): "regex" (default), "exact" or "cmdline", as above.
+
+        Returns:
+            dict: Maps each pattern to the list of PIDs it matches.
+
+        Raises:
+            ValueError: If ``match`` is unknown or a pattern is invalid.
+        )doc",
+        py::arg("patterns"),
+        py::arg("match") = "regex");
+
     // -- killall ------------------------------------------------------------
-    m.def("killall", &killall_impl,
+    m.def("killall", counted("killall", &killall_impl),
         R"doc(
         Kill all processes matching a name.
 
         Equivalent to the ``killall`` shell command. Finds and sends a signal
-        to all processes matching the given name.
+        to all processes matching the given name. Signals are sent through a
+        pidfd after checking the process's start time, so a PID reused
+        since the scan is never signalled. The calling process is never
+        signalled.
 
         Args:
             name (str): Process name to match (exact match on /proc/PID/comm).
             signal (int): Signal number to send. Default is 15 (SIGTERM).
                           Equivalent to ``killall -SIGNAL name``.
+            match (str): "exact" (default), "regex" or "cmdline"; see
+                         ``pgrep``.
+            wait (bool): Wait for the signalled processes to exit.
+                         Equivalent to ``killall -w``.
+            timeout (float): Seconds to wait at most. Default is 5.
 
         Returns:
-            dict: Keys "killed" (int), "failed" (int), "name", "signal".
+            dict: Keys "killed" (int), "failed" (int), "name", "signal",
+                  "pids" (list of signalled PIDs) and, when waiting,
+                  "exited" and "remaining" (lists of PIDs).
 
         Raises:
-            ValueError: If no process with the given name is found.
+            ValueError: If no process with the given name is found, or
+                        ``match`` or ``timeout`` is invalid.
         )doc",
         py::arg("name"),
-        py::arg("signal") = 15);
+        py::arg("signal") = 15,
+        py::arg("match") = "exact",
+        py::arg("wait") = false,
+        py::arg("timeout") = 5.0);
+
+    m.def("killall", counted("killall", &killall_many_impl),
+        R"doc(
+        Kill all processes matching any of several names.
+
+        The names are matched with a single pass over /proc, and a process
+        matching more than one name is signalled once.
+
+        Args:
+            names (list[str]): Process names (or patterns) to match.
+            signal (int): Signal number to send. Default is 15 (SIGTERM).
+            match (str): "exact" (default), "regex" or "cmdline".
+            wait (bool): Wait for the signalled processes to exit.
+            timeout (float): Seconds to wait at most. Default is 5.
+
+        Returns:
+            dict: Keys "killed", "failed", "signal" and "pids" as above,
+                  "names" (maps each name to the PIDs it matched) and, when
+                  waiting, "exited" and "remaining".
+
+        Raises:
+            ValueError: If no process matches any of the names, or
+                        ``match`` or ``timeout`` is invalid.
+        )doc",
+        py::arg("names"),
+        py::arg("signal") = 15,
+        py::arg("match") = "exact",
+        py::arg("wait") = false,
+        py::arg("timeout") = 5.0);
 }
@@ -0,0 +1,269 @@
+#include "command_index.h"
+
+#include <cstring>
+#include <unordered_set>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const kManDirs[] = {"/usr/share/man", "/usr/local/share/man", "/usr/man"};
+const char* const kSourceDirs[] = {"/usr/src", "/usr/local/src"};
+
+bool is_dot(const char* name) {
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+// Calls `fn(name, real_dir, is_dir, is_file)` for each entry of the open
+// directory `dir_fd`. is_dir and is_file follow symlinks; real_dir is a
+// directory that is not a symlink. Broken symlinks are skipped. Takes
+// ownership of `dir_fd`.
+template <typename Fn>
+void list_dir(int dir_fd, Fn&& fn) {
+    DIR* dir = fdopendir(dir_fd);
+    if (!dir) {
+        close(dir_fd);
+        return;
+    }
+    while (struct dirent* e = readdir(dir)) {
+        if (is_dot(e->d_name))
+            continue;
+        bool is_dir = e->d_type == DT_DIR;
+        bool is_file = e->d_type == DT_REG;
+        bool followed = false;
+        if (e->d_type == DT_LNK || e->d_type == DT_UNKNOWN) {
+            struct stat st;
+            if (fstatat(dirfd(dir), e->d_name, &st, 0) != 0)
+                continue;           // broken symlink
+            is_dir = S_ISDIR(st.st_mode);
+            is_file = S_ISREG(st.st_mode);
+            followed = e->d_type == DT_LNK;
+        }
+        fn(e->d_name, is_dir && !followed, is_dir, is_file);
+    }
+    closedir(dir);
+}
+
+// "ls.1.gz" -> "ls", "systemd.unit.5" -> "systemd.unit"; empty if the
+// name has no section suffix.
+std::string man_page_name(std::string name) {
+    static const char* const compressed[] = {".gz", ".bz2", ".xz", ".zst", ".lzma", ".Z"};
+    for (const char* ext : compressed) {
+        size_t len = std::strlen(ext);
+        if (name.size() > len && name.compare(name.size() - len, len, ext) == 0) {
+            name.resize(name.size() - len);
+            break;
+        }
+    }
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos || dot == 0 || dot + 1 == name.size())
+        return "";
+    char section = name[dot + 1];
+    if (!(section >= '0' && section <= '9') && section != 'n')
+        return "";
+    name.resize(dot);
+    return name;
+}
+
+bool is_executable_file(const std::string& path) {
+    if (access(path.c_str(), X_OK) != 0)
+        return false;
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && !S_ISDIR(st.st_mode);
+}
+
+}  // namespace
+
+std::vector<std::string> split_path(const std::string& path) {
+    std::vector<std::string> dirs;
+    std::unordered_set<std::string> seen;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find(':', start);
+        if (end == std::string::npos)
+            end = path.size();
+        std::string dir = path.substr(start, end - start);
+        if (!dir.empty() && seen.insert(dir).second)
+            dirs.push_back(std::move(dir));
+        start = end + 1;
+    }
+    return dirs;
+}
+
+std::string which_command(const std::string& command, const std::string& path) {
+    if (command.empty())
+        return "";
+    if (command.find('/') != std::string::npos)
+        return is_executable_file(command) ? command : "";
+    for (const auto& dir : split_path(path)) {
+        std::string candidate = dir + "/" + command;
+        if (is_executable_file(candidate))
+            return candidate;
+    }
+    return "";
+}
+
+// ---------------------------------------------------------------------------
+// CommandIndex
+// ---------------------------------------------------------------------------
+
+CommandIndex::DirStamp CommandIndex::stamp(const std::string& dir) {
+    DirStamp s;
+    s.path = dir;
+    struct stat st;
+    if (stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        s.exists = true;
+        s.dev = st.st_dev;
+        s.ino = st.st_ino;
+        s.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    }
+    return s;
+}
+
+bool CommandIndex::fresh(const Part& part) {
+    if (!part.built)
+        return false;
+    for (const auto& before : part.dirs) {
+        DirStamp now = stamp(before.path);
+        if (now.exists != before.exists || now.dev != before.dev || now.ino != before.ino ||
+            now.mtime_ns != before.mtime_ns)
+            return false;
+    }
+    return true;
+}
+
+void CommandIndex::refresh_binaries(const std::string& path) {
+    if (path == bin_path_ && fresh(bin_part_))
+        return;
+    bin_part_ = Part();
+    bin_path_ = path;
+    bin_dirs_ = split_path(path);
+    bins_.clear();
+    for (uint32_t i = 0; i < bin_dirs_.size(); ++i) {
+        const std::string& dir = bin_dirs_[i];
+        bin_part_.dirs.push_back(stamp(dir));      // before listing: a change during it
+        if (!bin_part_.dirs.back().exists)         // makes the next call rebuild
+            continue;
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        list_dir(fd, [&](const char* name, bool, bool is_dir, bool) {
+            if (!is_dir)
+                bins_[name].push_back(i);
+        });
+    }
+    bin_part_.built = true;
+}
+
+void CommandIndex::refresh_man_pages() {
+    if (fresh(man_part_))
+        return;
+    man_part_ = Part();
+    man_pages_.clear();
+
+    // Symlinked directories are not descended into, as with
+    // recursive_directory_iterator.
+    struct Walker {
+        CommandIndex& index;
+        void walk(const std::string& dir) {
+            index.man_part_.dirs.push_back(stamp(dir));
+            if (!index.man_part_.dirs.back().exists)
+                return;
+            int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd < 0)
+                return;
+            std::vector<std::string> subdirs;
+            list_dir(fd, [&](const char* name, bool real_dir, bool, bool is_file) {
+                if (real_dir) {
+                    subdirs.push_back(dir + "/" + name);
+                } else if (is_file) {
+                    std::string page = man_page_name(name);
+                    if (!page.empty())
+                        index.man_pages_[page].push_back(dir + "/" + name);
+                }
+            });
+            for (const auto& sub : subdirs)
+                walk(sub);
+        }
+    } walker{*this};
+    for (const char* dir : kManDirs)
+        walker.walk(dir);
+    man_part_.built = true;
+}
+
+void CommandIndex::refresh_sources() {
+    if (fresh(src_part_))
+        return;
+    src_part_ = Part();
+    sources_.clear();
+    for (const char* dir : kSourceDirs) {
+        src_part_.dirs.push_back(stamp(dir));
+        if (!src_part_.dirs.back().exists)
+            continue;
+        int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        std::string base = dir;
+        list_dir(fd, [&](const char* name, bool, bool, bool) {
+            sources_.push_back(base + "/" + name);
+        });
+    }
+    src_part_.built = true;
+}
+
+WhereisResult CommandIndex::whereis(const std::string& command, const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_binaries(path);
+    refresh_man_pages();
+    refresh_sources();
+
+    WhereisResult found;
+    auto bin = bins_.find(command);
+    if (bin != bins_.end())
+        for (uint32_t i : bin->second)
+            found.binaries.push_back(bin_dirs_[i] + "/" + command);
+    auto man = man_pages_.find(command);
+    if (man != man_pages_.end())
+        found.man_pages = man->second;
+    for (const auto& src : sources_)
+        if (src.find(command, src.rfind('/') + 1) != std::string::npos)
+            found.sources.push_back(src);
+    return found;
+}
+
+std::vector<std::string> CommandIndex::which(const std::vector<std::string>& commands,
+                                             const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_binaries(path);
+
+    // The index has every non-directory entry; executability is checked
+    // per lookup, so a chmod (which leaves the directory mtime alone) is
+    // still seen.
+    std::vector<std::string> found(commands.size());
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const std::string& command = commands[i];
+        if (command.find('/') != std::string::npos) {
+            found[i] = which_command(command, path);
+            continue;
+        }
+        auto bin = bins_.find(command);
+        if (bin == bins_.end())
+            continue;
+        for (uint32_t d : bin->second) {
+            std::string candidate = bin_dirs_[d] + "/" + command;
+            if (is_executable_file(candidate)) {
+                found[i] = std::move(candidate);
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+CommandIndex& command_index() {
+    static CommandIndex index;
+    return index;
+}
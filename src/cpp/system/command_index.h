@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Command index behind whereis and which_many
+//
+// Lists every PATH directory, the man page trees and the source directories
+// once, and keeps name -> location tables so a lookup is a hash probe. Each
+// part of the index remembers the mtime (and inode) of every directory it
+// read; a lookup first stats those directories and rebuilds only the parts
+// where one changed, so a binary installed or a PATH change is seen by the
+// next call. The man part covers many directories (one per section and
+// locale) but is still a stat each, against a full recursive listing.
+// ---------------------------------------------------------------------------
+
+struct WhereisResult {
+    std::vector<std::string> binaries;
+    std::vector<std::string> man_pages;
+    std::vector<std::string> sources;
+};
+
+// PATH split on ':', empty entries and duplicates dropped.
+std::vector<std::string> split_path(const std::string& path);
+
+// First PATH entry holding an executable, non-directory `command`, by
+// access(X_OK) on each candidate; a name containing '/' is checked as is.
+// Empty if not found.
+std::string which_command(const std::string& command, const std::string& path);
+
+class CommandIndex {
+public:
+    // What whereis reports: non-directory PATH entries named `command` (PATH
+    // order), man pages named `command` ("command.<section>[.gz]", any
+    // section or locale) and source directory entries containing `command`.
+    WhereisResult whereis(const std::string& command, const std::string& path);
+
+    // which_command() for each command, answered from the index.
+    std::vector<std::string> which(const std::vector<std::string>& commands,
+                                   const std::string& path);
+
+private:
+    struct DirStamp {
+        std::string path;
+        bool exists = false;
+        uint64_t dev = 0, ino = 0;
+        int64_t mtime_ns = 0;
+    };
+
+    // One independently rebuilt part of the index.
+    struct Part {
+        bool built = false;
+        std::vector<DirStamp> dirs;     // every directory that was listed
+    };
+
+    static DirStamp stamp(const std::string& dir);
+    static bool fresh(const Part& part);
+
+    void refresh_binaries(const std::string& path);
+    void refresh_man_pages();
+    void refresh_sources();
+
+    std::mutex mutex_;
+
+    Part bin_part_;
+    std::string bin_path_;                                          // PATH it was built for
+    std::vector<std::string> bin_dirs_;
+    std::unordered_map<std::string, std::vector<uint32_t>> bins_;  // name -> bin_dirs_ indices
+
+    Part man_part_;
+    std::unordered_map<std::string, std::vector<std::string>> man_pages_;
+
+    Part src_part_;
+    std::vector<std::string> sources_;                              // full paths
+};
+
+// The index shared by every whereis()/which_many() call.
+CommandIndex& command_index();
@@ -0,0 +1,314 @@
+#include "sysstat.h"
+
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Compile-time perfect hash over a fixed key set
+// ---------------------------------------------------------------------------
+
+constexpr uint32_t key_hash(std::string_view key, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;        // FNV-1a
+    for (char c : key) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    h ^= h >> 16;                           // the low bits of FNV barely
+    h *= 0x85ebca6bu;                       // depend on the seed; mix them
+    h ^= h >> 13;
+    return h;
+}
+
+// Maps each of N keys to a distinct slot of a Size-entry table. The seed
+// that makes the mapping collision-free is searched for by the constexpr
+// constructor, i.e. by the compiler.
+template <size_t N, size_t Size>
+class PerfectHash {
+    static_assert((Size & (Size - 1)) == 0, "Size must be a power of two");
+
+public:
+    constexpr explicit PerfectHash(const std::array<std::string_view, N>& keys)
+        : keys_(keys), slots_() {
+        for (uint32_t seed = 1;; ++seed) {
+            for (auto& s : slots_)
+                s = -1;
+            bool ok = true;
+            for (size_t i = 0; i < N && ok; ++i) {
+                auto& s = slots_[key_hash(keys[i], seed) & (Size - 1)];
+                if (s >= 0)
+                    ok = false;
+                else
+                    s = static_cast<int>(i);
+            }
+            if (ok) {
+                seed_ = seed;
+                break;
+            }
+        }
+    }
+
+    // Index of `key` in the key set, or -1.
+    int find(std::string_view key) const {
+        int i = slots_[key_hash(key, seed_) & (Size - 1)];
+        return i >= 0 && keys_[i] == key ? i : -1;
+    }
+
+private:
+    std::array<std::string_view, N> keys_;
+    std::array<int, Size> slots_;
+    uint32_t seed_ = 0;
+};
+
+constexpr PerfectHash<11, 32> kMeminfoKeys(std::array<std::string_view, 11>{{
+    "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached", "Shmem", "SReclaimable",
+    "Dirty", "Writeback", "SwapTotal", "SwapFree",
+}});
+constexpr uint64_t SysSnapshot::* kMeminfoFields[] = {
+    &SysSnapshot::mem_total, &SysSnapshot::mem_free, &SysSnapshot::mem_available,
+    &SysSnapshot::buffers, &SysSnapshot::cached, &SysSnapshot::shmem,
+    &SysSnapshot::sreclaimable, &SysSnapshot::dirty, &SysSnapshot::writeback,
+    &SysSnapshot::swap_total, &SysSnapshot::swap_free,
+};
+
+constexpr PerfectHash<4, 8> kStatKeys(std::array<std::string_view, 4>{{
+    "ctxt", "processes", "procs_running", "procs_blocked",
+}});
+constexpr uint64_t SysSnapshot::* kStatFields[] = {
+    &SysSnapshot::ctxt, &SysSnapshot::forks, &SysSnapshot::procs_running,
+    &SysSnapshot::procs_blocked,
+};
+
+constexpr PerfectHash<5, 16> kVmstatKeys(std::array<std::string_view, 5>{{
+    "pgfault", "pgmajfault", "pswpin", "pswpout", "oom_kill",
+}});
+constexpr uint64_t SysSnapshot::* kVmstatFields[] = {
+    &SysSnapshot::pgfault, &SysSnapshot::pgmajfault, &SysSnapshot::pswpin,
+    &SysSnapshot::pswpout, &SysSnapshot::oom_kill,
+};
+
+constexpr const char* kPaths[] = {
+    "/proc/meminfo", "/proc/stat", "/proc/loadavg", "/proc/uptime", "/proc/vmstat",
+    "/proc/pressure/cpu", "/proc/pressure/memory", "/proc/pressure/io",
+};
+
+// ---------------------------------------------------------------------------
+// Parsing
+// ---------------------------------------------------------------------------
+
+uint64_t parse_u64(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+        v = v * 10 + static_cast<uint64_t>(*p++ - '0');
+    return v;
+}
+
+// Calls `fn(key, rest_of_line_begin, line_end)` for every line, the key
+// being the text up to the first ' ' or ':'.
+template <typename Fn>
+void for_each_line(std::string_view text, Fn&& fn) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!eol)
+            eol = end;
+        const char* k = p;
+        while (k < eol && *k != ' ' && *k != ':')
+            ++k;
+        const char* rest = k < eol && *k == ':' ? k + 1 : k;
+        fn(std::string_view(p, static_cast<size_t>(k - p)), rest, eol);
+        p = eol + 1;
+    }
+}
+
+template <size_t N, size_t Size, size_t F>
+void parse_keyed(std::string_view text, const PerfectHash<N, Size>& keys,
+                 uint64_t SysSnapshot::* const (&fields)[F], SysSnapshot& out) {
+    static_assert(N == F, "one field per key");
+    for_each_line(text, [&](std::string_view key, const char* rest, const char* eol) {
+        int i = keys.find(key);
+        if (i >= 0)
+            out.*fields[i] = parse_u64(rest, eol);
+    });
+}
+
+void parse_stat(std::string_view text, SysSnapshot& out) {
+    for_each_line(text, [&](std::string_view key, const char* rest, const char* eol) {
+        if (key == "cpu") {
+            CpuTimes& c = out.cpu;
+            for (uint64_t* f : {&c.user, &c.nice, &c.system, &c.idle, &c.iowait, &c.irq,
+                                &c.softirq, &c.steal})
+                *f = parse_u64(rest, eol);
+            return;
+        }
+        int i = kStatKeys.find(key);
+        if (i >= 0)
+            out.*kStatFields[i] = parse_u64(rest, eol);
+    });
+}
+
+// "some avg10=0.00 avg60=0.00 avg300=0.00 total=0" and a "full" line.
+void parse_pressure(std::string_view text, Pressure& out) {
+    out.available = true;
+    for_each_line(text, [&](std::string_view key, const char* rest, const char* eol) {
+        bool some = key == "some";
+        if (!some && key != "full")
+            return;
+        double* avgs[3] = {some ? &out.some_avg10 : &out.full_avg10,
+                           some ? &out.some_avg60 : &out.full_avg60,
+                           some ? &out.some_avg300 : &out.full_avg300};
+        int n = 0;
+        for (const char* p = rest; p < eol; ++p) {
+            if (*p != '=')
+                continue;
+            if (n < 3) {
+                *avgs[n++] = std::strtod(p + 1, nullptr);
+            } else {
+                const char* q = p + 1;
+                (some ? out.some_total_us : out.full_total_us) = parse_u64(q, eol);
+            }
+        }
+    });
+}
+
+double monotonic_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec) + ts.tv_nsec / 1e9;
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// SysStatReader
+// ---------------------------------------------------------------------------
+
+SysStatReader::~SysStatReader() {
+    for (int fd : fds_)
+        if (fd >= 0)
+            close(fd);
+}
+
+bool SysStatReader::load(Source source, std::string_view& out) {
+    int& fd = fds_[source];
+    if (fd < 0) {
+        if (missing_[source])
+            return false;
+        fd = open(kPaths[source], O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            missing_[source] = true;
+            return false;
+        }
+    }
+    std::vector<char>& buf = bufs_[source];
+    if (buf.empty())
+        buf.resize(4096);
+    for (;;) {
+        ssize_t n = pread(fd, buf.data(), buf.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (static_cast<size_t>(n) < buf.size()) {
+            buf[static_cast<size_t>(n)] = '\0';      // for strtod()
+            out = std::string_view(buf.data(), static_cast<size_t>(n));
+            return true;
+        }
+        buf.resize(buf.size() * 2);     // might not have been the whole file
+    }
+}
+
+SysSnapshot SysStatReader::read(bool delta) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SysSnapshot snap;
+    std::string_view text;
+
+    if (!load(kMeminfo, text))
+        throw std::runtime_error("cannot read /proc/meminfo");
+    parse_keyed(text, kMeminfoKeys, kMeminfoFields, snap);
+    if (!load(kStat, text))
+        throw std::runtime_error("cannot read /proc/stat");
+    parse_stat(text, snap);
+    if (load(kVmstat, text))
+        parse_keyed(text, kVmstatKeys, kVmstatFields, snap);
+
+    if (load(kLoadavg, text)) {
+        // "0.05 0.10 0.15 2/345 6789"
+        const char* p = text.data();
+        char* next = nullptr;
+        snap.load_1 = std::strtod(p, &next);
+        snap.load_5 = std::strtod(next, &next);
+        snap.load_15 = std::strtod(next, &next);
+        const char* slash = static_cast<const char*>(std::memchr(next, '/', static_cast<size_t>(text.data() + text.size() - next)));
+        if (slash) {
+            const char* q = slash + 1;
+            snap.threads_total = parse_u64(q, text.data() + text.size());
+        }
+    }
+    if (load(kUptime, text))
+        snap.uptime = std::strtod(text.data(), nullptr);
+
+    if (load(kPsiCpu, text))
+        parse_pressure(text, snap.psi_cpu);
+    if (load(kPsiMemory, text))
+        parse_pressure(text, snap.psi_memory);
+    if (load(kPsiIo, text))
+        parse_pressure(text, snap.psi_io);
+
+    if (!delta)
+        return snap;
+
+    // The first delta read compares against boot.
+    snap.interval = monotonic_seconds();
+    SysSnapshot base;
+    double dt = snap.uptime;
+    if (have_previous_) {
+        base = previous_;
+        dt = snap.interval - previous_.interval;
+    }
+    previous_ = snap;           // `interval` holds the monotonic time here
+    have_previous_ = true;
+
+    snap.has_delta = true;
+    snap.interval = dt;
+    auto diff = [](uint64_t now, uint64_t before) {
+        return static_cast<double>(now >= before ? now - before : 0);
+    };
+    const CpuTimes& a = snap.cpu;
+    const CpuTimes& b = base.cpu;
+    double total = diff(a.total(), b.total());
+    if (total > 0) {
+        double idle = diff(a.idle, b.idle) + diff(a.iowait, b.iowait);
+        snap.cpu_busy_percent = (total - idle) / total * 100.0;
+        snap.cpu_user_percent = (diff(a.user, b.user) + diff(a.nice, b.nice)) / total * 100.0;
+        snap.cpu_system_percent = (diff(a.system, b.system) + diff(a.irq, b.irq) +
+                                   diff(a.softirq, b.softirq)) / total * 100.0;
+        snap.cpu_iowait_percent = diff(a.iowait, b.iowait) / total * 100.0;
+        snap.cpu_steal_percent = diff(a.steal, b.steal) / total * 100.0;
+        snap.cpu_idle_percent = diff(a.idle, b.idle) / total * 100.0;
+    }
+    if (dt > 0) {
+        snap.ctxt_per_sec = diff(snap.ctxt, base.ctxt) / dt;
+        snap.forks_per_sec = diff(snap.forks, base.forks) / dt;
+        snap.pgfault_per_sec = diff(snap.pgfault, base.pgfault) / dt;
+        snap.pgmajfault_per_sec = diff(snap.pgmajfault, base.pgmajfault) / dt;
+    }
+    return snap;
+}
+
+SysStatReader& sysstat_reader() {
+    static SysStatReader reader;
+    return reader;
+}
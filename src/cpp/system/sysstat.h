@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// System metrics snapshot behind sysstat
+//
+// Reads /proc/meminfo, /proc/stat, /proc/loadavg, /proc/uptime,
+// /proc/vmstat and /proc/pressure/{cpu,memory,io} through descriptors kept
+// open across calls. Each file is re-read with one pread() at offset 0
+// into a buffer that is reused, so a snapshot costs one syscall per file
+// and no allocation once the buffers have grown to size. The "key value" files
+// are parsed against key tables whose perfect hash is found at compile
+// time, so only the wanted lines are converted and each costs one lookup.
+// ---------------------------------------------------------------------------
+
+struct Pressure {
+    bool available = false;     // /proc/pressure missing without CONFIG_PSI
+    double some_avg10 = 0, some_avg60 = 0, some_avg300 = 0;
+    double full_avg10 = 0, full_avg60 = 0, full_avg300 = 0;
+    uint64_t some_total_us = 0, full_total_us = 0;
+};
+
+struct CpuTimes {               // clock ticks, the "cpu" line of /proc/stat
+    uint64_t user = 0, nice = 0, system = 0, idle = 0, iowait = 0;
+    uint64_t irq = 0, softirq = 0, steal = 0;
+
+    uint64_t total() const {
+        return user + nice + system + idle + iowait + irq + softirq + steal;
+    }
+};
+
+struct SysSnapshot {
+    double uptime = 0;          // seconds
+    double load_1 = 0, load_5 = 0, load_15 = 0;
+    uint64_t threads_total = 0; // schedulable entities, from loadavg
+
+    // /proc/meminfo, kB
+    uint64_t mem_total = 0, mem_free = 0, mem_available = 0;
+    uint64_t buffers = 0, cached = 0, shmem = 0, sreclaimable = 0;
+    uint64_t dirty = 0, writeback = 0;
+    uint64_t swap_total = 0, swap_free = 0;
+
+    // /proc/stat
+    CpuTimes cpu;
+    uint64_t ctxt = 0, forks = 0, procs_running = 0, procs_blocked = 0;
+
+    // /proc/vmstat
+    uint64_t pgfault = 0, pgmajfault = 0, pswpin = 0, pswpout = 0, oom_kill = 0;
+
+    Pressure psi_cpu, psi_memory, psi_io;
+
+    // Filled by SysStatReader::read(delta=true): changes since the previous
+    // delta read (since boot for the first one).
+    bool has_delta = false;
+    double interval = 0;        // seconds
+    double cpu_busy_percent = 0, cpu_user_percent = 0, cpu_system_percent = 0;
+    double cpu_iowait_percent = 0, cpu_steal_percent = 0, cpu_idle_percent = 0;
+    double ctxt_per_sec = 0, forks_per_sec = 0;
+    double pgfault_per_sec = 0, pgmajfault_per_sec = 0;
+};
+
+class SysStatReader {
+public:
+    SysStatReader() = default;
+    ~SysStatReader();
+
+    SysStatReader(const SysStatReader&) = delete;
+    SysStatReader& operator=(const SysStatReader&) = delete;
+
+    // A fresh snapshot. With `delta`, also fills the delta fields relative
+    // to the previous delta read. Throws std::runtime_error if meminfo or
+    // stat cannot be read.
+    SysSnapshot read(bool delta);
+
+private:
+    enum Source { kMeminfo, kStat, kLoadavg, kUptime, kVmstat, kPsiCpu, kPsiMemory, kPsiIo,
+                  kSourceCount };
+
+    // Re-reads `source`; false if it cannot be read.
+    bool load(Source source, std::string_view& out);
+
+    std::mutex mutex_;
+    int fds_[kSourceCount] = {-1, -1, -1, -1, -1, -1, -1, -1};
+    bool missing_[kSourceCount] = {};     // open failed once; don't retry
+    std::vector<char> bufs_[kSourceCount];
+
+    bool have_previous_ = false;
+    SysSnapshot previous_;
+};
+
+// The reader shared by every sysstat() call, so deltas span calls.
+SysStatReader& sysstat_reader();
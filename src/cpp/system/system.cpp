@@ -1,18 +1,18 @@
 #include "system.h"
+#include "system/command_index.h"
+#include "system/sysstat.h"
+#include "common/stats.h"
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
 #include <string>
 #include <vector>
-#include <map>
 #include <sstream>
-#include <fstream>
 #include <ctime>
 #include <chrono>
 #include <thread>
 #include <cstdlib>
 #include <cstring>
-#include <filesystem>
 
 #include <sys/utsname.h>
 #include <sys/sysinfo.h>
@@ -21,7 +21,6 @@
 #include <grp.h>
 
 namespace py = pybind11;
-namespace fs = std::filesystem;
 
 // ---------------------------------------------------------------------------
 // uname — System information
@@ -333,24 +332,19 @@ static py::list groups_impl(const std::string& username) {
 // free — Memory usage
 // ---------------------------------------------------------------------------
 
-static py::dict free_impl(bool human_readable) {
-    std::ifstream ifs("/proc/meminfo");
-    if (!ifs.is_open())
-        throw py::value_error("free: cannot read /proc/meminfo");
-
-    std::map<std::string, long> mem;
-    std::string line;
-    while (std::getline(ifs, line)) {
-        std::istringstream iss(line);
-        std::string key;
-        long value;
-        std::string unit;
-        iss >> key >> value >> unit;
-        key.pop_back(); // Remove ':'
-        mem[key] = value; // in kB
+static SysSnapshot read_snapshot(const char* cmd, bool delta) {
+    py::gil_scoped_release release;
+    try {
+        return sysstat_reader().read(delta);
+    } catch (const std::runtime_error& e) {
+        throw py::value_error(std::string(cmd) + ": " + e.what());
     }
+}
 
-    auto format_kb = [&](long kb) -> py::object {
+static py::dict free_impl(bool human_readable) {
+    SysSnapshot mem = read_snapshot("free", false);
+
+    auto format_kb = [&](uint64_t kb) -> py::object {
         if (human_readable) {
             double val = kb;
             const char* units[] = {"K", "M", "G", "T"};
@@ -367,78 +361,152 @@ static py::dict free_impl(bool human_readable) {
 
     // RAM
     py::dict ram;
-    ram["total"]     = format_kb(mem["MemTotal"]);
-    ram["used"]      = format_kb(mem["MemTotal"] - mem["MemAvailable"]);
-    ram["free"]      = format_kb(mem["MemFree"]);
-    ram["available"] = format_kb(mem["MemAvailable"]);
-    ram["buffers"]   = format_kb(mem["Buffers"]);
-    ram["cached"]    = format_kb(mem["Cached"]);
+    ram["total"]     = format_kb(mem.mem_total);
+    ram["used"]      = format_kb(mem.mem_total - mem.mem_available);
+    ram["free"]      = format_kb(mem.mem_free);
+    ram["available"] = format_kb(mem.mem_available);
+    ram["buffers"]   = format_kb(mem.buffers);
+    ram["cached"]    = format_kb(mem.cached);
     result["ram"] = ram;
 
     // Swap
     py::dict swap;
-    swap["total"] = format_kb(mem["SwapTotal"]);
-    swap["used"]  = format_kb(mem["SwapTotal"] - mem["SwapFree"]);
-    swap["free"]  = format_kb(mem["SwapFree"]);
+    swap["total"] = format_kb(mem.swap_total);
+    swap["used"]  = format_kb(mem.swap_total - mem.swap_free);
+    swap["free"]  = format_kb(mem.swap_free);
     result["swap"] = swap;
 
     return result;
 }
 
+// ---------------------------------------------------------------------------
+// sysstat — Memory, CPU, load and pressure in one snapshot
+// ---------------------------------------------------------------------------
+
+static SysSnapshot sysstat_impl(bool delta) {
+    return read_snapshot("sysstat", delta);
+}
+
+static py::object pressure_dict(const Pressure& p) {
+    if (!p.available)
+        return py::none();
+    py::dict d;
+    d["some_avg10"]    = p.some_avg10;
+    d["some_avg60"]    = p.some_avg60;
+    d["some_avg300"]   = p.some_avg300;
+    d["some_total_us"] = p.some_total_us;
+    d["full_avg10"]    = p.full_avg10;
+    d["full_avg60"]    = p.full_avg60;
+    d["full_avg300"]   = p.full_avg300;
+    d["full_total_us"] = p.full_total_us;
+    return d;
+}
+
+static py::object delta_value(const SysSnapshot& s, double value) {
+    return s.has_delta ? py::cast(value) : py::none();
+}
+
+static py::dict sysstat_dict(const SysSnapshot& s) {
+    py::dict d;
+    d["uptime"]        = s.uptime;
+    d["load_1"]        = s.load_1;
+    d["load_5"]        = s.load_5;
+    d["load_15"]       = s.load_15;
+    d["threads_total"] = s.threads_total;
+    d["mem_total"]     = s.mem_total;
+    d["mem_free"]      = s.mem_free;
+    d["mem_available"] = s.mem_available;
+    d["mem_used"]      = s.mem_total - s.mem_available;
+    d["buffers"]       = s.buffers;
+    d["cached"]        = s.cached;
+    d["shmem"]         = s.shmem;
+    d["sreclaimable"]  = s.sreclaimable;
+    d["dirty"]         = s.dirty;
+    d["writeback"]     = s.writeback;
+    d["swap_total"]    = s.swap_total;
+    d["swap_free"]     = s.swap_free;
+    d["ctxt"]          = s.ctxt;
+    d["forks"]         = s.forks;
+    d["procs_running"] = s.procs_running;
+    d["procs_blocked"] = s.procs_blocked;
+    d["pgfault"]       = s.pgfault;
+    d["pgmajfault"]    = s.pgmajfault;
+    d["pswpin"]        = s.pswpin;
+    d["pswpout"]       = s.pswpout;
+    d["oom_kill"]      = s.oom_kill;
+    d["psi_cpu"]       = pressure_dict(s.psi_cpu);
+    d["psi_memory"]    = pressure_dict(s.psi_memory);
+    d["psi_io"]        = pressure_dict(s.psi_io);
+    if (s.has_delta) {
+        d["interval"]           = s.interval;
+        d["cpu_busy_percent"]   = s.cpu_busy_percent;
+        d["cpu_user_percent"]   = s.cpu_user_percent;
+        d["cpu_system_percent"] = s.cpu_system_percent;
+        d["cpu_iowait_percent"] = s.cpu_iowait_percent;
+        d["cpu_steal_percent"]  = s.cpu_steal_percent;
+        d["cpu_idle_percent"]   = s.cpu_idle_percent;
+        d["ctxt_per_sec"]       = s.ctxt_per_sec;
+        d["forks_per_sec"]      = s.forks_per_sec;
+        d["pgfault_per_sec"]    = s.pgfault_per_sec;
+        d["pgmajfault_per_sec"] = s.pgmajfault_per_sec;
+    }
+    return d;
+}
+
 // ---------------------------------------------------------------------------
 // whereis — Locate binary, source, and man pages
 // ---------------------------------------------------------------------------
 
+// Read while holding the GIL: os.environ and export_env write environ
+// under it.
+static std::string path_env() {
+    const char* path = std::getenv("PATH");
+    return path ? path : "";
+}
+
 static py::dict whereis_impl(const std::string& command) {
-    py::dict result;
-    result["command"] = command;
-
-    // Search PATH for binary
-    py::list binaries;
-    const char* path_env = std::getenv("PATH");
-    if (path_env) {
-        std::istringstream iss(path_env);
-        std::string dir;
-        while (std::getline(iss, dir, ':')) {
-            fs::path candidate = fs::path(dir) / command;
-            if (fs::exists(candidate) && !fs::is_directory(candidate))
-                binaries.append(candidate.string());
-        }
+    WhereisResult found;
+    std::string path = path_env();
+    {
+        py::gil_scoped_release release;
+        found = command_index().whereis(command, path);
     }
-    result["binaries"] = binaries;
 
-    // Search common man page locations
-    py::list man_pages;
-    std::vector<std::string> man_dirs = {
-        "/usr/share/man", "/usr/local/share/man", "/usr/man"
-    };
-    for (const auto& mdir : man_dirs) {
-        if (!fs::exists(mdir)) continue;
-        for (auto& entry : fs::recursive_directory_iterator(
-                 mdir, fs::directory_options::skip_permission_denied)) {
-            if (entry.is_regular_file()) {
-                std::string fname = entry.path().filename().string();
-                if (fname.find(command) == 0)
-                    man_pages.append(entry.path().string());
-            }
-        }
-    }
-    result["man_pages"] = man_pages;
-
-    // Search common source locations
-    py::list sources;
-    std::vector<std::string> src_dirs = {"/usr/src", "/usr/local/src"};
-    for (const auto& sdir : src_dirs) {
-        if (!fs::exists(sdir)) continue;
-        for (auto& entry : fs::directory_iterator(
-                 sdir, fs::directory_options::skip_permission_denied)) {
-            std::string fname = entry.path().filename().string();
-            if (fname.find(command) != std::string::npos)
-                sources.append(entry.path().string());
-        }
+    py::dict result;
+    result["command"]   = command;
+    result["binaries"]  = found.binaries;
+    result["man_pages"] = found.man_pages;
+    result["sources"]   = found.sources;
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// which — Locate a command in PATH
+// ---------------------------------------------------------------------------
+
+static py::object which_impl(const std::string& command) {
+    std::string found;
+    std::string path = path_env();
+    {
+        py::gil_scoped_release release;
+        found = which_command(command, path);
     }
-    result["sources"] = sources;
+    if (found.empty())
+        return py::none();
+    return py::str(found);
+}
 
+static py::dict which_many_impl(const std::vector<std::string>& commands) {
+    std::vector<std::string> found;
+    std::string path = path_env();
+    {
+        py::gil_scoped_release release;
+        found = command_index().which(commands, path);
+    }
+    py::dict result;
+    for (size_t i = 0; i < commands.size(); ++i)
+        result[py::str(commands[i])] = found[i].empty() ? py::object(py::none())
+                                                        : py::object(py::str(found[i]));
     return result;
 }
 
@@ -449,7 +517,7 @@ static py::dict whereis_impl(const std::string& command) {
 void init_system(py::module_ &m) {
 
     // -- uname --------------------------------------------------------------
-    m.def("uname", &uname_impl,
+    m.def("uname", counted("uname", &uname_impl),
         R"doc(
         Return system information.
 
@@ -470,7 +538,7 @@ void init_system(py::module_ &m) {
         py::arg("all") = false);
 
     // -- whoami -------------------------------------------------------------
-    m.def("whoami", &whoami_impl,
+    m.def("whoami", counted("whoami", &whoami_impl),
         R"doc(
         Return the current username.
 
@@ -482,7 +550,7 @@ void init_system(py::module_ &m) {
         )doc");
 
     // -- uptime -------------------------------------------------------------
-    m.def("uptime", &uptime_impl,
+    m.def("uptime", counted("uptime", &uptime_impl),
         R"doc(
         Return system uptime and load averages.
 
@@ -498,7 +566,7 @@ void init_system(py::module_ &m) {
         )doc");
 
     // -- env ----------------------------------------------------------------
-    m.def("env", &env_impl,
+    m.def("env", counted("env", &env_impl),
         R"doc(
         Return all environment variables.
 
@@ -510,7 +578,7 @@ void init_system(py::module_ &m) {
         )doc");
 
     // -- getenv -------------------------------------------------------------
-    m.def("getenv", &getenv_impl,
+    m.def("getenv", counted("getenv", &getenv_impl),
         R"doc(
         Get the value of a single environment variable.
 
@@ -527,7 +595,7 @@ void init_system(py::module_ &m) {
         py::arg("default_val") = "");
 
     // -- export / setenv ----------------------------------------------------
-    m.def("export_env", &export_impl,
+    m.def("export_env", counted("export_env", &export_impl),
         R"doc(
         Set an environment variable.
 
@@ -548,7 +616,7 @@ void init_system(py::module_ &m) {
         py::arg("overwrite") = true);
 
     // -- unsetenv -----------------------------------------------------------
-    m.def("unsetenv", &unsetenv_impl,
+    m.def("unsetenv", counted("unsetenv", &unsetenv_impl),
         R"doc(
         Remove an environment variable.
 
@@ -564,7 +632,7 @@ void init_system(py::module_ &m) {
         py::arg("name"));
 
     // -- clear --------------------------------------------------------------
-    m.def("clear", &clear_impl,
+    m.def("clear", counted("clear", &clear_impl),
         R"doc(
         Return ANSI escape codes to clear the terminal.
 
@@ -576,7 +644,7 @@ void init_system(py::module_ &m) {
         )doc");
 
     // -- cal ----------------------------------------------------------------
-    m.def("cal", &cal_impl,
+    m.def("cal", counted("cal", &cal_impl),
         R"doc(
         Display a calendar for a given month and year.
 
@@ -595,7 +663,7 @@ void init_system(py::module_ &m) {
         py::arg("year") = -1);
 
     // -- date ---------------------------------------------------------------
-    m.def("date", &date_impl,
+    m.def("date", counted("date", &date_impl),
         R"doc(
         Display the current date and time.
 
@@ -613,7 +681,7 @@ void init_system(py::module_ &m) {
         py::arg("format") = "");
 
     // -- sleep --------------------------------------------------------------
-    m.def("sleep", &sleep_impl,
+    m.def("sleep", counted("sleep", &sleep_impl),
         R"doc(
         Suspend execution for a given number of seconds.
 
@@ -623,10 +691,11 @@ void init_system(py::module_ &m) {
         Args:
             seconds (float): Number of seconds to sleep.
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("seconds"));
 
     // -- id -----------------------------------------------------------------
-    m.def("id", &id_impl,
+    m.def("id", counted("id", &id_impl),
         R"doc(
         Return user identity information.
 
@@ -645,7 +714,7 @@ void init_system(py::module_ &m) {
         py::arg("username") = "");
 
     // -- groups -------------------------------------------------------------
-    m.def("groups", &groups_impl,
+    m.def("groups", counted("groups", &groups_impl),
         R"doc(
         List groups a user belongs to.
 
@@ -664,7 +733,7 @@ void init_system(py::module_ &m) {
         py::arg("username") = "");
 
     // -- free ---------------------------------------------------------------
-    m.def("free", &free_impl,
+    m.def("free", counted("free", &free_impl),
         R"doc(
         Display memory usage information.
 
@@ -683,20 +752,162 @@ void init_system(py::module_ &m) {
         )doc",
         py::arg("human_readable") = false);
 
+    // -- sysstat ------------------------------------------------------------
+    py::class_<SysSnapshot>(m, "SysStat",
+        "One sysstat() snapshot. Memory sizes are in kB, as in /proc/meminfo.")
+        .def_readonly("uptime", &SysSnapshot::uptime, "Seconds since boot.")
+        .def_readonly("load_1", &SysSnapshot::load_1)
+        .def_readonly("load_5", &SysSnapshot::load_5)
+        .def_readonly("load_15", &SysSnapshot::load_15)
+        .def_readonly("threads_total", &SysSnapshot::threads_total,
+             "Threads in the system, from /proc/loadavg.")
+        .def_readonly("mem_total", &SysSnapshot::mem_total)
+        .def_readonly("mem_free", &SysSnapshot::mem_free)
+        .def_readonly("mem_available", &SysSnapshot::mem_available)
+        .def_property_readonly("mem_used",
+             [](const SysSnapshot& s) { return s.mem_total - s.mem_available; },
+             "mem_total - mem_available, as free() reports it.")
+        .def_readonly("buffers", &SysSnapshot::buffers)
+        .def_readonly("cached", &SysSnapshot::cached)
+        .def_readonly("shmem", &SysSnapshot::shmem)
+        .def_readonly("sreclaimable", &SysSnapshot::sreclaimable)
+        .def_readonly("dirty", &SysSnapshot::dirty)
+        .def_readonly("writeback", &SysSnapshot::writeback)
+        .def_readonly("swap_total", &SysSnapshot::swap_total)
+        .def_readonly("swap_free", &SysSnapshot::swap_free)
+        .def_readonly("ctxt", &SysSnapshot::ctxt, "Context switches since boot.")
+        .def_readonly("forks", &SysSnapshot::forks, "Processes created since boot.")
+        .def_readonly("procs_running", &SysSnapshot::procs_running)
+        .def_readonly("procs_blocked", &SysSnapshot::procs_blocked)
+        .def_readonly("pgfault", &SysSnapshot::pgfault)
+        .def_readonly("pgmajfault", &SysSnapshot::pgmajfault)
+        .def_readonly("pswpin", &SysSnapshot::pswpin)
+        .def_readonly("pswpout", &SysSnapshot::pswpout)
+        .def_readonly("oom_kill", &SysSnapshot::oom_kill)
+        .def_property_readonly("psi_cpu",
+             [](const SysSnapshot& s) { return pressure_dict(s.psi_cpu); },
+             "CPU pressure (avg10/avg60/avg300 and total_us for some and full), "
+             "or None without /proc/pressure.")
+        .def_property_readonly("psi_memory",
+             [](const SysSnapshot& s) { return pressure_dict(s.psi_memory); })
+        .def_property_readonly("psi_io",
+             [](const SysSnapshot& s) { return pressure_dict(s.psi_io); })
+        .def_property_readonly("interval",
+             [](const SysSnapshot& s) { return delta_value(s, s.interval); },
+             "Seconds since the previous delta snapshot; None unless delta=True.")
+        .def_property_readonly("cpu_busy_percent",
+             [](const SysSnapshot& s) { return delta_value(s, s.cpu_busy_percent); })
+        .def_property_readonly("cpu_user_percent",
+             [](const SysSnapshot& s) { return delta_value(s, s.cpu_user_percent); })
+        .def_property_readonly("cpu_system_percent",
+             [](const SysSnapshot& s) { return delta_value(s, s.cpu_system_percent); })
+        .def_property_readonly("cpu_iowait_percent",
+             [](const SysSnapshot& s) { return delta_value(s, s.cpu_iowait_percent); })
+        .def_property_readonly("cpu_steal_percent",
+             [](const SysSnapshot& s) { return delta_value(s, s.cpu_steal_percent); })
+        .def_property_readonly("cpu_idle_percent",
+             [](const SysSnapshot& s) { return delta_value(s, s.cpu_idle_percent); })
+        .def_property_readonly("ctxt_per_sec",
+             [](const SysSnapshot& s) { return delta_value(s, s.ctxt_per_sec); })
+        .def_property_readonly("forks_per_sec",
+             [](const SysSnapshot& s) { return delta_value(s, s.forks_per_sec); })
+        .def_property_readonly("pgfault_per_sec",
+             [](const SysSnapshot& s) { return delta_value(s, s.pgfault_per_sec); })
+        .def_property_readonly("pgmajfault_per_sec",
+             [](const SysSnapshot& s) { return delta_value(s, s.pgmajfault_per_sec); })
+        .def("to_dict", &sysstat_dict,
+             "All fields as a dict; the delta keys only with delta=True.")
+        .def("__repr__", [](const SysSnapshot& s) {
+            char buf[160];
+            snprintf(buf, sizeof(buf), "SysStat(uptime=%.0f, load_1=%.2f, mem_available=%llu",
+                     s.uptime, s.load_1, static_cast<unsigned long long>(s.mem_available));
+            std::string out = buf;
+            if (s.has_delta) {
+                snprintf(buf, sizeof(buf), ", cpu_busy_percent=%.1f", s.cpu_busy_percent);
+                out += buf;
+            }
+            return out + ")";
+        });
+
+    m.def("sysstat", counted("sysstat", &sysstat_impl),
+        R"doc(
+        Return memory, CPU, load and pressure statistics in one snapshot.
+
+        Combines what ``free``, ``uptime`` and ``vmstat`` report. Reads
+        /proc/meminfo, /proc/stat, /proc/loadavg, /proc/uptime, /proc/vmstat
+        and /proc/pressure/* through descriptors kept open between calls,
+        one pread() per file, so it is cheap enough to poll.
+
+        With ``delta=True`` the snapshot also carries CPU utilization
+        percentages and per-second rates of context switches, forks and page
+        faults since the previous ``delta=True`` call in this process (since
+        boot for the first one).
+
+        Args:
+            delta (bool): Compute the change since the previous delta call.
+
+        Returns:
+            SysStat: Snapshot object; ``to_dict()`` converts it to a dict.
+                     Pressure fields are None without CONFIG_PSI; the delta
+                     fields are None unless ``delta=True``.
+
+        Raises:
+            ValueError: If /proc/meminfo or /proc/stat cannot be read.
+        )doc",
+        py::arg("delta") = false);
+
     // -- whereis ------------------------------------------------------------
-    m.def("whereis", &whereis_impl,
+    m.def("whereis", counted("whereis", &whereis_impl),
         R"doc(
         Locate the binary, source, and man pages for a command.
 
         Equivalent to the ``whereis`` shell command. Searches PATH for the
         binary and known directories for man pages and source files.
 
+        PATH directories, man page trees and source directories are listed
+        once into an in-process index; later calls only stat the indexed
+        directories and re-list those whose mtime changed.
+
         Args:
             command (str): Command name to locate.
 
         Returns:
             dict: Keys "command", "binaries" (list), "man_pages" (list),
-                  "sources" (list).
+                  "sources" (list). Man pages are files named
+                  ``command.<section>`` (possibly compressed).
         )doc",
         py::arg("command"));
+
+    // -- which --------------------------------------------------------------
+    m.def("which", counted("which", &which_impl),
+        R"doc(
+        Locate a command in PATH.
+
+        Equivalent to the ``which`` shell command. Checks ``dir/command`` with
+        access(X_OK) for each PATH directory in order, without building the
+        whereis index. A command containing '/' is checked as given.
+
+        Args:
+            command (str): Command name to locate.
+
+        Returns:
+            str | None: Path of the first executable match, or None.
+        )doc",
+        py::arg("command"));
+
+    m.def("which_many", counted("which_many", &which_many_impl),
+        R"doc(
+        Locate many commands in PATH at once.
+
+        Like ``which`` for each command, but answered from the whereis index
+        of PATH directories: one hash probe and one access(X_OK) check per
+        command once the index is built.
+
+        Args:
+            commands (list[str]): Command names to locate.
+
+        Returns:
+            dict: Maps each command to its path, or None if not found.
+        )doc",
+        py::arg("commands"));
 }
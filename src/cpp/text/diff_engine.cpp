@@ -0,0 +1,296 @@
+#include "diff_engine.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+// ---------------------------------------------------------------------------
+// Interning
+// ---------------------------------------------------------------------------
+
+void intern_lines(const std::vector<std::string_view>& lines1, bool terminated1,
+                  const std::vector<std::string_view>& lines2, bool terminated2,
+                  std::vector<uint32_t>& ids1, std::vector<uint32_t>& ids2) {
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::unordered_map<std::string_view, uint32_t> unterminated_ids;
+    ids.reserve(lines1.size() + lines2.size());
+
+    auto intern = [&](const std::vector<std::string_view>& lines, bool terminated,
+                      std::vector<uint32_t>& out) {
+        out.resize(lines.size());
+        for (size_t i = 0; i < lines.size(); i++) {
+            auto& table = (!terminated && i + 1 == lines.size()) ? unterminated_ids : ids;
+            uint32_t next = static_cast<uint32_t>(ids.size() + unterminated_ids.size());
+            out[i] = table.emplace(lines[i], next).first->second;
+        }
+    };
+    intern(lines1, terminated1, ids1);
+    intern(lines2, terminated2, ids2);
+}
+
+// ---------------------------------------------------------------------------
+// Myers diff with linear-space refinement
+// ---------------------------------------------------------------------------
+
+class MyersDiff {
+public:
+    MyersDiff(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, DiffResult& out)
+        : a_(a), b_(b), out_(out) {
+        size_t diagonals = 2 * (a.size() + b.size()) + 3;
+        fwd_.resize(diagonals);
+        bwd_.resize(diagonals);
+        offset_ = static_cast<long>(a.size() + b.size() + 1);
+
+        // About sqrt(number of diagonals), but never below 4096 (GNU diff)
+        too_expensive_ = 1;
+        for (size_t diags = diagonals; diags != 0; diags >>= 2)
+            too_expensive_ <<= 1;
+        too_expensive_ = std::max(too_expensive_, 4096L);
+    }
+
+    void run() { compare(0, a_.size(), 0, b_.size()); }
+
+private:
+    // Diffs a[xoff, xlim) against b[yoff, ylim).
+    void compare(size_t xoff, size_t xlim, size_t yoff, size_t ylim) {
+        for (;;) {
+            while (xoff < xlim && yoff < ylim && a_[xoff] == b_[yoff]) {
+                xoff++;
+                yoff++;
+            }
+            while (xlim > xoff && ylim > yoff && a_[xlim - 1] == b_[ylim - 1]) {
+                xlim--;
+                ylim--;
+            }
+
+            if (xoff == xlim) {
+                for (size_t y = yoff; y < ylim; y++) out_.inserted[y] = 1;
+                return;
+            }
+            if (yoff == ylim) {
+                for (size_t x = xoff; x < xlim; x++) out_.deleted[x] = 1;
+                return;
+            }
+
+            size_t xmid, ymid;
+            if (!middle_snake(xoff, xlim, yoff, ylim, xmid, ymid)) {
+                for (size_t x = xoff; x < xlim; x++) out_.deleted[x] = 1;
+                for (size_t y = yoff; y < ylim; y++) out_.inserted[y] = 1;
+                return;
+            }
+            // Recurse on the smaller half, loop on the other
+            if ((xmid - xoff) + (ymid - yoff) < (xlim - xmid) + (ylim - ymid)) {
+                compare(xoff, xmid, yoff, ymid);
+                xoff = xmid;
+                yoff = ymid;
+            } else {
+                compare(xmid, xlim, ymid, ylim);
+                xlim = xmid;
+                ylim = ymid;
+            }
+        }
+    }
+
+    // Runs the forward and backward searches towards each other until they
+    // overlap and returns a point on an optimal path strictly inside the
+    // box. Inputs are trimmed, so both sides are non-empty and differ at
+    // both ends. Diagonals that leave the box are dropped from the search.
+    //
+    // Past too_expensive_ edit steps the search stops and splits at the
+    // furthest-reaching point found (GNU diff's heuristic): the script
+    // stays correct but may no longer be minimal on huge, unrelated inputs.
+    //
+    // Returns false if the two sides have no line in common.
+    bool middle_snake(size_t xoff, size_t xlim, size_t yoff, size_t ylim,
+                      size_t& xmid, size_t& ymid) {
+        const long n = static_cast<long>(xlim - xoff);
+        const long m = static_cast<long>(ylim - yoff);
+        const long delta = n - m;
+        const bool odd = (delta & 1) != 0;
+        const long max_d = (n + m + 1) / 2;
+        const uint32_t* a = a_.data() + xoff;
+        const uint32_t* b = b_.data() + yoff;
+        long* vf = fwd_.data() + offset_;
+        long* vb = bwd_.data() + offset_;
+        std::fill(vf - max_d - 2, vf + max_d + 3, -1L);
+        std::fill(vb - max_d - 2, vb + max_d + 3, -1L);
+
+        auto split = [&](long x, long y) {
+            xmid = xoff + static_cast<size_t>(x);
+            ymid = yoff + static_cast<size_t>(y);
+        };
+
+        vf[1] = 0;
+        vb[1] = 0;
+        long f_lo = 0, f_hi = 0, b_lo = 0, b_hi = 0;
+        for (long d = 0; d < max_d; d++) {
+            long best_f = -1, best_fx = 0, best_fy = 0;
+            for (long k = -d + f_lo; k <= d - f_hi; k += 2) {
+                long x = (k == -d || (k != d && vf[k - 1] < vf[k + 1])) ? vf[k + 1] : vf[k - 1] + 1;
+                long y = x - k;
+                while (x < n && y < m && a[x] == b[y]) {
+                    x++;
+                    y++;
+                }
+                vf[k] = x;
+                if (x > n) {
+                    f_hi += 2;          // ran off the right edge
+                } else if (y > m) {
+                    f_lo += 2;          // ran off the bottom edge
+                } else {
+                    long kr = delta - k;
+                    if (odd && kr >= -d && kr <= d && vb[kr] != -1 && x >= n - vb[kr]) {
+                        split(x, y);
+                        return true;
+                    }
+                    if (x + y > best_f) {
+                        best_f = x + y;
+                        best_fx = x;
+                        best_fy = y;
+                    }
+                }
+            }
+
+            long best_b = -1, best_bx = 0, best_by = 0;
+            for (long k = -d + b_lo; k <= d - b_hi; k += 2) {
+                long x = (k == -d || (k != d && vb[k - 1] < vb[k + 1])) ? vb[k + 1] : vb[k - 1] + 1;
+                long y = x - k;
+                while (x < n && y < m && a[n - 1 - x] == b[m - 1 - y]) {
+                    x++;
+                    y++;
+                }
+                vb[k] = x;
+                if (x > n) {
+                    b_hi += 2;
+                } else if (y > m) {
+                    b_lo += 2;
+                } else {
+                    long kf = delta - k;
+                    if (!odd && kf >= -d && kf <= d && vf[kf] != -1 && vf[kf] >= n - x) {
+                        split(vf[kf], vf[kf] - kf);
+                        return true;
+                    }
+                    if (x + y > best_b) {
+                        best_b = x + y;
+                        best_bx = n - x;
+                        best_by = m - y;
+                    }
+                }
+            }
+
+            if (d >= too_expensive_ && (best_f > 0 || best_b > 0)) {
+                if (best_f >= best_b)
+                    split(best_fx, best_fy);
+                else
+                    split(best_bx, best_by);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const std::vector<uint32_t>& a_;
+    const std::vector<uint32_t>& b_;
+    DiffResult& out_;
+    std::vector<long> fwd_;
+    std::vector<long> bwd_;
+    long offset_;
+    long too_expensive_;
+};
+
+DiffResult diff_sequences(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    DiffResult result;
+    result.deleted.assign(a.size(), 0);
+    result.inserted.assign(b.size(), 0);
+
+    // A line with no equal in the other file can never be part of the
+    // common subsequence: mark it changed up front and keep it out of the
+    // search, so files that mostly differ stay close to linear time.
+    uint32_t max_id = 0;
+    for (uint32_t id : a) max_id = std::max(max_id, id);
+    for (uint32_t id : b) max_id = std::max(max_id, id);
+    std::vector<char> in_a(static_cast<size_t>(max_id) + 1, 0);
+    std::vector<char> in_b(static_cast<size_t>(max_id) + 1, 0);
+    for (uint32_t id : a) in_a[id] = 1;
+    for (uint32_t id : b) in_b[id] = 1;
+
+    std::vector<uint32_t> fa, fb;
+    std::vector<size_t> map_a, map_b;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (in_b[a[i]]) {
+            fa.push_back(a[i]);
+            map_a.push_back(i);
+        } else {
+            result.deleted[i] = 1;
+        }
+    }
+    for (size_t j = 0; j < b.size(); j++) {
+        if (in_a[b[j]]) {
+            fb.push_back(b[j]);
+            map_b.push_back(j);
+        } else {
+            result.inserted[j] = 1;
+        }
+    }
+
+    DiffResult inner;
+    inner.deleted.assign(fa.size(), 0);
+    inner.inserted.assign(fb.size(), 0);
+    MyersDiff(fa, fb, inner).run();
+    for (size_t i = 0; i < fa.size(); i++)
+        if (inner.deleted[i]) result.deleted[map_a[i]] = 1;
+    for (size_t j = 0; j < fb.size(); j++)
+        if (inner.inserted[j]) result.inserted[map_b[j]] = 1;
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Hunks
+// ---------------------------------------------------------------------------
+
+std::vector<DiffHunk> diff_hunks(const DiffResult& result, size_t context) {
+    const auto& del = result.deleted;
+    const auto& ins = result.inserted;
+    size_t n = del.size(), m = ins.size();
+
+    // Unchanged lines pair up in order, so a change is a maximal run of
+    // deletions followed by a maximal run of insertions.
+    std::vector<DiffChange> changes;
+    size_t i = 0, j = 0;
+    while (i < n || j < m) {
+        if (i < n && j < m && !del[i] && !ins[j]) {
+            i++;
+            j++;
+            continue;
+        }
+        DiffChange c{i, i, j, j};
+        while (i < n && del[i]) i++;
+        while (j < m && ins[j]) j++;
+        c.a_end = i;
+        c.b_end = j;
+        changes.push_back(c);
+    }
+
+    std::vector<DiffHunk> hunks;
+    for (const auto& c : changes) {
+        if (!hunks.empty() && c.a_begin - hunks.back().changes.back().a_end <= 2 * context) {
+            hunks.back().changes.push_back(c);
+            continue;
+        }
+        DiffHunk h;
+        h.changes.push_back(c);
+        hunks.push_back(std::move(h));
+    }
+
+    for (auto& h : hunks) {
+        const DiffChange& first = h.changes.front();
+        const DiffChange& last = h.changes.back();
+        size_t lead = std::min(context, first.a_begin);
+        size_t trail = std::min(context, n - last.a_end);
+        h.a_begin = first.a_begin - lead;
+        h.b_begin = first.b_begin - lead;
+        h.a_end = last.a_end + trail;
+        h.b_end = last.b_end + trail;
+    }
+    return hunks;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Line diff engine behind diff
+//
+// Lines are interned to integer ids (equal ids <=> equal lines) so the
+// search only ever compares integers. The common prefix and suffix are
+// trimmed, and the remainder goes through Myers' O(ND) algorithm with the
+// linear-space "middle snake" refinement. Memory is O(N + M) whatever the
+// size of the inputs or of the difference.
+// ---------------------------------------------------------------------------
+
+struct DiffResult {
+    std::vector<char> deleted;    // per line of a: not in the common subsequence
+    std::vector<char> inserted;   // per line of b: not in the common subsequence
+};
+
+// Computes a minimal edit script between two sequences of line ids.
+DiffResult diff_sequences(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b);
+
+// Interns the lines of both files. An unterminated last line gets a
+// different id from the same text followed by a newline, so "missing
+// newline at end of file" shows up as a change.
+void intern_lines(const std::vector<std::string_view>& lines1, bool terminated1,
+                  const std::vector<std::string_view>& lines2, bool terminated2,
+                  std::vector<uint32_t>& ids1, std::vector<uint32_t>& ids2);
+
+// A run of changes: a[a_begin, a_end) replaced by b[b_begin, b_end).
+struct DiffChange {
+    size_t a_begin, a_end;
+    size_t b_begin, b_end;
+};
+
+// A unified-diff hunk: the changes it covers plus surrounding context.
+struct DiffHunk {
+    size_t a_begin, a_end;
+    size_t b_begin, b_end;
+    std::vector<DiffChange> changes;
+};
+
+// Groups the changes of `result` into hunks with `context` lines around
+// each change; changes whose context overlaps share a hunk.
+std::vector<DiffHunk> diff_hunks(const DiffResult& result, size_t context);
@@ -0,0 +1,67 @@
+#include "fields.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// ---------------------------------------------------------------------------
+// parse_field_list
+// ---------------------------------------------------------------------------
+
+// Parses a positive field number; `item` is quoted in error messages.
+static size_t parse_field_number(std::string_view digits, std::string_view item) {
+    if (digits.empty())
+        throw std::invalid_argument("invalid field range '" + std::string(item) + "'");
+    size_t value = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '9')
+            throw std::invalid_argument("invalid field value '" + std::string(item) + "'");
+        if (value > (kFieldsToEnd - 10) / 10)
+            throw std::invalid_argument("field number too large '" + std::string(item) + "'");
+        value = value * 10 + static_cast<size_t>(c - '0');
+    }
+    if (value == 0)
+        throw std::invalid_argument("fields are numbered from 1");
+    return value;
+}
+
+std::vector<FieldRange> parse_field_list(std::string_view spec) {
+    std::vector<FieldRange> ranges;
+    size_t pos = 0;
+    for (;;) {
+        size_t comma = spec.find(',', pos);
+        std::string_view item = spec.substr(pos, comma == std::string_view::npos
+                                                     ? std::string_view::npos
+                                                     : comma - pos);
+        size_t dash = item.find('-');
+        FieldRange r;
+        if (dash == std::string_view::npos) {
+            r.first = r.last = parse_field_number(item, item);
+        } else {
+            std::string_view lo = item.substr(0, dash);
+            std::string_view hi = item.substr(dash + 1);
+            if (lo.empty() && hi.empty())
+                throw std::invalid_argument("invalid field range '-'");
+            r.first = lo.empty() ? 1 : parse_field_number(lo, item);
+            r.last = hi.empty() ? kFieldsToEnd : parse_field_number(hi, item);
+            if (r.last < r.first)
+                throw std::invalid_argument("invalid decreasing range '" +
+                                            std::string(item) + "'");
+        }
+        ranges.push_back(r);
+        if (comma == std::string_view::npos) break;
+        pos = comma + 1;
+    }
+
+    std::sort(ranges.begin(), ranges.end(), [](const FieldRange& a, const FieldRange& b) {
+        return a.first < b.first;
+    });
+    std::vector<FieldRange> merged;
+    for (const auto& r : ranges) {
+        if (!merged.empty() && (merged.back().last == kFieldsToEnd ||
+                                r.first <= merged.back().last + 1))
+            merged.back().last = std::max(merged.back().last, r.last);
+        else
+            merged.push_back(r);
+    }
+    return merged;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// FieldSplitter — field tokenizer behind cut, join and sort keys
+//
+// Splits a line into fields without copying: every token is a view into the
+// line. The delimiter may be several bytes long and is found with memchr (on
+// its first byte) plus a compare. An empty delimiter instead means runs of
+// whitespace, with leading blanks skipped (like sort and join without -t).
+//
+// With a delimiter, lines follow std::getline tokenizing: a trailing
+// delimiter does not start an extra empty field, and an empty line has no
+// fields at all.
+//
+// The splitter only views its delimiter, so it is free to construct per
+// call; the string it was built from must outlive it.
+// ---------------------------------------------------------------------------
+
+class FieldSplitter {
+public:
+    explicit FieldSplitter(std::string_view delimiter) : delim_(delimiter) {}
+
+    bool whitespace() const { return delim_.empty(); }
+    std::string_view delimiter() const { return delim_; }
+
+    // Calls fn(n, token) for fields n = 1, 2, ... in order until fn returns
+    // false or the line ends.
+    template <typename Fn>
+    void for_each(std::string_view line, Fn&& fn) const {
+        const char* p = line.data();
+        const char* end = p + line.size();
+        size_t n = 1;
+
+        if (whitespace()) {
+            for (;;) {
+                while (p < end && is_blank(*p)) p++;
+                if (p == end) return;
+                const char* start = p;
+                while (p < end && !is_blank(*p)) p++;
+                if (!fn(n++, std::string_view(start, static_cast<size_t>(p - start))))
+                    return;
+            }
+        }
+
+        while (p < end) {
+            const char* d = find(p, end);
+            const char* stop = d ? d : end;
+            if (!fn(n++, std::string_view(p, static_cast<size_t>(stop - p))) || !d)
+                return;
+            p = d + delim_.size();
+        }
+    }
+
+    // Field n (1-based) of `line`; empty if the line has fewer fields.
+    std::string_view field(std::string_view line, size_t n) const {
+        std::string_view result;
+        for_each(line, [&](size_t i, std::string_view token) {
+            if (i < n) return true;
+            result = token;
+            return false;
+        });
+        return result;
+    }
+
+private:
+    static bool is_blank(char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    // Start of the next delimiter in [p, end), or nullptr.
+    const char* find(const char* p, const char* end) const {
+        const size_t dlen = delim_.size();
+        const char first = delim_[0];
+        while (static_cast<size_t>(end - p) >= dlen) {
+            const char* c = static_cast<const char*>(
+                std::memchr(p, first, static_cast<size_t>(end - p) - dlen + 1));
+            if (!c) return nullptr;
+            if (dlen == 1 || std::memcmp(c + 1, delim_.data() + 1, dlen - 1) == 0)
+                return c;
+            p = c + 1;
+        }
+        return nullptr;
+    }
+
+    std::string_view delim_;
+};
+
+// ---------------------------------------------------------------------------
+// Field lists ("1,3", "2-4", "-3", "5-")
+// ---------------------------------------------------------------------------
+
+struct FieldRange {
+    size_t first;   // 1-based, inclusive
+    size_t last;    // inclusive; kFieldsToEnd for an open range like "5-"
+};
+
+constexpr size_t kFieldsToEnd = static_cast<size_t>(-1);
+
+// Parses a cut-style field list into sorted, merged ranges, so selection
+// costs the same for "1-1000000" as for "1". Throws std::invalid_argument
+// on syntax errors or a field number of 0.
+std::vector<FieldRange> parse_field_list(std::string_view spec);
+
+// Calls fn(token) for each field of `line` selected by `ranges` (as returned
+// by parse_field_list), in field order. Stops scanning the line once past
+// the last range.
+template <typename Fn>
+void select_fields(const FieldSplitter& splitter, std::string_view line,
+                   const std::vector<FieldRange>& ranges, Fn&& fn) {
+    if (ranges.empty()) return;
+    size_t r = 0;
+    splitter.for_each(line, [&](size_t n, std::string_view token) {
+        while (n > ranges[r].last) {
+            if (++r == ranges.size()) return false;
+        }
+        if (n >= ranges[r].first) fn(token);
+        return true;
+    });
+}
@@ -0,0 +1,186 @@
+#include "follow.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Upper bound on how much is read per fill(), so a burst of appended data
+// is handed out in pieces instead of being buffered whole.
+static constexpr size_t kFollowBlock = 1 << 20;
+static constexpr int kFallbackPollMs = 250;
+
+// ---------------------------------------------------------------------------
+// Setup
+// ---------------------------------------------------------------------------
+
+FileFollower::FileFollower(const std::string& path, uint64_t offset) : path_(path) {
+    size_t slash = path_.rfind('/');
+    dir_ = slash == std::string::npos ? "." : (slash == 0 ? "/" : path_.substr(0, slash));
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ >= 0)
+        inotify_add_watch(inotify_fd_, dir_.c_str(), IN_CREATE | IN_MOVED_TO);
+    try {
+        open_file(offset);
+    } catch (...) {
+        if (inotify_fd_ >= 0)
+            ::close(inotify_fd_);
+        throw;
+    }
+}
+
+FileFollower::~FileFollower() {
+    if (fd_ >= 0)
+        ::close(fd_);
+    if (inotify_fd_ >= 0)
+        ::close(inotify_fd_);
+}
+
+void FileFollower::open_file(uint64_t offset) {
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("cannot open '" + path_ + "': " + std::strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::runtime_error("cannot stat '" + path_ + "': " + std::strerror(err));
+    }
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = fd;
+    dev_ = static_cast<uint64_t>(st.st_dev);
+    ino_ = static_cast<uint64_t>(st.st_ino);
+    offset_ = offset;
+    pending_.clear();
+    pending_pos_ = 0;
+    watch();
+}
+
+void FileFollower::watch() {
+    if (inotify_fd_ < 0)
+        return;
+    if (file_wd_ >= 0)
+        inotify_rm_watch(inotify_fd_, file_wd_);
+    file_wd_ = inotify_add_watch(inotify_fd_, path_.c_str(),
+                                 IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+}
+
+// ---------------------------------------------------------------------------
+// Reading
+// ---------------------------------------------------------------------------
+
+size_t FileFollower::take_lines(std::string& out, size_t max_lines) {
+    size_t count = 0;
+    const char* base = pending_.data();
+    while (count < max_lines && pending_pos_ < pending_.size()) {
+        const char* nl = static_cast<const char*>(std::memchr(
+            base + pending_pos_, '\n', pending_.size() - pending_pos_));
+        if (!nl)
+            break;
+        size_t end = static_cast<size_t>(nl - base) + 1;
+        out.append(base + pending_pos_, end - pending_pos_);
+        pending_pos_ = end;
+        count++;
+    }
+    return count;
+}
+
+// Reads newly appended bytes into pending_. Returns false at end of file.
+bool FileFollower::fill() {
+    struct stat st;
+    if (fstat(fd_, &st) == 0 && S_ISREG(st.st_mode) &&
+        static_cast<uint64_t>(st.st_size) < offset_) {
+        // Truncated: start over, like tail -F.
+        offset_ = 0;
+        pending_.clear();
+        pending_pos_ = 0;
+    }
+
+    pending_.erase(0, pending_pos_);
+    pending_pos_ = 0;
+    size_t old_size = pending_.size();
+    pending_.resize(old_size + kFollowBlock);
+    ssize_t got;
+    do {
+        got = pread(fd_, &pending_[old_size], kFollowBlock, static_cast<off_t>(offset_));
+    } while (got < 0 && errno == EINTR);
+    if (got <= 0) {
+        pending_.resize(old_size);
+        return false;
+    }
+    pending_.resize(old_size + static_cast<size_t>(got));
+    offset_ += static_cast<uint64_t>(got);
+    return true;
+}
+
+// True if `path_` now names a different file than the one being read.
+bool FileFollower::rotated() {
+    struct stat st;
+    if (stat(path_.c_str(), &st) != 0)
+        return false;   // gone for now; keep the old file until one appears
+    return static_cast<uint64_t>(st.st_dev) != dev_ ||
+           static_cast<uint64_t>(st.st_ino) != ino_;
+}
+
+void FileFollower::wait(int timeout_ms) {
+    if (inotify_fd_ < 0) {
+        int ms = timeout_ms < 0 ? kFallbackPollMs : std::min(timeout_ms, kFallbackPollMs);
+        poll(nullptr, 0, ms);
+        return;
+    }
+
+    struct pollfd pfd = {inotify_fd_, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) <= 0)
+        return;
+    // The events only say "look again"; drain them and re-check the file.
+    alignas(struct inotify_event) char buf[4096];
+    while (::read(inotify_fd_, buf, sizeof(buf)) > 0) {
+    }
+}
+
+size_t FileFollower::read_lines(std::string& out, size_t max_lines, int timeout_ms) {
+    using clock = std::chrono::steady_clock;
+    auto deadline = clock::now() + std::chrono::milliseconds(std::max(timeout_ms, 0));
+
+    for (;;) {
+        size_t n = take_lines(out, max_lines);
+        if (n > 0)
+            return n;
+        if (fill())
+            continue;
+
+        if (rotated()) {
+            // The old file is finished: hand out its unterminated last line,
+            // then continue with the new file from the start.
+            size_t flushed = 0;
+            if (pending_pos_ < pending_.size()) {
+                out.append(pending_, pending_pos_, std::string::npos);
+                out.push_back('\n');
+                flushed = 1;
+            }
+            open_file(0);
+            if (flushed)
+                return flushed;
+            continue;
+        }
+
+        int remaining = -1;
+        if (timeout_ms >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - clock::now()).count();
+            if (left <= 0)
+                return 0;
+            remaining = static_cast<int>(left);
+        }
+        wait(remaining);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ---------------------------------------------------------------------------
+// FileFollower — the appended lines of a growing file (tail -F)
+//
+// Reads a file from a starting offset and then waits on inotify for more
+// data, so an idle log costs nothing until it is written to. Like tail -F it
+// follows the name rather than the descriptor:
+//
+//   * the file and its directory are both watched; when the name is renamed
+//     away or deleted and a new file appears under it (log rotation), the
+//     rest of the old file is drained and the new one is read from the
+//     beginning;
+//   * if the file shrinks below the current offset (truncation), reading
+//     restarts at 0.
+//
+// Only complete lines are returned; a partially written last line is held
+// back until its newline arrives. Where inotify is unavailable, the file is
+// re-checked every 250 ms instead.
+//
+// Not thread-safe. Throws std::runtime_error if the file cannot be opened.
+// ---------------------------------------------------------------------------
+
+class FileFollower {
+public:
+    FileFollower(const std::string& path, uint64_t offset);
+    ~FileFollower();
+
+    FileFollower(const FileFollower&) = delete;
+    FileFollower& operator=(const FileFollower&) = delete;
+
+    // Appends up to `max_lines` complete lines, each ending in '\n', to
+    // `out`. Waits up to `timeout_ms` for new data when none is buffered
+    // (-1 waits indefinitely, 0 only checks). Returns the number of lines
+    // appended; 0 means the wait timed out.
+    size_t read_lines(std::string& out, size_t max_lines, int timeout_ms);
+
+private:
+    void open_file(uint64_t offset);
+    void watch();
+    size_t take_lines(std::string& out, size_t max_lines);
+    bool fill();
+    bool rotated();
+    void wait(int timeout_ms);
+
+    std::string path_;
+    std::string dir_;
+    int fd_ = -1;
+    int inotify_fd_ = -1;
+    int file_wd_ = -1;
+    uint64_t dev_ = 0;
+    uint64_t ino_ = 0;
+    uint64_t offset_ = 0;
+    std::string pending_;   // read but not yet returned
+    size_t pending_pos_ = 0;
+};
@@ -0,0 +1,602 @@
+#include "grep_index.h"
+#include "matcher.h"
+#include "common/thread_pool.h"
+#include "filesystem/walker.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kIndexMagic[8] = {'S', 'F', 'G', 'R', 'E', 'P', 'I', 'X'};
+static constexpr uint32_t kIndexVersion = 1;
+static constexpr uint32_t kByteOrderMark = 0x01020304;
+
+// Bytes before indexed_end that must be unchanged for a file to count as
+// appended to.
+static constexpr size_t kTailHashBytes = 4096;
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Trigrams
+// ---------------------------------------------------------------------------
+
+struct LowerTable {
+    unsigned char map[256];
+    LowerTable() {
+        for (int c = 0; c < 256; c++)
+            map[c] = static_cast<unsigned char>((c >= 'A' && c <= 'Z') ? c + 32 : c);
+    }
+};
+
+const LowerTable kLower;
+
+// Calls add(trigram) for every ASCII-lowercased byte trigram of `text` that
+// does not span a newline.
+template <typename Add>
+void for_each_trigram(std::string_view text, Add&& add) {
+    uint32_t window = 0;
+    size_t run = 0;
+    for (unsigned char c : text) {
+        if (c == '\n') {
+            run = 0;
+            continue;
+        }
+        window = ((window << 8) | kLower.map[c]) & 0xFFFFFF;
+        if (++run >= 3)
+            add(window);
+    }
+}
+
+// Distinct trigrams of one block. The bitmap spans all 2^24 trigrams and is
+// cleared again from the list, so each worker allocates it once.
+class TrigramSet {
+public:
+    TrigramSet() : bits_((1u << 24) / 64, 0) {}
+
+    void add(uint32_t t) {
+        uint64_t& word = bits_[t >> 6];
+        uint64_t bit = uint64_t(1) << (t & 63);
+        if (!(word & bit)) {
+            word |= bit;
+            list_.push_back(t);
+        }
+    }
+
+    // Moves the sorted trigrams out and resets the set.
+    std::vector<uint32_t> take() {
+        for (uint32_t t : list_)
+            bits_[t >> 6] = 0;
+        std::sort(list_.begin(), list_.end());
+        std::vector<uint32_t> out;
+        out.swap(list_);
+        return out;
+    }
+
+private:
+    std::vector<uint64_t> bits_;
+    std::vector<uint32_t> list_;
+};
+
+uint64_t fnv1a(std::string_view data) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+uint64_t tail_hash(std::string_view data, uint64_t end) {
+    uint64_t begin = end > kTailHashBytes ? end - kTailHashBytes : 0;
+    return fnv1a(data.substr(begin, end - begin));
+}
+
+int64_t mtime_ns(const FileStat& st) {
+    return st.mtime_sec * 1000000000 + st.mtime_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// Build state
+// ---------------------------------------------------------------------------
+
+constexpr size_t kNoRecord = static_cast<size_t>(-1);
+
+struct FreshBlock {
+    uint64_t begin;
+    uint64_t end;
+    uint64_t line_base;
+    std::vector<uint32_t> trigrams;     // sorted
+};
+
+struct IndexedFile {
+    std::string path;
+    FileStat st;
+    bool skipped = false;               // could not be read: left out
+    size_t old = kNoRecord;             // record in the old index, if any
+    bool keep_old = false;              // its blocks are reused
+    bool appended = false;              // and new bytes were read after them
+    std::vector<FreshBlock> fresh;
+    uint64_t indexed_end = 0;
+    uint64_t lines = 0;
+    uint64_t tail_hash = 0;
+    uint64_t new_bytes = 0;
+};
+
+// Collects the regular files below the root (symlinks to files included).
+class IndexWalkVisitor : public WalkVisitor {
+public:
+    explicit IndexWalkVisitor(std::vector<IndexedFile>& files) : files_(files) {}
+
+    bool visit(const WalkEntry& e, void*) override {
+        if (e.target_type() != EntryType::file)
+            return true;
+        const FileStat* st = e.target_stat();
+        if (!st)
+            return true;
+        IndexedFile f;
+        f.path = e.path();
+        f.st = *st;
+        std::lock_guard<std::mutex> lock(mutex_);
+        files_.push_back(std::move(f));
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<IndexedFile>& files_;
+};
+
+// Cuts [begin, end) of `data` into newline-aligned blocks of about
+// `block_size` bytes and records their trigrams. `end` is a line end.
+// Returns the number of lines before `end`.
+uint64_t index_blocks(std::string_view data, uint64_t begin, uint64_t end, uint64_t line_base,
+                  size_t block_size, TrigramSet& set, std::vector<FreshBlock>& out) {
+    while (begin < end) {
+        uint64_t stop = begin + block_size;
+        if (stop >= end) {
+            stop = end;
+        } else {
+            size_t nl = data.find('\n', stop - 1);
+            stop = nl == std::string_view::npos || nl + 1 > end ? end : nl + 1;
+        }
+        std::string_view text = data.substr(begin, stop - begin);
+        for_each_trigram(text, [&](uint32_t t) { set.add(t); });
+        out.push_back(FreshBlock{begin, stop, line_base, set.take()});
+        line_base += count_newlines(text.data(), text.size());
+        begin = stop;
+    }
+    return line_base;
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// GrepIndex
+// ---------------------------------------------------------------------------
+
+GrepIndex::GrepIndex(const std::string& path) {
+    std::string error;
+    if (!load(path, error))
+        throw std::runtime_error("cannot read index '" + path + "': " + error);
+}
+
+bool GrepIndex::load(const std::string& path, std::string& error) {
+    static_assert(sizeof(Header) == 88 && sizeof(FileRecord) == 64 &&
+                  sizeof(BlockRecord) == 24 && sizeof(TrigramRecord) == 16,
+                  "grep index records must keep their on-disk size");
+    int err = file_.open(path);
+    if (err != 0) {
+        error = std::strerror(err);
+        return false;
+    }
+    std::string_view data = file_.data();
+    uint64_t size = data.size();
+    auto fail = [&](const char* why) {
+        file_ = MappedFile();
+        error = why;
+        return false;
+    };
+    if (size < sizeof(Header) || reinterpret_cast<uintptr_t>(data.data()) % 8 != 0)
+        return fail("not a grep index");
+
+    const Header* h = reinterpret_cast<const Header*>(data.data());
+    if (std::memcmp(h->magic, kIndexMagic, sizeof(kIndexMagic)) != 0)
+        return fail("not a grep index");
+    if (h->version != kIndexVersion || h->byte_order != kByteOrderMark)
+        return fail("unsupported index version");
+
+    auto section = [size](uint64_t at, uint64_t count, uint64_t width) {
+        return at % 8 == 0 && at <= size && count <= (size - at) / width;
+    };
+    if (!section(h->files_at, h->file_count, sizeof(FileRecord)) ||
+        !section(h->blocks_at, h->block_count, sizeof(BlockRecord)) ||
+        !section(h->trigrams_at, h->trigram_count, sizeof(TrigramRecord)) ||
+        !section(h->postings_at, h->posting_count, sizeof(uint32_t)) ||
+        h->block_count > UINT32_MAX)
+        return fail("damaged index");
+
+    const char* base = data.data();
+    files_ = reinterpret_cast<const FileRecord*>(base + h->files_at);
+    blocks_ = reinterpret_cast<const BlockRecord*>(base + h->blocks_at);
+    trigrams_ = reinterpret_cast<const TrigramRecord*>(base + h->trigrams_at);
+    postings_ = reinterpret_cast<const uint32_t*>(base + h->postings_at);
+    for (uint64_t i = 0; i < h->file_count; i++) {
+        const FileRecord& f = files_[i];
+        if (uint64_t(f.first_block) + f.block_count > h->block_count ||
+            f.indexed_end > f.size)
+            return fail("damaged index");
+    }
+    for (uint64_t i = 0; i < h->trigram_count; i++) {
+        const TrigramRecord& t = trigrams_[i];
+        if (t.first > h->posting_count || t.count > h->posting_count - t.first)
+            return fail("damaged index");
+    }
+    header_ = h;
+    return true;
+}
+
+const GrepIndex::FileRecord* GrepIndex::find(uint64_t dev, uint64_t ino) const {
+    const FileRecord* end = files_ + header_->file_count;
+    const FileRecord* it = std::lower_bound(
+        files_, end, std::make_pair(dev, ino), [](const FileRecord& r, const auto& key) {
+            return std::make_pair(r.dev, r.ino) < key;
+        });
+    return it != end && it->dev == dev && it->ino == ino ? it : nullptr;
+}
+
+const GrepIndex::TrigramRecord* GrepIndex::find(uint32_t trigram) const {
+    const TrigramRecord* end = trigrams_ + header_->trigram_count;
+    const TrigramRecord* it = std::lower_bound(
+        trigrams_, end, trigram,
+        [](const TrigramRecord& r, uint32_t key) { return r.trigram < key; });
+    return it != end && it->trigram == trigram ? it : nullptr;
+}
+
+bool GrepIndex::unchanged(const FileRecord& r, const FileStat& st) {
+    return r.size == st.size && r.mtime_ns == mtime_ns(st);
+}
+
+bool GrepIndex::appended(const FileRecord& r, const FileStat& st, std::string_view data) {
+    return st.size > r.size && data.size() >= r.indexed_end &&
+           tail_hash(data, r.indexed_end) == r.tail_hash;
+}
+
+std::vector<uint32_t> GrepIndex::candidates(std::string_view literal) const {
+    std::vector<uint32_t> grams;
+    for_each_trigram(literal, [&](uint32_t t) { grams.push_back(t); });
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+    std::vector<uint32_t> out;
+    if (grams.empty()) {
+        // Nothing to narrow by: every block is a candidate.
+        out.resize(header_->block_count);
+        for (size_t i = 0; i < out.size(); i++)
+            out[i] = static_cast<uint32_t>(i);
+        return out;
+    }
+
+    std::vector<const TrigramRecord*> lists;
+    for (uint32_t t : grams) {
+        const TrigramRecord* r = find(t);
+        if (!r)
+            return out;
+        lists.push_back(r);
+    }
+    // Shortest list first keeps every intersection small.
+    std::sort(lists.begin(), lists.end(),
+              [](const TrigramRecord* a, const TrigramRecord* b) { return a->count < b->count; });
+    const uint32_t* first = postings_ + lists[0]->first;
+    out.assign(first, first + lists[0]->count);
+    std::vector<uint32_t> next;
+    for (size_t i = 1; i < lists.size() && !out.empty(); i++) {
+        const uint32_t* p = postings_ + lists[i]->first;
+        next.clear();
+        std::set_intersection(out.begin(), out.end(), p, p + lists[i]->count,
+                              std::back_inserter(next));
+        out.swap(next);
+    }
+    return out;
+}
+
+bool GrepIndex::ranges(const FileStat& st, std::string_view data,
+                       const std::vector<uint32_t>& candidates,
+                       std::vector<IndexRange>& out) const {
+    const FileRecord* r = find(st.dev, st.ino);
+    if (!r)
+        return false;
+    if (!(unchanged(*r, st) && data.size() >= r->indexed_end) && !appended(*r, st, data))
+        return false;
+
+    auto add = [&out](size_t begin, size_t end, size_t line_base) {
+        if (begin >= end)
+            return;
+        if (!out.empty() && out.back().end == begin) {
+            out.back().end = end;
+            return;
+        }
+        out.push_back(IndexRange{begin, end, line_base});
+    };
+    uint32_t first = r->first_block;
+    uint32_t last = first + r->block_count;
+    for (auto it = std::lower_bound(candidates.begin(), candidates.end(), first);
+         it != candidates.end() && *it < last; ++it) {
+        const BlockRecord& b = blocks_[*it];
+        add(b.begin, b.end, b.line_base);
+    }
+    // Whatever was written after the index was built.
+    add(r->indexed_end, data.size(), r->lines);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Building
+// ---------------------------------------------------------------------------
+
+std::string default_grep_index_path(const std::string& root) {
+    char resolved[PATH_MAX];
+    if (!realpath(root.c_str(), resolved))
+        throw std::runtime_error("cannot access '" + root + "': " + std::strerror(errno));
+
+    std::string dir;
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && xdg[0] == '/') {
+        dir = xdg;
+    } else {
+        const char* home = std::getenv("HOME");
+        if (!home || !home[0])
+            throw std::runtime_error("cannot locate a cache directory: HOME is not set");
+        dir = join_path(home, ".cache");
+    }
+    for (const std::string& d : {dir, join_path(dir, "shellfast")}) {
+        if (mkdir(d.c_str(), 0700) != 0 && errno != EEXIST)
+            throw std::runtime_error("cannot create '" + d + "': " + std::strerror(errno));
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "grep-%016llx.idx",
+                  static_cast<unsigned long long>(fnv1a(resolved)));
+    return join_path(join_path(dir, "shellfast"), name);
+}
+
+template <typename T>
+static void write_records(std::ofstream& f, const std::vector<T>& v) {
+    f.write(reinterpret_cast<const char*>(v.data()),
+            static_cast<std::streamsize>(v.size() * sizeof(T)));
+}
+
+GrepIndexStats update_grep_index(const std::string& root, const std::string& index_path,
+                                 size_t block_size, ThreadPool& pool) {
+    using FileRecord = GrepIndex::FileRecord;
+    using BlockRecord = GrepIndex::BlockRecord;
+    using TrigramRecord = GrepIndex::TrigramRecord;
+
+    if (block_size == 0)
+        throw std::invalid_argument("block_size must be positive");
+
+    FileStat root_st;
+    int err = stat_at(AT_FDCWD, root.c_str(), true, root_st);
+    if (err != 0)
+        throw std::runtime_error("cannot access '" + root + "': " + std::strerror(err));
+
+    std::vector<IndexedFile> files;
+    if (root_st.type() == EntryType::dir) {
+        IndexWalkVisitor visitor(files);
+        walk_tree(root, pool, WalkOptions(), visitor);
+    } else if (root_st.type() == EntryType::file) {
+        files.emplace_back();
+        files.back().path = root;
+        files.back().st = root_st;
+    } else {
+        throw std::runtime_error("'" + root + "' is not a regular file or directory");
+    }
+
+    // One record per inode: hard links and symlinks share it.
+    std::sort(files.begin(), files.end(), [](const IndexedFile& a, const IndexedFile& b) {
+        if (a.st.dev != b.st.dev) return a.st.dev < b.st.dev;
+        if (a.st.ino != b.st.ino) return a.st.ino < b.st.ino;
+        return a.path < b.path;
+    });
+    files.erase(std::unique(files.begin(), files.end(),
+                            [](const IndexedFile& a, const IndexedFile& b) {
+                                return a.st.dev == b.st.dev && a.st.ino == b.st.ino;
+                            }),
+                files.end());
+
+    // An index built with another block size is rebuilt from scratch.
+    GrepIndex old;
+    std::string ignored;
+    bool have_old = old.load(index_path, ignored) && old.header_->block_size == block_size;
+
+    // One trigram set per worker, slot 0 for tasks run inline.
+    std::vector<std::unique_ptr<TrigramSet>> sets(pool.size() + 1);
+    auto index_file = [&](IndexedFile& f) {
+        const FileRecord* rec = have_old ? old.find(f.st.dev, f.st.ino) : nullptr;
+        if (rec) {
+            f.old = static_cast<size_t>(rec - old.files_);
+            if (GrepIndex::unchanged(*rec, f.st)) {
+                f.keep_old = true;
+                f.indexed_end = rec->indexed_end;
+                f.lines = rec->lines;
+                f.tail_hash = rec->tail_hash;
+                return;
+            }
+        }
+
+        MappedFile file;
+        if (file.open(f.path) != 0) {
+            f.skipped = true;
+            return;
+        }
+        std::string_view data = file.data();
+        uint64_t begin = 0;
+        uint64_t lines = 0;
+        if (rec && GrepIndex::appended(*rec, f.st, data)) {
+            f.keep_old = true;
+            f.appended = true;
+            begin = rec->indexed_end;
+            lines = rec->lines;
+        }
+        size_t nl = data.rfind('\n');
+        uint64_t end = nl == std::string_view::npos ? 0 : nl + 1;
+        end = std::max(end, begin);
+
+        auto& set = sets[static_cast<size_t>(pool.current_worker() + 1)];
+        if (!set)
+            set = std::make_unique<TrigramSet>();
+        f.lines = index_blocks(data, begin, end, lines, block_size, *set, f.fresh);
+        f.indexed_end = end;
+        f.tail_hash = tail_hash(data, end);
+        f.new_bytes = end - begin;
+    };
+    for (auto& f : files) {
+        IndexedFile* fp = &f;
+        pool.submit([&index_file, fp] { index_file(*fp); });
+    }
+    pool.wait();
+    sets.clear();
+
+    // Lay out files and blocks, mapping reused old blocks to their new ids
+    // and listing the (trigram, block) pairs of the fresh ones.
+    GrepIndexStats stats;
+    stats.index = index_path;
+    std::vector<FileRecord> out_files;
+    std::vector<BlockRecord> out_blocks;
+    std::vector<uint32_t> remap(have_old ? old.header_->block_count : 0, UINT32_MAX);
+    std::vector<uint64_t> pairs;
+    size_t matched_old = 0;
+    for (auto& f : files) {
+        if (f.skipped)
+            continue;
+        matched_old += f.old != kNoRecord;
+        FileRecord r{};
+        r.dev = f.st.dev;
+        r.ino = f.st.ino;
+        r.size = f.st.size;
+        r.mtime_ns = mtime_ns(f.st);
+        r.indexed_end = std::min<uint64_t>(f.indexed_end, f.st.size);
+        r.lines = f.lines;
+        r.tail_hash = f.tail_hash;
+        r.first_block = static_cast<uint32_t>(out_blocks.size());
+        if (f.keep_old) {
+            const FileRecord& o = old.files_[f.old];
+            for (uint32_t b = o.first_block; b < o.first_block + o.block_count; b++) {
+                remap[b] = static_cast<uint32_t>(out_blocks.size());
+                out_blocks.push_back(old.blocks_[b]);
+            }
+        }
+        for (auto& fb : f.fresh) {
+            uint64_t id = out_blocks.size();
+            out_blocks.push_back(BlockRecord{fb.begin, fb.end, fb.line_base});
+            for (uint32_t t : fb.trigrams)
+                pairs.push_back((uint64_t(t) << 32) | id);
+            std::vector<uint32_t>().swap(fb.trigrams);
+        }
+        if (out_blocks.size() >= UINT32_MAX)
+            throw std::runtime_error("too many blocks for one index; use a larger block_size");
+        r.block_count = static_cast<uint32_t>(out_blocks.size() - r.first_block);
+        out_files.push_back(r);
+
+        if (!f.keep_old)
+            stats.reindexed++;
+        else if (f.appended)
+            stats.appended++;
+        else
+            stats.unchanged++;
+        stats.indexed_bytes += r.indexed_end;
+        stats.new_bytes += f.new_bytes;
+    }
+    stats.files = out_files.size();
+    stats.blocks = out_blocks.size();
+    stats.removed = have_old ? old.header_->file_count - matched_old : 0;
+    std::sort(pairs.begin(), pairs.end());
+
+    // Merge the old postings (renumbered, dropping blocks that are gone)
+    // with the fresh pairs, one trigram at a time.
+    std::vector<TrigramRecord> out_trigrams;
+    std::vector<uint32_t> postings;
+    size_t old_count = have_old ? old.header_->trigram_count : 0;
+    size_t oi = 0;
+    size_t pi = 0;
+    while (oi < old_count || pi < pairs.size()) {
+        uint32_t key;
+        if (pi == pairs.size())
+            key = old.trigrams_[oi].trigram;
+        else if (oi == old_count)
+            key = static_cast<uint32_t>(pairs[pi] >> 32);
+        else
+            key = std::min(old.trigrams_[oi].trigram, static_cast<uint32_t>(pairs[pi] >> 32));
+
+        size_t start = postings.size();
+        if (oi < old_count && old.trigrams_[oi].trigram == key) {
+            const TrigramRecord& t = old.trigrams_[oi++];
+            for (uint64_t i = 0; i < t.count; i++) {
+                uint32_t b = old.postings_[t.first + i];
+                if (b < remap.size() && remap[b] != UINT32_MAX)
+                    postings.push_back(remap[b]);
+            }
+        }
+        size_t mid = postings.size();
+        for (; pi < pairs.size() && static_cast<uint32_t>(pairs[pi] >> 32) == key; pi++)
+            postings.push_back(static_cast<uint32_t>(pairs[pi]));
+        if (postings.size() == start)
+            continue;
+        std::inplace_merge(postings.begin() + static_cast<std::ptrdiff_t>(start),
+                           postings.begin() + static_cast<std::ptrdiff_t>(mid), postings.end());
+        out_trigrams.push_back(TrigramRecord{key, static_cast<uint32_t>(postings.size() - start),
+                                             start});
+    }
+    std::vector<uint64_t>().swap(pairs);
+    stats.trigrams = out_trigrams.size();
+
+    GrepIndex::Header h{};
+    std::memcpy(h.magic, kIndexMagic, sizeof(kIndexMagic));
+    h.version = kIndexVersion;
+    h.byte_order = kByteOrderMark;
+    h.block_size = block_size;
+    h.file_count = out_files.size();
+    h.block_count = out_blocks.size();
+    h.trigram_count = out_trigrams.size();
+    h.posting_count = postings.size();
+    h.files_at = sizeof(GrepIndex::Header);
+    h.blocks_at = h.files_at + h.file_count * sizeof(FileRecord);
+    h.trigrams_at = h.blocks_at + h.block_count * sizeof(BlockRecord);
+    h.postings_at = h.trigrams_at + h.trigram_count * sizeof(TrigramRecord);
+
+    // Write beside the target and rename, so a reader never sees half a file.
+    std::string tmp = index_path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        write_records(f, out_files);
+        write_records(f, out_blocks);
+        write_records(f, out_trigrams);
+        write_records(f, postings);
+        if (!f.flush()) {
+            int werr = errno;
+            std::remove(tmp.c_str());
+            throw std::runtime_error("cannot write index '" + index_path + "': " +
+                                     std::strerror(werr));
+        }
+    }
+    if (std::rename(tmp.c_str(), index_path.c_str()) != 0) {
+        int werr = errno;
+        std::remove(tmp.c_str());
+        throw std::runtime_error("cannot write index '" + index_path + "': " +
+                                 std::strerror(werr));
+    }
+    return stats;
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+class ThreadPool;
+struct FileStat;
+
+// ---------------------------------------------------------------------------
+// Grep index — trigram index behind index_build and grep(index=...)
+//
+// Files are cut into newline-aligned blocks of about block_size bytes, and
+// every block records the set of (ASCII-lowercased) byte trigrams in its
+// lines. A query takes the literal every match of the pattern must contain
+// (Matcher::literal()), intersects the block lists of its trigrams and
+// scans only the blocks that are left. Patterns without a literal of three
+// bytes or more, and inverted searches, cannot be narrowed.
+//
+// Files are keyed by device and inode, so the index does not depend on how
+// the root was spelled and survives log rotation by rename. Each file
+// records its size, mtime and `indexed_end`, the end of its last complete
+// line when it was indexed. Rebuilding keeps a file with the same size and
+// mtime as it is; a file that grew and whose bytes before indexed_end still
+// end the same way (a hash of the last 4 KiB) is treated as appended to and
+// only its new bytes are read. Anything else is indexed again. A search
+// applies the same checks, then scans whatever the index does not cover, so
+// a stale index is slower but never wrong.
+//
+// On disk the index is one file of fixed-width records in host byte order
+// (header, files, blocks, trigram table, postings), 8-byte aligned, so it is
+// used straight from the mapping. It is replaced atomically when rebuilt.
+// ---------------------------------------------------------------------------
+
+// Default block size: small enough to skip most of a large log, large
+// enough that the postings stay a fraction of the text.
+constexpr size_t kGrepIndexBlockSize = 256 * 1024;
+
+struct GrepIndexStats {
+    std::string index;          // path of the index file
+    size_t files = 0;
+    size_t blocks = 0;
+    size_t trigrams = 0;
+    uint64_t indexed_bytes = 0;
+    uint64_t new_bytes = 0;     // bytes read by this build
+    size_t unchanged = 0;       // files kept as they were
+    size_t appended = 0;        // files of which only the new bytes were read
+    size_t reindexed = 0;       // new or rewritten files
+    size_t removed = 0;         // files no longer below the root
+};
+
+// A stretch of a file grep has to search, with the number of lines before it.
+struct IndexRange {
+    size_t begin = 0;
+    size_t end = 0;
+    size_t line_base = 0;
+};
+
+// $XDG_CACHE_HOME/shellfast (or ~/.cache/shellfast), created if needed,
+// plus a name derived from the real path of `root`.
+std::string default_grep_index_path(const std::string& root);
+
+// Indexes the regular files below `root` (or `root` itself), reusing what
+// the index at `index_path` already holds. Throws std::runtime_error if the
+// root cannot be read or the index cannot be written, and
+// std::invalid_argument for a block_size of 0; an unreadable or damaged old
+// index is ignored.
+GrepIndexStats update_grep_index(const std::string& root, const std::string& index_path,
+                                 size_t block_size, ThreadPool& pool);
+
+class GrepIndex {
+public:
+    // Maps the index at `path`. Throws std::runtime_error if it cannot be
+    // read or is not a valid index.
+    explicit GrepIndex(const std::string& path);
+
+    // The blocks that can hold `literal`, sorted; call only for literals
+    // of three bytes or more.
+    std::vector<uint32_t> candidates(std::string_view literal) const;
+
+    // The ranges of `data`, the current contents of the file described by
+    // `st`, that a search for a literal with `candidates` has to scan, in
+    // order. False if the index does not cover the file: search all of it.
+    bool ranges(const FileStat& st, std::string_view data,
+                const std::vector<uint32_t>& candidates,
+                std::vector<IndexRange>& out) const;
+
+private:
+    friend GrepIndexStats update_grep_index(const std::string&, const std::string&,
+                                            size_t, ThreadPool&);
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t block_size;
+        uint64_t file_count;
+        uint64_t block_count;
+        uint64_t trigram_count;
+        uint64_t posting_count;
+        uint64_t files_at;
+        uint64_t blocks_at;
+        uint64_t trigrams_at;
+        uint64_t postings_at;
+    };
+
+    struct FileRecord {         // sorted by (dev, ino)
+        uint64_t dev;
+        uint64_t ino;
+        uint64_t size;
+        int64_t mtime_ns;
+        uint64_t indexed_end;
+        uint64_t lines;         // newlines before indexed_end
+        uint64_t tail_hash;
+        uint32_t first_block;
+        uint32_t block_count;
+    };
+
+    struct BlockRecord {
+        uint64_t begin;
+        uint64_t end;
+        uint64_t line_base;
+    };
+
+    struct TrigramRecord {      // sorted by trigram
+        uint32_t trigram;
+        uint32_t count;
+        uint64_t first;         // into the postings: `count` sorted block ids
+    };
+
+    GrepIndex() = default;
+    bool load(const std::string& path, std::string& error);
+
+    const FileRecord* find(uint64_t dev, uint64_t ino) const;
+    const TrigramRecord* find(uint32_t trigram) const;
+
+    // Whether the file behind `r` is as it was indexed, judged by `st`
+    // alone, or has only been appended to since (`data` is its contents).
+    static bool unchanged(const FileRecord& r, const FileStat& st);
+    static bool appended(const FileRecord& r, const FileStat& st, std::string_view data);
+
+    MappedFile file_;
+    const Header* header_ = nullptr;
+    const FileRecord* files_ = nullptr;
+    const BlockRecord* blocks_ = nullptr;
+    const TrigramRecord* trigrams_ = nullptr;
+    const uint32_t* postings_ = nullptr;
+};
@@ -0,0 +1,313 @@
+#include "mapped_file.h"
+#include "common/stats.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// MappedFile
+// ---------------------------------------------------------------------------
+
+MappedFile::~MappedFile() {
+    reset();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        reset();
+        map_ = std::exchange(other.map_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        buffer_ = std::move(other.buffer_);
+        data_ = map_ ? static_cast<const char*>(map_) : buffer_.data();
+        other.data_ = nullptr;
+    }
+    return *this;
+}
+
+void MappedFile::reset() {
+    if (map_)
+        munmap(map_, size_);
+    map_ = nullptr;
+    data_ = nullptr;
+    size_ = 0;
+    buffer_.clear();
+}
+
+int MappedFile::open(const std::string& path) {
+    reset();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return errno;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        return err;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        ::close(fd);
+        return EISDIR;
+    }
+
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                       MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            map_ = p;
+            data_ = static_cast<const char*>(p);
+            size_ = static_cast<size_t>(st.st_size);
+            ::close(fd);
+            stats_syscalls(5);      // open, fstat, mmap, madvise, close
+            stats_bytes(size_);
+            return 0;
+        }
+    }
+
+    // Fallback: pread for seekable files that could not be mapped (procfs,
+    // sysfs), plain read for pipes and sockets.
+    bool seekable = S_ISREG(st.st_mode) || S_ISBLK(st.st_mode);
+    size_t chunk = st.st_size > 0 ? static_cast<size_t>(st.st_size) : 64 * 1024;
+    off_t offset = 0;
+    for (;;) {
+        if (buffer_.size() - static_cast<size_t>(offset) < chunk)
+            buffer_.resize(static_cast<size_t>(offset) + chunk);
+        char* dst = &buffer_[static_cast<size_t>(offset)];
+        size_t room = buffer_.size() - static_cast<size_t>(offset);
+        ssize_t n = seekable ? pread(fd, dst, room, offset) : ::read(fd, dst, room);
+        stats_syscalls();
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int err = errno;
+            ::close(fd);
+            buffer_.clear();
+            return err;
+        }
+        if (n == 0) break;
+        offset += n;
+    }
+    ::close(fd);
+    stats_syscalls(3);              // open, fstat, close
+    stats_bytes(static_cast<uint64_t>(offset));
+
+    buffer_.resize(static_cast<size_t>(offset));
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// LineReader
+// ---------------------------------------------------------------------------
+
+bool LineReader::next(std::string_view& line) {
+    if (pos_ >= data_.size())
+        return false;
+    const char* begin = data_.data() + pos_;
+    size_t remaining = data_.size() - pos_;
+    const char* nl = static_cast<const char*>(std::memchr(begin, '\n', remaining));
+    if (nl) {
+        line = std::string_view(begin, static_cast<size_t>(nl - begin));
+        pos_ += line.size() + 1;
+    } else {
+        line = std::string_view(begin, remaining);
+        pos_ = data_.size();
+    }
+    return true;
+}
+
+std::vector<std::string_view> split_lines(std::string_view data) {
+    std::vector<std::string_view> lines;
+    LineReader reader(data);
+    std::string_view line;
+    while (reader.next(line))
+        lines.push_back(line);
+    return lines;
+}
+
+// ---------------------------------------------------------------------------
+// read_head_lines / read_tail_lines
+// ---------------------------------------------------------------------------
+
+static constexpr size_t kEndBlock = 64 * 1024;
+
+namespace {
+
+// Closes a descriptor on scope exit.
+struct FdCloser {
+    int fd;
+    ~FdCloser() { if (fd >= 0) ::close(fd); }
+};
+
+}  // namespace
+
+static int open_for_read(const std::string& path, struct stat& st) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -errno;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        return -err;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        ::close(fd);
+        return -EISDIR;
+    }
+    stats_syscalls(3);              // open, fstat and the closing close
+    return fd;
+}
+
+// read() that retries on EINTR; returns bytes read, 0 at EOF, -errno on error.
+static ssize_t read_some(int fd, char* dst, size_t len, off_t offset, bool positional) {
+    for (;;) {
+        ssize_t n = positional ? pread(fd, dst, len, offset) : ::read(fd, dst, len);
+        stats_syscalls();
+        if (n > 0)
+            stats_bytes(static_cast<uint64_t>(n));
+        if (n >= 0 || errno != EINTR)
+            return n < 0 ? -errno : n;
+    }
+}
+
+int read_head_lines(const std::string& path, size_t n, std::string& out) {
+    struct stat st;
+    int fd = open_for_read(path, st);
+    if (fd < 0)
+        return -fd;
+    FdCloser closer{fd};
+    if (n == 0)
+        return 0;
+
+    bool seekable = S_ISREG(st.st_mode) || S_ISBLK(st.st_mode);
+    off_t offset = 0;
+    for (;;) {
+        size_t old_size = out.size();
+        out.resize(old_size + kEndBlock);
+        ssize_t got = read_some(fd, &out[old_size], kEndBlock, offset, seekable);
+        if (got <= 0) {
+            out.resize(old_size);
+            return got < 0 ? static_cast<int>(-got) : 0;
+        }
+        offset += got;
+
+        // Count newlines in the new block; stop right after the n-th.
+        const char* p = out.data() + old_size;
+        const char* end = p + got;
+        while (p < end) {
+            const char* nl = static_cast<const char*>(
+                std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (!nl) break;
+            p = nl + 1;
+            if (--n == 0) {
+                out.resize(static_cast<size_t>(p - out.data()));
+                return 0;
+            }
+        }
+        out.resize(old_size + static_cast<size_t>(got));
+    }
+}
+
+int read_tail_lines(const std::string& path, size_t n, std::string& out) {
+    struct stat st;
+    int fd = open_for_read(path, st);
+    if (fd < 0)
+        return -fd;
+    FdCloser closer{fd};
+    if (n == 0)
+        return 0;
+
+    off_t size = S_ISREG(st.st_mode) ? st.st_size : 0;
+    if (size == 0) {
+        // Pipes and procfs files: read forwards from the descriptor already
+        // open (a FIFO must not be opened twice), then pick the tail.
+        bool seekable = S_ISREG(st.st_mode) || S_ISBLK(st.st_mode);
+        std::string buf;
+        off_t offset = 0;
+        for (;;) {
+            size_t old_size = buf.size();
+            buf.resize(old_size + kEndBlock);
+            ssize_t got = read_some(fd, &buf[old_size], kEndBlock, offset, seekable);
+            buf.resize(old_size + static_cast<size_t>(std::max<ssize_t>(got, 0)));
+            if (got < 0)
+                return static_cast<int>(-got);
+            if (got == 0)
+                break;
+            offset += got;
+        }
+        std::string_view data = buf;
+        size_t end = data.size();
+        if (end > 0 && data[end - 1] == '\n') end--;
+        size_t start = 0;
+        while (const char* nl = static_cast<const char*>(memrchr(data.data(), '\n', end))) {
+            end = static_cast<size_t>(nl - data.data());
+            if (--n == 0) { start = end + 1; break; }
+        }
+        out.append(data.substr(start));
+        return 0;
+    }
+
+    // Scan backwards block by block. `pos` is the file offset of block[0].
+    std::string block(kEndBlock, '\0');
+    off_t pos = size;
+    off_t start = 0;
+    bool skip_trailing = true;
+    while (pos > 0) {
+        size_t len = static_cast<size_t>(std::min<off_t>(pos, kEndBlock));
+        pos -= static_cast<off_t>(len);
+        size_t filled = 0;
+        while (filled < len) {
+            ssize_t got = read_some(fd, &block[filled], len - filled,
+                                    pos + static_cast<off_t>(filled), true);
+            if (got < 0) return static_cast<int>(-got);
+            if (got == 0) break;  // file shrank under us
+            filled += static_cast<size_t>(got);
+        }
+        size_t end = filled;
+        if (skip_trailing) {
+            // A newline ending the file does not start another line.
+            if (end > 0 && block[end - 1] == '\n') end--;
+            skip_trailing = false;
+        }
+        const char* nl = nullptr;
+        while (end > 0 && (nl = static_cast<const char*>(memrchr(block.data(), '\n', end)))) {
+            end = static_cast<size_t>(nl - block.data());
+            if (--n == 0) {
+                start = pos + static_cast<off_t>(end) + 1;
+                pos = 0;
+                break;
+            }
+        }
+    }
+
+    // Copy [start, size) forwards.
+    size_t want = static_cast<size_t>(size - start);
+    size_t base = out.size();
+    out.resize(base + want);
+    size_t filled = 0;
+    while (filled < want) {
+        ssize_t got = read_some(fd, &out[base + filled], want - filled,
+                                start + static_cast<off_t>(filled), true);
+        if (got < 0) {
+            out.resize(base);
+            return static_cast<int>(-got);
+        }
+        if (got == 0) break;
+        filled += static_cast<size_t>(got);
+    }
+    out.resize(base + filled);
+    return 0;
+}
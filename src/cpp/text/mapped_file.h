@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// MappedFile — read-only, zero-copy view of a whole file
+//
+// Regular files are mmap'd and advised MADV_SEQUENTIAL, so pages are only
+// faulted in as they are touched. Files that cannot be mapped (pipes,
+// procfs/sysfs entries that report a size of 0, character devices) are read
+// with pread/read into an owned buffer instead. Either way data() stays valid
+// for the lifetime of the object, so callers can hand out string_views into
+// it freely.
+// ---------------------------------------------------------------------------
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Opens and maps `path`. Returns 0 on success or an errno value.
+    int open(const std::string& path);
+
+    std::string_view data() const { return {data_, size_}; }
+    size_t size() const { return size_; }
+    bool is_mapped() const { return map_ != nullptr; }
+
+private:
+    void reset();
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    void* map_ = nullptr;
+    std::string buffer_;
+};
+
+// ---------------------------------------------------------------------------
+// LineReader — iterate the lines of a buffer without copying
+//
+// Follows std::getline semantics: lines are split on '\n', the newline is not
+// part of the line, and a trailing newline does not produce an extra empty
+// line.
+// ---------------------------------------------------------------------------
+
+class LineReader {
+public:
+    explicit LineReader(std::string_view data) : data_(data) {}
+
+    bool next(std::string_view& line);
+
+    // Byte offset of the start of the next line.
+    size_t offset() const { return pos_; }
+
+private:
+    std::string_view data_;
+    size_t pos_ = 0;
+};
+
+// Builds a line index over `data` (one view per line, getline semantics).
+std::vector<std::string_view> split_lines(std::string_view data);
+
+// ---------------------------------------------------------------------------
+// Reading just the ends of a file
+//
+// head and tail only need a few lines of a possibly huge file, so instead of
+// mapping it they read 64 KiB blocks: forwards from the start until `n`
+// lines are complete, or backwards from the end (pread + memrchr) until `n`
+// newlines have been seen. Files that cannot be read backwards (pipes) are
+// read forwards to the end.
+//
+// Both append the selected bytes to `out` as they are on disk (a last line
+// without a newline stays that way) and return 0 or an errno value.
+// ---------------------------------------------------------------------------
+
+// The first `n` lines of `path`.
+int read_head_lines(const std::string& path, size_t n, std::string& out);
+
+// The last `n` lines of `path` (getline semantics: a trailing newline does
+// not start another line).
+int read_tail_lines(const std::string& path, size_t n, std::string& out);
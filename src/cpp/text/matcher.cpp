@@ -0,0 +1,921 @@
+#include "matcher.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <regex>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+size_t Matcher::prefilter(std::string_view, size_t) const {
+    return std::string_view::npos;
+}
+
+size_t count_newlines(const char* begin, size_t len) {
+    return static_cast<size_t>(std::count(begin, begin + len, '\n'));
+}
+
+// ---------------------------------------------------------------------------
+// Character helpers (ECMAScript definitions, bytes only)
+// ---------------------------------------------------------------------------
+
+using ByteSet = std::bitset<256>;
+
+static bool is_word_byte(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+static unsigned char fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + 32) : c;
+}
+
+static ByteSet word_set() {
+    ByteSet s;
+    for (int c = 0; c < 256; c++)
+        if (is_word_byte(static_cast<unsigned char>(c))) s.set(c);
+    return s;
+}
+
+static ByteSet digit_set() {
+    ByteSet s;
+    for (int c = '0'; c <= '9'; c++) s.set(c);
+    return s;
+}
+
+static ByteSet space_set() {
+    ByteSet s;
+    for (char c : std::string(" \t\n\v\f\r")) s.set(static_cast<unsigned char>(c));
+    return s;
+}
+
+static void fold_set(ByteSet& s) {
+    for (int c = 'a'; c <= 'z'; c++) {
+        if (s.test(c) || s.test(c - 32)) {
+            s.set(c);
+            s.set(c - 32);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Literal search
+// ---------------------------------------------------------------------------
+
+// Finds the first byte equal to `a` or `b`.
+static const char* find_byte2(const char* p, const char* end, char a, char b) {
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va),
+                                                  _mm_cmpeq_epi8(chunk, vb)));
+        if (mask)
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        p += 16;
+    }
+#endif
+    for (; p < end; p++)
+        if (*p == a || *p == b) return p;
+    return nullptr;
+}
+
+class LiteralSearcher {
+public:
+    LiteralSearcher() = default;
+    LiteralSearcher(std::string needle, bool icase)
+        : needle_(std::move(needle)), icase_(icase) {
+        if (icase_)
+            for (auto& c : needle_) c = static_cast<char>(fold(static_cast<unsigned char>(c)));
+    }
+
+    size_t size() const { return needle_.size(); }
+    const std::string& needle() const { return needle_; }
+
+    size_t find(std::string_view hay, size_t from) const {
+        if (from > hay.size()) return std::string_view::npos;
+        if (needle_.empty()) return from;
+        const char* begin = hay.data() + from;
+        const char* end = hay.data() + hay.size();
+        if (!icase_) {
+            const void* hit = memmem(begin, static_cast<size_t>(end - begin),
+                                     needle_.data(), needle_.size());
+            return hit ? static_cast<size_t>(static_cast<const char*>(hit) - hay.data())
+                       : std::string_view::npos;
+        }
+        char lo = needle_[0];
+        char hi = (lo >= 'a' && lo <= 'z') ? static_cast<char>(lo - 32) : lo;
+        const char* last = end - needle_.size();
+        for (const char* p = begin; p <= last; p++) {
+            p = find_byte2(p, last + 1, lo, hi);
+            if (!p) break;
+            size_t i = 1;
+            while (i < needle_.size() &&
+                   fold(static_cast<unsigned char>(p[i])) ==
+                       static_cast<unsigned char>(needle_[i]))
+                i++;
+            if (i == needle_.size())
+                return static_cast<size_t>(p - hay.data());
+        }
+        return std::string_view::npos;
+    }
+
+private:
+    std::string needle_;
+    bool icase_ = false;
+};
+
+// ---------------------------------------------------------------------------
+// Literal engine
+// ---------------------------------------------------------------------------
+
+class LiteralMatcher : public Matcher {
+public:
+    LiteralMatcher(const std::string& literal, const MatchOptions& opts)
+        : searcher_(literal, opts.ignore_case), whole_word_(opts.whole_word),
+          literal_(literal) {}
+
+    bool matches(std::string_view line) override {
+        size_t pos = searcher_.find(line, 0);
+        if (!whole_word_)
+            return pos != std::string_view::npos;
+        // Same boundaries "\b" would enforce around the literal.
+        for (; pos != std::string_view::npos; pos = searcher_.find(line, pos + 1)) {
+            if (boundary(line, pos) && boundary(line, pos + literal_.size()))
+                return true;
+        }
+        return false;
+    }
+
+    size_t prefilter(std::string_view text, size_t from) const override {
+        return searcher_.find(text, from);
+    }
+    bool has_prefilter() const override { return !literal_.empty(); }
+    std::string_view literal() const override { return searcher_.needle(); }
+
+    std::unique_ptr<Matcher> clone() const override {
+        return std::make_unique<LiteralMatcher>(*this);
+    }
+    const char* engine() const override { return "literal"; }
+
+private:
+    static bool boundary(std::string_view s, size_t pos) {
+        bool before = pos > 0 && is_word_byte(static_cast<unsigned char>(s[pos - 1]));
+        bool after = pos < s.size() && is_word_byte(static_cast<unsigned char>(s[pos]));
+        return before != after;
+    }
+
+    LiteralSearcher searcher_;
+    bool whole_word_;
+    std::string literal_;
+};
+
+// ---------------------------------------------------------------------------
+// std::regex engine (fallback)
+// ---------------------------------------------------------------------------
+
+class StdRegexMatcher : public Matcher {
+public:
+    StdRegexMatcher(const std::string& pattern, bool icase) {
+        auto flags = std::regex_constants::ECMAScript;
+        if (icase)
+            flags |= std::regex_constants::icase;
+        re_ = std::make_shared<const std::regex>(pattern, flags);
+    }
+
+    bool matches(std::string_view line) override {
+        return std::regex_search(line.begin(), line.end(), *re_);
+    }
+
+    std::unique_ptr<Matcher> clone() const override {
+        return std::make_unique<StdRegexMatcher>(*this);
+    }
+    const char* engine() const override { return "std::regex"; }
+
+private:
+    std::shared_ptr<const std::regex> re_;
+};
+
+// ---------------------------------------------------------------------------
+// Regex parser — ECMAScript subset to AST
+// ---------------------------------------------------------------------------
+
+namespace {
+
+struct Unsupported {};  // thrown for syntax handed to std::regex instead
+
+enum class NodeKind { Empty, Set, Assert, Concat, Alt, Repeat };
+enum AssertKind : uint8_t { kBol, kEol, kWordB, kNotWordB };
+
+struct Node {
+    NodeKind kind = NodeKind::Empty;
+    ByteSet set;
+    AssertKind assertion = kBol;
+    std::vector<Node> children;
+    int min = 0, max = 0;  // Repeat; max < 0 means unbounded
+};
+
+class Parser {
+public:
+    Parser(const std::string& p, bool icase) : p_(p), icase_(icase) {}
+
+    Node parse() {
+        Node n = parse_alt();
+        if (pos_ != p_.size()) throw Unsupported{};
+        return n;
+    }
+
+private:
+    bool eof() const { return pos_ >= p_.size(); }
+    char peek() const { return p_[pos_]; }
+
+    Node parse_alt() {
+        Node first = parse_concat();
+        if (eof() || peek() != '|') return first;
+        Node alt;
+        alt.kind = NodeKind::Alt;
+        alt.children.push_back(std::move(first));
+        while (!eof() && peek() == '|') {
+            pos_++;
+            alt.children.push_back(parse_concat());
+        }
+        return alt;
+    }
+
+    Node parse_concat() {
+        Node cat;
+        cat.kind = NodeKind::Concat;
+        while (!eof() && peek() != '|' && peek() != ')')
+            cat.children.push_back(parse_repeat());
+        return cat;
+    }
+
+    bool parse_int(int& out) {
+        size_t start = pos_;
+        long v = 0;
+        while (!eof() && peek() >= '0' && peek() <= '9') {
+            v = v * 10 + (peek() - '0');
+            if (v > 100000) throw Unsupported{};
+            pos_++;
+        }
+        out = static_cast<int>(v);
+        return pos_ > start;
+    }
+
+    Node parse_repeat() {
+        Node atom = parse_atom();
+        if (eof()) return atom;
+        int mn, mx;
+        char c = peek();
+        if (c == '*')      { mn = 0; mx = -1; pos_++; }
+        else if (c == '+') { mn = 1; mx = -1; pos_++; }
+        else if (c == '?') { mn = 0; mx = 1;  pos_++; }
+        else if (c == '{') {
+            pos_++;
+            if (!parse_int(mn)) throw Unsupported{};
+            mx = mn;
+            if (!eof() && peek() == ',') {
+                pos_++;
+                if (!parse_int(mx)) mx = -1;
+            }
+            if (eof() || peek() != '}') throw Unsupported{};
+            pos_++;
+            if (mx >= 0 && mx < mn) throw Unsupported{};
+        } else {
+            return atom;
+        }
+        if (atom.kind == NodeKind::Assert) throw Unsupported{};
+        if (!eof() && peek() == '?') pos_++;  // lazy: same match/no-match answer
+        if (!eof() && (peek() == '*' || peek() == '+' || peek() == '?' || peek() == '{'))
+            throw Unsupported{};
+        Node rep;
+        rep.kind = NodeKind::Repeat;
+        rep.min = mn;
+        rep.max = mx;
+        rep.children.push_back(std::move(atom));
+        return rep;
+    }
+
+    Node make_set(ByteSet s) {
+        if (icase_) fold_set(s);
+        Node n;
+        n.kind = NodeKind::Set;
+        n.set = s;
+        return n;
+    }
+
+    Node make_assert(AssertKind k) {
+        Node n;
+        n.kind = NodeKind::Assert;
+        n.assertion = k;
+        return n;
+    }
+
+    int hex_value(size_t digits) {
+        if (pos_ + digits > p_.size()) throw Unsupported{};
+        int v = 0;
+        for (size_t i = 0; i < digits; i++) {
+            char h = p_[pos_++];
+            v <<= 4;
+            if (h >= '0' && h <= '9') v |= h - '0';
+            else if (h >= 'a' && h <= 'f') v |= h - 'a' + 10;
+            else if (h >= 'A' && h <= 'F') v |= h - 'A' + 10;
+            else throw Unsupported{};
+        }
+        return v;
+    }
+
+    // Parses the escape after a backslash. Returns true and fills `set` for
+    // class escapes; otherwise returns false and stores the byte in `byte`.
+    bool parse_escape(bool in_class, ByteSet& set, unsigned char& byte) {
+        if (eof()) throw Unsupported{};
+        char c = p_[pos_++];
+        switch (c) {
+            case 'd': set = digit_set(); return true;
+            case 'D': set = ~digit_set(); return true;
+            case 'w': set = word_set(); return true;
+            case 'W': set = ~word_set(); return true;
+            case 's': set = space_set(); return true;
+            case 'S': set = ~space_set(); return true;
+            case 't': byte = '\t'; return false;
+            case 'n': byte = '\n'; return false;
+            case 'r': byte = '\r'; return false;
+            case 'f': byte = '\f'; return false;
+            case 'v': byte = '\v'; return false;
+            case '0': byte = 0; return false;
+            case 'x': byte = static_cast<unsigned char>(hex_value(2)); return false;
+            case 'u': {
+                int v = hex_value(4);
+                if (v > 0xFF) throw Unsupported{};
+                byte = static_cast<unsigned char>(v);
+                return false;
+            }
+            case 'c': {
+                if (eof()) throw Unsupported{};
+                char l = p_[pos_++];
+                if (!((l >= 'a' && l <= 'z') || (l >= 'A' && l <= 'Z'))) throw Unsupported{};
+                byte = static_cast<unsigned char>(l % 32);
+                return false;
+            }
+            case 'b':
+                if (in_class) { byte = '\b'; return false; }
+                throw Unsupported{};  // handled by the caller outside classes
+            default:
+                if (c >= '1' && c <= '9') throw Unsupported{};  // backreference
+                byte = static_cast<unsigned char>(c);
+                return false;
+        }
+    }
+
+    Node parse_class() {
+        // Called after '['
+        bool negate = false;
+        if (!eof() && peek() == '^') { negate = true; pos_++; }
+        if (!eof() && peek() == ']') throw Unsupported{};  // "[]" / "[^]" quirks
+        ByteSet set;
+        while (true) {
+            if (eof()) throw Unsupported{};
+            char c = p_[pos_++];
+            if (c == ']') break;
+            ByteSet esc_set;
+            unsigned char lo;
+            bool is_set = false;
+            if (c == '\\') {
+                is_set = parse_escape(true, esc_set, lo);
+            } else if (c == '[' && !eof() && (peek() == ':' || peek() == '=' || peek() == '.')) {
+                throw Unsupported{};  // POSIX bracket expressions
+            } else {
+                lo = static_cast<unsigned char>(c);
+            }
+            if (is_set) {
+                if (!eof() && peek() == '-' && pos_ + 1 < p_.size() && p_[pos_ + 1] != ']')
+                    throw Unsupported{};
+                set |= esc_set;
+                continue;
+            }
+            if (!eof() && peek() == '-' && pos_ + 1 < p_.size() && p_[pos_ + 1] != ']') {
+                pos_++;
+                char hc = p_[pos_++];
+                unsigned char hi;
+                if (hc == '\\') {
+                    ByteSet tmp;
+                    if (parse_escape(true, tmp, hi)) throw Unsupported{};
+                } else {
+                    hi = static_cast<unsigned char>(hc);
+                }
+                if (hi < lo) throw Unsupported{};
+                for (int b = lo; b <= hi; b++) set.set(b);
+            } else {
+                set.set(lo);
+            }
+        }
+        if (icase_) fold_set(set);
+        if (negate) set = ~set;
+        Node n;
+        n.kind = NodeKind::Set;
+        n.set = set;
+        return n;
+    }
+
+    Node parse_atom() {
+        char c = p_[pos_++];
+        switch (c) {
+            case '(': {
+                if (!eof() && peek() == '?') {
+                    if (pos_ + 1 < p_.size() && p_[pos_ + 1] == ':') pos_ += 2;
+                    else throw Unsupported{};  // lookahead
+                }
+                Node inner = parse_alt();
+                if (eof() || peek() != ')') throw Unsupported{};
+                pos_++;
+                return inner;
+            }
+            case '[':
+                return parse_class();
+            case '.': {
+                ByteSet s;
+                s.set();
+                s.reset('\n');
+                s.reset('\r');
+                return make_set(s);
+            }
+            case '^': return make_assert(kBol);
+            case '$': return make_assert(kEol);
+            case '\\': {
+                if (!eof() && peek() == 'b') { pos_++; return make_assert(kWordB); }
+                if (!eof() && peek() == 'B') { pos_++; return make_assert(kNotWordB); }
+                ByteSet s;
+                unsigned char b;
+                if (parse_escape(false, s, b)) return make_set(s);
+                ByteSet one;
+                one.set(b);
+                return make_set(one);
+            }
+            case ')': case '*': case '+': case '?': case '{':
+                throw Unsupported{};
+            default: {
+                ByteSet one;
+                one.set(static_cast<unsigned char>(c));
+                return make_set(one);
+            }
+        }
+    }
+
+    const std::string& p_;
+    bool icase_;
+    size_t pos_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Required-literal extraction for the prefilter
+// ---------------------------------------------------------------------------
+
+struct LiteralInfo {
+    bool exact = false;   // node matches exactly `text`
+    std::string text;     // exact text, or the best required substring
+};
+
+// True if `s` matches exactly one byte (or, under icase, one letter in
+// either case); stores that byte, lowercased, in `out`.
+static bool single_byte(const ByteSet& s, bool icase, unsigned char& out) {
+    size_t n = s.count();
+    if (n == 0 || n > 2) return false;
+    int first = -1;
+    for (int c = 0; c < 256 && first < 0; c++)
+        if (s.test(c)) first = c;
+    if (n == 1) {
+        out = static_cast<unsigned char>(first);
+        return true;
+    }
+    if (icase && first >= 'A' && first <= 'Z' && s.test(first + 32)) {
+        out = static_cast<unsigned char>(first + 32);
+        return true;
+    }
+    return false;
+}
+
+static LiteralInfo required_literal(const Node& n, bool icase) {
+    constexpr size_t kMaxLiteral = 64;
+    LiteralInfo info;
+    switch (n.kind) {
+        case NodeKind::Empty:
+        case NodeKind::Assert:
+            info.exact = true;
+            return info;
+        case NodeKind::Set: {
+            unsigned char b;
+            if (single_byte(n.set, icase, b)) {
+                info.exact = true;
+                info.text.assign(1, static_cast<char>(b));
+            }
+            return info;
+        }
+        case NodeKind::Concat: {
+            std::string run, best;
+            bool all_exact = true;
+            for (const auto& child : n.children) {
+                LiteralInfo ci = required_literal(child, icase);
+                if (ci.exact && run.size() + ci.text.size() <= kMaxLiteral) {
+                    run += ci.text;
+                    continue;
+                }
+                all_exact = false;
+                if (run.size() > best.size()) best = run;
+                run = ci.exact ? ci.text : std::string();
+                if (!ci.exact && ci.text.size() > best.size()) best = ci.text;
+            }
+            if (all_exact) {
+                info.exact = true;
+                info.text = run;
+            } else {
+                info.text = run.size() > best.size() ? run : best;
+            }
+            return info;
+        }
+        case NodeKind::Alt:
+            return info;
+        case NodeKind::Repeat: {
+            if (n.min == 0) return info;
+            LiteralInfo ci = required_literal(n.children[0], icase);
+            if (ci.exact && n.min == 1 && n.max == 1) return ci;
+            info.text = ci.text;
+            return info;
+        }
+    }
+    return info;
+}
+
+// ---------------------------------------------------------------------------
+// NFA program
+// ---------------------------------------------------------------------------
+
+enum class Op : uint8_t { Set, Split, Jmp, Assert, Match };
+
+struct Inst {
+    Op op;
+    AssertKind assertion = kBol;
+    int x = 0, y = 0;  // Split targets / Jmp target; Set: index into sets
+};
+
+class Compiler {
+public:
+    static constexpr size_t kMaxProgram = 20000;
+
+    std::vector<Inst> prog;
+    std::vector<ByteSet> sets;
+
+    void emit(const Node& n) {
+        if (prog.size() > kMaxProgram) throw Unsupported{};
+        switch (n.kind) {
+            case NodeKind::Empty:
+                return;
+            case NodeKind::Set: {
+                Inst i{Op::Set};
+                i.x = static_cast<int>(sets.size());
+                sets.push_back(n.set);
+                prog.push_back(i);
+                return;
+            }
+            case NodeKind::Assert: {
+                Inst i{Op::Assert};
+                i.assertion = n.assertion;
+                prog.push_back(i);
+                return;
+            }
+            case NodeKind::Concat:
+                for (const auto& c : n.children) emit(c);
+                return;
+            case NodeKind::Alt: {
+                std::vector<size_t> jumps;
+                for (size_t k = 0; k < n.children.size(); k++) {
+                    if (k + 1 < n.children.size()) {
+                        size_t split = prog.size();
+                        prog.push_back(Inst{Op::Split});
+                        prog[split].x = static_cast<int>(prog.size());
+                        emit(n.children[k]);
+                        jumps.push_back(prog.size());
+                        prog.push_back(Inst{Op::Jmp});
+                        prog[split].y = static_cast<int>(prog.size());
+                    } else {
+                        emit(n.children[k]);
+                    }
+                }
+                for (size_t j : jumps) prog[j].x = static_cast<int>(prog.size());
+                return;
+            }
+            case NodeKind::Repeat: {
+                const Node& child = n.children[0];
+                for (int k = 0; k < n.min; k++) emit(child);
+                if (n.max < 0) {
+                    size_t split = prog.size();
+                    prog.push_back(Inst{Op::Split});
+                    prog[split].x = static_cast<int>(prog.size());
+                    emit(child);
+                    Inst j{Op::Jmp};
+                    j.x = static_cast<int>(split);
+                    prog.push_back(j);
+                    prog[split].y = static_cast<int>(prog.size());
+                } else {
+                    std::vector<size_t> splits;
+                    for (int k = n.min; k < n.max; k++) {
+                        splits.push_back(prog.size());
+                        prog.push_back(Inst{Op::Split});
+                        prog.back().x = static_cast<int>(prog.size());
+                        emit(child);
+                    }
+                    for (size_t s : splits) prog[s].y = static_cast<int>(prog.size());
+                }
+                return;
+            }
+        }
+    }
+};
+
+static bool anchored_at_start(const Node& n) {
+    if (n.kind == NodeKind::Assert) return n.assertion == kBol;
+    if (n.kind == NodeKind::Concat)
+        return !n.children.empty() && anchored_at_start(n.children[0]);
+    if (n.kind == NodeKind::Alt) {
+        for (const auto& c : n.children)
+            if (!anchored_at_start(c)) return false;
+        return !n.children.empty();
+    }
+    return false;
+}
+
+// Immutable compiled program shared by all clones of a DfaMatcher.
+struct Program {
+    std::vector<Inst> insts;
+    std::vector<ByteSet> sets;
+    bool anchored = false;
+    bool uses_word = false;
+    uint8_t byte_class[256];
+    std::vector<unsigned char> class_rep;  // representative byte per class
+    LiteralSearcher prefilter;
+    bool has_prefilter = false;
+};
+
+// ---------------------------------------------------------------------------
+// Lazy DFA
+//
+// A DFA state is the set of NFA instructions reached right after consuming a
+// byte (the "kernel"), plus what the previous byte was (line start, word
+// byte, other byte) so ^ and \b can be decided during the epsilon closure
+// once the next byte is known. Transitions are computed on first use and
+// cached per byte class; the cache is flushed if it grows too large.
+// ---------------------------------------------------------------------------
+
+class DfaMatcher : public Matcher {
+public:
+    explicit DfaMatcher(std::shared_ptr<const Program> prog)
+        : prog_(std::move(prog)) {
+        stride_ = prog_->class_rep.size() + 1;  // + end-of-line column
+        mark_.assign(prog_->insts.size(), 0);
+        reset_cache();
+    }
+
+    bool matches(std::string_view line) override {
+        const Program& p = *prog_;
+        int s = start_;
+        for (unsigned char c : line) {
+            int t = table_[static_cast<size_t>(s) * stride_ + p.byte_class[c]];
+            if (t < 0) {
+                if (t == kMatch) return true;
+                if (t == kDead) return false;
+                t = compute(s, p.byte_class[c]);
+                if (t == kMatch) return true;
+                if (t == kDead) return false;
+            }
+            s = t;
+        }
+        int t = table_[static_cast<size_t>(s) * stride_ + stride_ - 1];
+        if (t == kUnknown) t = compute(s, static_cast<int>(stride_ - 1));
+        return t == kMatch;
+    }
+
+    size_t prefilter(std::string_view text, size_t from) const override {
+        return prog_->prefilter.find(text, from);
+    }
+    bool has_prefilter() const override { return prog_->has_prefilter; }
+    std::string_view literal() const override {
+        return prog_->has_prefilter ? std::string_view(prog_->prefilter.needle())
+                                    : std::string_view();
+    }
+
+    std::unique_ptr<Matcher> clone() const override {
+        return std::make_unique<DfaMatcher>(prog_);
+    }
+    const char* engine() const override { return "dfa"; }
+
+private:
+    static constexpr int kUnknown = -1;
+    static constexpr int kMatch = -2;
+    static constexpr int kDead = -3;
+    static constexpr size_t kMaxStates = 4096;
+
+    enum Prev : uint8_t { kPrevStart, kPrevWord, kPrevOther };
+
+    struct State {
+        Prev prev;
+        std::vector<int> kernel;
+    };
+
+    void reset_cache() {
+        states_.clear();
+        index_.clear();
+        table_.clear();
+        start_ = intern(kPrevStart, {});
+    }
+
+    int intern(Prev prev, std::vector<int> kernel) {
+        std::string key(1, static_cast<char>(prev));
+        key.append(reinterpret_cast<const char*>(kernel.data()),
+                   kernel.size() * sizeof(int));
+        auto it = index_.find(key);
+        if (it != index_.end()) return it->second;
+        int id = static_cast<int>(states_.size());
+        states_.push_back({prev, std::move(kernel)});
+        index_.emplace(std::move(key), id);
+        table_.resize(states_.size() * stride_, kUnknown);
+        return id;
+    }
+
+    // Epsilon closure of `pcs` given the previous byte and the next byte
+    // (next < 0 means end of line). Returns true if Match is reachable.
+    bool closure(const std::vector<int>& pcs, Prev prev, int next,
+                 std::vector<int>& out) {
+        const Program& p = *prog_;
+        if (++gen_ == 0) {
+            std::fill(mark_.begin(), mark_.end(), 0);
+            gen_ = 1;
+        }
+        bool prev_word = prev == kPrevWord;
+        bool next_word = next >= 0 && is_word_byte(static_cast<unsigned char>(next));
+        stack_.assign(pcs.rbegin(), pcs.rend());
+        bool matched = false;
+        while (!stack_.empty()) {
+            int pc = stack_.back();
+            stack_.pop_back();
+            if (pc >= static_cast<int>(p.insts.size())) continue;
+            if (mark_[pc] == gen_) continue;
+            mark_[pc] = gen_;
+            const Inst& in = p.insts[pc];
+            switch (in.op) {
+                case Op::Match:
+                    matched = true;
+                    break;
+                case Op::Set:
+                    out.push_back(pc);
+                    break;
+                case Op::Jmp:
+                    stack_.push_back(in.x);
+                    break;
+                case Op::Split:
+                    stack_.push_back(in.y);
+                    stack_.push_back(in.x);
+                    break;
+                case Op::Assert: {
+                    bool ok = false;
+                    switch (in.assertion) {
+                        case kBol:      ok = prev == kPrevStart; break;
+                        case kEol:      ok = next < 0; break;
+                        case kWordB:    ok = prev_word != next_word; break;
+                        case kNotWordB: ok = prev_word == next_word; break;
+                    }
+                    if (ok) stack_.push_back(pc + 1);
+                    break;
+                }
+            }
+        }
+        return matched;
+    }
+
+    int compute(int s, int cls) {
+        const Program& p = *prog_;
+        if (states_.size() >= kMaxStates) {
+            // Keep memory bounded: restart the cache from the current state.
+            State cur = states_[s];
+            reset_cache();
+            s = intern(cur.prev, std::move(cur.kernel));
+        }
+        const State& st = states_[s];
+        bool at_end = cls == static_cast<int>(stride_ - 1);
+        int next = at_end ? -1 : p.class_rep[cls];
+
+        std::vector<int> seeds = st.kernel;
+        if (!p.anchored || st.prev == kPrevStart)
+            seeds.push_back(0);
+
+        std::vector<int> active;
+        bool matched = closure(seeds, st.prev, next, active);
+
+        int result;
+        if (matched) {
+            result = kMatch;
+        } else if (at_end) {
+            result = kDead;
+        } else {
+            std::vector<int> kernel;
+            for (int pc : active) {
+                const Inst& in = p.insts[pc];
+                if (p.sets[in.x].test(static_cast<unsigned char>(next)))
+                    kernel.push_back(pc + 1);
+            }
+            std::sort(kernel.begin(), kernel.end());
+            kernel.erase(std::unique(kernel.begin(), kernel.end()), kernel.end());
+            if (kernel.empty() && p.anchored) {
+                result = kDead;
+            } else {
+                Prev np = kPrevOther;
+                if (p.uses_word && is_word_byte(static_cast<unsigned char>(next)))
+                    np = kPrevWord;
+                result = intern(np, std::move(kernel));
+            }
+        }
+        table_[static_cast<size_t>(s) * stride_ + cls] = result;
+        return result;
+    }
+
+    std::shared_ptr<const Program> prog_;
+    size_t stride_;
+    std::vector<State> states_;
+    std::unordered_map<std::string, int> index_;
+    std::vector<int> table_;
+    int start_ = 0;
+
+    std::vector<uint32_t> mark_;
+    uint32_t gen_ = 0;
+    std::vector<int> stack_;
+};
+
+static bool node_uses_word(const Node& n) {
+    if (n.kind == NodeKind::Assert)
+        return n.assertion == kWordB || n.assertion == kNotWordB;
+    for (const auto& c : n.children)
+        if (node_uses_word(c)) return true;
+    return false;
+}
+
+static std::shared_ptr<const Program> build_program(const Node& root, bool icase) {
+    auto prog = std::make_shared<Program>();
+    Compiler comp;
+    comp.emit(root);
+    comp.prog.push_back(Inst{Op::Match});
+    prog->insts = std::move(comp.prog);
+    prog->sets = std::move(comp.sets);
+    prog->anchored = anchored_at_start(root);
+    prog->uses_word = node_uses_word(root);
+
+    // Partition bytes into classes that no instruction can tell apart.
+    std::vector<ByteSet> splitters = prog->sets;
+    if (prog->uses_word) splitters.push_back(word_set());
+    std::map<std::vector<bool>, int> classes;
+    for (int c = 0; c < 256; c++) {
+        std::vector<bool> sig;
+        sig.reserve(splitters.size());
+        for (const auto& s : splitters) sig.push_back(s.test(c));
+        auto it = classes.find(sig);
+        if (it == classes.end()) {
+            it = classes.emplace(sig, static_cast<int>(prog->class_rep.size())).first;
+            prog->class_rep.push_back(static_cast<unsigned char>(c));
+        }
+        prog->byte_class[c] = static_cast<uint8_t>(it->second);
+    }
+
+    LiteralInfo lit = required_literal(root, icase);
+    if (lit.text.size() >= 2) {
+        prog->prefilter = LiteralSearcher(lit.text, icase);
+        prog->has_prefilter = true;
+    }
+    return prog;
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// Engine selection
+// ---------------------------------------------------------------------------
+
+static bool has_metachar(const std::string& s) {
+    return s.find_first_of("\\^$.|?*+()[]{}") != std::string::npos;
+}
+
+std::unique_ptr<Matcher> compile_matcher(const std::string& pattern,
+                                         const MatchOptions& opts) {
+    if (opts.fixed_strings || !has_metachar(pattern))
+        return std::make_unique<LiteralMatcher>(pattern, opts);
+
+    std::string full = opts.whole_word ? "\\b(?:" + pattern + ")\\b" : pattern;
+    try {
+        Node root = Parser(full, opts.ignore_case).parse();
+        return std::make_unique<DfaMatcher>(build_program(root, opts.ignore_case));
+    } catch (const Unsupported&) {
+        return std::make_unique<StdRegexMatcher>(full, opts.ignore_case);
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// ---------------------------------------------------------------------------
+// Matcher — line matching engines behind grep
+//
+// compile_matcher() picks the cheapest engine that can handle a pattern:
+//
+//   literal     fixed_strings=True, or a pattern without metacharacters.
+//               memmem / SIMD byte scan, no per-line state.
+//   dfa         ECMAScript regexes without backreferences or lookahead.
+//               A Thompson NFA executed as a lazily built DFA, so matching
+//               is linear in the line length and never recurses. Patterns
+//               that require a literal substring expose it as a prefilter.
+//   std::regex  Everything else (backreferences, lookahead, odd syntax),
+//               so existing patterns keep working.
+//
+// Matchers carry mutable caches and are not thread-safe; give each thread
+// its own clone().
+// ---------------------------------------------------------------------------
+
+struct MatchOptions {
+    bool ignore_case = false;
+    bool whole_word = false;
+    bool fixed_strings = false;
+};
+
+class Matcher {
+public:
+    virtual ~Matcher() = default;
+
+    // True if `line` contains a match (search semantics, like regex_search).
+    virtual bool matches(std::string_view line) = 0;
+
+    // Offset of the next occurrence of a literal every match must contain,
+    // searching `text` from `from`; npos if there is none. Only meaningful
+    // when has_prefilter() is true.
+    virtual size_t prefilter(std::string_view text, size_t from) const;
+    virtual bool has_prefilter() const { return false; }
+
+    // The literal behind prefilter() (ASCII-lowercased under ignore_case);
+    // empty when there is none.
+    virtual std::string_view literal() const { return {}; }
+
+    virtual std::unique_ptr<Matcher> clone() const = 0;
+
+    // Engine name, for diagnostics: "literal", "dfa" or "std::regex".
+    virtual const char* engine() const = 0;
+};
+
+// Compiles `pattern` (ECMAScript syntax unless fixed_strings is set).
+// Throws std::regex_error if the pattern is invalid.
+std::unique_ptr<Matcher> compile_matcher(const std::string& pattern,
+                                         const MatchOptions& opts);
+
+// Number of '\n' bytes in [begin, begin + len).
+size_t count_newlines(const char* begin, size_t len);
+
+// ---------------------------------------------------------------------------
+// scan_lines — visit the selected lines of a buffer in order
+//
+// Calls on_line(line_number, line) for every line of `data` that matches
+// (or, with invert, does not match). on_line returns false to stop early.
+// Lines follow std::getline semantics. When the matcher has a literal
+// prefilter, stretches of the buffer that cannot contain a match are skipped
+// without being split into lines.
+// ---------------------------------------------------------------------------
+
+template <typename Fn>
+void scan_lines(Matcher& m, std::string_view data, bool invert, Fn&& on_line) {
+    const char* base = data.data();
+    size_t size = data.size();
+    size_t pos = 0;
+    size_t line_no = 1;
+
+    if (!invert && m.has_prefilter()) {
+        while (pos < size) {
+            size_t cand = m.prefilter(data, pos);
+            if (cand == std::string_view::npos || cand >= size)
+                return;
+            const char* prev_nl = static_cast<const char*>(
+                memrchr(base + pos, '\n', cand - pos));
+            size_t start = prev_nl ? static_cast<size_t>(prev_nl - base) + 1 : pos;
+            line_no += count_newlines(base + pos, start - pos);
+            const char* nl = static_cast<const char*>(
+                std::memchr(base + cand, '\n', size - cand));
+            size_t end = nl ? static_cast<size_t>(nl - base) : size;
+            std::string_view line(base + start, end - start);
+            if (m.matches(line) && !on_line(line_no, line))
+                return;
+            pos = end + 1;
+            line_no++;
+        }
+        return;
+    }
+
+    while (pos < size) {
+        const char* nl = static_cast<const char*>(
+            std::memchr(base + pos, '\n', size - pos));
+        size_t end = nl ? static_cast<size_t>(nl - base) : size;
+        std::string_view line(base + pos, end - pos);
+        if (m.matches(line) != invert && !on_line(line_no, line))
+            return;
+        pos = end + 1;
+        line_no++;
+    }
+}
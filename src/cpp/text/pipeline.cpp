@@ -0,0 +1,502 @@
+#include "pipeline.h"
+#include "fields.h"
+#include "mapped_file.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+namespace {
+
+constexpr size_t kBatchBytes = 256 * 1024;
+
+// Views every line of `b.storage` (each ending in '\n').
+void index_storage(LineBatch& b) {
+    b.text = b.storage;
+    const char* p = b.storage.data();
+    const char* end = p + b.storage.size();
+    while (p < end) {
+        auto* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        const char* stop = nl ? nl : end;
+        b.lines.emplace_back(p, static_cast<size_t>(stop - p));
+        p = stop + 1;
+    }
+}
+
+// A batch of views into `in`, which it keeps alive.
+std::shared_ptr<LineBatch> derived(const BatchPtr& in) {
+    auto out = std::make_shared<LineBatch>();
+    out->stable = in->stable;
+    if (!in->stable)
+        out->parent = in;
+    return out;
+}
+
+std::string quoted(const std::string& s) {
+    std::string out = "'";
+    for (char c : s) {
+        if (c == '\'' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out + "'";
+}
+
+// Cuts `input` into batches of whole lines; stops when `emit` returns false.
+void cut_batches(std::string_view input, const BatchEmit& emit) {
+    const char* base = input.data();
+    size_t size = input.size();
+    size_t pos = 0;
+    while (pos < size) {
+        size_t end = pos + kBatchBytes;
+        if (end >= size) {
+            end = size;
+        } else {
+            auto* nl = static_cast<const char*>(std::memchr(base + end, '\n', size - end));
+            end = nl ? static_cast<size_t>(nl - base) + 1 : size;
+        }
+        auto batch = std::make_shared<LineBatch>();
+        batch->text = input.substr(pos, end - pos);
+        batch->stable = true;
+        LineReader reader(batch->text);
+        std::string_view line;
+        while (reader.next(line))
+            batch->lines.push_back(line);
+        if (!emit(std::move(batch)))
+            return;
+        pos = end;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Stages
+// ---------------------------------------------------------------------------
+
+class GrepStage : public PipelineStage {
+public:
+    GrepStage(std::string pattern, std::unique_ptr<Matcher> matcher, bool invert)
+        : pattern_(std::move(pattern)), matcher_(std::move(matcher)), invert_(invert) {}
+
+    std::unique_ptr<PipelineStage> fresh() const override {
+        return std::make_unique<GrepStage>(pattern_, matcher_->clone(), invert_);
+    }
+
+    bool push(const BatchPtr& in, const BatchEmit& emit) override {
+        auto out = derived(in);
+        if (!in->text.empty()) {
+            // Whole lines of one buffer: the prefilter can skip through it.
+            scan_lines(*matcher_, in->text, invert_, [&](size_t, std::string_view line) {
+                out->lines.push_back(line);
+                return true;
+            });
+        } else {
+            for (auto line : in->lines)
+                if (matcher_->matches(line) != invert_)
+                    out->lines.push_back(line);
+        }
+        if (out->lines.empty())
+            return true;
+        if (out->lines.size() == in->lines.size())
+            return emit(in);
+        return emit(std::move(out));
+    }
+
+    std::string describe() const override {
+        return "grep(" + quoted(pattern_) + (invert_ ? ", invert=True)" : ")");
+    }
+
+private:
+    std::string pattern_;
+    std::unique_ptr<Matcher> matcher_;
+    bool invert_;
+};
+
+class CutStage : public PipelineStage {
+public:
+    CutStage(std::string spec, std::vector<FieldRange> ranges, std::string delimiter)
+        : spec_(std::move(spec)), ranges_(std::move(ranges)), delimiter_(std::move(delimiter)) {}
+
+    std::unique_ptr<PipelineStage> fresh() const override {
+        return std::make_unique<CutStage>(spec_, ranges_, delimiter_);
+    }
+
+    bool push(const BatchPtr& in, const BatchEmit& emit) override {
+        auto out = std::make_shared<LineBatch>();
+        std::string& buf = out->storage;
+        buf.reserve(in->text.empty() ? in->lines.size() * 16 : in->text.size());
+        FieldSplitter splitter(delimiter_);
+        for (auto line : in->lines) {
+            bool first = true;
+            select_fields(splitter, line, ranges_, [&](std::string_view token) {
+                if (!first) buf += delimiter_;
+                buf.append(token.data(), token.size());
+                first = false;
+            });
+            buf += '\n';
+        }
+        index_storage(*out);
+        return out->lines.empty() || emit(std::move(out));
+    }
+
+    std::string describe() const override {
+        return "cut(" + quoted(spec_) + ", " + quoted(delimiter_) + ")";
+    }
+
+private:
+    std::string spec_;
+    std::vector<FieldRange> ranges_;
+    std::string delimiter_;
+};
+
+class SortStage : public PipelineStage {
+public:
+    explicit SortStage(const SortOptions& opts) : opts_(opts) {}
+
+    std::unique_ptr<PipelineStage> fresh() const override {
+        return std::make_unique<SortStage>(opts_);
+    }
+
+    bool push(const BatchPtr& in, const BatchEmit&) override {
+        // Consecutive source batches are one stretch of the mapped file:
+        // remember its extent instead of copying it.
+        if (!copying_ && in->stable && !in->text.empty() &&
+            (span_.empty() || in->text.data() == span_.data() + span_.size())) {
+            span_ = std::string_view(span_.empty() ? in->text.data() : span_.data(),
+                                     span_.size() + in->text.size());
+            return true;
+        }
+        if (!copying_) {
+            copying_ = true;
+            buffer_.assign(span_.data(), span_.size());
+            if (!buffer_.empty() && buffer_.back() != '\n')
+                buffer_ += '\n';
+        }
+        for (auto line : in->lines) {
+            buffer_.append(line.data(), line.size());
+            buffer_ += '\n';
+        }
+        return true;
+    }
+
+    void finish(const BatchEmit& emit) override {
+        bool wanted = true;
+        sort_lines(copying_ ? std::string_view(buffer_) : span_, opts_,
+                   [&](std::string_view block) {
+                       if (!wanted)
+                           return;
+                       auto out = std::make_shared<LineBatch>();
+                       out->storage.assign(block.data(), block.size());
+                       index_storage(*out);
+                       wanted = emit(std::move(out));
+                   });
+        buffer_ = std::string();
+    }
+
+    std::string describe() const override {
+        std::string args;
+        auto flag = [&](bool on, const char* name) {
+            if (on) args += std::string(args.empty() ? "" : ", ") + name + "=True";
+        };
+        flag(opts_.reverse, "reverse");
+        flag(opts_.numeric, "numeric");
+        flag(opts_.unique, "unique");
+        flag(opts_.ignore_case, "ignore_case");
+        if (opts_.key)
+            args += std::string(args.empty() ? "" : ", ") + "key=" + std::to_string(opts_.key);
+        return "sort(" + args + ")";
+    }
+
+private:
+    SortOptions opts_;
+    bool copying_ = false;
+    std::string_view span_;
+    std::string buffer_;
+};
+
+class HeadStage : public PipelineStage {
+public:
+    explicit HeadStage(size_t n) : n_(n) {}
+
+    std::unique_ptr<PipelineStage> fresh() const override {
+        return std::make_unique<HeadStage>(n_);
+    }
+
+    bool push(const BatchPtr& in, const BatchEmit& emit) override {
+        if (seen_ >= n_)
+            return false;
+        size_t take = std::min(n_ - seen_, in->lines.size());
+        seen_ += take;
+        bool more;
+        if (take == in->lines.size()) {
+            more = emit(in);
+        } else {
+            auto out = derived(in);
+            out->lines.assign(in->lines.begin(), in->lines.begin() + static_cast<ptrdiff_t>(take));
+            more = emit(std::move(out));
+        }
+        return more && seen_ < n_;
+    }
+
+    std::string describe() const override { return "head(" + std::to_string(n_) + ")"; }
+
+private:
+    size_t n_;
+    size_t seen_ = 0;
+};
+
+class TailStage : public PipelineStage {
+public:
+    explicit TailStage(size_t n) : n_(n) {}
+
+    std::unique_ptr<PipelineStage> fresh() const override {
+        return std::make_unique<TailStage>(n_);
+    }
+
+    bool push(const BatchPtr& in, const BatchEmit&) override {
+        size_t skip = in->lines.size() > n_ ? in->lines.size() - n_ : 0;
+        for (size_t i = skip; i < in->lines.size(); ++i) {
+            last_.emplace_back(in->lines[i]);
+            if (last_.size() > n_)
+                last_.pop_front();
+        }
+        return true;
+    }
+
+    void finish(const BatchEmit& emit) override {
+        if (last_.empty())
+            return;
+        auto out = std::make_shared<LineBatch>();
+        for (const auto& line : last_) {
+            out->storage += line;
+            out->storage += '\n';
+        }
+        last_.clear();
+        index_storage(*out);
+        emit(std::move(out));
+    }
+
+    std::string describe() const override { return "tail(" + std::to_string(n_) + ")"; }
+
+private:
+    size_t n_;
+    std::deque<std::string> last_;
+};
+
+class CommStage : public PipelineStage {
+public:
+    CommStage(std::string path, bool keep_common)
+        : path_(std::move(path)), keep_common_(keep_common) {}
+
+    std::unique_ptr<PipelineStage> fresh() const override {
+        auto stage = std::make_unique<CommStage>(path_, keep_common_);
+        if (stage->file_.open(path_) != 0)
+            throw std::runtime_error("Cannot open file: " + path_);
+        LineReader reader(stage->file_.data());
+        std::string_view line;
+        while (reader.next(line))
+            stage->lines_.insert(line);
+        return stage;
+    }
+
+    bool push(const BatchPtr& in, const BatchEmit& emit) override {
+        auto out = derived(in);
+        for (auto line : in->lines)
+            if ((lines_.count(line) != 0) == keep_common_)
+                out->lines.push_back(line);
+        if (out->lines.empty())
+            return true;
+        return emit(std::move(out));
+    }
+
+    std::string describe() const override {
+        return "comm(" + quoted(path_) + ", keep=" +
+               (keep_common_ ? "'in_both'" : "'only_in_first'") + ")";
+    }
+
+private:
+    std::string path_;
+    bool keep_common_;
+    MappedFile file_;
+    std::unordered_set<std::string_view> lines_;
+};
+
+// ---------------------------------------------------------------------------
+// The queue between two threaded stages
+// ---------------------------------------------------------------------------
+
+class BatchQueue {
+public:
+    // Blocks while full. False if the consumer has stopped.
+    bool push(BatchPtr batch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&] { return cancelled_ || items_.size() < kPipelineQueueDepth; });
+        if (cancelled_)
+            return false;
+        items_.push_back(std::move(batch));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // Blocks while empty. False at the end of input or once cancelled.
+    bool pop(BatchPtr& batch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&] { return cancelled_ || closed_ || !items_.empty(); });
+        if (cancelled_ || items_.empty())
+            return false;
+        batch = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    // The producer is done.
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+    // The consumer wants nothing more (or the run failed): wakes both sides
+    // and drops what is queued.
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        items_.clear();
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable not_full_, not_empty_;
+    std::deque<BatchPtr> items_;
+    bool closed_ = false;
+    bool cancelled_ = false;
+};
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// Pipeline
+// ---------------------------------------------------------------------------
+
+void Pipeline::grep(const std::string& pattern, const MatchOptions& opts, bool invert) {
+    stages_.push_back(std::make_shared<GrepStage>(pattern, compile_matcher(pattern, opts), invert));
+}
+
+void Pipeline::cut(const std::string& fields, const std::string& delimiter) {
+    stages_.push_back(std::make_shared<CutStage>(fields, parse_field_list(fields),
+                                                 delimiter.empty() ? "\t" : delimiter));
+}
+
+void Pipeline::sort(const SortOptions& opts) {
+    stages_.push_back(std::make_shared<SortStage>(opts));
+}
+
+void Pipeline::head(size_t n) {
+    stages_.push_back(std::make_shared<HeadStage>(n));
+}
+
+void Pipeline::tail(size_t n) {
+    stages_.push_back(std::make_shared<TailStage>(n));
+}
+
+void Pipeline::comm(const std::string& path, bool keep_common) {
+    stages_.push_back(std::make_shared<CommStage>(path, keep_common));
+}
+
+std::vector<std::string> Pipeline::describe() const {
+    std::vector<std::string> out;
+    for (const auto& stage : stages_)
+        out.push_back(stage->describe());
+    return out;
+}
+
+void Pipeline::run(std::string_view input, bool threaded,
+                   const std::function<void(std::string_view)>& sink) const {
+    std::vector<std::unique_ptr<PipelineStage>> stages;
+    for (const auto& stage : stages_)
+        stages.push_back(stage->fresh());
+    const size_t n = stages.size();
+
+    auto deliver = [&](const BatchPtr& batch) {
+        for (auto line : batch->lines)
+            sink(line);
+    };
+
+    if (!threaded || n == 0) {
+        // emits[i] feeds stage i; emits[n] is the sink.
+        std::vector<BatchEmit> emits(n + 1);
+        emits[n] = [&](BatchPtr batch) {
+            deliver(batch);
+            return true;
+        };
+        for (size_t i = n; i-- > 0;)
+            emits[i] = [&, i](BatchPtr batch) { return stages[i]->push(batch, emits[i + 1]); };
+        cut_batches(input, emits[0]);
+        for (size_t i = 0; i < n; ++i)
+            stages[i]->finish(emits[i + 1]);
+        return;
+    }
+
+    // queues[i] feeds stage i; the caller drains queues[n] into the sink.
+    std::vector<BatchQueue> queues(n + 1);
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto fail = [&](std::exception_ptr e) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+                error = e;
+        }
+        failed = true;
+        for (auto& q : queues)
+            q.cancel();
+    };
+
+    std::vector<std::thread> threads;
+    threads.emplace_back([&] {
+        try {
+            cut_batches(input, [&](BatchPtr batch) { return queues[0].push(std::move(batch)); });
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        queues[0].close();
+    });
+    for (size_t i = 0; i < n; ++i) {
+        threads.emplace_back([&, i] {
+            try {
+                BatchEmit emit = [&](BatchPtr batch) { return queues[i + 1].push(std::move(batch)); };
+                BatchPtr batch;
+                while (queues[i].pop(batch)) {
+                    if (!stages[i]->push(batch, emit))
+                        queues[i].cancel();
+                }
+                if (!failed)
+                    stages[i]->finish(emit);
+            } catch (...) {
+                fail(std::current_exception());
+            }
+            queues[i + 1].close();
+        });
+    }
+
+    try {
+        BatchPtr batch;
+        while (queues[n].pop(batch))
+            deliver(batch);
+    } catch (...) {
+        fail(std::current_exception());
+    }
+    for (auto& t : threads)
+        t.join();
+    if (error)
+        std::rethrow_exception(error);
+}
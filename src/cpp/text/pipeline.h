@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "matcher.h"
+#include "sort_engine.h"
+
+// ---------------------------------------------------------------------------
+// Pipeline — grep | cut | sort | ... over one file, without leaving C++
+//
+// The input is mapped and cut into batches of about 256 KiB of lines. A
+// batch is a list of string_views; a stage that only selects lines (grep,
+// head, comm) passes views into its input batch on, which it keeps alive,
+// so the file's bytes are never copied. Stages that rewrite lines (cut)
+// build their output in a buffer owned by the new batch. Sorting and tail
+// need all of their input and emit only at the end; a sort directly on the
+// file sorts the mapping in place of a copy.
+//
+// Sequentially, each batch runs through the whole chain before the next is
+// cut. Threaded, every stage runs on its own thread and hands batches to
+// the next through a queue of at most kPipelineQueueDepth batches, so
+// memory stays bounded while the stages overlap. A stage that needs no more
+// input (head) stops the stages before it either way.
+//
+// grep() throws std::regex_error for an invalid pattern and cut()
+// std::invalid_argument for an invalid field list; run() throws
+// std::runtime_error (a comm file that cannot be read, a failed sort spill)
+// or whatever `sink` throws.
+// ---------------------------------------------------------------------------
+
+constexpr size_t kPipelineQueueDepth = 4;
+
+struct LineBatch {
+    std::vector<std::string_view> lines;
+    std::string_view text;      // set when `lines` is exactly the getline split of it
+    bool stable = false;        // views point into the input, valid for the whole run
+    std::string storage;        // bytes the views point into, if owned
+    std::shared_ptr<const LineBatch> parent;    // batch the views point into
+};
+
+using BatchPtr = std::shared_ptr<const LineBatch>;
+
+// Hands a batch to the next stage; false once it wants no more.
+using BatchEmit = std::function<bool(BatchPtr)>;
+
+class PipelineStage {
+public:
+    virtual ~PipelineStage() = default;
+
+    // A copy without state from earlier runs, for one run.
+    virtual std::unique_ptr<PipelineStage> fresh() const = 0;
+
+    // Processes `in`, emitting any output. Returns false once it needs no
+    // more input; later calls must then be harmless.
+    virtual bool push(const BatchPtr& in, const BatchEmit& emit) = 0;
+
+    // End of input: emits whatever was held back.
+    virtual void finish(const BatchEmit& emit) { (void)emit; }
+
+    // "grep('x')", for repr().
+    virtual std::string describe() const = 0;
+};
+
+class Pipeline {
+public:
+    void grep(const std::string& pattern, const MatchOptions& opts, bool invert);
+    void cut(const std::string& fields, const std::string& delimiter);
+    void sort(const SortOptions& opts);
+    void head(size_t n);
+    void tail(size_t n);
+    // Lines also in `path` (keep_common) or not in it; `path` is read when
+    // the pipeline runs.
+    void comm(const std::string& path, bool keep_common);
+
+    size_t size() const { return stages_.size(); }
+    std::vector<std::string> describe() const;
+
+    // Runs the stages over the lines of `input` and calls `sink` with every
+    // resulting line, in order, on the calling thread.
+    void run(std::string_view input, bool threaded,
+             const std::function<void(std::string_view)>& sink) const;
+
+private:
+    std::vector<std::shared_ptr<const PipelineStage>> stages_;
+};
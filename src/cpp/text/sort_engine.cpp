@@ -0,0 +1,413 @@
+#include "sort_engine.h"
+#include "fields.h"
+#include "mapped_file.h"
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Below this many records (or bytes, when building records) the work is not
+// worth splitting across threads.
+static constexpr size_t kParallelSortMin = 1 << 16;
+static constexpr size_t kParallelBuildMin = 1 << 20;
+static constexpr size_t kOutputBlock = 1 << 20;
+
+// ---------------------------------------------------------------------------
+// Records and ordering
+// ---------------------------------------------------------------------------
+
+struct SortRecord {
+    const char* line;
+    size_t len;
+    const char* key;
+    size_t key_len;
+    uint64_t prefix;    // first 8 key bytes, big-endian, case-folded if needed
+    double num;         // parsed key when sorting numerically
+};
+
+static unsigned char fold_byte(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + 32) : c;
+}
+
+// Like std::stod, but unparsable keys sort as 0 instead of throwing.
+static double parse_number(std::string_view key) {
+    char small[64];
+    std::string large;
+    const char* s;
+    if (key.size() < sizeof(small)) {
+        std::memcpy(small, key.data(), key.size());
+        small[key.size()] = '\0';
+        s = small;
+    } else {
+        large.assign(key.data(), key.size());
+        s = large.c_str();
+    }
+    char* end = nullptr;
+    double v = std::strtod(s, &end);
+    if (end == s || std::isnan(v))
+        return 0.0;
+    return v;
+}
+
+static SortRecord make_record(std::string_view line, const SortOptions& o) {
+    std::string_view key = o.key > 0
+        ? FieldSplitter(o.separator).field(line, static_cast<size_t>(o.key))
+        : line;
+    SortRecord r{line.data(), line.size(), key.data(), key.size(), 0, 0.0};
+    if (o.numeric) {
+        r.num = parse_number(key);
+    } else {
+        for (size_t i = 0; i < 8; i++) {
+            unsigned char c = i < key.size() ? static_cast<unsigned char>(key[i]) : 0;
+            r.prefix = (r.prefix << 8) | (o.ignore_case ? fold_byte(c) : c);
+        }
+    }
+    return r;
+}
+
+static int compare_bytes(const char* a, size_t alen, const char* b, size_t blen) {
+    int c = std::memcmp(a, b, std::min(alen, blen));
+    if (c != 0) return c;
+    return alen < blen ? -1 : (alen > blen ? 1 : 0);
+}
+
+static int compare_folded(const char* a, size_t alen, const char* b, size_t blen) {
+    size_t n = std::min(alen, blen);
+    for (size_t i = 0; i < n; i++) {
+        unsigned char ca = fold_byte(static_cast<unsigned char>(a[i]));
+        unsigned char cb = fold_byte(static_cast<unsigned char>(b[i]));
+        if (ca != cb) return ca < cb ? -1 : 1;
+    }
+    return alen < blen ? -1 : (alen > blen ? 1 : 0);
+}
+
+static int compare_records(const SortRecord& a, const SortRecord& b, const SortOptions& o) {
+    if (o.numeric) {
+        if (a.num < b.num) return -1;
+        if (a.num > b.num) return 1;
+    } else {
+        if (a.prefix != b.prefix) return a.prefix < b.prefix ? -1 : 1;
+        int c = o.ignore_case ? compare_folded(a.key, a.key_len, b.key, b.key_len)
+                              : compare_bytes(a.key, a.key_len, b.key, b.key_len);
+        if (c != 0) return c;
+    }
+    // Last resort: whole line, so the order is total and deterministic
+    return compare_bytes(a.line, a.len, b.line, b.len);
+}
+
+struct RecordLess {
+    const SortOptions& opts;
+    bool operator()(const SortRecord& a, const SortRecord& b) const {
+        int c = compare_records(a, b, opts);
+        return opts.reverse ? c > 0 : c < 0;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// In-memory phase: build records and sort them in parallel
+// ---------------------------------------------------------------------------
+
+static void build_records_serial(std::string_view data, const SortOptions& o,
+                                 std::vector<SortRecord>& out) {
+    LineReader reader(data);
+    std::string_view line;
+    while (reader.next(line))
+        out.push_back(make_record(line, o));
+}
+
+static void build_records(std::string_view data, const SortOptions& o,
+                          ThreadPool& pool, std::vector<SortRecord>& out) {
+    size_t parts = pool.size();
+    if (parts < 2 || data.size() < kParallelBuildMin) {
+        build_records_serial(data, o, out);
+        return;
+    }
+
+    // Newline-aligned slices, one per worker
+    std::vector<std::string_view> slices;
+    size_t begin = 0;
+    for (size_t p = 1; p <= parts && begin < data.size(); p++) {
+        size_t end = p == parts ? data.size() : data.size() / parts * p;
+        if (end < begin) end = begin;
+        if (end < data.size()) {
+            size_t nl = data.find('\n', end);
+            end = nl == std::string_view::npos ? data.size() : nl + 1;
+        }
+        slices.push_back(data.substr(begin, end - begin));
+        begin = end;
+    }
+
+    std::vector<std::vector<SortRecord>> partial(slices.size());
+    for (size_t i = 0; i < slices.size(); i++)
+        pool.submit([&, i] { build_records_serial(slices[i], o, partial[i]); });
+    pool.wait();
+
+    size_t total = out.size();
+    for (const auto& v : partial) total += v.size();
+    out.reserve(total);
+    for (const auto& v : partial)
+        out.insert(out.end(), v.begin(), v.end());
+}
+
+// Sorts equal slices on separate workers, then merges neighbouring slices
+// pairwise (also in parallel) until one sorted range is left.
+static void parallel_sort(std::vector<SortRecord>& recs, const RecordLess& less,
+                          ThreadPool& pool) {
+    size_t parts = pool.size();
+    if (parts < 2 || recs.size() < kParallelSortMin) {
+        std::sort(recs.begin(), recs.end(), less);
+        return;
+    }
+
+    std::vector<size_t> bounds(parts + 1);
+    for (size_t p = 0; p <= parts; p++)
+        bounds[p] = recs.size() / parts * p;
+    bounds[parts] = recs.size();
+
+    for (size_t p = 0; p < parts; p++)
+        pool.submit([&, p] {
+            std::sort(recs.begin() + bounds[p], recs.begin() + bounds[p + 1], less);
+        });
+    pool.wait();
+
+    std::vector<SortRecord> buffer(recs.size());
+    auto* src = &recs;
+    auto* dst = &buffer;
+    for (size_t width = 1; width < parts; width *= 2) {
+        for (size_t p = 0; p < parts; p += 2 * width) {
+            size_t lo = bounds[p];
+            size_t mid = bounds[std::min(p + width, parts)];
+            size_t hi = bounds[std::min(p + 2 * width, parts)];
+            pool.submit([src, dst, lo, mid, hi, &less] {
+                std::merge(src->begin() + lo, src->begin() + mid,
+                           src->begin() + mid, src->begin() + hi,
+                           dst->begin() + lo, less);
+            });
+        }
+        pool.wait();
+        std::swap(src, dst);
+    }
+    if (src != &recs)
+        recs.swap(buffer);
+}
+
+// ---------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------
+
+// Buffers lines into large blocks for the sink and applies `unique`. The
+// previous line is kept as a view, so its storage must outlive the writer.
+class LineWriter {
+public:
+    LineWriter(const std::function<void(std::string_view)>& sink, bool unique)
+        : sink_(sink), unique_(unique) {
+        buffer_.reserve(kOutputBlock + 4096);
+    }
+
+    void write(std::string_view line) {
+        if (unique_ && have_prev_ && line == prev_)
+            return;
+        prev_ = line;
+        have_prev_ = true;
+        buffer_.append(line.data(), line.size());
+        buffer_.push_back('\n');
+        if (buffer_.size() >= kOutputBlock)
+            flush();
+    }
+
+    void flush() {
+        if (!buffer_.empty()) {
+            sink_(buffer_);
+            buffer_.clear();
+        }
+    }
+
+private:
+    const std::function<void(std::string_view)>& sink_;
+    bool unique_;
+    std::string buffer_;
+    std::string_view prev_;
+    bool have_prev_ = false;
+};
+
+// ---------------------------------------------------------------------------
+// External phase: spilled runs and k-way merge
+// ---------------------------------------------------------------------------
+
+// Owns the spilled run files and removes them when the sort finishes.
+class TempRuns {
+public:
+    explicit TempRuns(std::string dir) : dir_(std::move(dir)) {
+        if (dir_.empty()) {
+            const char* tmp = std::getenv("TMPDIR");
+            dir_ = (tmp && *tmp) ? tmp : "/tmp";
+        }
+    }
+    ~TempRuns() {
+        for (const auto& p : paths_)
+            ::unlink(p.c_str());
+    }
+
+    // Creates a new run file and returns its descriptor.
+    int create() {
+        std::string tmpl = dir_ + "/shellfast-sort-XXXXXX";
+        int fd = mkostemp(&tmpl[0], O_CLOEXEC);
+        if (fd < 0)
+            throw std::runtime_error("cannot create temporary file in " + dir_ +
+                                     ": " + std::strerror(errno));
+        paths_.push_back(tmpl);
+        return fd;
+    }
+
+    const std::vector<std::string>& paths() const { return paths_; }
+
+private:
+    std::string dir_;
+    std::vector<std::string> paths_;
+};
+
+static void write_all(int fd, std::string_view data, const std::string& what) {
+    while (!data.empty()) {
+        ssize_t n = ::write(fd, data.data(), data.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("cannot write " + what + ": " + std::strerror(errno));
+        }
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+}
+
+static void spill_run(const std::vector<SortRecord>& recs, const SortOptions& o,
+                      TempRuns& runs) {
+    int fd = runs.create();
+    const std::string& path = runs.paths().back();
+    try {
+        std::function<void(std::string_view)> sink = [&](std::string_view block) {
+            write_all(fd, block, path);
+        };
+        LineWriter writer(sink, o.unique);
+        for (const auto& r : recs)
+            writer.write(std::string_view(r.line, r.len));
+        writer.flush();
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+struct RunCursor {
+    MappedFile file;
+    std::unique_ptr<LineReader> reader;
+    SortRecord head;
+};
+
+static void merge_runs(const TempRuns& runs, const SortOptions& o,
+                       const RecordLess& less, LineWriter& writer) {
+    std::vector<std::unique_ptr<RunCursor>> cursors;
+    for (const auto& path : runs.paths()) {
+        auto c = std::make_unique<RunCursor>();
+        if (int err = c->file.open(path))
+            throw std::runtime_error("cannot read temporary file " + path + ": " +
+                                     std::strerror(err));
+        c->reader = std::make_unique<LineReader>(c->file.data());
+        cursors.push_back(std::move(c));
+    }
+
+    // Min-heap of run indices by head record; ties go to the earlier run.
+    auto heap_greater = [&](size_t a, size_t b) {
+        const SortRecord& ra = cursors[a]->head;
+        const SortRecord& rb = cursors[b]->head;
+        if (less(rb, ra)) return true;
+        if (less(ra, rb)) return false;
+        return a > b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(heap_greater)> heap(heap_greater);
+
+    auto advance = [&](size_t i) {
+        std::string_view line;
+        if (cursors[i]->reader->next(line)) {
+            cursors[i]->head = make_record(line, o);
+            heap.push(i);
+        }
+    };
+    for (size_t i = 0; i < cursors.size(); i++)
+        advance(i);
+
+    while (!heap.empty()) {
+        size_t i = heap.top();
+        heap.pop();
+        const SortRecord& r = cursors[i]->head;
+        writer.write(std::string_view(r.line, r.len));
+        advance(i);
+    }
+    writer.flush();
+}
+
+// ---------------------------------------------------------------------------
+// sort_lines
+// ---------------------------------------------------------------------------
+
+void sort_lines(std::string_view input, const SortOptions& opts,
+                const std::function<void(std::string_view)>& sink) {
+    ThreadPool pool(opts.threads);
+    RecordLess less{opts};
+    LineWriter writer(sink, opts.unique);
+
+    // Fast path: everything fits in one in-memory run
+    size_t budget = opts.buffer_size;
+    if (budget == 0 || input.size() <= budget / 2) {
+        std::vector<SortRecord> recs;
+        build_records(input, opts, pool, recs);
+        if (budget == 0 || input.size() + recs.size() * sizeof(SortRecord) <= budget) {
+            parallel_sort(recs, less, pool);
+            for (const auto& r : recs)
+                writer.write(std::string_view(r.line, r.len));
+            writer.flush();
+            return;
+        }
+    }
+
+    // Cut the input into runs whose line bytes plus records fit the budget,
+    // sort each one and spill it.
+    TempRuns runs(opts.temp_dir);
+    LineReader reader(input);
+    size_t run_begin = 0;
+    size_t run_cost = 0;
+    std::string_view line;
+    std::vector<SortRecord> recs;
+
+    auto flush_run = [&](size_t run_end) {
+        if (run_end == run_begin) return;
+        recs.clear();
+        build_records(input.substr(run_begin, run_end - run_begin), opts, pool, recs);
+        parallel_sort(recs, less, pool);
+        spill_run(recs, opts, runs);
+        run_begin = run_end;
+        run_cost = 0;
+    };
+
+    for (;;) {
+        size_t line_begin = reader.offset();
+        if (!reader.next(line)) break;
+        size_t cost = line.size() + 1 + sizeof(SortRecord);
+        if (run_cost > 0 && run_cost + cost > budget)
+            flush_run(line_begin);
+        run_cost += cost;
+    }
+    flush_run(input.size());
+    std::vector<SortRecord>().swap(recs);
+
+    merge_runs(runs, opts, less, writer);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// ---------------------------------------------------------------------------
+// sort_lines — parallel, external-memory line sort behind sort_file
+//
+// Keys are extracted once per line into a compact record (line and key
+// views, an 8-byte key prefix and the parsed number), so comparisons never
+// re-tokenize or allocate. Records are sorted with a parallel merge sort on
+// a ThreadPool.
+//
+// When buffer_size is set and the input does not fit, it is cut into runs
+// of at most buffer_size bytes (line data plus records). Each run is sorted
+// in memory and spilled to a temporary file, and the runs are combined with
+// a k-way heap merge. Memory then stays near buffer_size however large the
+// input is.
+//
+// The ordering is total: lines with equal keys are ordered by their full
+// contents (like GNU sort without -s). Output is therefore identical for any
+// thread count or buffer size.
+// ---------------------------------------------------------------------------
+
+struct SortOptions {
+    bool reverse = false;
+    bool numeric = false;
+    bool unique = false;        // drop repeated identical lines
+    bool ignore_case = false;
+    int key = 0;                // 1-based field, 0 = whole line
+    std::string separator;      // "" = runs of whitespace
+    size_t buffer_size = 0;     // bytes per in-memory run, 0 = unlimited
+    size_t threads = 1;
+    std::string temp_dir;       // where runs are spilled; "" = $TMPDIR or /tmp
+};
+
+// Sorts the lines of `input` (getline semantics) and streams the result,
+// every line terminated by '\n', to `sink` in blocks. Throws
+// std::runtime_error if a temporary run cannot be written.
+void sort_lines(std::string_view input, const SortOptions& opts,
+                const std::function<void(std::string_view)>& sink);
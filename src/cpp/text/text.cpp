@@ -1,71 +1,242 @@
 #include "text.h"
+#include "mapped_file.h"
+#include "matcher.h"
+#include "wc_kernel.h"
+#include "sort_engine.h"
+#include "diff_engine.h"
+#include "fields.h"
+#include "follow.h"
+#include "pipeline.h"
+#include "text_buffer.h"
+#include "grep_index.h"
+#include "common/stats.h"
+#include "common/thread_pool.h"
+#include "filesystem/walker.h"
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <chrono>
 #include <filesystem>
-#include <fstream>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
+#include <deque>
+#include <exception>
 #include <regex>
-#include <map>
 #include <set>
 #include <numeric>
 #include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <stdexcept>
+#include <memory>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace py = pybind11;
 namespace fs = std::filesystem;
 
 // ---------------------------------------------------------------------------
-// Utility: Read entire file into string
+// Utility: Map a file for zero-copy reading
 // ---------------------------------------------------------------------------
 
-static std::string read_file(const std::string& path) {
-    std::ifstream ifs(path, std::ios::binary);
-    if (!ifs.is_open())
+static MappedFile open_mapped(const std::string& path) {
+    MappedFile file;
+    if (file.open(path) != 0)
         throw py::value_error("Cannot open file: " + path);
-    std::ostringstream oss;
-    oss << ifs.rdbuf();
-    return oss.str();
+    return file;
 }
 
-static std::vector<std::string> read_lines(const std::string& path) {
-    std::ifstream ifs(path);
-    if (!ifs.is_open())
-        throw py::value_error("Cannot open file: " + path);
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(ifs, line))
-        lines.push_back(line);
-    return lines;
+static void append_line(std::string& out, std::string_view line) {
+    out.append(line.data(), line.size());
+    out.push_back('\n');
+}
+
+// ---------------------------------------------------------------------------
+// Utility: Command output to a string or a file
+//
+// Without a path, output accumulates in a string that finish() returns.
+// With one, it is written through a 1 MiB buffer into a temporary file next
+// to the destination, which finish() renames into place (and the destructor
+// removes on failure). The destination may therefore be one of the input
+// files, even while it is still mapped.
+// ---------------------------------------------------------------------------
+
+class TextOutput {
+public:
+    TextOutput(std::string cmd, std::string path)
+        : cmd_(std::move(cmd)), path_(std::move(path)) {
+        if (path_.empty())
+            return;
+        tmp_path_ = path_ + ".partial-XXXXXX";
+        fd_ = mkostemp(&tmp_path_[0], O_CLOEXEC);
+        if (fd_ < 0)
+            throw py::value_error(cmd_ + ": cannot write '" + path_ + "': " +
+                                  std::strerror(errno));
+        buffer_.reserve(kBlock + 4096);
+    }
+
+    ~TextOutput() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            ::unlink(tmp_path_.c_str());
+        }
+    }
+
+    TextOutput(const TextOutput&) = delete;
+    TextOutput& operator=(const TextOutput&) = delete;
+
+    void reserve(size_t n) {
+        if (fd_ < 0) buffer_.reserve(n);
+    }
+
+    void write(std::string_view data) {
+        buffer_.append(data.data(), data.size());
+        if (fd_ >= 0 && buffer_.size() >= kBlock)
+            flush();
+    }
+
+    void line(std::string_view text) {
+        append_line(buffer_, text);
+        if (fd_ >= 0 && buffer_.size() >= kBlock)
+            flush();
+    }
+
+    // Returns the output, or "" once it has been moved to the destination.
+    std::string finish() {
+        if (fd_ < 0)
+            return std::move(buffer_);
+        flush();
+        ::fchmod(fd_, 0644);
+        int rc = ::close(fd_);
+        fd_ = -1;
+        if (rc != 0 || ::rename(tmp_path_.c_str(), path_.c_str()) != 0) {
+            int err = errno;
+            ::unlink(tmp_path_.c_str());
+            throw py::value_error(cmd_ + ": cannot write '" + path_ + "': " +
+                                  std::strerror(err));
+        }
+        return std::string();
+    }
+
+private:
+    static constexpr size_t kBlock = 1 << 20;
+
+    void flush() {
+        std::string_view data = buffer_;
+        while (!data.empty()) {
+            ssize_t n = ::write(fd_, data.data(), data.size());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw py::value_error(cmd_ + ": cannot write '" + path_ + "': " +
+                                      std::strerror(errno));
+            }
+            data.remove_prefix(static_cast<size_t>(n));
+        }
+        buffer_.clear();
+    }
+
+    std::string cmd_;
+    std::string path_;
+    std::string tmp_path_;
+    int fd_ = -1;
+    std::string buffer_;
+};
+
+// ---------------------------------------------------------------------------
+// Utility: str or TextBuffer results
+//
+// `produce` runs without the GIL. By default its bytes are decoded into a
+// str (one copy); with as_bytes the TextBuffer itself is returned, so
+// Python reads the bytes in place through memoryview or LineView.
+// ---------------------------------------------------------------------------
+
+template <typename Fn>
+static py::object text_result(bool as_bytes, Fn&& produce) {
+    std::shared_ptr<TextBuffer> buffer;
+    {
+        py::gil_scoped_release release;
+        buffer = produce();
+    }
+    if (as_bytes)
+        return py::cast(buffer);
+    std::string_view data = buffer->data();
+    return py::str(data.data(), data.size());
+}
+
+static std::shared_ptr<TextBuffer> owned_buffer(std::string text) {
+    return std::make_shared<TextBuffer>(std::move(text));
 }
 
+// The lines of a TextBuffer, indexed without decoding the rest.
+struct LineView {
+    std::shared_ptr<TextBuffer> buffer;
+};
+
 // ---------------------------------------------------------------------------
 // cat — Concatenate and display file contents
 // ---------------------------------------------------------------------------
 
-static std::string cat_impl(const std::string& path,
-                              bool number_lines,
-                              bool squeeze_blank) {
-    auto lines = read_lines(path);
-    std::ostringstream oss;
+struct CatState {
+    bool number_lines = false;
+    bool squeeze_blank = false;
     int line_num = 1;
     bool prev_blank = false;
-
-    for (const auto& line : lines) {
-        bool is_blank = line.empty() || line.find_first_not_of(" \t\r\n") == std::string::npos;
-
-        if (squeeze_blank && is_blank && prev_blank)
+};
+
+// Appends up to max_lines formatted lines from `reader` to `out`. Returns
+// the number of lines written; 0 means the input is exhausted.
+static size_t cat_lines(LineReader& reader, CatState& state, std::string& out,
+                        size_t max_lines) {
+    size_t written = 0;
+    std::string_view line;
+    while (written < max_lines && reader.next(line)) {
+        bool is_blank = line.find_first_not_of(" \t\r\n") == std::string_view::npos;
+
+        if (state.squeeze_blank && is_blank && state.prev_blank)
             continue;
 
-        if (number_lines)
-            oss << "     " << line_num++ << "\t";
+        if (state.number_lines) {
+            out += "     ";
+            out += std::to_string(state.line_num++);
+            out += '\t';
+        }
+
+        append_line(out, line);
+        state.prev_blank = is_blank;
+        written++;
+    }
+    return written;
+}
 
-        oss << line << "\n";
-        prev_blank = is_blank;
+static std::shared_ptr<TextBuffer> cat_buffer(const std::string& path,
+                                              bool number_lines,
+                                              bool squeeze_blank) {
+    auto file = open_mapped(path);
+    std::string_view data = file.data();
+    if (!number_lines && !squeeze_blank && (data.empty() || data.back() == '\n')) {
+        // Output is the file as it is: hand out the mapping itself.
+        size_t size = data.size();
+        return std::make_shared<TextBuffer>(std::move(file), 0, size);
     }
-    return oss.str();
+
+    std::string out;
+    out.reserve(file.size() + 1);
+
+    CatState state;
+    state.number_lines = number_lines;
+    state.squeeze_blank = squeeze_blank;
+    LineReader reader(data);
+    cat_lines(reader, state, out, SIZE_MAX);
+    return owned_buffer(std::move(out));
+}
+
+static py::object cat_impl(const std::string& path, bool number_lines, bool squeeze_blank,
+                           bool as_bytes) {
+    return text_result(as_bytes, [&] { return cat_buffer(path, number_lines, squeeze_blank); });
 }
 
 // ---------------------------------------------------------------------------
@@ -80,57 +251,149 @@ static std::string echo_impl(const std::string& text, bool no_newline) {
 
 // ---------------------------------------------------------------------------
 // head — First N lines of a file
+//
+// Line mode reads forwards in blocks and stops at the n-th newline.
 // ---------------------------------------------------------------------------
 
-static std::string head_impl(const std::string& path, int n, int bytes) {
+static std::shared_ptr<TextBuffer> head_buffer(const std::string& path, int n, int bytes) {
     if (bytes > 0) {
-        std::ifstream ifs(path, std::ios::binary);
-        if (!ifs.is_open())
+        MappedFile file;
+        if (file.open(path) != 0)
             throw py::value_error("head: cannot open '" + path + "'");
-        std::string buf(bytes, '\0');
-        ifs.read(&buf[0], bytes);
-        buf.resize(ifs.gcount());
-        return buf;
+        size_t length = std::min(file.size(), static_cast<size_t>(bytes));
+        return std::make_shared<TextBuffer>(std::move(file), 0, length);
     }
 
-    auto lines = read_lines(path);
-    std::ostringstream oss;
-    int count = std::min(n, static_cast<int>(lines.size()));
-    for (int i = 0; i < count; i++)
-        oss << lines[i] << "\n";
-    return oss.str();
+    std::string out;
+    if (read_head_lines(path, static_cast<size_t>(std::max(0, n)), out) != 0)
+        throw py::value_error("Cannot open file: " + path);
+    if (!out.empty() && out.back() != '\n')
+        out.push_back('\n');
+    return owned_buffer(std::move(out));
+}
+
+static py::object head_impl(const std::string& path, int n, int bytes, bool as_bytes) {
+    return text_result(as_bytes, [&] { return head_buffer(path, n, bytes); });
 }
 
 // ---------------------------------------------------------------------------
 // tail — Last N lines of a file
+//
+// Line mode scans backwards from the end of the file in blocks, so the cost
+// depends on the length of the tail, not of the file.
 // ---------------------------------------------------------------------------
 
-static std::string tail_impl(const std::string& path, int n, int bytes) {
+// Offset of the first of the last `n` lines of `data` (getline semantics: a
+// trailing newline does not start another line).
+static size_t tail_offset(std::string_view data, size_t n) {
+    if (n == 0)
+        return data.size();
+    size_t end = data.size();
+    if (end > 0 && data[end - 1] == '\n')
+        end--;
+    for (;;) {
+        const char* nl = static_cast<const char*>(memrchr(data.data(), '\n', end));
+        if (!nl)
+            return 0;
+        size_t pos = static_cast<size_t>(nl - data.data());
+        if (--n == 0)
+            return pos + 1;
+        end = pos;
+    }
+}
+
+static std::shared_ptr<TextBuffer> tail_buffer(const std::string& path, int n, int bytes) {
     if (bytes > 0) {
-        std::ifstream ifs(path, std::ios::binary | std::ios::ate);
-        if (!ifs.is_open())
+        MappedFile file;
+        if (file.open(path) != 0)
             throw py::value_error("tail: cannot open '" + path + "'");
-        auto size = ifs.tellg();
-        int read_bytes = std::min(static_cast<int>(size), bytes);
-        ifs.seekg(-read_bytes, std::ios::end);
-        std::string buf(read_bytes, '\0');
-        ifs.read(&buf[0], read_bytes);
-        return buf;
+        size_t size = file.size();
+        size_t read_bytes = std::min(size, static_cast<size_t>(bytes));
+        return std::make_shared<TextBuffer>(std::move(file), size - read_bytes, read_bytes);
     }
 
-    auto lines = read_lines(path);
-    int total = static_cast<int>(lines.size());
-    int start = std::max(0, total - n);
-    std::ostringstream oss;
-    for (int i = start; i < total; i++)
-        oss << lines[i] << "\n";
-    return oss.str();
+    std::string out;
+    if (read_tail_lines(path, static_cast<size_t>(std::max(0, n)), out) != 0)
+        throw py::value_error("Cannot open file: " + path);
+    if (!out.empty() && out.back() != '\n')
+        out.push_back('\n');
+    return owned_buffer(std::move(out));
+}
+
+static py::object tail_impl(const std::string& path, int n, int bytes, bool as_bytes) {
+    return text_result(as_bytes, [&] { return tail_buffer(path, n, bytes); });
 }
 
 // ---------------------------------------------------------------------------
 // grep — Search for patterns in files
 // ---------------------------------------------------------------------------
 
+// Files larger than two chunks are split into newline-aligned chunks so a
+// single big file can still use every worker.
+static constexpr size_t kGrepChunkSize = 4 * 1024 * 1024;
+
+struct GrepLine {
+    size_t line_number;
+    std::string line;
+};
+
+struct GrepChunk {
+    size_t begin = 0;
+    size_t end = 0;
+    size_t newlines = 0;   // only counted when the file has several chunks
+    size_t line_base = 0;  // lines before `begin`, for index ranges
+    int match_count = 0;
+    std::vector<GrepLine> lines;
+};
+
+struct GrepFile {
+    std::string path;
+    MappedFile file;
+    std::vector<GrepChunk> chunks;
+    std::exception_ptr error;
+    int match_count = 0;
+    bool indexed = false;  // chunks are the ranges an index left to scan
+};
+
+// The index file grep(index=...) names: None or False for none, True for
+// the default index of `path`, or a path.
+static std::string grep_index_arg(const py::object& index, const std::string& path) {
+    if (index.is_none())
+        return std::string();
+    if (py::isinstance<py::bool_>(index)) {
+        if (!index.cast<bool>())
+            return std::string();
+        try {
+            return default_grep_index_path(path);
+        } catch (const std::runtime_error& e) {
+            throw py::value_error(std::string("grep: ") + e.what());
+        }
+    }
+    if (py::isinstance<py::str>(index))
+        return index.cast<std::string>();
+    throw py::type_error("grep: index must be None, a bool or a path");
+}
+
+// Passes every regular file below a grep root to `add`, together with the
+// bucket that keeps it in serial walk order.
+template <typename Add>
+class GrepWalkVisitor : public WalkVisitor {
+public:
+    GrepWalkVisitor(WalkOrder<GrepFile>& order, Add& add) : order_(order), add_(add) {}
+
+    bool visit(const WalkEntry& e, void* dir) override {
+        if (e.target_type() == EntryType::file)
+            add_(order_.node(dir), e.path());
+        return true;
+    }
+
+    void* enter(const WalkEntry&, void* parent) override { return order_.child(parent); }
+
+private:
+    WalkOrder<GrepFile>& order_;
+    Add& add_;
+};
+
 static py::object grep_impl(const std::string& pattern,
                               const std::string& path,
                               bool ignore_case,
@@ -139,91 +402,219 @@ static py::object grep_impl(const std::string& pattern,
                               bool count_only,
                               bool invert,
                               bool files_only,
-                              bool whole_word) {
-    std::vector<std::string> files_to_search;
-
-    auto collect_files = [&](const std::string& p) {
-        fs::path fpath(p);
-        if (!fs::exists(fpath))
-            throw py::value_error("grep: " + p + ": No such file or directory");
-
-        if (fs::is_regular_file(fpath)) {
-            files_to_search.push_back(p);
-        } else if (fs::is_directory(fpath) && recursive) {
-            for (auto& entry : fs::recursive_directory_iterator(
-                     fpath, fs::directory_options::skip_permission_denied)) {
-                if (entry.is_regular_file())
-                    files_to_search.push_back(entry.path().string());
+                              bool whole_word,
+                              bool fixed_strings,
+                              int threads,
+                              const py::object& index) {
+    if (threads < 0)
+        throw py::value_error("grep: threads must be >= 0");
+    std::string index_path = grep_index_arg(index, path);
+
+    std::vector<GrepFile> files;
+
+    {
+        // Scan phase: plain C++ only, so other Python threads keep running.
+        py::gil_scoped_release release;
+
+        MatchOptions opts;
+        opts.ignore_case = ignore_case;
+        opts.whole_word = whole_word;
+        opts.fixed_strings = fixed_strings;
+
+        std::unique_ptr<Matcher> matcher;
+        try {
+            matcher = compile_matcher(pattern, opts);
+        } catch (const std::regex_error& e) {
+            throw py::value_error("grep: invalid regex pattern: " + std::string(e.what()));
+        }
+
+        // The index narrows a search to the blocks that hold every trigram
+        // of the pattern's required literal; without one it cannot help.
+        std::unique_ptr<GrepIndex> grep_index;
+        std::vector<uint32_t> candidates;
+        if (!index_path.empty()) {
+            try {
+                grep_index = std::make_unique<GrepIndex>(index_path);
+            } catch (const std::runtime_error& e) {
+                throw py::value_error(std::string("grep: ") + e.what());
             }
-        } else if (fs::is_directory(fpath)) {
-            throw py::value_error("grep: " + p + ": Is a directory (use recursive=True)");
+            std::string_view literal = matcher->literal();
+            if (invert || literal.size() < 3)
+                grep_index.reset();
+            else
+                candidates = grep_index->candidates(literal);
         }
-    };
 
-    collect_files(path);
+        ThreadPool pool(ThreadPool::resolve_threads(threads));
+
+        // Matchers are not thread-safe: one clone per worker, slot 0 for
+        // tasks that run inline on this thread.
+        std::vector<std::unique_ptr<Matcher>> matchers;
+        matchers.push_back(std::move(matcher));
+        for (size_t i = 0; i < pool.size(); i++)
+            matchers.push_back(matchers[0]->clone());
+        auto local_matcher = [&]() -> Matcher& {
+            return *matchers[static_cast<size_t>(pool.current_worker() + 1)];
+        };
+
+        auto scan_chunk = [&, invert, count_only, files_only](GrepFile& gf, GrepChunk& chunk) {
+            std::string_view data = gf.file.data().substr(chunk.begin, chunk.end - chunk.begin);
+            if (gf.chunks.size() > 1 && !gf.indexed)
+                chunk.newlines = count_newlines(data.data(), data.size());
+            scan_lines(local_matcher(), data, invert,
+                       [&](size_t line_no, std::string_view line) {
+                           chunk.match_count++;
+                           if (files_only) return false;
+                           if (!count_only)
+                               chunk.lines.push_back({line_no, std::string(line)});
+                           return true;
+                       });
+        };
+
+        auto search_file = [&, files_only](GrepFile& gf) {
+            try {
+                gf.file = open_mapped(gf.path);
+            } catch (...) {
+                gf.error = std::current_exception();
+                return;
+            }
+            size_t size = gf.file.size();
+            std::vector<IndexRange> ranges;
+            FileStat st;
+            if (grep_index && stat_at(AT_FDCWD, gf.path.c_str(), true, st) == 0 &&
+                grep_index->ranges(st, gf.file.data(), candidates, ranges)) {
+                gf.indexed = true;
+                for (const auto& r : ranges) {
+                    GrepChunk chunk;
+                    chunk.begin = r.begin;
+                    chunk.end = r.end;
+                    chunk.line_base = r.line_base;
+                    gf.chunks.push_back(std::move(chunk));
+                }
+                // Candidate blocks are small; scan them in this task.
+                for (auto& chunk : gf.chunks) {
+                    scan_chunk(gf, chunk);
+                    if (files_only && chunk.match_count > 0)
+                        break;
+                }
+                return;
+            }
+            if (pool.size() < 2 || files_only || size <= 2 * kGrepChunkSize) {
+                gf.chunks.resize(1);
+                gf.chunks[0].end = size;
+                scan_chunk(gf, gf.chunks[0]);
+                return;
+            }
 
-    // Build regex
-    std::string regex_pattern = pattern;
-    if (whole_word)
-        regex_pattern = "\\b" + regex_pattern + "\\b";
+            // Split at the first newline after each chunk boundary. The
+            // vector is fully built before any chunk task starts.
+            std::string_view data = gf.file.data();
+            size_t begin = 0;
+            while (begin < size) {
+                size_t end = begin + kGrepChunkSize;
+                if (end >= size) {
+                    end = size;
+                } else {
+                    size_t nl = data.find('\n', end);
+                    end = nl == std::string_view::npos ? size : nl + 1;
+                }
+                GrepChunk chunk;
+                chunk.begin = begin;
+                chunk.end = end;
+                gf.chunks.push_back(std::move(chunk));
+                begin = end;
+            }
+            GrepFile* g = &gf;
+            for (auto& chunk : gf.chunks) {
+                GrepChunk* c = &chunk;
+                pool.submit([&scan_chunk, g, c] { scan_chunk(*g, *c); });
+            }
+        };
+
+        // deque buckets: files are appended while workers write into
+        // earlier entries
+        WalkOrder<GrepFile> order;
+        auto add_file = [&](std::deque<GrepFile>& bucket, std::string p) {
+            bucket.emplace_back();
+            GrepFile* gf = &bucket.back();
+            gf->path = std::move(p);
+            pool.submit([&, gf] { search_file(*gf); });
+        };
+
+        // Files are handed to the pool as the walk finds them, and the walk
+        // itself runs on the same pool, so searching overlaps with directory
+        // traversal. WalkOrder fixes output order.
+        try {
+            fs::path fpath(path);
+            if (!fs::exists(fpath))
+                throw py::value_error("grep: " + path + ": No such file or directory");
+
+            if (fs::is_regular_file(fpath)) {
+                add_file(order.node(order.root()), path);
+            } else if (fs::is_directory(fpath) && recursive) {
+                GrepWalkVisitor<decltype(add_file)> visitor(order, add_file);
+                walk_tree(path, pool, WalkOptions(), visitor, order.root());
+            } else if (fs::is_directory(fpath)) {
+                throw py::value_error("grep: " + path + ": Is a directory (use recursive=True)");
+            }
+        } catch (...) {
+            // Let queued tasks drain before the state they use goes away.
+            try { pool.wait(); } catch (...) {}
+            throw;
+        }
 
-    auto flags = std::regex_constants::ECMAScript;
-    if (ignore_case)
-        flags |= std::regex_constants::icase;
+        pool.wait();
+        files = order.take();
 
-    std::regex re;
-    try {
-        re = std::regex(regex_pattern, flags);
-    } catch (const std::regex_error& e) {
-        throw py::value_error("grep: invalid regex pattern: " + std::string(e.what()));
-    }
+        // Report the first failing file in walk order, as a serial scan would.
+        for (auto& gf : files) {
+            if (gf.error)
+                std::rethrow_exception(gf.error);
+        }
 
-    bool multi_file = files_to_search.size() > 1;
+        // Turn chunk-relative line numbers into file line numbers.
+        for (auto& gf : files) {
+            size_t base = 0;
+            for (auto& chunk : gf.chunks) {
+                if (gf.indexed)
+                    base = chunk.line_base;
+                gf.match_count += chunk.match_count;
+                for (auto& l : chunk.lines)
+                    l.line_number += base;
+                base += chunk.newlines;
+            }
+            gf.file = MappedFile();
+        }
+    }
 
+    // Build phase: Python objects are only created with the GIL held.
     if (count_only) {
         py::dict counts;
-        for (const auto& file : files_to_search) {
-            auto lines = read_lines(file);
-            int match_count = 0;
-            for (const auto& line : lines) {
-                bool match = std::regex_search(line, re);
-                if (invert) match = !match;
-                if (match) match_count++;
-            }
-            counts[py::cast(file)] = match_count;
-        }
+        for (const auto& gf : files)
+            counts[py::cast(gf.path)] = gf.match_count;
         return counts;
     }
 
     if (files_only) {
         py::list matching_files;
-        for (const auto& file : files_to_search) {
-            auto lines = read_lines(file);
-            for (const auto& line : lines) {
-                bool match = std::regex_search(line, re);
-                if (invert) match = !match;
-                if (match) {
-                    matching_files.append(file);
-                    break;
-                }
-            }
+        for (const auto& gf : files) {
+            if (gf.match_count > 0)
+                matching_files.append(gf.path);
         }
         return matching_files;
     }
 
+    bool multi_file = files.size() > 1;
     py::list results;
-    for (const auto& file : files_to_search) {
-        auto lines = read_lines(file);
-        for (int i = 0; i < static_cast<int>(lines.size()); i++) {
-            bool match = std::regex_search(lines[i], re);
-            if (invert) match = !match;
-            if (match) {
+    for (const auto& gf : files) {
+        for (const auto& chunk : gf.chunks) {
+            for (const auto& l : chunk.lines) {
                 py::dict entry;
                 if (multi_file)
-                    entry["file"] = file;
+                    entry["file"] = gf.path;
                 if (line_numbers)
-                    entry["line_number"] = i + 1;
-                entry["line"] = lines[i];
+                    entry["line_number"] = static_cast<int>(l.line_number);
+                entry["line"] = l.line;
                 results.append(entry);
             }
         }
@@ -232,203 +623,708 @@ static py::object grep_impl(const std::string& pattern,
     return results;
 }
 
+static py::dict index_build_impl(const std::string& path, const std::string& index,
+                                 long long block_size, int threads) {
+    if (threads < 0)
+        throw py::value_error("index_build: threads must be >= 0");
+    if (block_size <= 0)
+        throw py::value_error("index_build: block_size must be positive");
+
+    GrepIndexStats stats;
+    {
+        py::gil_scoped_release release;
+        try {
+            std::string index_path = index.empty() ? default_grep_index_path(path) : index;
+            ThreadPool pool(ThreadPool::resolve_threads(threads));
+            stats = update_grep_index(path, index_path, static_cast<size_t>(block_size), pool);
+        } catch (const std::exception& e) {
+            throw py::value_error(std::string("index_build: ") + e.what());
+        }
+    }
+
+    py::dict res;
+    res["index"] = stats.index;
+    res["files"] = stats.files;
+    res["blocks"] = stats.blocks;
+    res["trigrams"] = stats.trigrams;
+    res["indexed_bytes"] = stats.indexed_bytes;
+    res["new_bytes"] = stats.new_bytes;
+    res["unchanged"] = stats.unchanged;
+    res["appended"] = stats.appended;
+    res["reindexed"] = stats.reindexed;
+    res["removed"] = stats.removed;
+    return res;
+}
+
 // ---------------------------------------------------------------------------
-// sort — Sort lines of a file
+// Streaming iterators — grep_iter, cat_iter, tail_iter
+//
+// The list-returning commands materialize every result before returning.
+// These iterators instead hand back one bounded batch per __next__ call,
+// doing the native work for each batch with the GIL released, so memory
+// stays proportional to batch_size however large the input is.
 // ---------------------------------------------------------------------------
 
-static std::string sort_impl(const std::string& path,
-                               bool reverse,
-                               bool numeric,
-                               bool unique,
-                               int key,
-                               const std::string& separator,
-                               bool ignore_case) {
-    auto lines = read_lines(path);
-
-    auto get_key = [&](const std::string& line) -> std::string {
-        if (key <= 0) return line;
-        std::istringstream iss(line);
-        std::string token;
-        char sep = separator.empty() ? ' ' : separator[0];
-
-        if (separator.empty()) {
-            for (int i = 0; i < key; i++) {
-                if (!(iss >> token)) return "";
-            }
+// Rejects re-entrant __next__ calls (e.g. from two Python threads) while
+// a batch is being produced without the GIL.
+struct IterBusyGuard {
+    bool& busy;
+    IterBusyGuard(bool& flag, const char* cmd) : busy(flag) {
+        if (busy)
+            throw py::value_error(std::string(cmd) + ": iterator is already running");
+        busy = true;
+    }
+    ~IterBusyGuard() { busy = false; }
+};
+
+struct GrepIterLine {
+    size_t file_slot;
+    size_t line_number;
+    std::string line;
+};
+
+class GrepIterator {
+public:
+    GrepIterator(std::unique_ptr<Matcher> matcher, const std::string& path,
+                 bool recursive, bool line_numbers, bool invert,
+                 int max_count, size_t batch_size)
+        : matcher_(std::move(matcher)), root_(path), recursive_(recursive),
+          line_numbers_(line_numbers), invert_(invert), max_count_(max_count),
+          batch_size_(batch_size) {
+        if (recursive_)
+            walk_ = std::make_unique<WalkStream>(root_);
+    }
+
+    py::list next() {
+        IterBusyGuard guard(busy_, "grep_iter");
+        std::vector<std::string> paths;
+        std::vector<GrepIterLine> batch;
+        {
+            py::gil_scoped_release release;
+            fill(paths, batch);
+        }
+        if (batch.empty())
+            throw py::stop_iteration();
+
+        py::list results;
+        for (const auto& m : batch) {
+            py::dict entry;
+            if (recursive_)
+                entry["file"] = paths[m.file_slot];
+            if (line_numbers_)
+                entry["line_number"] = static_cast<int>(m.line_number);
+            entry["line"] = m.line;
+            results.append(entry);
+        }
+        return results;
+    }
+
+    void close() {
+        IterBusyGuard guard(busy_, "grep_iter");
+        done_ = true;
+        close_file();
+        walk_.reset();
+    }
+
+private:
+    bool open_next_file() {
+        std::string next_path;
+        if (!recursive_) {
+            if (root_taken_) return false;
+            root_taken_ = true;
+            next_path = root_;
         } else {
-            std::string temp = line;
-            for (int i = 1; i < key; i++) {
-                auto pos = temp.find(sep);
-                if (pos == std::string::npos) return "";
-                temp = temp.substr(pos + 1);
+            while (walk_ && walk_->next()) {
+                const WalkEntry& entry = walk_->entry();
+                if (entry.target_type() == EntryType::file) {
+                    next_path = entry.path();
+                    break;
+                }
             }
-            auto pos = temp.find(sep);
-            token = (pos != std::string::npos) ? temp.substr(0, pos) : temp;
+            if (next_path.empty()) return false;
         }
-        return token;
-    };
 
-    if (numeric) {
-        std::sort(lines.begin(), lines.end(),
-                  [&](const std::string& a, const std::string& b) {
-                      try {
-                          double va = std::stod(get_key(a));
-                          double vb = std::stod(get_key(b));
-                          return va < vb;
-                      } catch (...) {
-                          return a < b;
-                      }
-                  });
-    } else if (ignore_case) {
-        std::sort(lines.begin(), lines.end(),
-                  [&](const std::string& a, const std::string& b) {
-                      std::string ka = get_key(a), kb = get_key(b);
-                      std::transform(ka.begin(), ka.end(), ka.begin(), ::tolower);
-                      std::transform(kb.begin(), kb.end(), kb.begin(), ::tolower);
-                      return ka < kb;
-                  });
-    } else {
-        std::sort(lines.begin(), lines.end(),
-                  [&](const std::string& a, const std::string& b) {
-                      return get_key(a) < get_key(b);
-                  });
+        if (file_.open(next_path) != 0)
+            throw py::value_error("Cannot open file: " + next_path);
+        file_path_ = std::move(next_path);
+        file_open_ = true;
+        pos_ = 0;
+        line_base_ = 0;
+        file_matches_ = 0;
+        return true;
+    }
+
+    void close_file() {
+        file_ = MappedFile();
+        file_open_ = false;
     }
 
-    if (reverse)
-        std::reverse(lines.begin(), lines.end());
+    void fill(std::vector<std::string>& paths, std::vector<GrepIterLine>& batch) {
+        while (!done_ && batch.size() < batch_size_) {
+            if (!file_open_ && !open_next_file()) {
+                done_ = true;
+                break;
+            }
+            if (max_count_ == 0) {
+                close_file();
+                continue;
+            }
+
+            size_t slot = paths.size();
+            paths.push_back(file_path_);
+
+            std::string_view rest = file_.data().substr(pos_);
+            bool paused = false;
+            size_t last_line = 0, last_end = 0;
+            scan_lines(*matcher_, rest, invert_,
+                       [&](size_t line_no, std::string_view line) {
+                           batch.push_back({slot, line_base_ + line_no, std::string(line)});
+                           file_matches_++;
+                           if (max_count_ > 0 && file_matches_ >= max_count_)
+                               return false;
+                           if (batch.size() >= batch_size_) {
+                               paused = true;
+                               last_line = line_no;
+                               last_end = static_cast<size_t>(line.data() + line.size() - rest.data());
+                               return false;
+                           }
+                           return true;
+                       });
+
+            if (paused) {
+                // Resume after the last reported line on the next call.
+                pos_ = std::min(file_.size(), pos_ + last_end + 1);
+                line_base_ += last_line;
+            } else {
+                close_file();
+            }
+        }
+        if (done_)
+            close_file();
+    }
+
+    std::unique_ptr<Matcher> matcher_;
+    std::string root_;
+    bool recursive_;
+    bool line_numbers_;
+    bool invert_;
+    int max_count_;
+    size_t batch_size_;
+
+    std::unique_ptr<WalkStream> walk_;
+    bool root_taken_ = false;
+    bool done_ = false;
+    bool busy_ = false;
+
+    MappedFile file_;
+    std::string file_path_;
+    bool file_open_ = false;
+    size_t pos_ = 0;
+    size_t line_base_ = 0;
+    int file_matches_ = 0;
+};
+
+static std::unique_ptr<GrepIterator> grep_iter_impl(const std::string& pattern,
+                                                    const std::string& path,
+                                                    bool ignore_case,
+                                                    bool recursive,
+                                                    bool line_numbers,
+                                                    bool invert,
+                                                    bool whole_word,
+                                                    bool fixed_strings,
+                                                    int max_count,
+                                                    int batch_size) {
+    if (batch_size <= 0)
+        throw py::value_error("grep_iter: batch_size must be positive");
+
+    fs::path fpath(path);
+    if (!fs::exists(fpath))
+        throw py::value_error("grep_iter: " + path + ": No such file or directory");
+    bool is_dir = fs::is_directory(fpath);
+    if (is_dir && !recursive)
+        throw py::value_error("grep_iter: " + path + ": Is a directory (use recursive=True)");
+
+    MatchOptions opts;
+    opts.ignore_case = ignore_case;
+    opts.whole_word = whole_word;
+    opts.fixed_strings = fixed_strings;
+
+    std::unique_ptr<Matcher> matcher;
+    try {
+        matcher = compile_matcher(pattern, opts);
+    } catch (const std::regex_error& e) {
+        throw py::value_error("grep_iter: invalid regex pattern: " + std::string(e.what()));
+    }
+
+    return std::make_unique<GrepIterator>(std::move(matcher), path, is_dir,
+                                          line_numbers, invert, max_count,
+                                          static_cast<size_t>(batch_size));
+}
 
-    if (unique) {
-        lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+// Yields batches of whole lines from a mapped file, with cat's formatting.
+// With a follower (tail_iter(follow=True)), the mapped snapshot is read up
+// to its last complete line and the follower takes over from there. Waiting
+// happens in short slices with the GIL released, checking for signals in
+// between so Ctrl-C still interrupts an idle follow.
+static constexpr int kFollowSliceMs = 200;
+
+class LineIterator {
+public:
+    LineIterator(MappedFile file, size_t offset, size_t end, CatState state,
+                 size_t batch_size)
+        : file_(std::move(file)), reader_(file_.data().substr(offset, end - offset)),
+          state_(state), batch_size_(batch_size) {}
+
+    void follow(std::unique_ptr<FileFollower> follower, double timeout) {
+        follower_ = std::move(follower);
+        timeout_ms_ = timeout < 0 ? -1 : static_cast<long long>(timeout * 1000);
     }
 
-    std::ostringstream oss;
-    for (const auto& line : lines)
-        oss << line << "\n";
-    return oss.str();
+    std::string next() {
+        IterBusyGuard guard(busy_, "line iterator");
+        std::string out;
+        {
+            py::gil_scoped_release release;
+            if (cat_lines(reader_, state_, out, batch_size_) == 0)
+                file_ = MappedFile();
+        }
+        if (out.empty() && follower_)
+            wait_for_lines(out);
+        if (out.empty())
+            throw py::stop_iteration();
+        return out;
+    }
+
+    void close() {
+        IterBusyGuard guard(busy_, "line iterator");
+        file_ = MappedFile();
+        reader_ = LineReader(std::string_view());
+        follower_.reset();
+    }
+
+private:
+    void wait_for_lines(std::string& out) {
+        using clock = std::chrono::steady_clock;
+        auto deadline = clock::now() + std::chrono::milliseconds(std::max(timeout_ms_, 0LL));
+        for (;;) {
+            int slice = kFollowSliceMs;
+            if (timeout_ms_ >= 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - clock::now()).count();
+                slice = static_cast<int>(std::max<long long>(0, std::min<long long>(left, slice)));
+            }
+            size_t n;
+            try {
+                py::gil_scoped_release release;
+                n = follower_->read_lines(out, batch_size_, slice);
+            } catch (const std::runtime_error& e) {
+                throw py::value_error(std::string("tail_iter: ") + e.what());
+            }
+            if (n > 0)
+                return;
+            if (PyErr_CheckSignals() != 0)
+                throw py::error_already_set();
+            if (timeout_ms_ >= 0 && clock::now() >= deadline)
+                return;
+        }
+    }
+
+    MappedFile file_;
+    LineReader reader_;
+    CatState state_;
+    size_t batch_size_;
+    std::unique_ptr<FileFollower> follower_;
+    long long timeout_ms_ = -1;
+    bool busy_ = false;
+};
+
+static std::unique_ptr<LineIterator> cat_iter_impl(const std::string& path,
+                                                   bool number_lines,
+                                                   bool squeeze_blank,
+                                                   int batch_size) {
+    if (batch_size <= 0)
+        throw py::value_error("cat_iter: batch_size must be positive");
+    CatState state;
+    state.number_lines = number_lines;
+    state.squeeze_blank = squeeze_blank;
+    auto file = open_mapped(path);
+    size_t size = file.size();
+    return std::make_unique<LineIterator>(std::move(file), 0, size, state,
+                                          static_cast<size_t>(batch_size));
+}
+
+static std::unique_ptr<LineIterator> tail_iter_impl(const std::string& path,
+                                                    int n,
+                                                    int batch_size,
+                                                    bool follow,
+                                                    double timeout) {
+    if (batch_size <= 0)
+        throw py::value_error("tail_iter: batch_size must be positive");
+    auto file = open_mapped(path);
+    std::string_view data = file.data();
+    size_t offset = tail_offset(data, static_cast<size_t>(std::max(0, n)));
+    size_t end = data.size();
+    if (follow) {
+        // An unterminated last line may still be growing; leave it to the
+        // follower.
+        const char* nl = static_cast<const char*>(memrchr(data.data(), '\n', end));
+        end = nl ? static_cast<size_t>(nl - data.data()) + 1 : 0;
+        offset = std::min(offset, end);
+    }
+
+    auto it = std::make_unique<LineIterator>(std::move(file), offset, end, CatState(),
+                                             static_cast<size_t>(batch_size));
+    if (follow) {
+        try {
+            it->follow(std::make_unique<FileFollower>(path, end), timeout);
+        } catch (const std::runtime_error& e) {
+            throw py::value_error(std::string("tail_iter: ") + e.what());
+        }
+    }
+    return it;
+}
+
+// ---------------------------------------------------------------------------
+// sort — Sort lines of a file
+// ---------------------------------------------------------------------------
+
+static std::string sort_text(const std::string& path,
+                               bool reverse,
+                               bool numeric,
+                               bool unique,
+                               int key,
+                               const std::string& separator,
+                               bool ignore_case,
+                               long long buffer_size,
+                               const std::string& output,
+                               const std::string& temp_dir,
+                               int threads) {
+    if (buffer_size < 0)
+        throw py::value_error("sort: buffer_size must be >= 0");
+    if (threads < 0)
+        throw py::value_error("sort: threads must be >= 0");
+
+    auto file = open_mapped(path);
+
+    SortOptions opts;
+    opts.reverse = reverse;
+    opts.numeric = numeric;
+    opts.unique = unique;
+    opts.ignore_case = ignore_case;
+    opts.key = key;
+    opts.separator = separator;
+    opts.buffer_size = static_cast<size_t>(buffer_size);
+    opts.threads = ThreadPool::resolve_threads(threads);
+    opts.temp_dir = temp_dir;
+
+    TextOutput out("sort", output);
+    out.reserve(file.size() + 1);
+    try {
+        sort_lines(file.data(), opts, [&](std::string_view block) { out.write(block); });
+    } catch (const std::runtime_error& e) {
+        throw py::value_error(std::string("sort: ") + e.what());
+    }
+    return out.finish();
+}
+
+static py::object sort_impl(const std::string& path, bool reverse, bool numeric, bool unique,
+                            int key, const std::string& separator, bool ignore_case,
+                            long long buffer_size, const std::string& output,
+                            const std::string& temp_dir, int threads, bool as_bytes) {
+    return text_result(as_bytes, [&] {
+        return owned_buffer(sort_text(path, reverse, numeric, unique, key, separator,
+                                      ignore_case, buffer_size, output, temp_dir, threads));
+    });
 }
 
 // ---------------------------------------------------------------------------
 // diff — Compare two files line by line
 // ---------------------------------------------------------------------------
 
+// "start,count" for a unified hunk header, GNU style: the count is omitted
+// when it is 1, and an empty range names the line before it.
+static std::string hunk_range(size_t begin, size_t end) {
+    size_t count = end - begin;
+    if (count == 1)
+        return std::to_string(begin + 1);
+    return std::to_string(count == 0 ? begin : begin + 1) + "," + std::to_string(count);
+}
+
 static std::string diff_impl(const std::string& file1, const std::string& file2,
                                bool unified, int context_lines) {
-    auto lines1 = read_lines(file1);
-    auto lines2 = read_lines(file2);
-
-    int n = static_cast<int>(lines1.size());
-    int m = static_cast<int>(lines2.size());
-
-    // LCS-based diff using dynamic programming
-    std::vector<std::vector<int>> dp(n + 1, std::vector<int>(m + 1, 0));
-    for (int i = 1; i <= n; i++) {
-        for (int j = 1; j <= m; j++) {
-            if (lines1[i - 1] == lines2[j - 1])
-                dp[i][j] = dp[i - 1][j - 1] + 1;
-            else
-                dp[i][j] = std::max(dp[i - 1][j], dp[i][j - 1]);
-        }
-    }
-
-    // Backtrack to find diff
-    struct DiffLine { char type; std::string text; int line1; int line2; };
-    std::vector<DiffLine> diffs;
-    int i = n, j = m;
-    while (i > 0 || j > 0) {
-        if (i > 0 && j > 0 && lines1[i - 1] == lines2[j - 1]) {
-            diffs.push_back({' ', lines1[i - 1], i, j});
-            i--; j--;
-        } else if (j > 0 && (i == 0 || dp[i][j - 1] >= dp[i - 1][j])) {
-            diffs.push_back({'+', lines2[j - 1], 0, j});
-            j--;
-        } else {
-            diffs.push_back({'-', lines1[i - 1], i, 0});
-            i--;
+    if (context_lines < 0)
+        throw py::value_error("diff: context_lines must be >= 0");
+
+    auto mapped1 = open_mapped(file1);
+    auto mapped2 = open_mapped(file2);
+    auto lines1 = split_lines(mapped1.data());
+    auto lines2 = split_lines(mapped2.data());
+    bool terminated1 = mapped1.size() == 0 || mapped1.data().back() == '\n';
+    bool terminated2 = mapped2.size() == 0 || mapped2.data().back() == '\n';
+
+    std::vector<uint32_t> ids1, ids2;
+    intern_lines(lines1, terminated1, lines2, terminated2, ids1, ids2);
+    DiffResult result = diff_sequences(ids1, ids2);
+    auto hunks = diff_hunks(result, unified ? static_cast<size_t>(context_lines) : 0);
+
+    std::string out;
+    if (hunks.empty())
+        return out;
+
+    if (!unified) {
+        for (const auto& h : hunks) {
+            for (const auto& c : h.changes) {
+                for (size_t i = c.a_begin; i < c.a_end; i++) {
+                    out += "- ";
+                    append_line(out, lines1[i]);
+                }
+                for (size_t j = c.b_begin; j < c.b_end; j++) {
+                    out += "+ ";
+                    append_line(out, lines2[j]);
+                }
+            }
         }
+        return out;
     }
-    std::reverse(diffs.begin(), diffs.end());
 
-    std::ostringstream oss;
-    if (unified) {
-        oss << "--- " << file1 << "\n";
-        oss << "+++ " << file2 << "\n";
-    }
+    auto emit = [&](char prefix, const std::vector<std::string_view>& lines,
+                    size_t index, bool terminated) {
+        out += prefix;
+        append_line(out, lines[index]);
+        if (!terminated && index + 1 == lines.size())
+            out += "\\ No newline at end of file\n";
+    };
 
-    for (const auto& d : diffs) {
-        if (d.type != ' ' || unified) {
-            oss << d.type << " " << d.text << "\n";
+    out += "--- " + file1 + "\n";
+    out += "+++ " + file2 + "\n";
+    for (const auto& h : hunks) {
+        out += "@@ -" + hunk_range(h.a_begin, h.a_end) +
+               " +" + hunk_range(h.b_begin, h.b_end) + " @@\n";
+        size_t i = h.a_begin, j = h.b_begin;
+        for (const auto& c : h.changes) {
+            for (; i < c.a_begin; i++, j++)
+                emit(' ', lines1, i, terminated1);
+            for (; i < c.a_end; i++)
+                emit('-', lines1, i, terminated1);
+            for (; j < c.b_end; j++)
+                emit('+', lines2, j, terminated2);
         }
+        for (; i < h.a_end; i++, j++)
+            emit(' ', lines1, i, terminated1);
     }
 
-    return oss.str();
+    return out;
 }
 
 // ---------------------------------------------------------------------------
 // cmp — Compare two files byte by byte
 // ---------------------------------------------------------------------------
 
+// Index of the first byte where a and b differ, or n if they are equal.
+// Whole blocks are skipped with memcmp, then the differing word is located
+// 8 bytes at a time.
+static size_t first_mismatch(const char* a, const char* b, size_t n) {
+    constexpr size_t kBlock = 4096;
+    size_t i = 0;
+    while (i + kBlock <= n && std::memcmp(a + i, b + i, kBlock) == 0)
+        i += kBlock;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t x, y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        if (x != y) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return i + static_cast<size_t>(__builtin_ctzll(x ^ y)) / 8;
+#else
+            return i + static_cast<size_t>(__builtin_clzll(x ^ y)) / 8;
+#endif
+        }
+    }
+    for (; i < n; i++)
+        if (a[i] != b[i]) return i;
+    return n;
+}
+
+struct CmpRange {
+    size_t offset;       // 0-based index of the first differing byte
+    size_t length;
+    size_t line_number;  // line of file1 holding the first byte
+};
+
 static py::dict cmp_impl(const std::string& file1, const std::string& file2,
-                           bool silent) {
-    std::ifstream ifs1(file1, std::ios::binary);
-    std::ifstream ifs2(file2, std::ios::binary);
-    if (!ifs1.is_open())
-        throw py::value_error("cmp: " + file1 + ": No such file or directory");
-    if (!ifs2.is_open())
-        throw py::value_error("cmp: " + file2 + ": No such file or directory");
-
-    long byte_offset = 0;
-    int line_number = 1;
-    bool identical = true;
+                           bool silent, int max_diffs) {
+    if (max_diffs < 0)
+        throw py::value_error("cmp: max_diffs must be >= 0");
 
-    char c1, c2;
-    while (ifs1.get(c1) && ifs2.get(c2)) {
-        byte_offset++;
-        if (c1 == '\n') line_number++;
-        if (c1 != c2) {
+    bool identical = true;
+    std::vector<CmpRange> ranges;
+    size_t size1 = 0, size2 = 0;
+    size_t byte_offset = 0, line_number = 1;
+
+    {
+        py::gil_scoped_release release;
+
+        struct stat st1, st2;
+        if (::stat(file1.c_str(), &st1) != 0)
+            throw py::value_error("cmp: " + file1 + ": No such file or directory");
+        if (::stat(file2.c_str(), &st2) != 0)
+            throw py::value_error("cmp: " + file2 + ": No such file or directory");
+
+        bool regular = S_ISREG(st1.st_mode) && S_ISREG(st2.st_mode);
+        bool same_file = st1.st_dev == st2.st_dev && st1.st_ino == st2.st_ino;
+        bool sizes_differ = regular && st1.st_size != st2.st_size;
+
+        if (regular && same_file) {
+            // Same inode: identical without reading anything
+        } else if (silent && sizes_differ) {
+            // cmp -s only needs a yes/no answer
             identical = false;
-            break;
+        } else {
+            MappedFile mapped1, mapped2;
+            if (mapped1.open(file1) != 0)
+                throw py::value_error("cmp: " + file1 + ": No such file or directory");
+            if (mapped2.open(file2) != 0)
+                throw py::value_error("cmp: " + file2 + ": No such file or directory");
+
+            auto a = mapped1.data();
+            auto b = mapped2.data();
+            size1 = a.size();
+            size2 = b.size();
+            size_t common = std::min(size1, size2);
+
+            size_t first = first_mismatch(a.data(), b.data(), common);
+            identical = first == common && size1 == size2;
+
+            if (!identical && !silent) {
+                // Lines are only counted up to the first difference
+                byte_offset = first + 1;
+                line_number = 1 + count_newlines(a.data(), first);
+
+                size_t pos = first, counted = first, line = line_number;
+                while (ranges.size() < static_cast<size_t>(max_diffs) && pos < common) {
+                    size_t end = pos;
+                    while (end < common && a[end] != b[end]) end++;
+                    line += count_newlines(a.data() + counted, pos - counted);
+                    counted = pos;
+                    ranges.push_back({pos, end - pos, line});
+                    pos = end + first_mismatch(a.data() + end, b.data() + end, common - end);
+                }
+            }
         }
     }
 
-    if (identical && (ifs1.get(c1) || ifs2.get(c2))) {
-        identical = false;
-        byte_offset++;
-    }
-
     py::dict result;
     result["identical"] = identical;
-    if (!identical && !silent) {
-        result["byte_offset"] = byte_offset;
-        result["line_number"] = line_number;
+    if (identical || silent)
+        return result;
+
+    result["byte_offset"] = byte_offset;
+    result["line_number"] = line_number;
+    if (byte_offset > std::min(size1, size2)) {
+        // One file is a prefix of the other
+        const std::string& shorter = size1 < size2 ? file1 : file2;
+        result["message"] = "EOF on " + shorter + " after byte " +
+                           std::to_string(byte_offset - 1) + ", line " +
+                           std::to_string(line_number);
+    } else {
         result["message"] = file1 + " " + file2 + " differ: byte " +
                            std::to_string(byte_offset) + ", line " +
                            std::to_string(line_number);
     }
+
+    if (max_diffs > 0) {
+        py::list diffs;
+        for (const auto& r : ranges) {
+            py::dict d;
+            d["byte_offset"] = r.offset + 1;
+            d["length"] = r.length;
+            d["line_number"] = r.line_number;
+            diffs.append(d);
+        }
+        result["differences"] = diffs;
+    }
     return result;
 }
 
 // ---------------------------------------------------------------------------
 // comm — Compare two sorted files line by line
+//
+// With assume_sorted the files are merged in one streaming pass over the
+// mappings, so no per-line index is built; repeated lines are skipped, which
+// gives the same result as the set-based mode for sorted input.
 // ---------------------------------------------------------------------------
 
-static py::dict comm_impl(const std::string& file1, const std::string& file2) {
-    auto lines1 = read_lines(file1);
-    auto lines2 = read_lines(file2);
+// Steps `reader` to the next line that differs from `line`, checking the
+// byte order on the way. Returns false at end of file.
+static bool comm_next_distinct(LineReader& reader, std::string_view& line,
+                               bool& has_line, int file) {
+    std::string_view next;
+    while (reader.next(next)) {
+        if (!has_line || next > line) {
+            line = next;
+            has_line = true;
+            return true;
+        }
+        if (next < line)
+            throw py::value_error("comm: file " + std::to_string(file) +
+                                  " is not in sorted order");
+    }
+    return false;
+}
 
-    std::set<std::string> set1(lines1.begin(), lines1.end());
-    std::set<std::string> set2(lines2.begin(), lines2.end());
+static py::dict comm_impl(const std::string& file1, const std::string& file2,
+                          bool assume_sorted) {
+    std::vector<std::string> only_in_1, only_in_2, in_both;
+
+    {
+        py::gil_scoped_release release;
+
+        auto mapped1 = open_mapped(file1);
+        auto mapped2 = open_mapped(file2);
+
+        if (assume_sorted) {
+            LineReader reader1(mapped1.data());
+            LineReader reader2(mapped2.data());
+            std::string_view line1, line2;
+            bool has1 = false, has2 = false;
+            bool more1 = comm_next_distinct(reader1, line1, has1, 1);
+            bool more2 = comm_next_distinct(reader2, line2, has2, 2);
+            while (more1 && more2) {
+                int c = line1.compare(line2);
+                if (c < 0) {
+                    only_in_1.emplace_back(line1);
+                    more1 = comm_next_distinct(reader1, line1, has1, 1);
+                } else if (c > 0) {
+                    only_in_2.emplace_back(line2);
+                    more2 = comm_next_distinct(reader2, line2, has2, 2);
+                } else {
+                    in_both.emplace_back(line1);
+                    more1 = comm_next_distinct(reader1, line1, has1, 1);
+                    more2 = comm_next_distinct(reader2, line2, has2, 2);
+                }
+            }
+            for (; more1; more1 = comm_next_distinct(reader1, line1, has1, 1))
+                only_in_1.emplace_back(line1);
+            for (; more2; more2 = comm_next_distinct(reader2, line2, has2, 2))
+                only_in_2.emplace_back(line2);
+        } else {
+            auto lines1 = split_lines(mapped1.data());
+            auto lines2 = split_lines(mapped2.data());
 
-    py::list only_in_1, only_in_2, in_both;
+            std::set<std::string_view> set1(lines1.begin(), lines1.end());
+            std::set<std::string_view> set2(lines2.begin(), lines2.end());
 
-    for (const auto& line : set1) {
-        if (set2.count(line))
-            in_both.append(line);
-        else
-            only_in_1.append(line);
-    }
-    for (const auto& line : set2) {
-        if (!set1.count(line))
-            only_in_2.append(line);
+            for (const auto& line : set1) {
+                if (set2.count(line))
+                    in_both.emplace_back(line);
+                else
+                    only_in_1.emplace_back(line);
+            }
+            for (const auto& line : set2) {
+                if (!set1.count(line))
+                    only_in_2.emplace_back(line);
+            }
+        }
     }
 
     py::dict result;
@@ -442,171 +1338,474 @@ static py::dict comm_impl(const std::string& file1, const std::string& file2) {
 // wc — Word, line, character, byte count
 // ---------------------------------------------------------------------------
 
-static py::dict wc_impl(const std::string& path,
-                          bool lines_only,
-                          bool words_only,
-                          bool chars_only,
-                          bool bytes_only) {
-    std::ifstream ifs(path, std::ios::binary);
-    if (!ifs.is_open())
-        throw py::value_error("wc: " + path + ": No such file or directory");
-
-    long line_count = 0, word_count = 0, char_count = 0, byte_count = 0;
-    bool in_word = false;
+// Large files are split into chunks counted on separate workers; the word
+// state at each boundary comes from the byte before the chunk.
+static constexpr size_t kWcChunkSize = 16 * 1024 * 1024;
+
+struct WcFile {
+    std::string path;
+    MappedFile file;
+    std::vector<WcCounts> chunks;
+    std::exception_ptr error;
+};
+
+static void wc_collect(std::vector<WcFile>& files, int threads) {
+    ThreadPool pool(ThreadPool::resolve_threads(threads));
+
+    for (auto& wf : files) {
+        WcFile* f = &wf;
+        pool.submit([&pool, f] {
+            if (f->file.open(f->path) != 0) {
+                f->error = std::make_exception_ptr(
+                    py::value_error("wc: " + f->path + ": No such file or directory"));
+                return;
+            }
+            std::string_view data = f->file.data();
+            size_t nchunks = pool.size() < 2 || data.size() <= 2 * kWcChunkSize
+                ? 1 : (data.size() + kWcChunkSize - 1) / kWcChunkSize;
+            f->chunks.resize(nchunks);
+            if (nchunks == 1) {
+                f->chunks[0] = wc_count(data);
+                return;
+            }
+            for (size_t c = 0; c < nchunks; c++) {
+                pool.submit([f, data, c] {
+                    size_t begin = c * kWcChunkSize;
+                    bool prev_in_word = begin > 0 &&
+                        !wc_is_space(static_cast<unsigned char>(data[begin - 1]));
+                    f->chunks[c] = wc_count(data.substr(begin, kWcChunkSize), prev_in_word);
+                });
+            }
+        });
+    }
+    pool.wait();
 
-    char c;
-    while (ifs.get(c)) {
-        byte_count++;
-        char_count++;
-        if (c == '\n') line_count++;
-        if (std::isspace(static_cast<unsigned char>(c))) {
-            in_word = false;
-        } else if (!in_word) {
-            in_word = true;
-            word_count++;
-        }
+    for (auto& wf : files) {
+        if (wf.error)
+            std::rethrow_exception(wf.error);
+        wf.file = MappedFile();
     }
+}
+
+static py::dict wc_result(const WcFile& wf,
+                            bool lines_only,
+                            bool words_only,
+                            bool chars_only,
+                            bool bytes_only) {
+    WcCounts total;
+    for (const auto& c : wf.chunks)
+        total += c;
 
     py::dict result;
-    result["file"] = path;
+    result["file"] = wf.path;
 
-    if (lines_only)      { result["lines"] = line_count; return result; }
-    if (words_only)      { result["words"] = word_count; return result; }
-    if (chars_only)      { result["chars"] = char_count; return result; }
-    if (bytes_only)      { result["bytes"] = byte_count; return result; }
+    if (lines_only)      { result["lines"] = total.lines; return result; }
+    if (words_only)      { result["words"] = total.words; return result; }
+    if (chars_only)      { result["chars"] = total.chars; return result; }
+    if (bytes_only)      { result["bytes"] = total.bytes; return result; }
 
-    result["lines"] = line_count;
-    result["words"] = word_count;
-    result["chars"] = char_count;
-    result["bytes"] = byte_count;
+    result["lines"] = total.lines;
+    result["words"] = total.words;
+    result["chars"] = total.chars;
+    result["bytes"] = total.bytes;
     return result;
 }
 
+static py::dict wc_impl(const std::string& path,
+                          bool lines_only,
+                          bool words_only,
+                          bool chars_only,
+                          bool bytes_only,
+                          int threads) {
+    if (threads < 0)
+        throw py::value_error("wc: threads must be >= 0");
+
+    std::vector<WcFile> files(1);
+    files[0].path = path;
+    {
+        py::gil_scoped_release release;
+        wc_collect(files, threads);
+    }
+    return wc_result(files[0], lines_only, words_only, chars_only, bytes_only);
+}
+
+static py::list wc_many_impl(const std::vector<std::string>& paths,
+                               bool lines_only,
+                               bool words_only,
+                               bool chars_only,
+                               bool bytes_only,
+                               int threads) {
+    if (threads < 0)
+        throw py::value_error("wc: threads must be >= 0");
+
+    std::vector<WcFile> files(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+        files[i].path = paths[i];
+    {
+        py::gil_scoped_release release;
+        wc_collect(files, threads);
+    }
+
+    py::list results;
+    for (const auto& wf : files)
+        results.append(wc_result(wf, lines_only, words_only, chars_only, bytes_only));
+    return results;
+}
+
 // ---------------------------------------------------------------------------
 // cut — Remove sections from each line of files
 // ---------------------------------------------------------------------------
 
-static std::string cut_impl(const std::string& path,
+static std::string cut_text(const std::string& path,
                               const std::string& delimiter,
                               const std::string& fields) {
-    auto lines = read_lines(path);
-    char sep = delimiter.empty() ? '\t' : delimiter[0];
-
-    // Parse fields like "1,3" or "1-3" or "2"
-    std::set<int> field_set;
-    std::istringstream fss(fields);
-    std::string part;
-    while (std::getline(fss, part, ',')) {
-        auto dash = part.find('-');
-        if (dash != std::string::npos) {
-            int start = std::stoi(part.substr(0, dash));
-            int end = std::stoi(part.substr(dash + 1));
-            for (int i = start; i <= end; i++)
-                field_set.insert(i);
-        } else {
-            field_set.insert(std::stoi(part));
-        }
+    std::vector<FieldRange> ranges;
+    try {
+        ranges = parse_field_list(fields);
+    } catch (const std::invalid_argument& e) {
+        throw py::value_error(std::string("cut: ") + e.what());
     }
 
-    std::ostringstream oss;
-    for (const auto& line : lines) {
-        std::vector<std::string> tokens;
-        std::istringstream lss(line);
-        std::string token;
-        while (std::getline(lss, token, sep))
-            tokens.push_back(token);
+    auto file = open_mapped(path);
+    const std::string sep = delimiter.empty() ? "\t" : delimiter;
+    FieldSplitter splitter(sep);
 
+    std::string out;
+    LineReader reader(file.data());
+    std::string_view line;
+    while (reader.next(line)) {
         bool first = true;
-        for (int f : field_set) {
-            if (f >= 1 && f <= static_cast<int>(tokens.size())) {
-                if (!first) oss << sep;
-                oss << tokens[f - 1];
-                first = false;
-            }
-        }
-        oss << "\n";
+        select_fields(splitter, line, ranges, [&](std::string_view token) {
+            if (!first) out += sep;
+            out.append(token.data(), token.size());
+            first = false;
+        });
+        out += '\n';
     }
-    return oss.str();
+    return out;
+}
+
+static py::object cut_impl(const std::string& path, const std::string& delimiter,
+                           const std::string& fields, bool as_bytes) {
+    return text_result(as_bytes,
+                       [&] { return owned_buffer(cut_text(path, delimiter, fields)); });
 }
 
 // ---------------------------------------------------------------------------
 // paste — Merge lines of files
 // ---------------------------------------------------------------------------
 
-static std::string paste_impl(const std::vector<std::string>& files,
+static std::string paste_text(const std::vector<std::string>& files,
                                 const std::string& delimiter) {
-    std::vector<std::vector<std::string>> all_lines;
+    std::vector<MappedFile> mapped;
+    std::vector<std::vector<std::string_view>> all_lines;
     size_t max_lines = 0;
 
     for (const auto& file : files) {
-        auto lines = read_lines(file);
+        mapped.push_back(open_mapped(file));
+        auto lines = split_lines(mapped.back().data());
         max_lines = std::max(max_lines, lines.size());
         all_lines.push_back(std::move(lines));
     }
 
     std::string sep = delimiter.empty() ? "\t" : delimiter;
-    std::ostringstream oss;
+    std::string out;
 
     for (size_t i = 0; i < max_lines; i++) {
         for (size_t f = 0; f < all_lines.size(); f++) {
-            if (f > 0) oss << sep;
+            if (f > 0) out += sep;
             if (i < all_lines[f].size())
-                oss << all_lines[f][i];
+                out.append(all_lines[f][i].data(), all_lines[f][i].size());
         }
-        oss << "\n";
+        out += '\n';
     }
 
-    return oss.str();
+    return out;
+}
+
+static py::object paste_impl(const std::vector<std::string>& files,
+                             const std::string& delimiter, bool as_bytes) {
+    return text_result(as_bytes, [&] { return owned_buffer(paste_text(files, delimiter)); });
 }
 
 // ---------------------------------------------------------------------------
 // join — Join lines of two files on a common field
+//
+// The default mode hashes file2 into a flat open-addressing table and probes
+// it once per file1 line. With assume_sorted both files are merged in a
+// single pass instead: only the current run of equal keys in file2 is
+// revisited, and since it is a contiguous range of the mapping nothing is
+// copied, so memory stays constant however large the inputs are.
 // ---------------------------------------------------------------------------
 
-static std::string join_impl(const std::string& file1, const std::string& file2,
-                               int field1, int field2,
-                               const std::string& separator) {
-    auto lines1 = read_lines(file1);
-    auto lines2 = read_lines(file2);
-    char sep = separator.empty() ? ' ' : separator[0];
-
-    auto get_field = [&](const std::string& line, int field) -> std::string {
-        std::istringstream iss(line);
-        std::string token;
-        if (sep == ' ') {
-            for (int i = 0; i < field; i++) {
-                if (!(iss >> token)) return "";
-            }
-        } else {
-            std::string temp = line;
-            for (int i = 1; i < field; i++) {
-                auto pos = temp.find(sep);
-                if (pos == std::string::npos) return "";
-                temp = temp.substr(pos + 1);
+static void join_emit(TextOutput& out, std::string_view line1, std::string_view sep,
+                      std::string_view line2) {
+    out.write(line1);
+    out.write(sep);
+    out.line(line2);
+}
+
+// Keys of file2 mapped to the chain of lines carrying them. Slots hold the
+// key hash and the first and last line of the chain; next_ links the lines
+// in file order, so matches come out as they appear in file2.
+class JoinTable {
+public:
+    JoinTable(const std::vector<std::string_view>& lines, size_t field,
+              const FieldSplitter& splitter)
+        : lines_(lines), keys_(lines.size()), next_(lines.size(), npos) {
+        size_t capacity = 16;
+        while (capacity < lines.size() * 2)
+            capacity <<= 1;
+        slots_.assign(capacity, Slot{});
+        mask_ = capacity - 1;
+
+        for (size_t i = 0; i < lines.size(); i++) {
+            keys_[i] = splitter.field(lines[i], field);
+            size_t h = std::hash<std::string_view>{}(keys_[i]);
+            Slot& slot = probe(keys_[i], h);
+            if (slot.first == npos) {
+                slot = Slot{h, i, i};
+            } else {
+                next_[slot.last] = i;
+                slot.last = i;
             }
-            auto pos = temp.find(sep);
-            token = (pos != std::string::npos) ? temp.substr(0, pos) : temp;
         }
-        return token;
+    }
+
+    // First line of file2 with `key`, or npos; continue with next().
+    size_t find(std::string_view key) const {
+        return const_cast<JoinTable*>(this)->probe(
+            key, std::hash<std::string_view>{}(key)).first;
+    }
+
+    size_t next(size_t i) const { return next_[i]; }
+    std::string_view line(size_t i) const { return lines_[i]; }
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+    struct Slot {
+        size_t hash = 0;
+        size_t first = npos;
+        size_t last = npos;
     };
 
-    // Build index on file2
-    std::multimap<std::string, std::string> index2;
-    for (const auto& line : lines2) {
-        std::string key = get_field(line, field2);
-        index2.emplace(key, line);
+    // Linear probing; the table is at most half full, so runs stay short.
+    Slot& probe(std::string_view key, size_t h) {
+        for (size_t idx = h & mask_;; idx = (idx + 1) & mask_) {
+            Slot& slot = slots_[idx];
+            if (slot.first == npos ||
+                (slot.hash == h && keys_[slot.first] == key))
+                return slot;
+        }
+    }
+
+    const std::vector<std::string_view>& lines_;
+    std::vector<std::string_view> keys_;
+    std::vector<size_t> next_;
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+};
+
+// Line reader for the sorted join: yields lines with their keys and checks
+// that the keys never decrease.
+class SortedKeyReader {
+public:
+    SortedKeyReader(std::string_view data, size_t field,
+                    const FieldSplitter& splitter, int file)
+        : reader_(data), field_(field), splitter_(splitter), file_(file) {
+        advance();
+    }
+
+    bool has() const { return has_; }
+    std::string_view line() const { return line_; }
+    std::string_view key() const { return key_; }
+
+    void advance() {
+        std::string_view prev = key_;
+        has_ = reader_.next(line_);
+        if (!has_)
+            return;
+        key_ = splitter_.field(line_, field_);
+        if (started_ && key_ < prev)
+            throw py::value_error("join: file" + std::to_string(file_) +
+                                  " is not sorted on the join field");
+        started_ = true;
+    }
+
+private:
+    LineReader reader_;
+    size_t field_;
+    const FieldSplitter& splitter_;
+    int file_;
+    bool has_ = false;
+    bool started_ = false;
+    std::string_view line_;
+    std::string_view key_;
+};
+
+static std::string join_text(const std::string& file1, const std::string& file2,
+                               int field1, int field2,
+                               const std::string& separator,
+                               bool assume_sorted,
+                               const std::string& output) {
+    if (field1 < 1 || field2 < 1)
+        throw py::value_error("join: fields must be >= 1");
+
+    auto mapped1 = open_mapped(file1);
+    auto mapped2 = open_mapped(file2);
+    // Without a separator, or with " " (as before multi-character
+    // separators), fields are split on whitespace runs and joined with a
+    // single space.
+    FieldSplitter splitter(separator == " " ? std::string_view() : std::string_view(separator));
+    std::string_view sep = separator.empty() ? std::string_view(" ") : separator;
+    TextOutput out("join", output);
+
+    if (!assume_sorted) {
+        auto lines2 = split_lines(mapped2.data());
+        JoinTable table(lines2, static_cast<size_t>(field2), splitter);
+
+        LineReader reader1(mapped1.data());
+        std::string_view line;
+        while (reader1.next(line)) {
+            std::string_view key = splitter.field(line, static_cast<size_t>(field1));
+            for (size_t i = table.find(key); i != JoinTable::npos; i = table.next(i))
+                join_emit(out, line, sep, table.line(i));
+        }
+        return out.finish();
     }
 
-    std::ostringstream oss;
-    for (const auto& line : lines1) {
-        std::string key = get_field(line, field1);
-        auto range = index2.equal_range(key);
-        for (auto it = range.first; it != range.second; ++it) {
-            oss << line << sep << it->second << "\n";
+    SortedKeyReader r1(mapped1.data(), static_cast<size_t>(field1), splitter, 1);
+    SortedKeyReader r2(mapped2.data(), static_cast<size_t>(field2), splitter, 2);
+    while (r1.has() && r2.has()) {
+        int c = r1.key().compare(r2.key());
+        if (c < 0) {
+            r1.advance();
+        } else if (c > 0) {
+            r2.advance();
+        } else {
+            // The file2 lines sharing this key are consecutive in the
+            // mapping; remember where they start and how many there are.
+            std::string_view key = r2.key();
+            std::string_view data2 = mapped2.data();
+            size_t begin = static_cast<size_t>(r2.line().data() - data2.data());
+            size_t count = 0;
+            for (; r2.has() && r2.key() == key; r2.advance())
+                count++;
+            std::string_view group = data2.substr(begin);
+
+            // r2 has moved on, but `key` still views the mapping.
+            for (; r1.has() && r1.key() == key; r1.advance()) {
+                LineReader lines(group);
+                std::string_view line2;
+                for (size_t i = 0; i < count && lines.next(line2); i++)
+                    join_emit(out, r1.line(), sep, line2);
+            }
         }
     }
+    return out.finish();
+}
+
+static py::object join_impl(const std::string& file1, const std::string& file2,
+                            int field1, int field2, const std::string& separator,
+                            bool assume_sorted, const std::string& output, bool as_bytes) {
+    return text_result(as_bytes, [&] {
+        return owned_buffer(join_text(file1, file2, field1, field2, separator,
+                                      assume_sorted, output));
+    });
+}
+
+// ---------------------------------------------------------------------------
+// pipeline — grep | cut | sort | head | tail | comm in one native call
+// ---------------------------------------------------------------------------
+
+static Pipeline& pipeline_grep(Pipeline& p, const std::string& pattern, bool ignore_case,
+                               bool invert, bool whole_word, bool fixed_strings) {
+    MatchOptions opts;
+    opts.ignore_case = ignore_case;
+    opts.whole_word = whole_word;
+    opts.fixed_strings = fixed_strings;
+    try {
+        p.grep(pattern, opts, invert);
+    } catch (const std::regex_error& e) {
+        throw py::value_error("pipeline: invalid regex pattern: " + std::string(e.what()));
+    }
+    return p;
+}
+
+static Pipeline& pipeline_cut(Pipeline& p, const std::string& fields,
+                              const std::string& delimiter) {
+    try {
+        p.cut(fields, delimiter);
+    } catch (const std::invalid_argument& e) {
+        throw py::value_error(std::string("pipeline: ") + e.what());
+    }
+    return p;
+}
+
+static Pipeline& pipeline_sort(Pipeline& p, bool reverse, bool numeric, bool unique, int key,
+                               const std::string& separator, bool ignore_case,
+                               long long buffer_size, const std::string& temp_dir,
+                               int threads) {
+    if (buffer_size < 0)
+        throw py::value_error("pipeline: buffer_size must be >= 0");
+    if (threads < 0)
+        throw py::value_error("pipeline: threads must be >= 0");
+    SortOptions opts;
+    opts.reverse = reverse;
+    opts.numeric = numeric;
+    opts.unique = unique;
+    opts.ignore_case = ignore_case;
+    opts.key = key;
+    opts.separator = separator;
+    opts.buffer_size = static_cast<size_t>(buffer_size);
+    opts.threads = ThreadPool::resolve_threads(threads);
+    opts.temp_dir = temp_dir;
+    p.sort(opts);
+    return p;
+}
+
+static Pipeline& pipeline_head(Pipeline& p, int n) {
+    if (n < 0)
+        throw py::value_error("pipeline: head n must be >= 0");
+    p.head(static_cast<size_t>(n));
+    return p;
+}
+
+static Pipeline& pipeline_tail(Pipeline& p, int n) {
+    if (n < 0)
+        throw py::value_error("pipeline: tail n must be >= 0");
+    p.tail(static_cast<size_t>(n));
+    return p;
+}
+
+static Pipeline& pipeline_comm(Pipeline& p, const std::string& path, const std::string& keep) {
+    if (keep != "only_in_first" && keep != "in_both")
+        throw py::value_error("pipeline: keep must be 'only_in_first' or 'in_both'");
+    p.comm(path, keep == "in_both");
+    return p;
+}
+
+static std::string pipeline_run(const Pipeline& p, const std::string& path,
+                                const std::string& output, bool threaded) {
+    auto file = open_mapped(path);
+    TextOutput out("pipeline", output);
+    try {
+        p.run(file.data(), threaded, [&](std::string_view line) { out.line(line); });
+    } catch (const py::value_error&) {
+        throw;
+    } catch (const std::runtime_error& e) {
+        throw py::value_error(std::string("pipeline: ") + e.what());
+    }
+    return out.finish();
+}
 
-    return oss.str();
+static std::string pipeline_repr(const Pipeline& p) {
+    std::string out = "Pipeline(";
+    auto stages = p.describe();
+    for (size_t i = 0; i < stages.size(); ++i)
+        out += (i ? " | " : "") + stages[i];
+    return out + ")";
 }
 
 // ===========================================================================
@@ -615,8 +1814,47 @@ static std::string join_impl(const std::string& file1, const std::string& file2,
 
 void init_text(py::module_ &m) {
 
+    // -- zero-copy results --------------------------------------------------
+    py::class_<TextBuffer, std::shared_ptr<TextBuffer>>(m, "TextBuffer", py::buffer_protocol(),
+        "Bytes of a command result (as_bytes=True), held natively. Supports the "
+        "buffer protocol, so memoryview() reads them in place.")
+        .def_buffer([](TextBuffer& b) {
+            std::string_view data = b.data();
+            return py::buffer_info(const_cast<char*>(data.data()), 1, "B", 1,
+                                   {static_cast<py::ssize_t>(data.size())}, {1}, true);
+        })
+        .def("__len__", [](const TextBuffer& b) { return b.data().size(); })
+        .def("__bytes__", [](const TextBuffer& b) {
+            std::string_view data = b.data();
+            return py::bytes(data.data(), data.size());
+        })
+        .def("decode", [](const TextBuffer& b) {
+            std::string_view data = b.data();
+            return py::str(data.data(), data.size());
+        }, "The contents as a str (UTF-8).")
+        .def("lines", [](std::shared_ptr<TextBuffer> b) { return LineView{std::move(b)}; },
+             "A LineView of the contents.")
+        .def("__repr__", [](const TextBuffer& b) {
+            return "TextBuffer(" + std::to_string(b.data().size()) + " bytes" +
+                   (b.is_mapped() ? ", mapped)" : ")");
+        });
+
+    py::class_<LineView>(m, "LineView",
+        "Sequence of the lines of a TextBuffer (without newlines). The line "
+        "offsets are indexed once; each access decodes only that line.")
+        .def("__len__", [](const LineView& v) { return v.buffer->line_count(); })
+        .def("__getitem__", [](const LineView& v, long long i) {
+            long long n = static_cast<long long>(v.buffer->line_count());
+            if (i < 0)
+                i += n;
+            if (i < 0 || i >= n)
+                throw py::index_error("LineView index out of range");
+            std::string_view line = v.buffer->line(static_cast<size_t>(i));
+            return py::str(line.data(), line.size());
+        });
+
     // -- cat ----------------------------------------------------------------
-    m.def("cat", &cat_impl,
+    m.def("cat", counted("cat", &cat_impl),
         R"doc(
         Concatenate and display file contents.
 
@@ -629,19 +1867,25 @@ void init_text(py::module_ &m) {
                                  Equivalent to ``cat -n``.
             squeeze_blank (bool): If True, suppress repeated empty lines.
                                   Equivalent to ``cat -s``.
+            as_bytes (bool): If True, return a :class:`TextBuffer` (bytes
+                             readable through memoryview, or as lines
+                             through ``lines()``) instead of decoding a str.
 
         Returns:
-            str: The file contents.
+            str | TextBuffer: The file contents. With as_bytes, an
+                unnumbered, unsqueezed file ending in a newline is the
+                mapped file itself.
 
         Raises:
             ValueError: If the file cannot be opened.
         )doc",
         py::arg("path"),
         py::arg("number_lines") = false,
-        py::arg("squeeze_blank") = false);
+        py::arg("squeeze_blank") = false,
+        py::arg("as_bytes") = false);
 
     // -- echo ---------------------------------------------------------------
-    m.def("echo", &echo_impl,
+    m.def("echo", counted("echo", &echo_impl),
         R"doc(
         Return a string, optionally without trailing newline.
 
@@ -660,12 +1904,12 @@ void init_text(py::module_ &m) {
         py::arg("no_newline") = false);
 
     // -- head ---------------------------------------------------------------
-    m.def("head", &head_impl,
+    m.def("head", counted("head", &head_impl),
         R"doc(
         Output the first N lines of a file.
 
         Equivalent to the ``head`` shell command. Returns the first N lines
-        or first N bytes of a file.
+        or first N bytes of a file. Reading stops at the N-th line.
 
         Args:
             path (str): Path to the file.
@@ -673,24 +1917,29 @@ void init_text(py::module_ &m) {
                      Equivalent to ``head -n``.
             bytes (int): If > 0, return first N bytes instead of lines.
                          Equivalent to ``head -c``.
+            as_bytes (bool): If True, return a :class:`TextBuffer` instead
+                             of a str.
 
         Returns:
-            str: The first N lines or bytes of the file.
+            str | TextBuffer: The first N lines or bytes of the file.
 
         Raises:
             ValueError: If the file cannot be opened.
         )doc",
         py::arg("path"),
         py::arg("n") = 10,
-        py::arg("bytes") = -1);
+        py::arg("bytes") = -1,
+        py::arg("as_bytes") = false);
 
     // -- tail ---------------------------------------------------------------
-    m.def("tail", &tail_impl,
+    m.def("tail", counted("tail", &tail_impl),
         R"doc(
         Output the last N lines of a file.
 
         Equivalent to the ``tail`` shell command. Returns the last N lines
-        or last N bytes of a file.
+        or last N bytes of a file. Lines are found by reading backwards from
+        the end in blocks, so the cost does not depend on the file size.
+        For ``tail -F`` see :func:`tail_iter` with ``follow=True``.
 
         Args:
             path (str): Path to the file.
@@ -698,24 +1947,30 @@ void init_text(py::module_ &m) {
                      Equivalent to ``tail -n``.
             bytes (int): If > 0, return last N bytes instead of lines.
                          Equivalent to ``tail -c``.
+            as_bytes (bool): If True, return a :class:`TextBuffer` instead
+                             of a str.
 
         Returns:
-            str: The last N lines or bytes of the file.
+            str | TextBuffer: The last N lines or bytes of the file.
 
         Raises:
             ValueError: If the file cannot be opened.
         )doc",
         py::arg("path"),
         py::arg("n") = 10,
-        py::arg("bytes") = -1);
+        py::arg("bytes") = -1,
+        py::arg("as_bytes") = false);
 
     // -- grep ---------------------------------------------------------------
-    m.def("grep", &grep_impl,
+    m.def("grep", counted("grep", &grep_impl),
         R"doc(
         Search for a pattern in files.
 
         Equivalent to the ``grep`` shell command. Searches for lines matching
-        a regex pattern within one or more files.
+        a regex pattern (ECMAScript syntax) within one or more files. Literal
+        patterns are matched with a vectorized substring search; regexes run
+        on a linear-time DFA engine, with std::regex only used for
+        backreferences and lookahead.
 
         Args:
             pattern (str): Regular expression pattern to search for.
@@ -734,12 +1989,27 @@ void init_text(py::module_ &m) {
                                Equivalent to ``grep -l``.
             whole_word (bool): If True, match whole words only.
                                Equivalent to ``grep -w``.
+            fixed_strings (bool): If True, treat pattern as a literal string
+                                  rather than a regex. Equivalent to ``grep -F``.
+            threads (int): Number of worker threads. Files are searched in
+                           parallel as the directory walk finds them, and
+                           large files are split into newline-aligned
+                           chunks. 0 uses every core. Output order is the
+                           same for any thread count.
+            index (bool | str | None): Trigram index built by
+                           ``index_build``: a path, or True for the default
+                           index of ``path``. Only the blocks that can hold
+                           the pattern's required literal are read. Files
+                           the index does not cover are searched in full,
+                           so results never differ, and invert=True or a
+                           pattern without a literal of 3+ bytes ignores it.
 
         Returns:
             list[dict] | dict | list[str]: Match results depending on flags.
 
         Raises:
-            ValueError: If file doesn't exist or pattern is invalid.
+            ValueError: If file doesn't exist, pattern is invalid, threads
+                        is negative or the index cannot be read.
         )doc",
         py::arg("pattern"),
         py::arg("path"),
@@ -749,15 +2019,200 @@ void init_text(py::module_ &m) {
         py::arg("count_only") = false,
         py::arg("invert") = false,
         py::arg("files_only") = false,
-        py::arg("whole_word") = false);
+        py::arg("whole_word") = false,
+        py::arg("fixed_strings") = false,
+        py::arg("threads") = 1,
+        py::arg("index") = py::none());
+
+    // -- index_build --------------------------------------------------------
+    m.def("index_build", counted("index_build", &index_build_impl),
+        R"doc(
+        Build or update a trigram index for repeated grep searches.
+
+        Indexes the regular files below ``path`` (or ``path`` itself) in
+        newline-aligned blocks, recording which lowercased byte trigrams each
+        block contains. Pass the index to ``grep(index=...)`` to read only
+        the blocks that can match.
+
+        Running it again updates the index: files whose size and mtime are
+        unchanged are kept, files that only grew (logs) have just their new
+        lines indexed, and anything else is indexed again. The index is one
+        memory-mapped file, replaced atomically.
+
+        Args:
+            path (str): Directory (walked recursively) or file to index.
+            index (str): Index file. Defaults to a file under
+                         ``$XDG_CACHE_HOME/shellfast`` (or
+                         ``~/.cache/shellfast``) named after the real path of
+                         ``path``, which is what ``grep(index=True)`` uses.
+            block_size (int): Approximate block size in bytes. Smaller blocks
+                              skip more text but make a larger index.
+                              Changing it rebuilds the index.
+            threads (int): Number of worker threads (0 uses every core).
+
+        Returns:
+            dict: ``index`` (path), ``files``, ``blocks``, ``trigrams``,
+            ``indexed_bytes``, ``new_bytes`` (read by this run),
+            ``unchanged``, ``appended``, ``reindexed`` and ``removed`` file
+            counts.
+
+        Raises:
+            ValueError: If path cannot be read, the index cannot be written,
+                        block_size is not positive or threads is negative.
+        )doc",
+        py::arg("path"),
+        py::arg("index") = "",
+        py::arg("block_size") = kGrepIndexBlockSize,
+        py::arg("threads") = 1);
+
+    // -- streaming iterators ------------------------------------------------
+    py::class_<GrepIterator>(m, "GrepIterator",
+        "Iterator returned by grep_iter(); yields lists of match dicts.")
+        .def("__iter__", [](GrepIterator& self) -> GrepIterator& { return self; },
+             py::return_value_policy::reference_internal)
+        .def("__next__", &GrepIterator::next)
+        .def("close", &GrepIterator::close,
+             "Stop the search and release the current file.");
+
+    py::class_<LineIterator>(m, "LineIterator",
+        "Iterator returned by cat_iter() and tail_iter(); yields strings of whole lines.")
+        .def("__iter__", [](LineIterator& self) -> LineIterator& { return self; },
+             py::return_value_policy::reference_internal)
+        .def("__next__", &LineIterator::next)
+        .def("close", &LineIterator::close,
+             "Stop iterating and release the file.");
+
+    m.def("grep_iter", counted("grep_iter", &grep_iter_impl),
+        R"doc(
+        Search for a pattern in files, yielding matches in batches.
+
+        Streaming form of ``grep``. Instead of building one list of every
+        match, the returned iterator yields lists of at most ``batch_size``
+        match dicts as they are found, so memory stays bounded on very large
+        inputs. Each batch is scanned with the GIL released. Breaking out of
+        the loop stops the scan; the rest of the input is never read.
+
+        Args:
+            pattern (str): Regular expression pattern to search for.
+            path (str): File or directory path to search in.
+            ignore_case (bool): If True, perform case-insensitive matching.
+                                Equivalent to ``grep -i``.
+            recursive (bool): If True, search directories recursively.
+                              Equivalent to ``grep -r``.
+            line_numbers (bool): If True, include line numbers in results.
+                                 Equivalent to ``grep -n``.
+            invert (bool): If True, select non-matching lines.
+                           Equivalent to ``grep -v``.
+            whole_word (bool): If True, match whole words only.
+                               Equivalent to ``grep -w``.
+            fixed_strings (bool): If True, treat pattern as a literal string
+                                  rather than a regex. Equivalent to ``grep -F``.
+            max_count (int): Stop reading a file after this many matching
+                             lines (-1 for no limit). Equivalent to ``grep -m``.
+            batch_size (int): Maximum number of matches per yielded list.
+
+        Returns:
+            GrepIterator: Iterator over ``list[dict]`` batches. Dicts have
+            ``file`` (when searching a directory), ``line_number`` and
+            ``line`` keys.
+
+        Raises:
+            ValueError: If the path doesn't exist, the pattern is invalid or
+                        batch_size is not positive. Files that cannot be
+                        opened raise when the iterator reaches them.
+        )doc",
+        py::arg("pattern"),
+        py::arg("path"),
+        py::arg("ignore_case") = false,
+        py::arg("recursive") = false,
+        py::arg("line_numbers") = true,
+        py::arg("invert") = false,
+        py::arg("whole_word") = false,
+        py::arg("fixed_strings") = false,
+        py::arg("max_count") = -1,
+        py::arg("batch_size") = 1024);
+
+    m.def("cat_iter", counted("cat_iter", &cat_iter_impl),
+        R"doc(
+        Read a file in batches of lines.
+
+        Streaming form of ``cat``. The file is memory-mapped and each
+        iteration yields a string of at most ``batch_size`` whole lines, so
+        large files can be processed without holding a copy in memory.
+        Joining every batch gives the same text as ``cat``.
+
+        Args:
+            path (str): Path to the file to read.
+            number_lines (bool): If True, number all output lines.
+                                 Equivalent to ``cat -n``.
+            squeeze_blank (bool): If True, suppress repeated empty lines.
+                                  Equivalent to ``cat -s``.
+            batch_size (int): Maximum number of lines per yielded string.
+
+        Returns:
+            LineIterator: Iterator over ``str`` batches.
+
+        Raises:
+            ValueError: If the file cannot be opened or batch_size is not
+                        positive.
+        )doc",
+        py::arg("path"),
+        py::arg("number_lines") = false,
+        py::arg("squeeze_blank") = false,
+        py::arg("batch_size") = 1024);
+
+    m.def("tail_iter", counted("tail_iter", &tail_iter_impl),
+        R"doc(
+        Read the last N lines of a file in batches.
+
+        Streaming form of ``tail``. The start of the last ``n`` lines is
+        found by scanning backwards from the end of the file, so only the
+        tail is ever touched. Each iteration yields a string of at most
+        ``batch_size`` whole lines.
+
+        With ``follow=True`` the iterator then keeps yielding lines as they
+        are appended, like ``tail -F``. It sleeps on inotify between writes
+        rather than polling, reopens the path when the log is rotated, and
+        starts over when the file is truncated. Only complete lines are
+        yielded.
+
+        Args:
+            path (str): Path to the file.
+            n (int): Number of lines from the end (default 10).
+            batch_size (int): Maximum number of lines per yielded string.
+            follow (bool): If True, wait for appended lines instead of
+                           stopping at end of file. Equivalent to
+                           ``tail -F``.
+            timeout (float): With follow, stop once no new line has arrived
+                             for this many seconds. Negative (default)
+                             waits indefinitely; ``close()`` or breaking
+                             out of the loop stops it.
+
+        Returns:
+            LineIterator: Iterator over ``str`` batches.
+
+        Raises:
+            ValueError: If the file cannot be opened or batch_size is not
+                        positive.
+        )doc",
+        py::arg("path"),
+        py::arg("n") = 10,
+        py::arg("batch_size") = 1024,
+        py::arg("follow") = false,
+        py::arg("timeout") = -1.0);
 
     // -- sort ---------------------------------------------------------------
-    m.def("sort_file", &sort_impl,
+    m.def("sort_file", counted("sort_file", &sort_impl),
         R"doc(
         Sort lines of a text file.
 
         Equivalent to the ``sort`` shell command. Reads the file and returns
-        its lines sorted according to the specified criteria.
+        its lines sorted according to the specified criteria. Sort keys are
+        extracted once per line and sorted in parallel across ``threads``.
+        With ``buffer_size`` set, inputs larger than the buffer are sorted
+        in runs that are spilled to temporary files and merged, so memory
+        use stays bounded. Lines with equal keys are ordered by their full
+        contents, so the result never depends on threads or buffer_size.
 
         Args:
             path (str): Path to the file to sort.
@@ -769,16 +2224,32 @@ void init_text(py::module_ &m) {
                            Equivalent to ``sort -u``.
             key (int): Sort by the Nth field (1-indexed). 0 = entire line.
                        Equivalent to ``sort -k``.
-            separator (str): Field separator character.
+            separator (str): Field separator; may be several characters.
+                             Default splits on runs of whitespace.
                              Equivalent to ``sort -t``.
             ignore_case (bool): If True, ignore case when sorting.
                                 Equivalent to ``sort -f``.
+            buffer_size (int): Memory budget in bytes for each in-memory run
+                               (0 = sort entirely in memory).
+                               Equivalent to ``sort -S``.
+            output (str): If set, write the result to this file instead of
+                          returning it. It may be the input file.
+                          Equivalent to ``sort -o``.
+            temp_dir (str): Directory for spilled runs (default $TMPDIR or
+                            /tmp). Equivalent to ``sort -T``.
+            threads (int): Number of worker threads. 0 uses every core.
+                           Equivalent to ``sort --parallel``.
+            as_bytes (bool): If True, return a :class:`TextBuffer` instead
+                             of a str.
 
         Returns:
-            str: Sorted file contents.
+            str | TextBuffer: Sorted file contents, or empty when
+                              output is set.
 
         Raises:
-            ValueError: If the file cannot be opened.
+            ValueError: If the file cannot be opened, a temporary or output
+                        file cannot be written, or buffer_size/threads is
+                        negative.
         )doc",
         py::arg("path"),
         py::arg("reverse") = false,
@@ -786,61 +2257,83 @@ void init_text(py::module_ &m) {
         py::arg("unique") = false,
         py::arg("key") = 0,
         py::arg("separator") = "",
-        py::arg("ignore_case") = false);
+        py::arg("ignore_case") = false,
+        py::arg("buffer_size") = 0,
+        py::arg("output") = "",
+        py::arg("temp_dir") = "",
+        py::arg("threads") = 1,
+        py::arg("as_bytes") = false);
 
     // -- diff ---------------------------------------------------------------
-    m.def("diff", &diff_impl,
+    m.def("diff", counted("diff", &diff_impl),
         R"doc(
         Compare two files line by line.
 
-        Equivalent to the ``diff`` shell command. Uses an LCS-based algorithm
-        to compute the differences between two files.
+        Equivalent to the ``diff`` shell command. Uses Myers' O(ND)
+        algorithm with linear-space refinement on interned lines, so memory
+        stays linear in the file sizes. Identical files produce no output.
 
         Args:
             file1 (str): Path to the first file.
             file2 (str): Path to the second file.
-            unified (bool): If True, output in unified diff format.
-                            Equivalent to ``diff -u``.
-            context_lines (int): Number of context lines (for future use).
+            unified (bool): If True, output unified diff hunks with
+                            ``@@ -l,n +l,n @@`` headers. Equivalent to
+                            ``diff -u``. If False, list only the changed
+                            lines, prefixed with "- " or "+ ".
+            context_lines (int): Number of context lines around each change
+                                 in unified output. Equivalent to ``diff -U``.
 
         Returns:
             str: Unified or standard diff output.
 
         Raises:
-            ValueError: If either file cannot be opened.
+            ValueError: If either file cannot be opened or context_lines is
+                        negative.
         )doc",
+        py::call_guard<py::gil_scoped_release>(),
         py::arg("file1"),
         py::arg("file2"),
         py::arg("unified") = true,
         py::arg("context_lines") = 3);
 
     // -- cmp ----------------------------------------------------------------
-    m.def("cmp", &cmp_impl,
+    m.def("cmp", counted("cmp", &cmp_impl),
         R"doc(
         Compare two files byte by byte.
 
         Equivalent to the ``cmp`` shell command. Reports the first byte and
-        line number where the two files differ.
+        line number where the two files differ. Files are memory-mapped and
+        compared in large blocks; lines are only counted up to the first
+        difference. With ``silent=True``, regular files of different sizes
+        are reported as different without being read.
 
         Args:
             file1 (str): Path to the first file.
             file2 (str): Path to the second file.
             silent (bool): If True, only set the 'identical' flag, no details.
                            Equivalent to ``cmp -s``.
+            max_diffs (int): If > 0, also list up to this many ranges of
+                             differing bytes under "differences", in the
+                             spirit of ``cmp -l``.
 
         Returns:
             dict: A dict with keys "identical" (bool), and optionally
-                  "byte_offset", "line_number", "message".
+                  "byte_offset", "line_number", "message" and
+                  "differences" (list of dicts with "byte_offset",
+                  "length" and "line_number"; offsets and lines are
+                  1-based).
 
         Raises:
-            ValueError: If either file cannot be opened.
+            ValueError: If either file cannot be opened or max_diffs is
+                        negative.
         )doc",
         py::arg("file1"),
         py::arg("file2"),
-        py::arg("silent") = false);
+        py::arg("silent") = false,
+        py::arg("max_diffs") = 0);
 
     // -- comm ---------------------------------------------------------------
-    m.def("comm", &comm_impl,
+    m.def("comm", counted("comm", &comm_impl),
         R"doc(
         Compare two sorted files line by line.
 
@@ -850,24 +2343,32 @@ void init_text(py::module_ &m) {
         Args:
             file1 (str): Path to the first sorted file.
             file2 (str): Path to the second sorted file.
+            assume_sorted (bool): If True, the files must be sorted in byte
+                                  order and are merged in a single streaming
+                                  pass instead of being indexed. Default is
+                                  False, which accepts any order.
 
         Returns:
             dict: A dict with keys "only_in_first" (list), "only_in_second" (list),
-                  "in_both" (list).
+                  "in_both" (list). Each list is sorted with duplicates removed.
 
         Raises:
-            ValueError: If either file cannot be opened.
+            ValueError: If either file cannot be opened, or with assume_sorted
+                        a file is not in sorted order.
         )doc",
         py::arg("file1"),
-        py::arg("file2"));
+        py::arg("file2"),
+        py::arg("assume_sorted") = false);
 
     // -- wc -----------------------------------------------------------------
-    m.def("wc", &wc_impl,
+    m.def("wc", counted("wc", &wc_impl),
         R"doc(
         Count lines, words, characters, and bytes in a file.
 
         Equivalent to the ``wc`` shell command. Returns a dictionary with
-        counts for the specified file.
+        counts for the specified file. Counting runs on a block-based SIMD
+        kernel (AVX2, SSE2 or NEON, picked at runtime). Characters are
+        UTF-8 code points, as ``wc -m`` counts them in a UTF-8 locale.
 
         Args:
             path (str): Path to the file.
@@ -879,22 +2380,53 @@ void init_text(py::module_ &m) {
                                Equivalent to ``wc -m``.
             bytes_only (bool): If True, return only byte count.
                                Equivalent to ``wc -c``.
+            threads (int): Number of worker threads used to count chunks of
+                           a large file in parallel. 0 uses every core.
 
         Returns:
             dict: A dict with keys "file", "lines", "words", "chars", "bytes"
                   (or a subset based on flags).
 
         Raises:
-            ValueError: If the file cannot be opened.
+            ValueError: If the file cannot be opened or threads is negative.
         )doc",
         py::arg("path"),
         py::arg("lines_only") = false,
         py::arg("words_only") = false,
         py::arg("chars_only") = false,
-        py::arg("bytes_only") = false);
+        py::arg("bytes_only") = false,
+        py::arg("threads") = 1);
+
+    m.def("wc", counted("wc", &wc_many_impl),
+        R"doc(
+        Count lines, words, characters, and bytes in several files.
+
+        Like ``wc file1 file2 ...``. Files (and chunks of large files) are
+        counted in parallel across ``threads`` workers.
+
+        Args:
+            paths (list[str]): Paths of the files to count.
+            lines_only (bool): If True, return only line counts.
+            words_only (bool): If True, return only word counts.
+            chars_only (bool): If True, return only character counts.
+            bytes_only (bool): If True, return only byte counts.
+            threads (int): Number of worker threads. 0 uses every core.
+
+        Returns:
+            list[dict]: One result dict per path, in input order.
+
+        Raises:
+            ValueError: If any file cannot be opened or threads is negative.
+        )doc",
+        py::arg("paths"),
+        py::arg("lines_only") = false,
+        py::arg("words_only") = false,
+        py::arg("chars_only") = false,
+        py::arg("bytes_only") = false,
+        py::arg("threads") = 1);
 
     // -- cut ----------------------------------------------------------------
-    m.def("cut", &cut_impl,
+    m.def("cut", counted("cut", &cut_impl),
         R"doc(
         Remove sections from each line of a file.
 
@@ -903,24 +2435,29 @@ void init_text(py::module_ &m) {
 
         Args:
             path (str): Path to the file.
-            delimiter (str): Field delimiter character. Default is tab.
-                             Equivalent to ``cut -d``.
+            delimiter (str): Field delimiter; may be several characters.
+                             Default is tab. Equivalent to ``cut -d``.
             fields (str): Comma-separated field numbers (1-indexed) or ranges.
-                          e.g. "1,3" or "2-4" or "1,3-5".
-                          Equivalent to ``cut -f``.
+                          e.g. "1,3" or "2-4" or "1,3-5". Open ranges
+                          "-3" and "5-" run from the first/to the last
+                          field. Equivalent to ``cut -f``.
+            as_bytes (bool): If True, return a :class:`TextBuffer` instead
+                             of a str.
 
         Returns:
-            str: Extracted fields from each line.
+            str | TextBuffer: Extracted fields from each line.
 
         Raises:
-            ValueError: If the file cannot be opened.
+            ValueError: If the file cannot be opened or the field list is
+                        invalid.
         )doc",
         py::arg("path"),
         py::arg("delimiter") = "\t",
-        py::arg("fields") = "1");
+        py::arg("fields") = "1",
+        py::arg("as_bytes") = false);
 
     // -- paste --------------------------------------------------------------
-    m.def("paste", &paste_impl,
+    m.def("paste", counted("paste", &paste_impl),
         R"doc(
         Merge lines of files side by side.
 
@@ -931,18 +2468,21 @@ void init_text(py::module_ &m) {
             files (list[str]): List of file paths to merge.
             delimiter (str): Delimiter between fields. Default is tab.
                              Equivalent to ``paste -d``.
+            as_bytes (bool): If True, return a :class:`TextBuffer` instead
+                             of a str.
 
         Returns:
-            str: Merged lines.
+            str | TextBuffer: Merged lines.
 
         Raises:
             ValueError: If any file cannot be opened.
         )doc",
         py::arg("files"),
-        py::arg("delimiter") = "\t");
+        py::arg("delimiter") = "\t",
+        py::arg("as_bytes") = false);
 
     // -- join ---------------------------------------------------------------
-    m.def("join", &join_impl,
+    m.def("join", counted("join", &join_impl),
         R"doc(
         Join lines of two files on a common field.
 
@@ -956,18 +2496,120 @@ void init_text(py::module_ &m) {
                           Equivalent to ``join -1``.
             field2 (int): Join field in file2 (1-indexed). Default is 1.
                           Equivalent to ``join -2``.
-            separator (str): Field separator. Default is space.
-                             Equivalent to ``join -t``.
+            separator (str): Field separator; may be several characters.
+                             Default (or " ") splits on runs of whitespace
+                             and joins with a space. Equivalent to
+                             ``join -t``.
+            assume_sorted (bool): If True, both files must be sorted
+                                  (byte order) on their join fields and are
+                                  merged in a single streaming pass using
+                                  constant memory. By default file2 is
+                                  loaded into a hash table and the inputs
+                                  may be in any order.
+            output (str): If given, write the joined lines to this file
+                          (replaced atomically) and return an empty string.
+            as_bytes (bool): If True, return a :class:`TextBuffer` instead
+                             of a str.
 
         Returns:
-            str: Joined lines.
+            str | TextBuffer: Joined lines, in file1 order and then file2
+                 order for repeated keys. Empty if ``output`` is given.
 
         Raises:
-            ValueError: If either file cannot be opened.
+            ValueError: If either file cannot be opened or written, a field
+                        is < 1, or with assume_sorted an input is not sorted
+                        on its join field.
         )doc",
         py::arg("file1"),
         py::arg("file2"),
         py::arg("field1") = 1,
         py::arg("field2") = 1,
-        py::arg("separator") = "");
+        py::arg("separator") = "",
+        py::arg("assume_sorted") = false,
+        py::arg("output") = "",
+        py::arg("as_bytes") = false);
+
+    // -- pipeline -----------------------------------------------------------
+    py::class_<Pipeline>(m, "Pipeline",
+        "A chain of text stages built by pipeline(); each method appends a stage "
+        "and returns the pipeline.")
+        .def(py::init<>())
+        .def("grep", &pipeline_grep,
+             "Keep lines matching pattern (grep). Same matching as grep().",
+             py::return_value_policy::reference,
+             py::arg("pattern"),
+             py::arg("ignore_case") = false,
+             py::arg("invert") = false,
+             py::arg("whole_word") = false,
+             py::arg("fixed_strings") = false)
+        .def("cut", &pipeline_cut,
+             "Keep the given fields of each line (cut -f).",
+             py::return_value_policy::reference,
+             py::arg("fields") = "1",
+             py::arg("delimiter") = "\t")
+        .def("sort", &pipeline_sort,
+             "Sort all lines (sort_file() options). Emits once its input ends.",
+             py::return_value_policy::reference,
+             py::arg("reverse") = false,
+             py::arg("numeric") = false,
+             py::arg("unique") = false,
+             py::arg("key") = 0,
+             py::arg("separator") = "",
+             py::arg("ignore_case") = false,
+             py::arg("buffer_size") = 0,
+             py::arg("temp_dir") = "",
+             py::arg("threads") = 1)
+        .def("head", &pipeline_head,
+             "Keep the first n lines; earlier stages stop once they are through.",
+             py::return_value_policy::reference,
+             py::arg("n") = 10)
+        .def("tail", &pipeline_tail,
+             "Keep the last n lines.",
+             py::return_value_policy::reference,
+             py::arg("n") = 10)
+        .def("comm", &pipeline_comm,
+             "Keep lines that are ('in_both') or are not ('only_in_first') lines "
+             "of path. Lines are not de-duplicated; the input need not be sorted.",
+             py::return_value_policy::reference,
+             py::arg("path"),
+             py::arg("keep") = "only_in_first")
+        .def("run", counted("pipeline", &pipeline_run),
+             R"doc(
+             Run the stages over the lines of a file.
+
+             Args:
+                 path (str): Input file.
+                 output (str): If given, write the result to this file
+                               (replaced atomically) and return "".
+                 threaded (bool): Run every stage on its own thread,
+                                  connected by bounded queues.
+
+             Returns:
+                 str: The resulting lines, each ending in a newline.
+
+             Raises:
+                 ValueError: If a file cannot be opened or written.
+             )doc",
+             py::call_guard<py::gil_scoped_release>(),
+             py::arg("path"),
+             py::arg("output") = "",
+             py::arg("threaded") = false)
+        .def("__len__", &Pipeline::size)
+        .def("__repr__", &pipeline_repr);
+
+    m.def("pipeline", [] { return Pipeline(); },
+        R"doc(
+        Start a native text pipeline.
+
+        Chains grep, cut, sort, head, tail and comm stages over one file,
+        like a shell pipeline, without passing data through Python between
+        stages: ``sf.pipeline().grep("POST").cut("1").sort(unique=True).run(path)``.
+        Stages exchange batches of line views, so lines that are only
+        selected are never copied; only the final result becomes a Python
+        string. The pipeline can be run any number of times.
+
+        Returns:
+            Pipeline: An empty pipeline; add stages with its methods and
+                      call ``run(path)``.
+        )doc");
 }
@@ -0,0 +1,42 @@
+#include "text_buffer.h"
+
+#include <cstring>
+
+TextBuffer::TextBuffer(std::string text)
+    : owned_(std::move(text)), length_(owned_.size()) {}
+
+TextBuffer::TextBuffer(MappedFile file, size_t offset, size_t length)
+    : file_(std::move(file)), offset_(offset), length_(length), use_file_(true) {}
+
+std::string_view TextBuffer::data() const {
+    if (use_file_)
+        return file_.data().substr(offset_, length_);
+    return owned_;
+}
+
+void TextBuffer::build_index() {
+    std::string_view text = data();
+    const char* base = text.data();
+    size_t size = text.size();
+    size_t pos = 0;
+    while (pos < size) {
+        starts_.push_back(pos);
+        auto* nl = static_cast<const char*>(std::memchr(base + pos, '\n', size - pos));
+        pos = nl ? static_cast<size_t>(nl - base) + 1 : size + 1;
+    }
+    // Sentinel: line i ends at starts_[i + 1] - 1.
+    starts_.push_back(size > 0 && base[size - 1] != '\n' ? size + 1 : size);
+    indexed_ = true;
+}
+
+size_t TextBuffer::line_count() {
+    if (!indexed_)
+        build_index();
+    return starts_.size() - 1;
+}
+
+std::string_view TextBuffer::line(size_t i) {
+    if (!indexed_)
+        build_index();
+    return data().substr(starts_[i], starts_[i + 1] - 1 - starts_[i]);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+// ---------------------------------------------------------------------------
+// TextBuffer — command output handed to Python without a copy
+//
+// Owns the bytes of a result: either a string the command built (moved in,
+// not copied) or a mapped file and the range of it the result covers, so
+// cat or head -c of a file expose the page cache directly. Python sees it
+// through the buffer protocol (memoryview, bytes) and as a LineView.
+//
+// The line index (one offset per line, getline semantics) is built on the
+// first line() or line_count() call and makes every line lookup O(1). Not
+// thread-safe; the bindings only touch it with the GIL held.
+// ---------------------------------------------------------------------------
+
+class TextBuffer {
+public:
+    explicit TextBuffer(std::string text);
+    TextBuffer(MappedFile file, size_t offset, size_t length);
+
+    TextBuffer(const TextBuffer&) = delete;
+    TextBuffer& operator=(const TextBuffer&) = delete;
+
+    std::string_view data() const;
+    bool is_mapped() const { return file_.is_mapped(); }
+
+    size_t line_count();
+    // Line i (0-based, < line_count()) without its newline.
+    std::string_view line(size_t i);
+
+private:
+    void build_index();
+
+    std::string owned_;
+    MappedFile file_;
+    size_t offset_ = 0;
+    size_t length_ = 0;
+    bool use_file_ = false;
+
+    bool indexed_ = false;
+    std::vector<size_t> starts_;    // line starts, then one past the last line's end + 1
+};
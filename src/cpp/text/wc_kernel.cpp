@@ -0,0 +1,230 @@
+#include "wc_kernel.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define WC_HAVE_X86 1
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define WC_HAVE_NEON 1
+#endif
+
+// ---------------------------------------------------------------------------
+// Scalar kernel — reference implementation and tail handler
+// ---------------------------------------------------------------------------
+
+static WcCounts wc_count_scalar(const unsigned char* p, size_t n, bool& in_word) {
+    WcCounts c;
+    c.bytes = n;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char b = p[i];
+        c.lines += b == '\n';
+        bool word = !wc_is_space(b);
+        c.words += word && !in_word;
+        in_word = word;
+        c.chars += (b & 0xC0) != 0x80;
+    }
+    return c;
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 kernel — 64 bytes per iteration, reduced to bitmasks
+//
+// Each 64-byte block becomes three 64-bit masks (newline, non-space,
+// continuation byte). A word starts at every non-space bit whose previous
+// bit (carried across blocks) is clear.
+// ---------------------------------------------------------------------------
+
+#if defined(WC_HAVE_X86)
+__attribute__((target("avx2,popcnt")))
+static uint64_t wc_mask64_avx2(__m256i lo, __m256i hi) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(lo)) |
+           static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hi))) << 32;
+}
+
+__attribute__((target("avx2,popcnt")))
+static __m256i wc_space_avx2(__m256i v) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i four = _mm256_set1_epi8(4);
+    // '\t'..'\r' are 9..13: (v - 9) <= 4 as unsigned bytes
+    __m256i t = _mm256_sub_epi8(v, nine);
+    return _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+                           _mm256_cmpeq_epi8(_mm256_min_epu8(t, four), t));
+}
+
+__attribute__((target("avx2,popcnt")))
+static WcCounts wc_count_avx2(const unsigned char* p, size_t n, bool& in_word) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i cont_limit = _mm256_set1_epi8(-64);  // 0x80-0xBF are < -64
+    WcCounts c;
+    uint64_t carry = in_word ? 1 : 0;
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 32));
+
+        uint64_t nl = wc_mask64_avx2(_mm256_cmpeq_epi8(lo, newline),
+                                     _mm256_cmpeq_epi8(hi, newline));
+        uint64_t word = ~wc_mask64_avx2(wc_space_avx2(lo), wc_space_avx2(hi));
+        uint64_t cont = wc_mask64_avx2(_mm256_cmpgt_epi8(cont_limit, lo),
+                                       _mm256_cmpgt_epi8(cont_limit, hi));
+
+        c.lines += static_cast<uint64_t>(_mm_popcnt_u64(nl));
+        c.words += static_cast<uint64_t>(_mm_popcnt_u64(word & ~((word << 1) | carry)));
+        c.chars += 64 - static_cast<uint64_t>(_mm_popcnt_u64(cont));
+        carry = word >> 63;
+    }
+    in_word = carry != 0;
+    WcCounts tail = wc_count_scalar(p + i, n - i, in_word);
+    c.bytes = i;
+    c += tail;
+    return c;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// SSE2 / NEON kernels — per-byte counters
+//
+// Without a fast popcount, flags are accumulated in 8-bit lanes (each
+// compare yields 0 or -1, so subtracting it adds 1) and folded into 64-bit
+// totals every 255 blocks, before a lane can overflow. The "previous byte
+// was in a word" vector is built by shifting the non-space mask one byte
+// and pulling in the last byte of the previous block.
+// ---------------------------------------------------------------------------
+
+#if defined(WC_HAVE_X86)
+static uint64_t wc_fold_sse2(__m128i acc) {
+    __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(sums)) +
+           static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums)));
+}
+
+static WcCounts wc_count_sse2(const unsigned char* p, size_t n, bool& in_word) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i four = _mm_set1_epi8(4);
+    const __m128i cont_limit = _mm_set1_epi8(-64);
+    const __m128i ones = _mm_set1_epi8(-1);
+
+    WcCounts c;
+    __m128i prev_word = in_word ? ones : _mm_setzero_si128();
+    size_t i = 0;
+    while (i + 16 <= n) {
+        __m128i acc_nl = _mm_setzero_si128();
+        __m128i acc_start = _mm_setzero_si128();
+        __m128i acc_cont = _mm_setzero_si128();
+        size_t blocks = 0;
+        for (; blocks < 255 && i + 16 <= n; blocks++, i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            __m128i t = _mm_sub_epi8(v, nine);
+            __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+                                      _mm_cmpeq_epi8(_mm_min_epu8(t, four), t));
+            __m128i word = _mm_xor_si128(ws, ones);
+            __m128i before = _mm_or_si128(_mm_slli_si128(word, 1),
+                                          _mm_srli_si128(prev_word, 15));
+            acc_nl = _mm_sub_epi8(acc_nl, _mm_cmpeq_epi8(v, newline));
+            acc_start = _mm_sub_epi8(acc_start, _mm_andnot_si128(before, word));
+            acc_cont = _mm_sub_epi8(acc_cont, _mm_cmpgt_epi8(cont_limit, v));
+            prev_word = word;
+        }
+        c.lines += wc_fold_sse2(acc_nl);
+        c.words += wc_fold_sse2(acc_start);
+        c.chars += blocks * 16 - wc_fold_sse2(acc_cont);
+    }
+    in_word = _mm_movemask_epi8(prev_word) & 0x8000;
+    WcCounts tail = wc_count_scalar(p + i, n - i, in_word);
+    c.bytes = i;
+    c += tail;
+    return c;
+}
+#endif
+
+#if defined(WC_HAVE_NEON)
+static uint64_t wc_fold_neon(uint8x16_t acc) {
+    uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(acc)));
+    return vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1);
+}
+
+static WcCounts wc_count_neon(const unsigned char* p, size_t n, bool& in_word) {
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    const uint8x16_t space = vdupq_n_u8(' ');
+    const uint8x16_t nine = vdupq_n_u8(9);
+    const uint8x16_t four = vdupq_n_u8(4);
+    const uint8x16_t top2 = vdupq_n_u8(0xC0);
+    const uint8x16_t cont_bits = vdupq_n_u8(0x80);
+    const uint8x16_t one = vdupq_n_u8(1);
+
+    WcCounts c;
+    uint8x16_t prev_word = vdupq_n_u8(in_word ? 0xFF : 0);
+    size_t i = 0;
+    while (i + 16 <= n) {
+        uint8x16_t acc_nl = vdupq_n_u8(0);
+        uint8x16_t acc_start = vdupq_n_u8(0);
+        uint8x16_t acc_cont = vdupq_n_u8(0);
+        size_t blocks = 0;
+        for (; blocks < 255 && i + 16 <= n; blocks++, i += 16) {
+            uint8x16_t v = vld1q_u8(p + i);
+            uint8x16_t ws = vorrq_u8(vceqq_u8(v, space),
+                                     vcleq_u8(vsubq_u8(v, nine), four));
+            uint8x16_t word = vmvnq_u8(ws);
+            uint8x16_t before = vextq_u8(prev_word, word, 15);
+            acc_nl = vaddq_u8(acc_nl, vandq_u8(vceqq_u8(v, newline), one));
+            acc_start = vaddq_u8(acc_start, vandq_u8(vbicq_u8(word, before), one));
+            acc_cont = vaddq_u8(acc_cont,
+                                vandq_u8(vceqq_u8(vandq_u8(v, top2), cont_bits), one));
+            prev_word = word;
+        }
+        c.lines += wc_fold_neon(acc_nl);
+        c.words += wc_fold_neon(acc_start);
+        c.chars += blocks * 16 - wc_fold_neon(acc_cont);
+    }
+    in_word = vgetq_lane_u8(prev_word, 15) != 0;
+    WcCounts tail = wc_count_scalar(p + i, n - i, in_word);
+    c.bytes = i;
+    c += tail;
+    return c;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+using WcKernel = WcCounts (*)(const unsigned char*, size_t, bool&);
+
+struct WcDispatch {
+    WcKernel fn;
+    const char* name;
+};
+
+static WcDispatch select_wc_kernel() {
+#if defined(WC_HAVE_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        return {wc_count_avx2, "avx2"};
+#endif
+#if defined(WC_HAVE_X86)
+    return {wc_count_sse2, "sse2"};
+#elif defined(WC_HAVE_NEON)
+    return {wc_count_neon, "neon"};
+#else
+    return {wc_count_scalar, "scalar"};
+#endif
+}
+
+static const WcDispatch& wc_dispatch() {
+    static const WcDispatch dispatch = select_wc_kernel();
+    return dispatch;
+}
+
+WcCounts wc_count(std::string_view data, bool prev_in_word) {
+    bool in_word = prev_in_word;
+    return wc_dispatch().fn(reinterpret_cast<const unsigned char*>(data.data()),
+                            data.size(), in_word);
+}
+
+const char* wc_kernel_name() {
+    return wc_dispatch().name;
+}
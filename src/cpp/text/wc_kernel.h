@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// ---------------------------------------------------------------------------
+// wc counting kernel
+//
+// Counts lines, words, UTF-8 characters and bytes of a buffer in one pass.
+// The widest available implementation is picked once at runtime: AVX2 (with
+// POPCNT) on x86 CPUs that have it, SSE2 on other x86-64 CPUs, NEON on ARM,
+// and a portable scalar loop elsewhere.
+//
+// Words are maximal runs of bytes that are not ASCII whitespace (" \t\n\v\f\r"),
+// like std::isspace in the C locale. Characters are counted as the bytes
+// that are not UTF-8 continuation bytes (0x80-0xBF), which is the number of
+// code points for valid UTF-8.
+// ---------------------------------------------------------------------------
+
+struct WcCounts {
+    uint64_t lines = 0;
+    uint64_t words = 0;
+    uint64_t chars = 0;
+    uint64_t bytes = 0;
+
+    WcCounts& operator+=(const WcCounts& other) {
+        lines += other.lines;
+        words += other.words;
+        chars += other.chars;
+        bytes += other.bytes;
+        return *this;
+    }
+};
+
+// Counts `data`. `prev_in_word` tells whether the byte just before `data`
+// was part of a word, so a buffer can be split into chunks that are counted
+// independently (even on different threads) and summed.
+WcCounts wc_count(std::string_view data, bool prev_in_word = false);
+
+// True if `c` ends a word.
+inline bool wc_is_space(unsigned char c) {
+    return c == ' ' || static_cast<unsigned char>(c - 9) <= 4;
+}
+
+// Name of the kernel wc_count() dispatches to: "avx2", "sse2", "neon" or
+// "scalar".
+const char* wc_kernel_name();
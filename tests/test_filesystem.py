@@ -6,6 +6,20 @@ import pytest
 import shellfast as sf
 
 
+def _make_tree(root, width=4, depth=3):
+    """Create a small directory tree: `width` files and subdirs per level."""
+    def fill(path, level):
+        for i in range(width):
+            with open(os.path.join(path, f"f{i}.txt"), "w") as f:
+                f.write("x" * (10 * i))
+        if level < depth:
+            for i in range(width):
+                sub = os.path.join(path, f"d{i}")
+                os.mkdir(sub)
+                fill(sub, level + 1)
+    fill(root, 1)
+
+
 class TestPwd:
     def test_returns_current_directory(self):
         result = sf.pwd()
@@ -87,6 +101,32 @@ class TestLs:
         with pytest.raises(ValueError):
             sf.ls("/nonexistent_12345")
 
+    def test_recursive_threads(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            _make_tree(tmpdir)
+            serial = sf.ls(tmpdir, recursive=True)
+            assert "f0.txt" in serial and "d1" in serial
+            assert sf.ls(tmpdir, recursive=True, threads=4) == serial
+
+    def test_stat_results(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, "file.txt")
+            with open(path, "w") as f:
+                f.write("hello")
+            os.chmod(path, 0o640)
+            os.symlink("file.txt", os.path.join(tmpdir, "link"))
+            entries = sf.ls(tmpdir, stat=True)
+            assert [e.name for e in entries] == ["file.txt", "link"]
+            entry, link = entries
+            st = os.stat(path)
+            assert entry.size == 5
+            assert entry.permissions == "rw-r-----"
+            assert entry.uid == st.st_uid and entry.ino == st.st_ino
+            assert entry.mtime_ns == st.st_mtime_ns
+            assert entry.symlink_target is None
+            assert link.is_symlink and link.symlink_target == "file.txt"
+            assert entry.to_dict() == sf.ls(tmpdir, long_format=True)[0]
+
 
 class TestTouchAndRm:
     def test_create_file(self):
@@ -122,6 +162,38 @@ class TestTouchAndRm:
             sf.rm(subdir, recursive=True)
             assert not os.path.exists(subdir)
 
+    def test_rm_tree_threads(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            root = os.path.join(tmpdir, "tree")
+            os.mkdir(root)
+            _make_tree(root)
+            os.symlink(tmpdir, os.path.join(root, "d0", "up"))
+            assert sf.rm(root, recursive=True, threads=4) is None
+            assert os.listdir(tmpdir) == []
+
+    def test_rm_symlink_to_directory(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            target = os.path.join(tmpdir, "target")
+            os.mkdir(target)
+            sf.touch(os.path.join(target, "keep"))
+            link = os.path.join(tmpdir, "link")
+            os.symlink(target, link)
+            sf.rm(link, recursive=True)
+            assert not os.path.lexists(link)
+            assert os.path.exists(os.path.join(target, "keep"))
+
+    def test_rm_async(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            root = os.path.join(tmpdir, "tree")
+            os.mkdir(root)
+            _make_tree(root)
+            handle = sf.rm(root, recursive=True, async_=True)
+            assert not os.path.exists(root)
+            assert os.path.dirname(handle.path) == tmpdir
+            handle.wait()
+            assert handle.done()
+            assert os.listdir(tmpdir) == []
+
 
 class TestCpAndMv:
     def test_copy_file(self):
@@ -135,6 +207,84 @@ class TestCpAndMv:
             with open(dst) as f:
                 assert f.read() == "hello"
 
+    def test_copy_tree_threads(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            src = os.path.join(tmpdir, "src")
+            os.mkdir(src)
+            _make_tree(src)
+            os.chmod(os.path.join(src, "f1.txt"), 0o640)
+            dst = os.path.join(tmpdir, "dst")
+            sf.cp(src, dst, recursive=True, threads=4)
+            for dirpath, _, files in os.walk(src):
+                rel = os.path.relpath(dirpath, src)
+                assert sorted(os.listdir(os.path.join(dst, rel))) == \
+                    sorted(os.listdir(dirpath))
+                for name in files:
+                    with open(os.path.join(dirpath, name), "rb") as a, \
+                         open(os.path.join(dst, rel, name), "rb") as b:
+                        assert a.read() == b.read()
+            assert os.stat(os.path.join(dst, "f1.txt")).st_mode & 0o777 == 0o640
+
+    def test_copy_directory_needs_recursive(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            src = os.path.join(tmpdir, "src")
+            os.mkdir(src)
+            with pytest.raises(ValueError, match="-r not specified"):
+                sf.cp(src, os.path.join(tmpdir, "dst"))
+
+    def test_copy_existing_needs_force(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            src = os.path.join(tmpdir, "src.txt")
+            dst = os.path.join(tmpdir, "dst.txt")
+            with open(src, "w") as f:
+                f.write("new")
+            with open(dst, "w") as f:
+                f.write("old contents")
+            with pytest.raises(ValueError):
+                sf.cp(src, dst)
+            sf.cp(src, dst, force=True)
+            with open(dst) as f:
+                assert f.read() == "new"
+
+    def test_copy_sparse_file(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            src = os.path.join(tmpdir, "sparse.bin")
+            with open(src, "wb") as f:
+                f.write(b"head")
+                f.seek(64 * 1024 * 1024)
+                f.write(b"tail")
+            dst = os.path.join(tmpdir, "copy.bin")
+            sf.cp(src, dst)
+            assert os.path.getsize(dst) == os.path.getsize(src)
+            assert os.stat(dst).st_blocks <= os.stat(src).st_blocks + 64
+            with open(dst, "rb") as f:
+                assert f.read(4) == b"head"
+                f.seek(64 * 1024 * 1024)
+                assert f.read() == b"tail"
+
+    def test_copy_progress(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            src = os.path.join(tmpdir, "src")
+            os.mkdir(src)
+            _make_tree(src, width=3, depth=2)
+            calls = []
+            sf.cp(src, os.path.join(tmpdir, "dst"), recursive=True,
+                  progress=lambda b, n: calls.append((b, n)))
+            # 3 files of 0, 10, 20 bytes at each of the 4 directories.
+            assert calls[-1] == (120, 12)
+
+    def test_copy_progress_raises(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            src = os.path.join(tmpdir, "src")
+            os.mkdir(src)
+            _make_tree(src, width=3, depth=2)
+
+            def stop(copied, files):
+                raise KeyError("stop")
+
+            with pytest.raises(KeyError):
+                sf.cp(src, os.path.join(tmpdir, "dst"), recursive=True, progress=stop)
+
     def test_move_file(self):
         with tempfile.TemporaryDirectory() as tmpdir:
             src = os.path.join(tmpdir, "src.txt")
@@ -145,6 +295,43 @@ class TestCpAndMv:
             assert not os.path.exists(src)
             assert os.path.exists(dst)
 
+    @pytest.mark.skipif(not os.path.isdir("/dev/shm"), reason="needs /dev/shm")
+    def test_move_across_filesystems(self):
+        with tempfile.TemporaryDirectory() as tmpdir, \
+             tempfile.TemporaryDirectory(dir="/dev/shm") as shm:
+            if os.stat(tmpdir).st_dev == os.stat(shm).st_dev:
+                pytest.skip("temporary directory is on /dev/shm")
+            src = os.path.join(tmpdir, "tree")
+            os.mkdir(src)
+            _make_tree(src, width=3, depth=2)
+            os.symlink("f1.txt", os.path.join(src, "link"))
+            os.utime(os.path.join(src, "f2.txt"), (1000000000, 1000000000))
+            dst = os.path.join(shm, "moved")
+            sf.mv(src, dst, threads=2)
+            assert not os.path.exists(src)
+            assert os.readlink(os.path.join(dst, "link")) == "f1.txt"
+            assert os.path.getsize(os.path.join(dst, "d2", "f2.txt")) == 20
+            assert os.stat(os.path.join(dst, "f2.txt")).st_mtime == 1000000000
+
+    @pytest.mark.skipif(not os.path.isdir("/dev/shm"), reason="needs /dev/shm")
+    def test_failed_move_across_filesystems_keeps_destination(self):
+        with tempfile.TemporaryDirectory() as tmpdir, \
+             tempfile.TemporaryDirectory(dir="/dev/shm") as shm:
+            if os.stat(tmpdir).st_dev == os.stat(shm).st_dev:
+                pytest.skip("temporary directory is on /dev/shm")
+            # A FIFO can't be copied, so the copy fails after rename()'s EXDEV.
+            src = os.path.join(tmpdir, "fifo")
+            os.mkfifo(src)
+            dst = os.path.join(shm, "dst.txt")
+            with open(dst, "w") as f:
+                f.write("original")
+            with pytest.raises(ValueError):
+                sf.mv(src, dst, force=True)
+            assert os.path.exists(src)
+            with open(dst) as f:
+                assert f.read() == "original"
+            assert os.listdir(shm) == ["dst.txt"]
+
 
 class TestLn:
     def test_symbolic_link(self):
@@ -183,6 +370,76 @@ class TestFind:
             assert len(dirs) == 1
             assert len(files) == 1
 
+    def test_threads_same_order(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            _make_tree(tmpdir)
+            serial = sf.find(tmpdir)
+            expected = []
+            for dirpath, dirnames, filenames in os.walk(tmpdir):
+                expected += [os.path.join(dirpath, n) for n in dirnames + filenames]
+            assert sorted(serial) == sorted(expected)
+            assert sf.find(tmpdir, threads=4) == serial
+            assert sf.find(tmpdir, threads=0) == serial
+
+    def test_max_depth_and_size(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            _make_tree(tmpdir)
+            top = sf.find(tmpdir, type="f", max_depth=0, threads=2)
+            assert sorted(os.path.basename(p) for p in top) == \
+                ["f0.txt", "f1.txt", "f2.txt", "f3.txt"]
+            big = sf.find(tmpdir, min_size=30, threads=2)
+            assert big and all(p.endswith("f3.txt") for p in big)
+
+    def test_negative_threads_raises(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            with pytest.raises(ValueError):
+                sf.find(tmpdir, threads=-1)
+
+    def test_glob_classes(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            for n in ["a1.log", "a2.log", "ab.log", "b1.log"]:
+                sf.touch(os.path.join(tmpdir, n))
+            result = sf.find(tmpdir, name="a[0-9].lo?")
+            assert sorted(os.path.basename(p) for p in result) == ["a1.log", "a2.log"]
+            result = sf.find(tmpdir, name="[!a]*")
+            assert [os.path.basename(p) for p in result] == ["b1.log"]
+
+    def test_path_glob_and_prune(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            os.makedirs(os.path.join(tmpdir, "src", "x", "y"))
+            os.makedirs(os.path.join(tmpdir, ".git"))
+            for p in ["src/a.h", "src/x/y/b.h", "src/x/c.cpp", ".git/d.h"]:
+                sf.touch(os.path.join(tmpdir, p))
+            result = sf.find(tmpdir, path_glob="src/**/*.h")
+            assert sorted(os.path.relpath(p, tmpdir) for p in result) == \
+                ["src/a.h", "src/x/y/b.h"]
+            result = sf.find(tmpdir, name="*.h", prune=[".git"])
+            assert not any(".git" in p for p in result)
+            assert len(result) == 2
+
+    def test_metadata_predicates(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            old = os.path.join(tmpdir, "old.txt")
+            new = os.path.join(tmpdir, "new.txt")
+            sf.touch(old)
+            sf.touch(new)
+            os.utime(old, (0, 10 * 86400))
+            os.chmod(old, 0o600)
+            os.chmod(new, 0o644)
+            assert sf.find(tmpdir, type="f", mtime="+5") == [old]
+            assert sf.find(tmpdir, type="f", mtime="-1") == [new]
+            assert sf.find(tmpdir, newer=old) == [new]
+            assert sf.find(tmpdir, perm="600") == [old]
+            assert sf.find(tmpdir, type="f", perm="-044") == [new]
+            assert len(sf.find(tmpdir, type="f", user=str(os.getuid()))) == 2
+
+    def test_invalid_criteria_raise(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            for kwargs in [{"type": "q"}, {"mtime": "soon"}, {"perm": "9"},
+                           {"newer": "/nonexistent_12345"}]:
+                with pytest.raises(ValueError):
+                    sf.find(tmpdir, **kwargs)
+
 
 class TestDu:
     def test_summary(self):
@@ -194,6 +451,52 @@ class TestDu:
             assert "bytes" in result
             assert result["bytes"] >= 100
 
+    def test_per_directory_threads(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            _make_tree(tmpdir, depth=2)
+            serial = sf.du(tmpdir, summary_only=False)
+            assert [d["path"] for d in serial] == sorted(d["path"] for d in serial)
+            assert len(serial) == 5
+            totals = {d["path"]: d["bytes"] for d in serial}
+            assert totals[tmpdir] == 5 * 60     # subdirectories roll up
+            assert totals[os.path.join(tmpdir, "d0")] == 60
+            assert sf.du(tmpdir, summary_only=False, threads=4) == serial
+            assert sf.du(tmpdir, threads=4)["bytes"] == 5 * 60
+
+    def test_hard_links_counted_once(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, "file.txt")
+            with open(path, "w") as f:
+                f.write("x" * 1000)
+            os.mkdir(os.path.join(tmpdir, "sub"))
+            os.link(path, os.path.join(tmpdir, "sub", "link.txt"))
+            assert sf.du(tmpdir)["bytes"] == 1000
+
+    def test_blocks_mode_sparse_file(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, "sparse")
+            with open(path, "wb") as f:
+                f.truncate(64 * 1024 * 1024)
+            assert sf.du(tmpdir)["bytes"] == 64 * 1024 * 1024
+            on_disk = sf.du(tmpdir, apparent=False)["bytes"]
+            expected = (os.stat(tmpdir).st_blocks + os.stat(path).st_blocks) * 512
+            assert on_disk == expected
+            assert sf.du(path, apparent=False)["bytes"] == os.stat(path).st_blocks * 512
+
+    def test_cache_reuses_unchanged_directories(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            root = os.path.join(tmpdir, "tree")
+            os.mkdir(root)
+            _make_tree(root, depth=2)
+            cache = os.path.join(tmpdir, "du.cache")
+            first = sf.du(root, summary_only=False, cache=cache)
+            assert os.path.exists(cache)
+            assert sf.du(root, summary_only=False, cache=cache) == first
+            with open(os.path.join(root, "d1", "new.txt"), "w") as f:
+                f.write("y" * 500)
+            updated = sf.du(root, cache=cache, threads=2)
+            assert updated["bytes"] == sf.du(root)["bytes"] == 5 * 60 + 500
+
 
 class TestChmod:
     def test_change_permissions(self):
@@ -203,3 +506,11 @@ class TestChmod:
             sf.chmod(path, 0o644)
             mode = os.stat(path).st_mode & 0o777
             assert mode == 0o644
+
+    def test_recursive_threads(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            _make_tree(tmpdir, depth=2)
+            sf.chmod(tmpdir, 0o750, recursive=True, threads=4)
+            for dirpath, dirnames, filenames in os.walk(tmpdir):
+                for n in dirnames + filenames:
+                    assert os.stat(os.path.join(dirpath, n)).st_mode & 0o777 == 0o750
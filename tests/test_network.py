@@ -0,0 +1,99 @@
+"""Tests for the shellfast network module (loopback only, no network needed)."""
+
+import ipaddress
+import os
+import socket
+import time
+import pytest
+import shellfast as sf
+
+
+def _loopback(result):
+    return bool(result["addresses"]) and all(
+        ipaddress.ip_address(a["address"]).is_loopback for a in result["addresses"])
+
+
+class TestNslookupMany:
+    def test_localhost_twice(self):
+        first, second = sf.nslookup_many(["localhost", "localhost"], cache_ttl=60)
+        assert _loopback(first) and _loopback(second)
+        assert first["addresses"] == second["addresses"]
+        assert "error" not in first
+
+        # Answered from the cache filled by the call above.
+        again = sf.nslookup_many(["localhost"])[0]
+        assert again["cached"]
+        assert again["addresses"] == first["addresses"]
+
+    def test_no_cache(self):
+        result = sf.nslookup_many(["localhost"], cache=False)[0]
+        assert _loopback(result)
+        assert not result["cached"]
+
+    def test_invalid_name_is_per_name_error(self):
+        bad, good = sf.nslookup_many(["no such host..invalid", "localhost"], timeout=2)
+        assert bad["addresses"] == []
+        assert "error" in bad
+        assert _loopback(good)
+
+    def test_validates_arguments(self):
+        with pytest.raises(ValueError):
+            sf.nslookup_many(["localhost"], timeout=0)
+        with pytest.raises(ValueError):
+            sf.nslookup_many(["localhost"], timeout=-1)
+        with pytest.raises(ValueError):
+            sf.nslookup_many(["localhost"], concurrency=0)
+        with pytest.raises(ValueError):
+            sf.nslookup_many(["localhost"], cache_ttl=-1)
+
+
+def _sys_lo(attr):
+    with open(f"/sys/class/net/lo/{attr}") as f:
+        return int(f.read().strip(), 0)
+
+
+@pytest.mark.skipif(not os.path.isdir("/sys/class/net/lo"), reason="needs a loopback interface")
+class TestIfconfig:
+    def test_loopback(self):
+        (lo,) = sf.ifconfig("lo")
+        assert lo["name"] == "lo"
+        assert lo["index"] == _sys_lo("ifindex")
+        assert lo["is_loopback"]
+        assert lo["is_up"]
+        assert lo["is_running"]
+        # netlink adds the operational flags (RUNNING, LOWER_UP) to these.
+        assert lo["flags"] & _sys_lo("flags") == _sys_lo("flags")
+        assert lo["mtu"] == _sys_lo("mtu")
+        assert lo["ipv4_address"] == "127.0.0.1"
+        assert lo["ipv4_netmask"] == "255.0.0.0"
+        assert "ipv4_broadcast" not in lo
+        v4 = [a for a in lo["addresses"] if a["family"] == "IPv4"]
+        assert v4[0]["address"] == "127.0.0.1"
+        assert v4[0]["prefixlen"] == 8
+
+    def test_all_includes_loopback(self):
+        names = [i["name"] for i in sf.ifconfig()]
+        assert "lo" in names
+        assert names == sorted(names)
+
+
+@pytest.mark.skipif(not os.path.isdir("/sys/class/net/lo"), reason="needs a loopback interface")
+class TestInterfaceSampler:
+    def test_loopback_rates(self):
+        sampler = sf.InterfaceSampler(["lo"])
+        with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as s:
+            for _ in range(10):
+                s.sendto(b"x" * 100, ("127.0.0.1", 9))
+        time.sleep(0.05)
+        (lo,) = sampler.sample()
+        assert lo["name"] == "lo"
+        assert not lo["new"]
+        assert sampler.interval > 0
+        for key, value in lo.items():
+            if key.endswith("_per_sec"):
+                assert value >= 0, key
+        assert lo["tx_packets_per_sec"] > 0
+
+        (again,) = sampler.sample()
+        assert again["rx_bytes"] >= lo["rx_bytes"]
+        assert all(v >= 0 for k, v in again.items() if k.endswith("_per_sec"))
@@ -1,6 +1,8 @@
 """Tests for the shellfast system and process modules."""
 
 import os
+import shutil
+import time
 import pytest
 import shellfast as sf
 
@@ -130,6 +132,36 @@ class TestFree:
         assert isinstance(result["ram"]["total"], str)
 
 
+class TestSysstat:
+    def test_fields(self):
+        s = sf.sysstat()
+        assert s.mem_total > 0
+        assert 0 < s.mem_available <= s.mem_total
+        assert s.mem_used == s.mem_total - s.mem_available
+        assert s.uptime > 0
+        assert s.ctxt > 0 and s.forks > 0
+        assert s.cpu_busy_percent is None
+        assert "cpu_busy_percent" not in s.to_dict()
+
+    def test_matches_free(self):
+        assert sf.sysstat().mem_total == sf.free()["ram"]["total"]
+
+    def test_delta(self):
+        sf.sysstat(delta=True)
+        s = sf.sysstat(delta=True)
+        assert 0 < s.interval < 60
+        assert 0.0 <= s.cpu_busy_percent <= 100.0
+        assert abs(s.cpu_busy_percent + s.cpu_idle_percent + s.cpu_iowait_percent - 100.0) < 1.0
+        assert s.to_dict()["ctxt_per_sec"] >= 0
+
+    def test_pressure(self):
+        psi = sf.sysstat().psi_memory
+        if os.path.exists("/proc/pressure/memory"):
+            assert "some_avg10" in psi and "full_total_us" in psi
+        else:
+            assert psi is None
+
+
 class TestPs:
     def test_list_processes(self):
         result = sf.ps()
@@ -144,9 +176,217 @@ class TestPs:
         pids = [p["pid"] for p in result]
         assert pid in pids
 
+    def test_fields(self):
+        result = sf.ps(fields=["pid", "command"])
+        assert all(list(p) == ["pid", "command"] for p in result)
+        me = [p for p in result if p["pid"] == os.getpid()]
+        with open("/proc/self/comm") as f:
+            assert me == [{"pid": os.getpid(), "command": f.read().strip()}]
+
+    def test_unknown_field_raises(self):
+        with pytest.raises(ValueError, match="unknown field"):
+            sf.ps(fields=["bogus"])
+
+    def test_table(self):
+        table = sf.ps(fields=["pid", "uid", "cmdline"], table=True)
+        assert sorted(table) == ["cmdline", "pid", "uid"]
+        assert table["pid"] == sorted(table["pid"])
+        i = table["pid"].index(os.getpid())
+        assert table["uid"][i] == str(os.geteuid())
+        with open("/proc/self/cmdline") as f:
+            assert table["cmdline"][i] == f.read().rstrip("\0").replace("\0", " ")
+
+    def test_sort_by_mem(self):
+        mem = [p["mem_kb"] for p in sf.ps(sort_by="mem")]
+        assert mem == sorted(mem, reverse=True)
+
+
+class TestProcessSampler:
+    def test_interval_cpu(self):
+        sampler = sf.ProcessSampler()
+        end = time.time() + 0.3
+        while time.time() < end:
+            pass
+        me = [p for p in sampler.sample() if p["pid"] == os.getpid()]
+        assert len(me) == 1
+        assert not me[0]["new"]
+        assert me[0]["cpu_percent"] > 20
+        assert me[0]["read_bytes_per_sec"] is not None
+        assert sampler.interval >= 0.3
+
+    def test_top(self):
+        sampler = sf.ProcessSampler(io=False)
+        top = sampler.top(3, by="mem")
+        assert len(top) <= 3
+        mem = [p["mem_kb"] for p in top]
+        assert mem == sorted(mem, reverse=True)
+        assert top[0]["read_bytes_per_sec"] is None
+        with pytest.raises(ValueError, match="unknown key"):
+            sampler.top(by="bogus")
+
+    def test_background(self):
+        with sf.ProcessSampler(interval=0.05) as sampler:
+            assert sampler.running
+            time.sleep(0.2)
+            assert sampler.interval > 0
+            assert any(p["pid"] == os.getpid() for p in sampler.sample())
+        assert not sampler.running
+
+    def test_negative_interval_raises(self):
+        with pytest.raises(ValueError):
+            sf.ProcessSampler(interval=-1)
+
+
+@pytest.fixture
+def sleeper(tmp_path):
+    """Starts copies of sleep under a unique process name."""
+    import subprocess
+    exe = tmp_path / "sf_sleeper"
+    shutil.copy(shutil.which("sleep"), exe)
+    procs = []
+
+    def start(count=1):
+        new = [subprocess.Popen([str(exe), "30"]) for _ in range(count)]
+        procs.extend(new)
+        time.sleep(0.05)
+        return new
+
+    yield start
+    for p in procs:
+        p.kill()
+        p.wait()
+
+
+class TestPgrep:
+    def test_exact(self, sleeper):
+        procs = sleeper(2)
+        assert sf.pgrep("sf_sleeper", match="exact") == sorted(p.pid for p in procs)
+        assert sf.pgrep("sf_sleep", match="exact") == []
+
+    def test_regex_and_cmdline(self, sleeper):
+        (proc,) = sleeper()
+        assert sf.pgrep("^sf_sl.*er$") == [proc.pid]
+        assert proc.pid in sf.pgrep("sf_sleeper 30", match="cmdline")
+
+    def test_many(self, sleeper):
+        (proc,) = sleeper()
+        result = sf.pgrep(["sf_sleeper", "no_such_process_xyz"], match="exact")
+        assert result == {"sf_sleeper": [proc.pid], "no_such_process_xyz": []}
+
+    def test_excludes_self(self):
+        with open("/proc/self/comm") as f:
+            assert os.getpid() not in sf.pgrep(f.read().strip(), match="exact")
+
+    def test_invalid(self):
+        with pytest.raises(ValueError, match="unknown match mode"):
+            sf.pgrep("x", match="bogus")
+        with pytest.raises(ValueError, match="invalid pattern"):
+            sf.pgrep("(")
+
+
+class TestKillall:
+    def test_wait(self, sleeper):
+        procs = sleeper(2)
+        result = sf.killall("sf_sleeper", wait=True, timeout=5)
+        pids = sorted(p.pid for p in procs)
+        assert result["killed"] == 2
+        assert result["name"] == "sf_sleeper"
+        assert result["pids"] == pids
+        assert result["exited"] == pids
+        assert result["remaining"] == []
+
+    def test_many(self, sleeper):
+        (proc,) = sleeper()
+        result = sf.killall(["sf_sleeper", "sf_sleep.*"], signal=9, match="regex")
+        assert result["killed"] == 1
+        assert result["names"] == {"sf_sleeper": [proc.pid], "sf_sleep.*": [proc.pid]}
+        assert proc.wait(timeout=5) == -9
+
+    def test_timeout(self, sleeper):
+        (proc,) = sleeper()
+        result = sf.killall("sf_sleeper", signal=0, wait=True, timeout=0.1)
+        assert result["remaining"] == [proc.pid]
+        assert proc.poll() is None
+
+    def test_not_found(self):
+        with pytest.raises(ValueError, match="no process found"):
+            sf.killall("no_such_process_xyz")
+        with pytest.raises(ValueError, match="no process found"):
+            sf.killall(["no_such_process_xyz", "another_missing_xyz"])
+
 
 class TestWhereis:
     def test_find_ls(self):
         result = sf.whereis("ls")
         assert "binaries" in result
         assert len(result["binaries"]) > 0
+
+    def test_sees_new_binary(self, tmp_path, monkeypatch):
+        monkeypatch.setenv("PATH", f"{tmp_path}:{os.environ['PATH']}")
+        assert sf.whereis("sf_new_tool")["binaries"] == []
+        tool = tmp_path / "sf_new_tool"
+        tool.write_text("#!/bin/sh\n")
+        assert sf.whereis("sf_new_tool")["binaries"] == [str(tool)]
+
+
+class TestWhich:
+    def test_matches_shutil(self):
+        assert sf.which("sh") == shutil.which("sh")
+        assert sf.which("no_such_command_xyz") is None
+
+    def test_skips_non_executable(self, tmp_path, monkeypatch):
+        monkeypatch.setenv("PATH", str(tmp_path))
+        tool = tmp_path / "sf_tool"
+        tool.write_text("#!/bin/sh\n")
+        (tmp_path / "sf_dir").mkdir()
+        assert sf.which("sf_dir") is None
+        assert sf.which_many(["sf_tool"]) == {"sf_tool": None}
+        tool.chmod(0o755)
+        assert sf.which("sf_tool") == str(tool)
+        assert sf.which_many(["sf_tool"]) == {"sf_tool": str(tool)}
+
+    def test_which_many(self):
+        result = sf.which_many(["sh", "ls", "no_such_command_xyz"])
+        assert result["sh"] == shutil.which("sh")
+        assert result["ls"] == shutil.which("ls")
+        assert result["no_such_command_xyz"] is None
+
+
+class TestStats:
+    @pytest.fixture(autouse=True)
+    def collecting(self):
+        previous = sf.stats_enable(True)
+        sf.stats(reset=True)
+        yield
+        sf.stats_enable(previous)
+
+    def test_counts_calls_bytes_and_latency(self, tmp_path):
+        path = tmp_path / "data.txt"
+        path.write_text("alpha\nbeta\nalpha beta\n" * 1000)
+        sf.grep("alpha", str(path))
+        sf.grep("beta", str(path))
+        sf.wc(str(path))
+        result = sf.stats()
+        grep = result["grep"]
+        assert grep["calls"] == 2
+        assert grep["bytes"] >= 2 * path.stat().st_size
+        assert grep["syscalls"] > 0
+        assert sum(grep["latency_us"].values()) == 2
+        assert grep["total_seconds"] > 0
+        assert result["wc"]["calls"] == 1
+
+    def test_worker_threads_charge_the_command(self, tmp_path):
+        for d in range(4):
+            (tmp_path / f"d{d}").mkdir()
+            for f in range(10):
+                (tmp_path / f"d{d}" / f"f{f}").write_text("x")
+        sf.find(str(tmp_path), threads=4)
+        assert sf.stats()["find"]["syscalls"] >= 5
+
+    def test_reset_and_disable(self, tmp_path):
+        sf.pwd()
+        assert sf.stats(reset=True)["pwd"]["calls"] == 1
+        assert "pwd" not in sf.stats()
+        assert sf.stats_enable(False) is True
+        sf.pwd()
+        assert "pwd" not in sf.stats()
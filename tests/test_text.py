@@ -2,6 +2,8 @@
 
 import os
 import tempfile
+import threading
+import time
 import pytest
 import shellfast as sf
 
@@ -32,6 +34,15 @@ class TestCat:
         with pytest.raises(ValueError):
             sf.cat("/nonexistent_file_12345")
 
+    def test_unterminated_last_line(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "a\nb")
+            assert sf.cat(path) == "a\nb\n"
+
+    def test_procfs_file(self):
+        # procfs reports st_size == 0, so this exercises the read fallback
+        assert "Name:" in sf.cat("/proc/self/status")
+
 
 class TestEcho:
     def test_basic(self):
@@ -71,6 +82,16 @@ class TestHeadAndTail:
             result = sf.tail(path, n=5)
             assert len(result.strip().split("\n")) == 5
 
+    def test_tail_spans_blocks(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            # Lines longer than the 64 KiB scan block, no trailing newline
+            lines = [c * 100000 for c in "abcde"]
+            path = create_file(tmpdir, "long.txt", "\n".join(lines))
+            assert sf.tail(path, n=2) == lines[3] + "\n" + lines[4] + "\n"
+            assert sf.tail(path, n=10) == "\n".join(lines) + "\n"
+            assert sf.head(path, n=1) == lines[0] + "\n"
+            assert sf.tail(path, n=0) == ""
+
 
 class TestGrep:
     def test_basic_match(self):
@@ -97,6 +118,212 @@ class TestGrep:
             result = sf.grep("a", path, count_only=True)
             assert isinstance(result, dict)
 
+    def test_fixed_strings(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "a.c\nabc\n")
+            assert len(sf.grep("a.c", path)) == 2
+            result = sf.grep("a.c", path, fixed_strings=True)
+            assert [r["line"] for r in result] == ["a.c"]
+
+    def test_whole_word(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "cat\ncatalog\nthe cat sat\n")
+            result = sf.grep("cat|dog", path, whole_word=True)
+            assert [r["line_number"] for r in result] == [1, 3]
+
+    def test_regex_features(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt",
+                               "id=42 ok\nid=x ok\nERROR id=7\n(a)(a)\n")
+            assert len(sf.grep(r"^id=\d+\s", path)) == 1
+            assert len(sf.grep(r"error id=[0-9]{1,2}$", path, ignore_case=True)) == 1
+            # Backreferences still work through the std::regex fallback
+            assert len(sf.grep(r"(\(a\))\1", path)) == 1
+
+    def test_invalid_pattern_raises(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "a\n")
+            with pytest.raises(ValueError, match="invalid regex"):
+                sf.grep("a(", path)
+
+    def test_concurrent_calls(self):
+        from concurrent.futures import ThreadPoolExecutor
+        with tempfile.TemporaryDirectory() as tmpdir:
+            paths = [create_file(tmpdir, f"f{i}.txt", "match\nmiss\n" * 100)
+                     for i in range(8)]
+            with ThreadPoolExecutor(max_workers=4) as pool:
+                results = list(pool.map(lambda p: sf.grep("match", p), paths))
+            assert all(len(r) == 100 for r in results)
+
+    def test_threads_recursive_order(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            for d in range(4):
+                sub = os.path.join(tmpdir, f"d{d}")
+                os.makedirs(sub)
+                for i in range(10):
+                    create_file(sub, f"f{i}.txt", "hit\nmiss\nhit again\n")
+            serial = sf.grep("hit", tmpdir, recursive=True)
+            parallel = sf.grep("hit", tmpdir, recursive=True, threads=4)
+            assert len(serial) == 80
+            assert parallel == serial
+            assert (sf.grep("hit", tmpdir, recursive=True, count_only=True, threads=0)
+                    == sf.grep("hit", tmpdir, recursive=True, count_only=True))
+
+    def test_threads_large_file_chunks(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            # Large enough to be split into several chunks
+            lines = [f"line {i} {'target' if i % 1000 == 0 else 'filler'}"
+                     for i in range(1200000)]
+            path = create_file(tmpdir, "big.txt", "\n".join(lines) + "\n")
+            result = sf.grep("target", path, threads=4)
+            assert [r["line_number"] for r in result] == list(range(1, 1200001, 1000))
+            inverted = sf.grep("filler", path, invert=True, count_only=True, threads=4)
+            assert inverted[path] == 1200
+
+    def test_negative_threads_raises(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "a\n")
+            with pytest.raises(ValueError):
+                sf.grep("a", path, threads=-1)
+
+
+class TestGrepIndex:
+    def _corpus(self, tmpdir):
+        for i in range(3):
+            lines = [f"{i} request {n} ok" for n in range(5000)]
+            lines[1234] = f"{i} request 1234 Timeout after 30ms"
+            create_file(tmpdir, f"app{i}.log", "\n".join(lines) + "\n")
+
+    def test_indexed_grep_matches_full_scan(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            logs = os.path.join(tmpdir, "logs")
+            os.makedirs(logs)
+            self._corpus(logs)
+            idx = os.path.join(tmpdir, "logs.idx")
+            stats = sf.index_build(logs, index=idx, block_size=4096, threads=2)
+            assert stats["index"] == idx
+            assert stats["files"] == 3 and stats["reindexed"] == 3
+            for pattern, kw in [("Timeout after", {}), ("timeout AFTER", {"ignore_case": True}),
+                                ("after [0-9]+ms", {}), ("request 12", {"count_only": True}),
+                                ("ok", {}), ("Timeout", {"invert": True, "count_only": True})]:
+                expected = sf.grep(pattern, logs, recursive=True, **kw)
+                assert sf.grep(pattern, logs, recursive=True, index=idx, **kw) == expected
+            hits = sf.grep("Timeout after", logs, recursive=True, index=idx)
+            assert [h["line_number"] for h in hits] == [1235, 1235, 1235]
+
+    def test_incremental_update(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            logs = os.path.join(tmpdir, "logs")
+            os.makedirs(logs)
+            self._corpus(logs)
+            idx = os.path.join(tmpdir, "logs.idx")
+            sf.index_build(logs, index=idx, block_size=4096)
+            with open(os.path.join(logs, "app0.log"), "a") as f:
+                f.write("0 request 5000 Timeout after 99ms\n")
+            create_file(logs, "app1.log", "rewritten\n")
+            os.remove(os.path.join(logs, "app2.log"))
+
+            # A stale index still gives the same answer.
+            expected = sf.grep("Timeout after", logs, recursive=True)
+            assert sf.grep("Timeout after", logs, recursive=True, index=idx) == expected
+
+            stats = sf.index_build(logs, index=idx, block_size=4096)
+            assert (stats["appended"], stats["reindexed"], stats["removed"]) == (1, 1, 1)
+            assert stats["new_bytes"] == len("0 request 5000 Timeout after 99ms\n") + len("rewritten\n")
+            hits = sf.grep("Timeout after", logs, recursive=True, index=idx)
+            assert [h["line_number"] for h in hits] == [1235, 5001]
+            assert sf.index_build(logs, index=idx, block_size=4096)["unchanged"] == 2
+
+    def test_default_index_path(self, monkeypatch):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            monkeypatch.setenv("XDG_CACHE_HOME", os.path.join(tmpdir, "cache"))
+            logs = os.path.join(tmpdir, "logs")
+            os.makedirs(logs)
+            self._corpus(logs)
+            stats = sf.index_build(logs)
+            assert stats["index"].startswith(os.path.join(tmpdir, "cache", "shellfast"))
+            assert (sf.grep("Timeout", logs, recursive=True, index=True)
+                    == sf.grep("Timeout", logs, recursive=True))
+
+    def test_invalid_index_raises(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "a.log", "hello\n")
+            bogus = create_file(tmpdir, "bogus.idx", "not an index at all, really\n" * 8)
+            with pytest.raises(ValueError):
+                sf.grep("hello", path, index=bogus)
+            with pytest.raises(ValueError):
+                sf.index_build(path, index=os.path.join(tmpdir, "x.idx"), block_size=0)
+            with pytest.raises(ValueError):
+                sf.index_build("/nonexistent_dir_12345")
+
+
+class TestStreaming:
+    def test_grep_iter_batches(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "hit\nmiss\n" * 2500)
+            batches = list(sf.grep_iter("hit", path, batch_size=1000))
+            assert [len(b) for b in batches] == [1000, 1000, 500]
+            flat = [m for b in batches for m in b]
+            assert flat == sf.grep("hit", path)
+
+    def test_grep_iter_max_count(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "hit\n" * 100)
+            batches = list(sf.grep_iter("hit", path, max_count=5, batch_size=2))
+            flat = [m["line_number"] for b in batches for m in b]
+            assert flat == [1, 2, 3, 4, 5]
+
+    def test_grep_iter_recursive_and_early_stop(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            for i in range(3):
+                create_file(tmpdir, f"f{i}.txt", "hit\n" * 10)
+            it = sf.grep_iter("hit", tmpdir, recursive=True, batch_size=4)
+            first = next(it)
+            assert len(first) == 4 and "file" in first[0]
+            it.close()
+            assert list(it) == []
+            total = sum(len(b) for b in sf.grep_iter("hit", tmpdir, recursive=True))
+            assert total == 30
+
+    def test_cat_iter_matches_cat(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "a\n\n\nb\nc")
+            for kwargs in ({}, {"number_lines": True}, {"squeeze_blank": True}):
+                chunks = list(sf.cat_iter(path, batch_size=2, **kwargs))
+                assert "".join(chunks) == sf.cat(path, **kwargs)
+
+    def test_tail_iter(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt",
+                               "".join(f"line{i}\n" for i in range(20)))
+            assert "".join(sf.tail_iter(path, n=5, batch_size=2)) == sf.tail(path, n=5)
+            assert "".join(sf.tail_iter(path, n=50)) == sf.cat(path)
+
+    def test_tail_iter_follow(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "app.log", "old\npart")
+
+            def writer():
+                time.sleep(0.2)
+                with open(path, "a") as f:
+                    f.write("ial\nnew\n")
+                time.sleep(0.2)
+                os.rename(path, path + ".1")
+                with open(path, "w") as f:
+                    f.write("rotated\n")
+
+            t = threading.Thread(target=writer)
+            t.start()
+            got = "".join(sf.tail_iter(path, n=1, follow=True, timeout=1.0))
+            t.join()
+            assert got == "partial\nnew\nrotated\n"
+
+    def test_invalid_batch_size_raises(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "a\n")
+            with pytest.raises(ValueError):
+                sf.cat_iter(path, batch_size=0)
+
 
 class TestSort:
     def test_basic_sort(self):
@@ -127,6 +354,33 @@ class TestSort:
             lines = result.strip().split("\n")
             assert lines == ["a", "b", "c"]
 
+    def test_key_and_separator(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "x,3\ny,1\nz,2\n")
+            result = sf.sort_file(path, key=2, separator=",", numeric=True)
+            assert result == "y,1\nz,2\nx,3\n"
+            result = sf.sort_file(path, key=2, separator=",", reverse=True)
+            assert result == "x,3\nz,2\ny,1\n"
+
+    def test_external_matches_in_memory(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            lines = [f"{(i * 7919) % 5000},row{i % 37}" for i in range(20000)]
+            path = create_file(tmpdir, "test.txt", "\n".join(lines) + "\n")
+            expected = sf.sort_file(path, key=1, separator=",", numeric=True)
+            spilled = sf.sort_file(path, key=1, separator=",", numeric=True,
+                                   buffer_size=64 * 1024, temp_dir=tmpdir, threads=4)
+            assert spilled == expected
+            assert sorted(os.listdir(tmpdir)) == ["test.txt"]
+            assert (sf.sort_file(path, unique=True, buffer_size=32 * 1024)
+                    == "".join(l + "\n" for l in sorted(set(lines))))
+
+    def test_output_file(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "b\nc\na\n")
+            assert sf.sort_file(path, output=path) == ""
+            with open(path) as f:
+                assert f.read() == "a\nb\nc\n"
+
 
 class TestDiff:
     def test_identical_files(self):
@@ -136,6 +390,44 @@ class TestDiff:
             result = sf.diff(f1, f2)
             assert "-" not in result.split("\n", 2)[-1] or "+" not in result
 
+    def test_unified_hunks(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            old = [f"line{i}" for i in range(1, 21)]
+            new = list(old)
+            new[4] = "changed5"
+            new.insert(15, "added")
+            f1 = create_file(tmpdir, "a.txt", "\n".join(old) + "\n")
+            f2 = create_file(tmpdir, "b.txt", "\n".join(new) + "\n")
+            result = sf.diff(f1, f2, context_lines=1)
+            assert result.split("\n") == [
+                f"--- {f1}", f"+++ {f2}",
+                "@@ -4,3 +4,3 @@", " line4", "-line5", "+changed5", " line6",
+                "@@ -15,2 +15,3 @@", " line15", "+added", " line16",
+                "",
+            ]
+            # Wider context merges both changes into one hunk
+            merged = sf.diff(f1, f2, context_lines=5)
+            assert merged.count("@@ -") == 1
+
+    def test_large_files(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            old = [f"key{i} = {i % 7}" for i in range(100000)]
+            new = [l if i % 1000 else l + " # edited" for i, l in enumerate(old)]
+            f1 = create_file(tmpdir, "a.txt", "\n".join(old) + "\n")
+            f2 = create_file(tmpdir, "b.txt", "\n".join(new) + "\n")
+            result = sf.diff(f1, f2, context_lines=0)
+            body = result.split("\n")[2:]
+            assert sum(1 for l in body if l.startswith("-")) == 100
+            assert sum(1 for l in body if l.startswith("+")) == 100
+
+    def test_missing_newline(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            f1 = create_file(tmpdir, "a.txt", "a\nb\n")
+            f2 = create_file(tmpdir, "b.txt", "a\nb")
+            result = sf.diff(f1, f2)
+            assert "\\ No newline at end of file" in result
+            assert sf.diff(f1, f1) == ""
+
 
 class TestCmp:
     def test_identical(self):
@@ -152,6 +444,39 @@ class TestCmp:
             result = sf.cmp(f1, f2)
             assert result["identical"] is False
 
+    def test_first_difference_position(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            base = "x" * 10000 + "\n" + "y" * 10000
+            f1 = create_file(tmpdir, "a.txt", base + "\nA tail")
+            f2 = create_file(tmpdir, "b.txt", base + "\nB tail")
+            result = sf.cmp(f1, f2)
+            assert result["byte_offset"] == 20003
+            assert result["line_number"] == 3
+            # A differing newline byte is still on its own line
+            f3 = create_file(tmpdir, "c.txt", "ab\ncd")
+            f4 = create_file(tmpdir, "d.txt", "abXcd")
+            assert sf.cmp(f3, f4)["line_number"] == 1
+
+    def test_prefix_and_silent(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            f1 = create_file(tmpdir, "a.txt", "abc")
+            f2 = create_file(tmpdir, "b.txt", "abcdef")
+            result = sf.cmp(f1, f2)
+            assert result["byte_offset"] == 4
+            assert "EOF on" in result["message"]
+            assert sf.cmp(f1, f2, silent=True) == {"identical": False}
+
+    def test_max_diffs(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            f1 = create_file(tmpdir, "a.txt", "aaaa\nbbbb\ncccc\n")
+            f2 = create_file(tmpdir, "b.txt", "aXXa\nbbbb\ncYcc\n")
+            result = sf.cmp(f1, f2, max_diffs=5)
+            assert result["differences"] == [
+                {"byte_offset": 2, "length": 2, "line_number": 1},
+                {"byte_offset": 12, "length": 1, "line_number": 3},
+            ]
+            assert len(sf.cmp(f1, f2, max_diffs=1)["differences"]) == 1
+
 
 class TestWc:
     def test_counts(self):
@@ -168,6 +493,34 @@ class TestWc:
             assert result["lines"] == 3
             assert "words" not in result
 
+    def test_utf8_chars(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, "test.txt")
+            with open(path, "w", encoding="utf-8") as f:
+                f.write("héllo wörld €\n")
+            result = sf.wc(path)
+            assert result["chars"] == 14
+            assert result["bytes"] == 18
+            assert result["words"] == 3
+
+    def test_matches_python_counts(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            text = "".join(f"word{i}\t{'x' * (i % 50)}  \v\n" for i in range(5000))
+            path = create_file(tmpdir, "test.txt", text)
+            result = sf.wc(path, threads=4)
+            assert result["lines"] == text.count("\n")
+            assert result["words"] == len(text.split())
+            assert result["bytes"] == len(text)
+
+    def test_multiple_files(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            paths = [create_file(tmpdir, f"f{i}.txt", "a b\n" * (i + 1)) for i in range(6)]
+            results = sf.wc(paths, threads=3)
+            assert [r["file"] for r in results] == paths
+            assert [r["lines"] for r in results] == [1, 2, 3, 4, 5, 6]
+            with pytest.raises(ValueError):
+                sf.wc(paths + [os.path.join(tmpdir, "missing.txt")])
+
 
 class TestComm:
     def test_comm(self):
@@ -179,6 +532,23 @@ class TestComm:
             assert "d" in result["only_in_second"]
             assert "b" in result["in_both"]
 
+    def test_assume_sorted_matches_default(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            f1 = create_file(tmpdir, "a.txt", "a\nb\nb\nc\ne\n")
+            f2 = create_file(tmpdir, "b.txt", "b\nc\nd\nd\nf")
+            result = sf.comm(f1, f2, assume_sorted=True)
+            assert result == sf.comm(f1, f2)
+            assert result["only_in_first"] == ["a", "e"]
+            assert result["only_in_second"] == ["d", "f"]
+            assert result["in_both"] == ["b", "c"]
+
+    def test_assume_sorted_rejects_unsorted(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            f1 = create_file(tmpdir, "a.txt", "b\na\n")
+            f2 = create_file(tmpdir, "b.txt", "a\n")
+            with pytest.raises(ValueError, match="not in sorted order"):
+                sf.comm(f1, f2, assume_sorted=True)
+
 
 class TestCut:
     def test_basic_cut(self):
@@ -187,3 +557,168 @@ class TestCut:
             result = sf.cut(path, delimiter=":", fields="2")
             lines = result.strip().split("\n")
             assert lines == ["b", "e"]
+
+    def test_ranges_merge_and_open_ends(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "a:b:c:d:e\nx:y\n")
+            assert sf.cut(path, delimiter=":", fields="4-,1,2-3") == "a:b:c:d:e\nx:y\n"
+            assert sf.cut(path, delimiter=":", fields="-2,5") == "a:b:e\nx:y\n"
+            assert sf.cut(path, delimiter=":", fields="1-1000000") == "a:b:c:d:e\nx:y\n"
+
+    def test_multibyte_delimiter(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "a::b:c::d\n")
+            assert sf.cut(path, delimiter="::", fields="2,3") == "b:c::d\n"
+
+    def test_invalid_fields_raise(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "test.txt", "a\n")
+            for spec in ("0", "x", "3-1", ""):
+                with pytest.raises(ValueError, match="cut:"):
+                    sf.cut(path, fields=spec)
+
+
+class TestJoin:
+    def test_hash_join_unsorted(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            f1 = create_file(tmpdir, "a.txt", "3 c\n1 a\n2 b\n1 z\n")
+            f2 = create_file(tmpdir, "b.txt", "1 x\n3 y\n1 w\n")
+            result = sf.join(f1, f2)
+            assert result.splitlines() == [
+                "3 c 3 y", "1 a 1 x", "1 a 1 w", "1 z 1 x", "1 z 1 w",
+            ]
+
+    def test_assume_sorted_matches_hash_join(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            f1 = create_file(tmpdir, "a.txt", "a,1\nb,2\nb,3\nd,4\n")
+            f2 = create_file(tmpdir, "b.txt", "x,b\ny,b\nz,c\nw,d")
+            expected = sf.join(f1, f2, field2=2, separator=",")
+            assert expected.splitlines() == [
+                "b,2,x,b", "b,2,y,b", "b,3,x,b", "b,3,y,b", "d,4,w,d",
+            ]
+            assert sf.join(f1, f2, field2=2, separator=",",
+                           assume_sorted=True) == expected
+
+    def test_assume_sorted_rejects_unsorted(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            f1 = create_file(tmpdir, "a.txt", "b 1\na 2\n")
+            f2 = create_file(tmpdir, "b.txt", "a 1\nb 2\n")
+            with pytest.raises(ValueError, match="not sorted"):
+                sf.join(f1, f2, assume_sorted=True)
+
+    def test_multibyte_separator(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            f1 = create_file(tmpdir, "a.txt", "k1||a\nk2||b\n")
+            f2 = create_file(tmpdir, "b.txt", "k2||y\n")
+            assert sf.join(f1, f2, separator="||") == "k2||b||k2||y\n"
+
+    def test_space_separator_splits_on_whitespace_runs(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            f1 = create_file(tmpdir, "a.txt", "  1\ta\n2   b\n")
+            f2 = create_file(tmpdir, "b.txt", "1 x\n2\t\ty\n")
+            result = sf.join(f1, f2, separator=" ")
+            assert result == sf.join(f1, f2)
+            assert len(result.splitlines()) == 2
+
+    def test_output_file(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            f1 = create_file(tmpdir, "a.txt", "1 a\n2 b\n")
+            f2 = create_file(tmpdir, "b.txt", "1 x\n2 y\n")
+            out = os.path.join(tmpdir, "out.txt")
+            assert sf.join(f1, f2, assume_sorted=True, output=out) == ""
+            with open(out) as f:
+                assert f.read() == "1 a 1 x\n2 b 2 y\n"
+
+
+class TestPipeline:
+    LOG = "".join(f"u{i % 7}\t{'POST' if i % 3 == 0 else 'GET'}\t/p/{i}\n" for i in range(200))
+
+    def test_grep_cut_sort(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "log.txt", self.LOG)
+            expected = sorted({l.split("\t")[0] for l in self.LOG.splitlines() if "POST" in l})
+            for threaded in (False, True):
+                result = (sf.pipeline().grep("POST").cut("1").sort(unique=True)
+                          .run(path, threaded=threaded))
+                assert result.splitlines() == expected
+
+    def test_matches_separate_commands(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "log.txt", self.LOG)
+            cut = create_file(tmpdir, "cut.txt", sf.cut(path, fields="3"))
+            p = sf.pipeline().cut("3").sort(reverse=True).head(5)
+            assert p.run(path).splitlines() == sf.sort_file(cut, reverse=True).splitlines()[:5]
+            assert p.run(path, threaded=True) == p.run(path)
+
+    def test_head_tail_and_comm(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "nums.txt", "".join(f"{i}\n" for i in range(10000)))
+            drop = create_file(tmpdir, "drop.txt", "2\n3\n")
+            assert sf.pipeline().head(3).run(path) == "0\n1\n2\n"
+            assert sf.pipeline().tail(2).run(path) == "9998\n9999\n"
+            assert sf.pipeline().head(5).comm(drop).run(path) == "0\n1\n4\n"
+            assert sf.pipeline().head(5).comm(drop, keep="in_both").run(path) == "2\n3\n"
+            assert sf.pipeline().grep("^9", invert=True).tail(1).run(path, threaded=True) == "8999\n"
+
+    def test_output_and_repr(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "a.txt", "b\na\n")
+            out = os.path.join(tmpdir, "out.txt")
+            p = sf.pipeline().sort()
+            assert len(p) == 1 and repr(p) == "Pipeline(sort())"
+            assert p.run(path, output=out) == ""
+            with open(out) as f:
+                assert f.read() == "a\nb\n"
+
+    def test_errors(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "a.txt", "a\n")
+            with pytest.raises(ValueError, match="pipeline:"):
+                sf.pipeline().grep("(")
+            with pytest.raises(ValueError, match="pipeline:"):
+                sf.pipeline().cut("0")
+            with pytest.raises(ValueError):
+                sf.pipeline().comm(os.path.join(tmpdir, "missing")).run(path)
+            with pytest.raises(ValueError):
+                sf.pipeline().run(os.path.join(tmpdir, "missing"))
+
+
+class TestTextBuffer:
+    def test_cat_as_bytes(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "a.txt", "hello\nworld\n")
+            buf = sf.cat(path, as_bytes=True)
+            assert len(buf) == 12
+            assert memoryview(buf).tobytes() == b"hello\nworld\n"
+            assert memoryview(buf).readonly
+            assert bytes(buf) == b"hello\nworld\n"
+            assert buf.decode() == sf.cat(path)
+            numbered = sf.cat(path, number_lines=True, as_bytes=True)
+            assert numbered.decode() == sf.cat(path, number_lines=True)
+
+    def test_head_tail_bytes(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "a.txt", "0123456789")
+            assert bytes(sf.head(path, bytes=4, as_bytes=True)) == b"0123"
+            assert bytes(sf.tail(path, bytes=3, as_bytes=True)) == b"789"
+            assert bytes(sf.head(path, bytes=100, as_bytes=True)) == b"0123456789"
+
+    def test_lines(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = create_file(tmpdir, "a.txt", "c\na\n\nb")
+            lines = sf.cat(path, as_bytes=True).lines()
+            assert len(lines) == 4
+            assert lines[0] == "c" and lines[2] == "" and lines[-1] == "b"
+            assert list(lines) == ["c", "a", "", "b"]
+            with pytest.raises(IndexError):
+                lines[4]
+            assert list(sf.sort_file(path, as_bytes=True).lines()) == ["", "a", "b", "c"]
+
+    def test_other_commands(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            a = create_file(tmpdir, "a.txt", "1\tx\n2\ty\n")
+            b = create_file(tmpdir, "b.txt", "1\tp\n2\tq\n")
+            assert sf.cut(a, fields="2", as_bytes=True).decode() == sf.cut(a, fields="2")
+            assert sf.paste([a, b], as_bytes=True).decode() == sf.paste([a, b])
+            assert (sf.join(a, b, separator="\t", as_bytes=True).decode()
+                    == sf.join(a, b, separator="\t"))